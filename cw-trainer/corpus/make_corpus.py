@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+"""Packs the practice word lists into ../trainer_corpus_data.cpp.
+
+Every token is stored as a run of 6-bit codes. Each character the lists use
+gets a code, and the codes left over go to the most frequent character pairs,
+a small shared dictionary. An index of code offsets, one per token plus an end
+marker and packed just wide enough for the corpus, lets the trainer decode any
+token without touching the others.
+
+    python3 make_corpus.py            (run from anywhere)
+
+The host simulator Makefile re-runs this when a list changes; the output is
+checked in so the Arduino IDE build needs no extra step.
+"""
+
+import collections
+import os
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+OUTPUT = os.path.join(HERE, "..", "trainer_corpus_data.cpp")
+
+# Same order as CorpusList in trainer_corpus.h
+LISTS = [
+    ("CORPUS_WORDS", "words.txt"),
+    ("CORPUS_ABBREVIATIONS", "abbreviations.txt"),
+    ("CORPUS_PREFIXES", "prefixes.txt"),
+    ("CORPUS_EXCHANGES", "exchanges.txt"),
+    ("CORPUS_PHRASES", "phrases.txt"),
+]
+
+# Everything the Morse table can send, plus the word space
+SENDABLE = set("ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789/?,.=+-()\":;@! ")
+CODE_BITS = 6
+CODE_COUNT = 1 << CODE_BITS
+TOKEN_MAX = 24  # GENERATOR_TOKEN_MAX in trainer_generator.h
+
+
+def read_list(name):
+    tokens = []
+    seen = set()
+    with open(os.path.join(HERE, name)) as f:
+        for number, line in enumerate(f, 1):
+            token = " ".join(line.split("#", 1)[0].split()).upper()
+            if not token:
+                continue
+            bad = set(token) - SENDABLE
+            if bad:
+                sys.exit("%s:%d: cannot send %r" % (name, number, "".join(sorted(bad))))
+            if len(token) > TOKEN_MAX:
+                sys.exit("%s:%d: longer than %d characters" % (name, number, TOKEN_MAX))
+            if token not in seen:
+                seen.add(token)
+                tokens.append(token)
+    if not tokens:
+        sys.exit("%s: empty list" % name)
+    return tokens
+
+
+def choose_codes(tokens):
+    chars = sorted(set("".join(tokens)))
+    if len(chars) > CODE_COUNT:
+        sys.exit("%d distinct characters do not fit %d codes" % (len(chars), CODE_COUNT))
+    pairs = collections.Counter()
+    for token in tokens:
+        for i in range(len(token) - 1):
+            pairs[token[i:i + 2]] += 1
+    spare = CODE_COUNT - len(chars)
+    common = [p for p, n in pairs.most_common() if n > 1][:spare]
+    return chars + sorted(common)
+
+
+def encode(token, lookup):
+    codes = []
+    i = 0
+    while i < len(token):
+        pair = token[i:i + 2]
+        if len(pair) == 2 and pair in lookup:
+            codes.append(lookup[pair])
+            i += 2
+        else:
+            codes.append(lookup[token[i]])
+            i += 1
+    return codes
+
+
+def pack(values, width, slack):
+    out = bytearray()
+    acc = bits = 0
+    for value in values:
+        acc = (acc << width) | value
+        bits += width
+        while bits >= 8:
+            bits -= 8
+            out.append((acc >> bits) & 0xFF)
+    if bits:
+        out.append((acc << (8 - bits)) & 0xFF)
+    out.extend(bytes(slack))  # the decoder reads whole windows past the last field
+    return out
+
+
+def c_char(c):
+    return "'\\\\'" if c == "\\" else "'\\''" if c == "'" else "'%s'" % c
+
+
+def rows(values, per_line, fmt):
+    items = [fmt % v for v in values]
+    return ",\n".join("  " + ", ".join(items[i:i + per_line]) for i in range(0, len(items), per_line))
+
+
+def main():
+    lists = [(enum, read_list(name)) for enum, name in LISTS]
+    tokens = [t for _, ts in lists for t in ts]
+    alphabet = choose_codes(tokens)
+    lookup = {s: i for i, s in enumerate(alphabet)}
+
+    codes = []
+    index = []
+    for token in tokens:
+        index.append(len(codes))
+        codes.extend(encode(token, lookup))
+    index.append(len(codes))
+    index_bits = max(1, len(codes).bit_length())
+    if index_bits > 16:
+        sys.exit("corpus too large for 16-bit code offsets")
+    packed = pack(codes, CODE_BITS, 1)
+    packed_index = pack(index, index_bits, 2)
+
+    # Baseline: NUL-terminated strings plus a 32-bit pointer per token
+    raw = sum(len(t) + 1 for t in tokens) + 4 * len(tokens)
+    stored = len(packed) + len(packed_index) + 2 * len(alphabet) + 4 * len(lists)
+
+    ranges = []
+    first = 0
+    for enum, ts in lists:
+        ranges.append("  { %d, %d },  // %s" % (first, len(ts), enum))
+        first += len(ts)
+
+    table = ", ".join("{ %s, %s }" % (c_char(s[0]), c_char(s[1]) if len(s) > 1 else "0") for s in alphabet)
+
+    with open(OUTPUT, "w") as f:
+        f.write("// Generated by corpus/make_corpus.py from corpus/*.txt -- do not edit.\n")
+        f.write("// %d tokens: %d bytes packed with index, %d as a string table.\n\n"
+                % (len(tokens), stored, raw))
+        f.write('#include "trainer_corpus.h"\n\n')
+        f.write("static_assert(CORPUS_LIST_COUNT == %d, \"CorpusList does not match make_corpus.py\");\n\n"
+                % len(lists))
+        f.write("const char CORPUS_CODES[%d][2] PROGMEM = {\n  %s\n};\n\n" % (len(alphabet), table))
+        f.write("const uint8_t CORPUS_PACKED[%d] PROGMEM = {\n%s\n};\n\n"
+                % (len(packed), rows(packed, 16, "0x%02X")))
+        f.write("// Start of each token in codes, CORPUS_INDEX_BITS wide; one extra entry marks the end\n")
+        f.write("const uint8_t CORPUS_INDEX_BITS = %d;\n" % index_bits)
+        f.write("const uint8_t CORPUS_INDEX[%d] PROGMEM = {\n%s\n};\n\n"
+                % (len(packed_index), rows(packed_index, 16, "0x%02X")))
+        f.write("const CorpusRange CORPUS_LISTS[CORPUS_LIST_COUNT] PROGMEM = {\n%s\n};\n"
+                % "\n".join(ranges))
+
+    print("corpus: %d tokens, %d bytes packed (string table: %d), %d codes, %d pairs, %d-bit index"
+          % (len(tokens), stored, raw, len(codes), len(alphabet) - len(set("".join(tokens))), index_bits))
+
+
+if __name__ == "__main__":
+    main()
@@ -3,13 +3,19 @@
 #include <SPI.h>
 #include <SD.h>
 #include <SerialFlash.h>
-#include <Bounce2.h>
-#include <Encoder.h>
 #include <EEPROM.h>
 #include <Adafruit_SSD1306.h>
 #include <Adafruit_GFX.h>
+#include <ADC.h>
 #include "trainer_protocol.h"
-#include "trainer_constants.h"
+#include "trainer_core.h"
+#include "trainer_trace.h"
+#include "trainer_pots.h"
+#include "trainer_input.h"
+#include "trainer_sessionlog.h"
+#include "trainer_frame.h"
+#include "trainer_monitor.h"
+#include <malloc.h>
 
 // Display setup
 #define SCREEN_WIDTH 128
@@ -17,13 +23,6 @@
 #define OLED_RESET -1
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 
-// Forward declarations for features not yet implemented (prevent compile errors)
-void startQSOSimulation();
-void continueQSOSimulation();
-void displayDetailedStats();
-
-bool wifiEnabled = true;  // Set to true if you add WiFi module
-
 // Audio objects for generation
 AudioSynthWaveformSine sine1;
 AudioSynthWaveform waveform1;
@@ -36,6 +35,7 @@ AudioInputI2S audioInput;  // For radio input
 AudioMixer4 decodeMixer;
 AudioAnalyzeFFT1024 fft1024;  // For spectrum analysis
 AudioEffectMultiply agc;      // Simple AGC
+AudioRecordQueue monitorQueue;  // decode mix for the web page's live audio
 
 // Audio outputs
 AudioOutputAnalog dac1;
@@ -55,6 +55,7 @@ AudioConnection patchCord8(audioInput, 0, decodeMixer, 1);  // External audional
 
 AudioConnection patchCord9(decodeMixer, toneDetect1);
 AudioConnection patchCord10(decodeMixer, 0, fft1024, 0);  // Spectrum a
+AudioConnection patchCord11(decodeMixer, 0, monitorQueue, 0);
 AudioControlSGTL5000 sgtl5000_1;
 
 // Pin definitions
@@ -70,6 +71,9 @@ const int SPEED_POT = A2;  // Koch speed control
 
 const int WIFI_RST_PIN = 28;    // ESP32 EN reset control
 const int WIFI_READY_PIN = 23;  // ESP32 ready signal (low = ready)
+const int LINK_RTS_PIN = -1;    // Serial1 RTS to the ESP32's CTS; -1 if not wired
+const int LINK_CTS_PIN = -1;    // Serial1 CTS from the ESP32's RTS
+const uint32_t LINK_MAX_BAUD = 2000000;
 const int MENU_BTN = 9;         // Menu navigation
 #define BUTTON_PIN MENU_BTN     // Alias for legacy code
 
@@ -80,65 +84,34 @@ const int ENC_B_PIN = 40;  // Encoder DT
 // Rotary encoder resolution (pulses per detent)
 const int ENCODER_STEPS_PER_DETENT = 4;
 
-// Debounce objects
-Bounce keyDebouncer = Bounce();
-
-
-
-
-
+// Pin-change inputs: each ISR ignores edges inside the lockout after the last
+// accepted one, and pollInputSettle() catches a level that settled inside it
+struct EdgeInput {
+  uint8_t pin;
+  InputEventType type;
+  uint32_t lockoutMs;
+  volatile bool pressed;
+  volatile uint32_t lastEdge;
+};
+EdgeInput keyInput = { KEY_PIN, INPUT_KEY, 5, false, 0 };
+EdgeInput buttonInput = { MENU_BTN, INPUT_BUTTON, 50, false, 0 };
 
-Bounce menuButton = Bounce();
+// Quadrature decoder state for the encoder ISR
+volatile uint8_t encoderState = 0;
+volatile int8_t encoderSteps = 0;
 
 
-// Configuration variables
-float sidetoneFreq = 600.0;
-float volume = 0.5;
-int currentWaveform = 0;
-bool useHeadphones = false;
-bool keyPressed = false;
-bool decoderEnabled = true;
-bool kochModeEnabled = false;
-bool useExternalAudio = true;  // false = sidetone, true = radio input
-bool espConnected = false;
+// Sketch-local state (the trainer core lives in trainer_*.cpp)
 unsigned long lastPingTime = 0;
-const unsigned long PING_INTERVAL = 5000;  // 1 second ping
-unsigned long lastWiFiHeartbeat = 0;
-// Event-driven status cache
-unsigned long lastStatusSentTime = 0;
-String lastStatusSent = "";
-const unsigned long STATUS_KEEPALIVE_INTERVAL = 30000;  // send at least every 30 s
-
-unsigned long lastFreqUpdate = 0;
-unsigned long lastVolumeUpdate = 0;
-unsigned long lastDisplayUpdate = 0;
-
-// Menu system
-enum MenuMode { MAIN_SCREEN,
-                KOCH_MENU,
-                PRACTICE_MENU,
-                SETTINGS_MENU,
-                STATS_MENU,
-                QSO_MENU };
-MenuMode currentMenu = MAIN_SCREEN;
-int menuSelection = 0;
-bool inMenu = false;
-bool editMode = false;
-// Encoder push button timing
-const unsigned long LONG_PRESS_DURATION = 1000;  // ms threshold for long press to exit menu
-unsigned long buttonDownTime = 0;
-bool buttonIsDown = false;         // true while button physically held
-bool shortPressCandidate = false;  // cleared if long press detected
-Encoder knob(ENC_A_PIN, ENC_B_PIN);
-long lastEncoderPos = 0;
-
-// Practice modes
-enum PracticeMode { KOCH_TRAINING,
-                    CALLSIGN_PRACTICE,
-                    QSO_SIMULATION,
-                    CONTEST_MODE,
-                    CUSTOM_LESSON };
-PracticeMode currentPracticeMode = KOCH_TRAINING;
+
+// Pots are sampled in the background: a timer starts each conversion on ADC0
+// and the completion interrupt feeds the filters, alternating between pots
+ADC adc;
+IntervalTimer potTimer;
+const uint32_t POT_SAMPLE_PERIOD_US = 500;  // 2 kHz, so 1 kHz per pot
+PotFilter freqPot(20);                      // ~4.4 Hz of hysteresis
+PotFilter volumePot(16);                    // ~0.4 % of hysteresis
+volatile uint8_t potChannel = 0;
 
 // Envelope settings
 const float ATTACK_TIME = 5.0;
@@ -146,115 +119,32 @@ const float DECAY_TIME = 0.0;
 const float SUSTAIN_LEVEL = 1.0;
 const float RELEASE_TIME = 8.0;
 
-// CW Decoder variables
-unsigned long keyDownTime = 0;
-unsigned long keyUpTime = 0;
-unsigned long lastKeyChange = 0;
-bool lastToneState = false;
-String currentCharacter = "";
-String decodedText = "";
-unsigned long lastCharacterTime = 0;
-unsigned long lastWordTime = 0;
-
-// Timing
-float ditLength = 100;
-float dahThreshold = 200;
-float charSpaceThreshold = 300;
-float wordSpaceThreshold = 700;
 const float TONE_THRESHOLD = 0.1;
 
-// Statistics (stored in EEPROM)
-struct TrainingStats {
-  unsigned long totalDits;
-  unsigned long totalDahs;
-  unsigned long charactersDecoded;
-  unsigned long sessionsCompleted;
-  float bestWPM;
-  float totalTrainingMinutes;
-  int highestLesson;
-  unsigned long characterErrors[26];  // A-Z error counts
-  float lessonAccuracy[40];           // Accuracy for each Koch lesson
-  unsigned long lastSessionTime;
-  int customLessonsCompleted;
-  float averageAccuracy;
-};
-
-TrainingStats stats;
-
-// Persisted device configuration
-struct DeviceSettings {
-  float sidetoneFreq;
-  float volume;
-  uint8_t waveform;
-  bool useHeadphones;
-  bool decoderEnabled;
-  bool useExternalAudio;
-  bool kochModeEnabled;
-};
-
-DeviceSettings deviceSettings;
-unsigned long sessionStartTime;
-float currentWPM = 0;
-
-// Koch Method Variables
-int kochLesson = 1;
-String kochCharSet = "";
-int kochSpeed = 20;
-int kochEffectiveSpeed = 13;
-String kochSentText = "";
-String kochReceivedText = "";
-int kochCharIndex = 0;
-unsigned long kochSendTimer = 0;
-bool kochSending = false;
-bool kochListening = false;
-int kochCorrect = 0;
-int kochTotal = 0;
-float kochAccuracy = 0.0;
-
-// Callsign practice
-// RAM-hungry arrays replaced with flash-resident tables in trainer_constants.h/.cpp
-
-
-// QSO simulation data
-String qsoExchanges[] = { "CQ CQ DE ", " K", " TU 73", "599 ", "5NN ", "QTH ", "NAME ", "AGE ", "PWR ", "ANT " };
-
-
-// Koch method character progression
-String kochLessons[] = {
-  "KM", "KMR", "KMRS", "KMRSU", "KMRSUA", "KMRSUAP", "KMRSUAPT", "KMRSUAPTL",
-  "KMRSUAPTLO", "KMRSUAPTLOW", "KMRSUAPTLOWI", "KMRSUAPTLOWIN", "KMRSUAPTLOWING",
-  "KMRSUAPTLOWINGD", "KMRSUAPTLOWINGDK", "KMRSUAPTLOWINGDKG", "KMRSUAPTLOWINGDKGO",
-  "KMRSUAPTLOWINGDKGOH", "KMRSUAPTLOWINGDKGOHV", "KMRSUAPTLOWINGDKGOHVF",
-  "KMRSUAPTLOWINGDKGOHVFU", "KMRSUAPTLOWINGDKGOHVFUJ", "KMRSUAPTLOWINGDKGOHVFUJE",
-  "KMRSUAPTLOWINGDKGOHVFUJEL", "KMRSUAPTLOWINGDKGOHVFUJELB", "KMRSUAPTLOWINGDKGOHVFUJELBY",
-  "KMRSUAPTLOWINGDKGOHVFUJELBYC", "KMRSUAPTLOWINGDKGOHVFUJELBYCK", "KMRSUAPTLOWINGDKGOHVFUJELBYCKX",
-  "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQ", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ5",
-  "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ54", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ543", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ5432",
-  "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ54321", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ543210", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ5432109",
-  "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ54321098", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ543210987", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ5432109876"
-};
-
-// Morse code lookup table
-struct MorseChar {
-  char character;
-  String code;
+// Virtual time gained while replaying a trace faster than real time
+uint32_t clockSkew = 0;
+uint32_t lastClockSample = 0;
+
+// Serial1 buffers beyond the core's 64 bytes: writes return at once and the
+// UART interrupt drains them, and a slow loop pass does not overrun reception
+static uint8_t linkRxMemory[4096];
+static uint8_t linkTxMemory[4096];
+
+// Per-character session log on the built-in SD card, one file per power-up
+File sessionLogFile;
+bool sdCardReady = false;
+
+// Heap probe: samples the allocator after setup() to prove the runtime is heap-free
+struct HeapProbe {
+  size_t inUseAtSetup;
+  size_t inUse;
+  size_t highWater;
+  uint32_t changeEvents;  // samples where in-use bytes differed from the previous one
 };
-
-MorseChar morseTable[] = {
-  { 'A', ".-" }, { 'B', "-..." }, { 'C', "-.-." }, { 'D', "-.." }, { 'E', "." }, { 'F', "..-." }, { 'G', "--." }, { 'H', "...." }, { 'I', ".." }, { 'J', ".---" }, { 'K', "-.-" }, { 'L', ".-.." }, { 'M', "--" }, { 'N', "-." }, { 'O', "---" }, { 'P', ".--." }, { 'Q', "--.-" }, { 'R', ".-." }, { 'S', "..." }, { 'T', "-" }, { 'U', "..-" }, { 'V', "...-" }, { 'W', ".--" }, { 'X', "-..-" }, { 'Y', "-.--" }, { 'Z', "--.." }, { '1', ".----" }, { '2', "..---" }, { '3', "...--" }, { '4', "....-" }, { '5', "....." }, { '6', "-...." }, { '7', "--..." }, { '8', "---.." }, { '9', "----." }, { '0', "-----" }, { '/', "-..-." }, { '?', "..--.." }, { ',', "--..--" }, { '.', ".-.-.-" }, { '=', "-...-" }, { '+', ".-.-." }, { '-', "-....-" }, { '(', "-.--." }, { ')', "-.--.-" }, { '"', ".-..-." }, { ':', "---..." }, { ';', "-.-.-." }, { '@', ".--.-." }, { '!', "-.-.--" }
-};
-const int morseTableSize = sizeof(morseTable) / sizeof(MorseChar);
-
-const char* waveformNames[] = { "Sine", "Square", "Sawtooth", "Triangle" };
-const char* practiceModeNames[] = { "Koch", "Callsign", "QSO", "Contest", "Custom" };
-
-// EEPROM addresses
-const int STATS_ADDR = 0;
-const int KOCH_LESSON_ADDR = sizeof(TrainingStats);
-const int SETTINGS_ADDR = KOCH_LESSON_ADDR + sizeof(int);
+HeapProbe heapProbe;
 
 void setup() {
-  Serial1.begin(115200);   // UART to wifi companion module
+  beginLinkSerial(LINK_BAUD_DEFAULT);  // UART to wifi companion module
   Serial1.setTimeout(20);  // longer timeout to receive full lines
   Serial.begin(115200);    // USB Serial for debugging
 
@@ -285,7 +175,9 @@ void setup() {
   loadSettings();
 
   // Audio setup
-  AudioMemory(35);  // Increased for all features
+  AudioMemory(35 + MONITOR_QUEUE_BLOCKS);  // Increased for all features
+  monitorQueue.setMaxBuffers(MONITOR_QUEUE_BLOCKS);  // a stalled loop costs audio blocks, not the graph's
+  patchCord10.disconnect();  // the FFT runs only while a browser shows the spectrum
   sgtl5000_1.enable();
   sgtl5000_1.volume(0.8);
   sgtl5000_1.inputSelect(AUDIO_INPUT_LINEIN);
@@ -297,9 +189,8 @@ void setup() {
   envelope1.sustain(SUSTAIN_LEVEL);
   envelope1.release(RELEASE_TIME);
 
-  // Configure mixers
-  decodeMixer.gain(0, 1.0);  // Internal sidetone
-  decodeMixer.gain(1, 0.0);  // External audio (off initially)
+  startPotSampling();
+  startSessionLog();
 
   // Initialize WiFi communication
   if (wifiEnabled) {
@@ -308,856 +199,429 @@ void setup() {
     Serial.println("WiFi disabled - use serial or OLED interface");
   }
 
-  // Initial setup
-  updateWaveform();
-  updateFrequency();
-  updateVolume();
-  updateOutputRouting();
-  updateToneDetector();
-  initializeKoch();
-
-  sessionStartTime = millis();
+  // Initial setup: push settings to the audio graph, init Koch, draw screen
+  trainerBegin();
 
   Serial.println("Ready! Use buttons, serial, or web interface.");
-  updateDisplay();
+
+  // Everything from here on must run without heap allocation
+  startHeapProbe();
 }
 
 void loop() {
+  // A trace replay stands in for the companion, buttons and controls
+  bool replaying = handleTraceReplay();
+
   // Handle WiFi communication with wifi companion
-  if (wifiEnabled) {
+  if (wifiEnabled && !replaying) {
     handleWiFiComm();
   }
 
-  // Update debouncers
-  updateDebouncers();
+  // Key and button levels that settled inside a debounce lockout
+  pollInputSettle();
 
   // Handle serial commands
   handleSerialCommands();
 
-  // Handle button inputs
-  handleButtons();
-
-  // Handle CW key (manual keying)
-  if (!kochSending) {
-    handleManualKeying();
+  if (!replaying) {
+    // Update controls (pots)
+    updateControls();
   }
 
-  // Handle decoder
-  if (decoderEnabled && !kochSending) {
-    processCWDecoder();
-  }
-
-  // Handle various training modes
-  handleTrainingModes();
+  // Keying, decoder, training modes, display and auto-save
+  trainerTick();
 
-  // Update controls and display
-  updateControls();
+  // Lowest priority: write a finished log block once the keyer is idle
+  serviceSessionLog();
 
-  // Update display periodically
-  if (millis() - lastDisplayUpdate > 100) {
-    updateDisplay();
-    lastDisplayUpdate = millis();
-  }
-
-  // Auto-save statistics every 5 minutes
-  static unsigned long lastSave = 0;
-  if (millis() - lastSave > 300000) {
-    saveSettings();
-    lastSave = millis();
-  }
+  sampleHeapProbe();
 }
 
-void setupPins() {
-  pinMode(KEY_PIN, INPUT_PULLUP);
-
-
-
-
-
-
-  pinMode(MENU_BTN, INPUT_PULLUP);
-  pinMode(ENC_A_PIN, INPUT_PULLUP);
-  pinMode(ENC_B_PIN, INPUT_PULLUP);
-  knob.write(0);
-
-
-  // Setup debouncers
-  keyDebouncer.attach(KEY_PIN);
-  keyDebouncer.interval(5);
-
-
-
-
-
-
-
-
-
-
-
-
-  menuButton.attach(MENU_BTN);
-  menuButton.interval(50);
-
-
-  // Built-in LED for status indication
-  pinMode(LED_BUILTIN, OUTPUT);
-  digitalWrite(LED_BUILTIN, HIGH);
-
-  // WiFi companion reset pin
-  pinMode(WIFI_RST_PIN, OUTPUT);
-  digitalWrite(WIFI_RST_PIN, HIGH);  // keep ESP32 enabled after boot
-
-  // WiFi companion ready input
-  pinMode(WIFI_READY_PIN, INPUT_PULLUP);
+// --------------------
+// Platform interface (trainer_hal.h) for the Teensy 4.1
+uint32_t halMillis() {
+  return millis() + clockSkew;
 }
 
-void updateDebouncers() {
-  keyDebouncer.update();
-
-
-
-
-
-
-  menuButton.update();
+uint32_t halMicros() {
+  return micros();
 }
 
-void handleButtons() {
-  // -------- Detect press start --------
-  if (menuButton.fell()) {
-    buttonDownTime = millis();
-    buttonIsDown = true;
-    shortPressCandidate = true;  // assume short unless long detected
-  }
-
-  // -------- Long-press detection (while held) --------
-  if (buttonIsDown && (millis() - buttonDownTime) >= LONG_PRESS_DURATION) {
-    // Treat as long press once, then ignore until release
-    buttonIsDown = false;
-    shortPressCandidate = false;
-
-    if (inMenu || editMode) {
-      inMenu = false;
-      editMode = false;
-      updateDisplay();
-    }
-  }
-
-  // -------- Handle release --------
-  if (menuButton.rose()) {
-    buttonIsDown = false;
-
-    // If long press already handled, nothing further
-    if (!shortPressCandidate) return;
-
-    // ---- Short-press actions ----
-    if (!inMenu) {
-      inMenu = true;
-      currentMenu = KOCH_MENU;
-      menuSelection = 0;
-      lastEncoderPos = knob.read() / ENCODER_STEPS_PER_DETENT;  // reset baseline
-      updateDisplay();
-    } else if (!editMode) {
-      handleMenuSelection();
-    } else {
-      editMode = false;
-      applySettings();
-      updateDisplay();
-    }
+bool halToneDetected() {
+  // The detector only reports once per analysis window; hold the last result in between
+  static bool toneDetected = false;
+  if (toneDetect1.available()) {
+    toneDetected = toneDetect1.read() > TONE_THRESHOLD;
   }
+  return toneDetected;
 }
 
-void handleMenuSelection() {
-  switch (currentMenu) {
-    case KOCH_MENU:
-      if (menuSelection == 0) {  // Start Koch lesson
-        kochModeEnabled = true;
-        currentPracticeMode = KOCH_TRAINING;
-        startKochLesson();
-        inMenu = false;
-      } else if (menuSelection == 1) {  // Set lesson
-        // Implement lesson selection
-        inMenu = false;
-      }
-      break;
-
-    case PRACTICE_MENU:
-      currentPracticeMode = (PracticeMode)menuSelection;
-      startPracticeMode();
-      inMenu = false;
-      break;
-
-    case SETTINGS_MENU:
-      switch (menuSelection) {
-        case 2:  // Waveform edit
-          editMode = true;
-          break;
-        case 3:  // Output toggle edit
-          editMode = true;
-          break;
-        case 4:  // Decoder toggle
-          decoderEnabled = !decoderEnabled;
-          if (decoderEnabled) {
-            currentCharacter = "";
-            lastCharacterTime = millis();
-            lastWordTime = millis();
-          }
-          applySettings();
-          updateDisplay();
-          break;
-        case 5:  // Input toggle
-          useExternalAudio = !useExternalAudio;
-          decodeMixer.gain(0, useExternalAudio ? 0.0 : 1.0);
-          decodeMixer.gain(1, useExternalAudio ? 1.0 : 0.0);
-          applySettings();
-          updateDisplay();
-          break;
-        case 6:  // Koch Mode toggle
-          kochModeEnabled = !kochModeEnabled;
-          if (kochModeEnabled) {
-            currentPracticeMode = KOCH_TRAINING;
-            startKochLesson();
-          } else {
-            stopKochLesson();
-          }
-          applySettings();
-          updateDisplay();
-          break;
-        default:
-          // Non-editable items (Freq/Vol)
-          break;
-      }
-      // Remain in menu unless entering editMode
-      if (!editMode) {
-        // keep menu open to allow more adjustments
-      }
-      break;
-
-    case STATS_MENU:
-      // Display detailed stats
-      displayDetailedStats();
-      break;
-
-    case QSO_MENU:
-      startQSOSimulation();
-      inMenu = false;
-      break;
-
-    default:
-      inMenu = false;
-      break;
-  }
+void halToneOn() {
+  envelope1.noteOn();
 }
 
-void handlePracticeModeButton() {
-  switch (currentPracticeMode) {
-    case KOCH_TRAINING:
-      if (kochSending || kochListening) {
-        startKochLesson();  // Repeat
-      } else {
-        evaluateKochSession();
-      }
-      break;
-
-    case CALLSIGN_PRACTICE:
-      generateCallsignLesson();
-      break;
-
-    case QSO_SIMULATION:
-      continueQSOSimulation();
-      break;
-
-    case CONTEST_MODE:
-      generateContestExchange();
-      break;
-
-    case CUSTOM_LESSON:
-      generateCustomLesson();
-      break;
-  }
+void halToneOff() {
+  envelope1.noteOff();
 }
 
-void startPracticeMode() {
-  switch (currentPracticeMode) {
-    case KOCH_TRAINING:
-      kochModeEnabled = true;
-      startKochLesson();
-      break;
-
-    case CALLSIGN_PRACTICE:
-      generateCallsignLesson();
-      break;
-
-    case QSO_SIMULATION:
-      startQSOSimulation();
-      break;
-
-    case CONTEST_MODE:
-      generateContestExchange();
-      break;
-
-    case CUSTOM_LESSON:
-      generateCustomLesson();
-      break;
-  }
+// The loader sets the RTC to the PC's time on upload; a coin cell keeps it
+uint32_t halClockSeconds() {
+  return Teensy3Clock.get();
 }
 
-// Helper to initialize a generated lesson and update state/display
-void startLesson(const String& lesson, const char* title) {
-  kochSentText = lesson;
-  kochReceivedText = "";
-  kochCharIndex = 0;
-  kochSendTimer = millis();
-  kochSending = true;
-  kochListening = false;
-  Serial.println(title);
-  Serial.println(lesson);
-  updateDisplay();
+void halStorageRead(int addr, void* dst, size_t len) {
+  uint8_t* p = (uint8_t*)dst;
+  for (size_t i = 0; i < len; i++) p[i] = EEPROM.read(addr + i);
 }
 
-void generateCallsignLesson() {
-  String lesson = "";
-  for (int i = 0; i < 10; i++) {  // 10 callsigns
-    String callsign = generateRandomCallsign();
-    lesson += callsign + " ";
-  }
-
-  startLesson(lesson, "Callsign Practice:");
+void halStorageWrite(int addr, const void* src, size_t len) {
+  const uint8_t* p = (const uint8_t*)src;
+  for (size_t i = 0; i < len; i++) EEPROM.update(addr + i, p[i]);
 }
 
-// Centralised settings application – updates all subsystems after any config change
-void applySettings() {
-  updateFrequency();
-  updateToneDetector();
-  calculateKochTiming();
-  updateDisplay();
-  sendStatusToWiFi();
+void halConsoleWrite(const char* text) {
+  Serial.print(text);
 }
 
-// Helper to read flash string tables and return as Arduino String
-String readProgmemString(const char* const* table, uint8_t index, uint8_t maxLen) {
-  char buf[8];  // sufficient for our small tokens
-  if (index >= maxLen) return String();
-  strcpy_P(buf, (PGM_P)pgm_read_ptr(&table[index]));
-  return String(buf);
+void halLinkWriteLine(const char* line) {
+  Serial1.println(line);
 }
 
-String generateRandomCallsign() {
-  String callsign = "";
-
-  // Choose prefix
-  int prefixIndex = random(CALLSIGN_PREFIXES_COUNT);
-  callsign += readProgmemString((const char* const*)CALLSIGN_PREFIXES, prefixIndex, CALLSIGN_PREFIXES_COUNT);
-
-  // Add number
-  callsign += String(random(0, 10));
-
-  // Add suffix (1-3 letters)
-  int suffixLength = random(1, 4);
-  for (int i = 0; i < suffixLength; i++) {
-    int suffixIndex = random(CALLSIGN_SUFFIXES_COUNT);
-    callsign += readProgmemString((const char* const*)CALLSIGN_SUFFIXES, suffixIndex, CALLSIGN_SUFFIXES_COUNT);
-  }
-
-  return callsign;
+void halLinkWrite(const uint8_t* data, size_t len) {
+  Serial1.write(data, len);
 }
 
-void generateContestExchange() {
-  String exchange = "";
-
-  // Generate contest number
-  static int contestNumber = 1;
-  if (contestNumber < 10) exchange += "00";
-  else if (contestNumber < 100) exchange += "0";
-  exchange += String(contestNumber++) + " ";
-
-  // Add state/province
-  int stateIndex = random(CONTEST_EXCHANGES_COUNT);
-  exchange += readProgmemString((const char* const*)CONTEST_EXCHANGES, stateIndex, CONTEST_EXCHANGES_COUNT) + " ";
-
-  // Repeat for multiple exchanges
-  String lesson = "";
-  for (int i = 0; i < 5; i++) {
-    lesson += generateRandomCallsign() + " " + exchange;
+void beginLinkSerial(uint32_t baud) {
+  Serial1.begin(baud);
+  Serial1.addMemoryForRead(linkRxMemory, sizeof(linkRxMemory));
+  Serial1.addMemoryForWrite(linkTxMemory, sizeof(linkTxMemory));
+  if (halLinkFlowControl()) {
+    Serial1.attachRts(LINK_RTS_PIN);
+    Serial1.attachCts(LINK_CTS_PIN);
   }
-
-  startLesson(lesson, "Contest Practice:");
 }
 
-void generateCustomLesson() {
-  // Generate lesson based on user's weak characters
-  String weakChars = findWeakCharacters();
-  if (weakChars.length() == 0) weakChars = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
-  String lesson = "";
-  for (int i = 0; i < 50; i++) {
-    if (i % 6 == 5) {
-      lesson += " ";
-    } else {
-      lesson += weakChars.charAt(random(weakChars.length()));
-    }
-  }
+void halLinkSetBaud(uint32_t baud) {
+  Serial1.flush();  // the rest goes out at the old rate
+  beginLinkSerial(baud);
+}
 
-  startLesson(lesson, "Custom Lesson (Weak Characters):");
+uint32_t halLinkMaxBaud() {
+  return LINK_MAX_BAUD;
 }
 
-String findWeakCharacters() {
-  String weakChars = "";
-  float threshold = stats.averageAccuracy * 0.8;  // Characters below 80% of average
+// The record queue copies each block in the audio interrupt and takes no more
+// than MONITOR_QUEUE_BLOCKS; when it is full new blocks are dropped, which
+// shows as blocks missing against the time since capture started
+static uint32_t monitorLastMicros = 0;
+static double monitorBlocksDue = 0;  // since capture started; summed so micros() may wrap
+static uint32_t monitorBlocksRead = 0;
+static uint32_t monitorDropped = 0;
 
-  for (int i = 0; i < 26; i++) {
-    if (stats.characterErrors[i] > threshold) {
-      weakChars += char('A' + i);
-    }
+void halMonitorCapture(bool on) {
+  if (on) {
+    monitorQueue.clear();
+    monitorLastMicros = micros();
+    monitorBlocksDue = 0;
+    monitorBlocksRead = 0;
+    monitorDropped = 0;
+    AudioProcessorUsageMaxReset();
+    monitorQueue.begin();
+  } else {
+    monitorQueue.end();
+    monitorQueue.clear();
   }
+}
 
-  return weakChars;
+int halMonitorRead(int16_t* block) {
+  if (monitorQueue.available() == 0) return 0;
+  memcpy(block, monitorQueue.readBuffer(), AUDIO_BLOCK_SAMPLES * sizeof(int16_t));
+  monitorQueue.freeBuffer();
+  monitorBlocksRead++;
+  return AUDIO_BLOCK_SAMPLES;
 }
 
-void handleSerialCommands() {
-  if (Serial.available()) {
-    String command = Serial.readStringUntil('\n');
-    command.trim();
-    command.toUpperCase();
-
-    if (command.startsWith("SPEED ")) {
-      int speed = command.substring(6).toInt();
-      if (speed >= 5 && speed <= 50) {
-        kochSpeed = speed;
-        applySettings();
-        Serial.println("Speed set to " + String(speed) + " WPM");
-      }
-    } else if (command.startsWith("FARNSWORTH ")) {
-      int farnsworth = command.substring(11).toInt();
-      if (farnsworth >= 5 && farnsworth <= kochSpeed) {
-        kochEffectiveSpeed = farnsworth;
-        applySettings();
-        Serial.println("Farnsworth speed set to " + String(farnsworth) + " WPM");
-      }
-    } else if (command.startsWith("LESSON ")) {
-      int lesson = command.substring(7).toInt();
-      if (lesson >= 1 && lesson <= 40) {
-        kochLesson = lesson;
-        initializeKoch();
-        Serial.println("Jumped to lesson " + String(lesson));
-      }
-    } else if (command == "STATS") {
-      displayDetailedStats();
-    } else if (command == "RESET") {
-      resetAllStats();
-      Serial.println("All statistics reset");
-    } else if (command.startsWith("FREQ ")) {
-      int freq = command.substring(5).toInt();
-      if (freq >= 300 && freq <= 1200) {
-        sidetoneFreq = freq;
-        applySettings();
-        Serial.println("Frequency set to " + String(freq) + " Hz");
-      }
-    } else if (command == "HELP") {
-      printHelp();
-    }
-  }
+uint32_t halMonitorDropped() {
+  uint32_t now = micros();
+  monitorBlocksDue += (now - monitorLastMicros) * (AUDIO_SAMPLE_RATE_EXACT / 1e6 / AUDIO_BLOCK_SAMPLES);
+  monitorLastMicros = now;
+  uint32_t due = monitorBlocksDue;
+  uint32_t seen = monitorBlocksRead + monitorQueue.available() + 1;  // one block may be in the graph's hands
+  if (due > seen + monitorDropped) monitorDropped = due - seen;
+  return monitorDropped;
 }
 
-void printHelp() {
-  Serial.println("\n=== COMMAND REFERENCE ===");
-  Serial.println("SPEED [5-50]     - Set character speed");
-  Serial.println("FARNSWORTH [5-50] - Set effective speed");
-  Serial.println("LESSON [1-40]    - Jump to Koch lesson");
-  Serial.println("FREQ [300-1200]  - Set sidetone frequency");
-  Serial.println("STATS            - Show detailed statistics");
-  Serial.println("RESET            - Reset all statistics");
-  Serial.println("HELP             - Show this help");
-  Serial.println("========================\n");
+float halAudioLoadPeak() {
+  return AudioProcessorUsageMax();
 }
 
-void handleManualKeying() {
-  bool currentKeyState = !keyDebouncer.read();
-  if (currentKeyState != keyPressed) {
-    keyPressed = currentKeyState;
-    if (keyPressed) {
-      envelope1.noteOn();
-      keyDownTime = millis();
-    } else {
-      envelope1.noteOff();
-      keyUpTime = millis();
-    }
-    lastKeyChange = millis();
-  }
+void halSpectrumEnable(bool on) {
+  if (on) patchCord10.connect();
+  else patchCord10.disconnect();
 }
 
-void handleTrainingModes() {
-  if (kochModeEnabled) {
-    processKochSending();
+bool halSpectrumRead(float* magnitudes, int firstBin, int count) {
+  if (!fft1024.available()) return false;
+  for (int i = 0; i < count; i++) {
+    magnitudes[i] = fft1024.read(firstBin + i);
   }
+  return true;
 }
 
-// [Previous Koch method functions remain the same]
-void initializeKoch() {
-  kochCharSet = kochLessons[kochLesson - 1];
-  calculateKochTiming();
+bool halLinkFlowControl() {
+  return LINK_RTS_PIN >= 0 && LINK_CTS_PIN >= 0;
 }
 
-void startKochLesson() {
-  kochSentText = generateKochText(50);
-  kochReceivedText = "";
-  kochCharIndex = 0;
-  kochSendTimer = millis();
-  kochSending = true;
-  kochListening = false;
-  kochCorrect = 0;
-  kochTotal = 0;
-
-  Serial.println("\n=== KOCH LESSON " + String(kochLesson) + " ===");
-  Serial.println("Characters: " + kochCharSet);
-  Serial.println("Speed: " + String(kochSpeed) + "/" + String(kochEffectiveSpeed) + " WPM");
-  Serial.println("Text: " + kochSentText);
-  Serial.println("Sending...");
-
-  decodedText = "";
-
-  // Send current lesson text to WiFi
-  sendCurrentTextToWiFi(kochSentText);
-  sendStatusToWiFi();
-
-  updateDisplay();
+void halSetLinkIndicator(bool connected) {
+  digitalWrite(LED_BUILTIN, connected ? LOW : HIGH);
 }
 
-void stopKochLesson() {
-  kochSending = false;
-  kochListening = false;
-  envelope1.noteOff();
-  Serial.println("Training stopped.");
-  updateDisplay();
+void halDisplayShow(const TextScreen& screen) {
+  display.clearDisplay();
+  display.setTextSize(1);
+  display.setTextWrap(false);
+  for (int row = 0; row < SCREEN_TEXT_ROWS; row++) {
+    display.setCursor(0, row * 8);
+    display.print(screen.rows[row]);
+  }
+  display.display();
 }
 
-String generateKochText(int length) {
-  String text = "";
-  for (int i = 0; i < length; i++) {
-    if (i % 6 == 5) {
-      text += " ";
-    } else {
-      int charIndex = random(kochCharSet.length());
-      text += kochCharSet.charAt(charIndex);
-    }
+// --------------------
+// Trace replay: feed due events; at speed x the core clock runs x times faster
+bool handleTraceReplay() {
+  uint32_t real = millis();
+  bool replaying = traceReplaying();
+  if (replaying) {
+    clockSkew += (real - lastClockSample) * (traceReplaySpeed() - 1);
+    replaying = traceReplayPoll();
   }
-  return text;
+  lastClockSample = real;
+  return replaying;
 }
 
-void processKochSending() {
-  if (!kochSending || kochCharIndex >= kochSentText.length()) {
-    if (kochSending) {
-      kochSending = false;
-      kochListening = true;
-      envelope1.noteOff();
-      Serial.println("\nSending complete. Copy received:");
-      updateDisplay();
-    }
+// --------------------
+// SD session log
+void startSessionLog() {
+  if (!SD.begin(BUILTIN_SDCARD)) {
+    Serial.println("No SD card - session log and profiles off");
     return;
   }
-
-  unsigned long currentTime = millis();
-  char currentChar = kochSentText.charAt(kochCharIndex);
-
-  if (currentChar == ' ') {
-    if (currentTime - kochSendTimer >= wordSpaceThreshold) {
-      kochCharIndex++;
-      kochSendTimer = currentTime;
-    }
-  } else {
-    String morseCode = getMorseCode(currentChar);
-    if (sendMorseCharacter(morseCode, currentTime)) {
-      kochCharIndex++;
-      kochSendTimer = currentTime + charSpaceThreshold;
-    }
+  sdCardReady = true;
+  char name[16];
+  for (int i = 0; i < 1000; i++) {
+    snprintf(name, sizeof(name), "CWLOG%03d.BIN", i);
+    if (!SD.exists(name)) break;
   }
+  sessionLogFile = SD.open(name, FILE_WRITE);
+  if (!sessionLogFile) {
+    Serial.println("Session log: cannot create file");
+    return;
+  }
+  Serial.print("Session log: ");
+  Serial.println(name);
+  sessionLogBegin();
 }
 
-bool sendMorseCharacter(String morseCode, unsigned long currentTime) {
-  static int elementIndex = 0;
-  static unsigned long elementTimer = 0;
-  static bool elementState = false;
-
-  if (kochCharIndex == 0 || kochSendTimer <= currentTime) {
-    elementIndex = 0;
-    elementTimer = currentTime;
-    elementState = true;
-    envelope1.noteOn();
-    return false;
-  }
+void serviceSessionLog() {
+  if (!sessionLogFile) return;
+  const uint8_t* block = sessionLogTakeBlock();
+  if (!block) return;
+  // Whole blocks from offset 0 keep every write on a sector boundary
+  sessionLogFile.write(block, SESSION_LOG_BLOCK);
+  sessionLogFile.flush();
+  sessionLogRelease();
+}
 
-  if (elementIndex >= morseCode.length()) {
-    envelope1.noteOff();
-    elementIndex = 0;
-    return true;
-  }
+// --------------------
+// Profile images on the SD card, PROFILEn.CWB. SdFat's FsFile is used
+// directly because it needs no heap, unlike the SD library's File. A new image
+// goes to PROFILEn.TMP first and is renamed over the old one, and a read falls
+// back to the .TMP file, so a reset mid-save keeps one complete image.
+static void profileFileName(int profile, const char* extension, char* name, size_t size) {
+  snprintf(name, size, "PROFILE%d.%s", profile + 1, extension);
+}
+
+bool halProfileWrite(int profile, const uint8_t* data, size_t len) {
+  if (!sdCardReady) return false;
+  char name[16], temp[16];
+  profileFileName(profile, "CWB", name, sizeof(name));
+  profileFileName(profile, "TMP", temp, sizeof(temp));
+  FsFile file = SD.sdfs.open(temp, O_WRONLY | O_CREAT | O_TRUNC);
+  if (!file) return false;
+  bool written = file.write(data, len) == len;
+  file.close();
+  if (!written) return false;
+  SD.sdfs.remove(name);
+  return SD.sdfs.rename(temp, name);
+}
+
+// Session history, HISTORYn.BIN, updated in place a bucket at a time
+bool halHistoryRead(int profile, uint32_t offset, void* dst, size_t len) {
+  if (!sdCardReady) return false;
+  char name[16];
+  snprintf(name, sizeof(name), "HISTORY%d.BIN", profile + 1);
+  FsFile file = SD.sdfs.open(name, O_RDONLY);
+  if (!file) return false;
+  bool ok = file.seekSet(offset) && file.read(dst, len) == (int)len;
+  file.close();
+  return ok;
+}
+
+bool halHistoryWrite(int profile, uint32_t offset, const void* src, size_t len) {
+  if (!sdCardReady) return false;
+  char name[16];
+  snprintf(name, sizeof(name), "HISTORY%d.BIN", profile + 1);
+  FsFile file = SD.sdfs.open(name, O_RDWR | O_CREAT);
+  if (!file) return false;
+  bool ok = file.seekSet(offset) && file.write(src, len) == len;
+  file.close();
+  return ok;
+}
+
+size_t halProfileRead(int profile, uint8_t* dst, size_t max) {
+  if (!sdCardReady) return 0;
+  char name[16];
+  profileFileName(profile, "CWB", name, sizeof(name));
+  if (!SD.sdfs.exists(name)) profileFileName(profile, "TMP", name, sizeof(name));
+  FsFile file = SD.sdfs.open(name, O_RDONLY);
+  if (!file) return 0;
+  int n = file.read(dst, max);
+  file.close();
+  return n > 0 ? n : 0;
+}
+
+// --------------------
+// Heap probe
+size_t heapInUse() {
+  struct mallinfo mi = mallinfo();
+  return mi.uordblks;
+}
 
-  char element = morseCode.charAt(elementIndex);
-  unsigned long elementDuration = (element == '.') ? ditLength : (ditLength * 3);
+void startHeapProbe() {
+  heapProbe.inUseAtSetup = heapInUse();
+  heapProbe.inUse = heapProbe.inUseAtSetup;
+  heapProbe.highWater = heapProbe.inUseAtSetup;
+  heapProbe.changeEvents = 0;
+}
 
-  if (elementState) {
-    if (currentTime - elementTimer >= elementDuration) {
-      envelope1.noteOff();
-      elementState = false;
-      elementTimer = currentTime;
-    }
-  } else {
-    if (currentTime - elementTimer >= ditLength) {
-      elementIndex++;
-      if (elementIndex < morseCode.length()) {
-        envelope1.noteOn();
-        elementState = true;
-        elementTimer = currentTime;
-      }
-    }
+void sampleHeapProbe() {
+  size_t now = heapInUse();
+  if (now != heapProbe.inUse) {
+    heapProbe.changeEvents++;
+    heapProbe.inUse = now;
+    if (now > heapProbe.highWater) heapProbe.highWater = now;
   }
+}
 
-  return false;
+void printHeapProbe() {
+  Serial.println("\n=== HEAP PROBE ===");
+  Serial.printf("In use at setup: %u bytes\n", (unsigned)heapProbe.inUseAtSetup);
+  Serial.printf("In use now: %u bytes\n", (unsigned)heapProbe.inUse);
+  Serial.printf("High water: %u bytes\n", (unsigned)heapProbe.highWater);
+  Serial.printf("Heap changes since setup: %lu\n", (unsigned long)heapProbe.changeEvents);
+  Serial.printf("Lesson arena: %u/%u bytes (peak %u, failures %lu)\n",
+                (unsigned)lessonArena.used(), (unsigned)lessonArena.capacity(),
+                (unsigned)lessonArena.highWater(), (unsigned long)lessonArena.failures());
+  Serial.println("==================\n");
 }
 
-void evaluateKochSession() {
-  if (kochTotal == 0) {
-    Serial.println("No characters to evaluate.");
-    return;
-  }
+void setupPins() {
+  pinMode(KEY_PIN, INPUT_PULLUP);
 
-  kochAccuracy = (float)kochCorrect / kochTotal * 100.0;
-  stats.lessonAccuracy[kochLesson - 1] = kochAccuracy;
 
-  Serial.println("\n=== LESSON RESULTS ===");
-  Serial.println("Accuracy: " + String(kochAccuracy, 1) + "% (" + String(kochCorrect) + "/" + String(kochTotal) + ")");
 
-  if (kochAccuracy >= 90.0) {
-    kochLesson++;
-    if (kochLesson > 40) kochLesson = 40;
-    kochCharSet = kochLessons[kochLesson - 1];
-    Serial.println("Excellent! Advancing to lesson " + String(kochLesson));
 
-    if (kochLesson > stats.highestLesson) {
-      stats.highestLesson = kochLesson;
-    }
-  } else {
-    Serial.println("Practice more with lesson " + String(kochLesson));
-  }
 
-  stats.sessionsCompleted++;
-  saveSettings();
-  calculateKochTiming();
-  updateDisplay();
-}
 
-void calculateKochTiming() {
-  ditLength = 1200.0 / kochSpeed;
-  charSpaceThreshold = ditLength * 3.0;
-  wordSpaceThreshold = (1200.0 / kochEffectiveSpeed) * 7.0;
-}
+  pinMode(MENU_BTN, INPUT_PULLUP);
+  pinMode(ENC_A_PIN, INPUT_PULLUP);
+  pinMode(ENC_B_PIN, INPUT_PULLUP);
 
-String getMorseCode(char c) {
-  for (int i = 0; i < morseTableSize; i++) {
-    if (morseTable[i].character == c) {
-      return morseTable[i].code;
-    }
-  }
-  return "";
-}
+  // Input interrupts push timestamped events into inputQueue
+  keyInput.pressed = digitalRead(KEY_PIN) == LOW;
+  buttonInput.pressed = digitalRead(MENU_BTN) == LOW;
+  encoderState = digitalRead(ENC_A_PIN) | (digitalRead(ENC_B_PIN) << 1);
+  attachInterrupt(digitalPinToInterrupt(KEY_PIN), keyIsr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(MENU_BTN), buttonIsr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(ENC_A_PIN), encoderIsr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(ENC_B_PIN), encoderIsr, CHANGE);
 
-void processCWDecoder() {
-  bool toneDetected = toneDetect1.available() && toneDetect1.read() > TONE_THRESHOLD;
-  unsigned long currentTime = millis();
-
-  if (toneDetected != lastToneState) {
-    if (toneDetected) {
-      if (lastToneState == false && currentTime - lastKeyChange > 50) {
-        unsigned long spaceLength = currentTime - lastKeyChange;
-        processSpace(spaceLength);
-      }
-    } else {
-      if (lastToneState == true && currentTime - lastKeyChange > 30) {
-        unsigned long toneLength = currentTime - lastKeyChange;
-        processElement(toneLength);
-      }
-    }
-    lastKeyChange = currentTime;
-    lastToneState = toneDetected;
-  }
 
-  if (currentCharacter.length() > 0 && currentTime - lastCharacterTime > charSpaceThreshold) {
-    processCharacter();
-  }
+  // Built-in LED for status indication
+  pinMode(LED_BUILTIN, OUTPUT);
+  digitalWrite(LED_BUILTIN, HIGH);
 
-  if (currentTime - lastWordTime > wordSpaceThreshold && decodedText.length() > 0 && !decodedText.endsWith(" ")) {
-    decodedText += " ";
-    if (!kochModeEnabled) Serial.print(" ");
-  }
-}
+  // WiFi companion reset pin
+  pinMode(WIFI_RST_PIN, OUTPUT);
+  digitalWrite(WIFI_RST_PIN, HIGH);  // keep ESP32 enabled after boot
 
-void processElement(unsigned long duration) {
-  if (stats.totalDits + stats.totalDahs < 10) {
-    if (duration < 150) {
-      currentCharacter += ".";
-      stats.totalDits++;
-    } else {
-      currentCharacter += "-";
-      stats.totalDahs++;
-    }
-  } else {
-    float avgDitLength = ditLength;
-    dahThreshold = avgDitLength * 2.5;
-
-    if (duration < dahThreshold) {
-      currentCharacter += ".";
-      stats.totalDits++;
-      ditLength = (ditLength * 0.9) + (duration * 0.1);
-    } else {
-      currentCharacter += "-";
-      stats.totalDahs++;
-    }
-  }
+  // WiFi companion ready input
+  pinMode(WIFI_READY_PIN, INPUT_PULLUP);
+}
 
-  lastCharacterTime = millis();
-  charSpaceThreshold = ditLength * 3.0;
-  wordSpaceThreshold = ditLength * 7.0;
+// --------------------
+// Input interrupts
+void sampleEdge(EdgeInput& input) {
+  bool pressed = digitalReadFast(input.pin) == LOW;
+  uint32_t now = halMillis();
+  if (pressed == input.pressed || now - input.lastEdge < input.lockoutMs) return;
+  input.pressed = pressed;
+  input.lastEdge = now;
+  inputQueue.push({ now, input.type, (int8_t)pressed });
 }
 
-void processSpace(unsigned long duration) {
-  if (duration > wordSpaceThreshold && currentCharacter.length() == 0) {
-    if (!decodedText.endsWith(" ")) {
-      decodedText += " ";
-      if (!kochModeEnabled) Serial.print(" ");
-    }
-    lastWordTime = millis();
-  }
+void keyIsr() {
+  sampleEdge(keyInput);
 }
 
-void processCharacter() {
-  char decodedChar = lookupMorseCharacter(currentCharacter);
-
-  if (kochListening && decodedChar != '?') {
-    kochReceivedText += decodedChar;
-    kochTotal++;
-
-    if (kochTotal <= kochSentText.length()) {
-      char expectedChar = kochSentText.charAt(kochTotal - 1);
-      if (decodedChar == expectedChar) {
-        kochCorrect++;
-        Serial.print(decodedChar);
-        sendDecodedTextToWiFi(String(decodedChar));
-      } else {
-        Serial.print("[" + String(decodedChar) + "]");
-        sendDecodedTextToWiFi("[" + String(decodedChar) + "]");
-        // Track character errors
-        if (expectedChar >= 'A' && expectedChar <= 'Z') {
-          stats.characterErrors[expectedChar - 'A']++;
-        }
-      }
-    }
-  } else if (!kochModeEnabled) {
-    if (decodedChar != '?') {
-      decodedText += decodedChar;
-      Serial.print(decodedChar);
-      sendDecodedTextToWiFi(String(decodedChar));
-      stats.charactersDecoded++;
-
-      if (stats.charactersDecoded > 0) {
-        float timeMinutes = (millis() - sessionStartTime) / 60000.0;
-        currentWPM = (stats.charactersDecoded * 2.4) / timeMinutes;
-        if (currentWPM > stats.bestWPM) {
-          stats.bestWPM = currentWPM;
-        }
-      }
-
-      if (stats.charactersDecoded % 10 == 0) {
-        Serial.print(" |Stats: ");
-        Serial.print(stats.totalDits);
-        Serial.print("/");
-        Serial.print(stats.totalDahs);
-        Serial.print("/");
-        Serial.print(stats.charactersDecoded);
-        Serial.print("/");
-        Serial.print(currentWPM, 1);
-        Serial.println("wpm|");
-      }
-    } else if (currentCharacter.length() > 0) {
-      Serial.print("?");
-      sendDecodedTextToWiFi("?");
-    }
-  }
+void buttonIsr() {
+  sampleEdge(buttonInput);
+}
 
-  currentCharacter = "";
-  lastWordTime = millis();
+void pollInputSettle() {
+  noInterrupts();
+  sampleEdge(keyInput);
+  sampleEdge(buttonInput);
+  interrupts();
 }
 
-char lookupMorseCharacter(String morseCode) {
-  for (int i = 0; i < morseTableSize; i++) {
-    if (morseTable[i].code == morseCode) {
-      return morseTable[i].character;
-    }
+// Same transition table as the Encoder library: index is old A/B | new A/B << 2
+void encoderIsr() {
+  static const int8_t QUADRATURE[16] = { 0, 1, -1, 2, -1, 0, -2, 1, 1, -2, 0, -1, 2, -1, 1, 0 };
+  uint8_t state = digitalReadFast(ENC_A_PIN) | (digitalReadFast(ENC_B_PIN) << 1);
+  int8_t steps = encoderSteps + QUADRATURE[encoderState | (state << 2)];
+  encoderState = state;
+  if (steps >= ENCODER_STEPS_PER_DETENT || steps <= -ENCODER_STEPS_PER_DETENT) {
+    int8_t detents = steps / ENCODER_STEPS_PER_DETENT;
+    steps -= detents * ENCODER_STEPS_PER_DETENT;
+    inputQueue.push({ halMillis(), INPUT_ENCODER, detents });
   }
-  return '?';
+  encoderSteps = steps;
 }
 
-// --------------------
-// UI knob / button polling
-// Rotary encoder helper: return number of items in each menu
-int getMenuItemCount(MenuMode menu) {
-  switch (menu) {
-    case KOCH_MENU: return 3;      // Start, Lesson, Speed
-    case PRACTICE_MENU: return 5;  // Koch, Callsign, QSO, Contest, Custom
-    case SETTINGS_MENU: return 7;  // Freq, Vol, Waveform, Output, Decoder, Input, Koch Mode
-    case STATS_MENU: return 1;     // Stats page only
-    case QSO_MENU: return 3;       // Start, Contest, Ragchew
-    default: return 4;
+void handleSerialCommands() {
+  // Only the bytes already here, and at most one command per pass; a pasted
+  // batch waits in the USB buffer rather than delaying the keyer
+  int n = Serial.available();
+  while (n-- > 0) {
+    if (consoleReceiveByte(Serial.read())) break;
   }
 }
 
 void updateControls() {
-  // Rotary encoder navigation and button handling
-  long encPos = knob.read() / ENCODER_STEPS_PER_DETENT;  // convert raw counts to detent steps
-  if (encPos != lastEncoderPos) {
-    int delta = encPos - lastEncoderPos;
-    lastEncoderPos = encPos;
-
-    if (inMenu && !editMode) {
-      int itemCount = getMenuItemCount(currentMenu);
-      menuSelection = (menuSelection + delta + itemCount) % itemCount;
-      updateDisplay();
-    } else if (editMode) {
-      switch (currentMenu) {
-        case SETTINGS_MENU:
-          if (menuSelection == 2) {  // Waveform
-            currentWaveform = (currentWaveform + delta + 4) % 4;
-            updateWaveform();
-          } else if (menuSelection == 3) {  // Output
-            useHeadphones = !useHeadphones;
-            updateOutputRouting();
-          }
-          break;
-        default:
-          break;
-      }
-      updateDisplay();
-    }
-  }
-
-  // Button handling removed – handled exclusively in handleButtons() using Bounce2 debouncer to avoid conflicts
+  // Encoder and buttons arrive as events through inputQueue (trainer_input.cpp)
 
-  if (millis() - lastFreqUpdate > 100) {
-    float newFreq = mapFloat(analogRead(FREQ_POT), 0, 1023, 300.0, 1200.0);
-    if (abs(newFreq - sidetoneFreq) > 5.0) {
-      sidetoneFreq = newFreq;
-      applySettings();
-      lastFreqUpdate = millis();
-    }
+  // Pots: only settled changes from the background filters get through
+  uint16_t potValue;
+  if (freqPot.update(potValue)) {
+    sidetoneFreq = mapFloat(potValue, 0, POT_ADC_MAX, 300.0, 1200.0);
+    applySettings();
   }
 
-  if (millis() - lastVolumeUpdate > 100) {
-    float newVolume = mapFloat(analogRead(VOLUME_POT), 0, 1023, 0.0, 1.0);
-    if (abs(newVolume - volume) > 0.05) {
-      volume = newVolume;
-      updateVolume();
-      lastVolumeUpdate = millis();
-    }
+  if (volumePot.update(potValue)) {
+    volume = mapFloat(potValue, 0, POT_ADC_MAX, 0.0, 1.0);
+    updateVolume();
   }
 
   // Speed control from potentiometer
@@ -1170,217 +634,31 @@ void updateControls() {
   }
 }
 
-void updateDisplay() {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(0, 0);
-
-  if (inMenu) {
-    displayMenu();
-  } else {
-    displayMainScreen();
-  }
-
-  display.display();
-}
-
-void displayMenu() {
-  int cursorIndex = 0;
-  switch (currentMenu) {
-    case KOCH_MENU:
-      display.println("KOCH TRAINING");
-      cursorIndex = 0;
-      display.println("> Start Lesson");
-      display.println("  Set Lesson #");
-      display.println("  Speed Control");
-      break;
-
-    case PRACTICE_MENU:
-      display.println("PRACTICE MODES");
-      display.println("- Koch Method");
-      display.println("- Callsigns");
-      display.println("- QSO Simulation");
-      display.println("- Contest Mode");
-      display.println("- Custom Lesson");
-      break;
-
-    case SETTINGS_MENU:
-      display.println("SETTINGS");
-      display.printf("Freq: %.0f Hz\n", sidetoneFreq);
-      display.printf("Vol: %.0f%%\n", volume * 100);
-      display.println("Waveform: " + String(waveformNames[currentWaveform]));
-      display.println("Output: " + String(useHeadphones ? "HP" : "SPK"));
-      display.println("Decoder: " + String(decoderEnabled ? "On" : "Off"));
-      display.println("Input: " + String(useExternalAudio ? "EXT" : "INT"));
-      display.println("Koch Mode: " + String(kochModeEnabled ? "On" : "Off"));
-      break;
-
-    case STATS_MENU:
-      display.println("STATISTICS");
-      display.printf("Sessions: %lu\n", stats.sessionsCompleted);
-      display.printf("Best WPM: %.1f\n", stats.bestWPM);
-      display.printf("Chars: %lu\n", stats.charactersDecoded);
-      display.printf("Accuracy: %.1f%%\n", stats.averageAccuracy);
-      break;
-
-    case QSO_MENU:
-      display.println("QSO SIMULATOR");
-      display.println("- Start QSO");
-      display.println("- Contest Mode");
-      display.println("- Ragchew");
-      break;
-
-    default:
-      display.println("MAIN MENU");
-      break;
-  }
+// --------------------
+// Background pot sampling
+void potTimerIsr() {
+  adc.adc0->startSingleRead(potChannel == 0 ? FREQ_POT : VOLUME_POT);
 }
 
-void displayMainScreen() {
-  // Line 1: Mode and lesson
-  if (kochModeEnabled) {
-    display.printf("Koch L%d: %s\n", kochLesson, kochCharSet.c_str());
+void potAdcIsr() {
+  uint16_t raw = adc.adc0->readSingle();
+  if (potChannel == 0) {
+    freqPot.addSample(raw);
   } else {
-    display.printf("Mode: %s\n", practiceModeNames[currentPracticeMode]);
-  }
-
-  // Line 2: Frequency and waveform
-  display.printf("%.0fHz %s\n", sidetoneFreq, waveformNames[currentWaveform]);
-
-  // Line 3: Speed and volume
-  display.printf("Spd:%d/%d Vol:%.0f%%\n", kochSpeed, kochEffectiveSpeed, volume * 100);
-
-  // Line 4: Status indicators
-  String status = "";
-  status += decoderEnabled ? "DEC " : "";
-  status += useHeadphones ? "HP " : "SPK ";
-  status += useExternalAudio ? "EXT " : "INT ";
-  status += (wifiEnabled && espConnected) ? "WiFi" : "";
-  display.println(status);
-
-  // Line 5-6: Current activity
-  if (kochSending) {
-    display.println("Sending...");
-    display.printf("Char %d/%d\n", kochCharIndex, kochSentText.length());
-  } else if (kochListening) {
-    display.println("Listening...");
-    display.printf("Acc: %.1f%%\n", kochAccuracy);
-  } else if (stats.charactersDecoded > 0) {
-    display.printf("WPM: %.1f\n", currentWPM);
-    display.printf("Total: %lu chars\n", stats.charactersDecoded);
-  } else if (wifiEnabled && espConnected) {
-    display.println("WiFi Ready");
-    display.println("Web control active");
-  }
-
-  // Line 7-8: Recent decoded text (last 21 chars)
-  String recentText = decodedText;
-  if (recentText.length() > 21) {
-    recentText = recentText.substring(recentText.length() - 21);
-  }
-  display.println(recentText);
-}
-
-void displayDetailedStats() {
-  Serial.println("\n=== DETAILED STATISTICS ===");
-  Serial.printf("Total Sessions: %lu\n", stats.sessionsCompleted);
-  Serial.printf("Characters Decoded: %lu\n", stats.charactersDecoded);
-  Serial.printf("Best WPM: %.1f\n", stats.bestWPM);
-  Serial.printf("Training Time: %.1f hours\n", stats.totalTrainingMinutes / 60.0);
-  Serial.printf("Highest Koch Lesson: %d\n", stats.highestLesson);
-  Serial.printf("Average Accuracy: %.1f%%\n", stats.averageAccuracy);
-
-  Serial.println("\nCharacter Error Counts:");
-  for (int i = 0; i < 26; i++) {
-    if (stats.characterErrors[i] > 0) {
-      Serial.printf("%c: %lu errors\n", 'A' + i, stats.characterErrors[i]);
-    }
-  }
-
-  Serial.println("\nKoch Lesson Accuracy:");
-  for (int i = 0; i < min(40, stats.highestLesson); i++) {
-    if (stats.lessonAccuracy[i] > 0) {
-      Serial.printf("Lesson %d: %.1f%%\n", i + 1, stats.lessonAccuracy[i]);
-    }
+    volumePot.addSample(raw);
   }
-  Serial.println("========================\n");
-}
-
-void resetAllStats() {
-  memset(&stats, 0, sizeof(stats));
-  stats.bestWPM = 0;
-  stats.averageAccuracy = 0;
-  kochLesson = 1;
-  initializeKoch();
-  saveSettings();
-}
-
-// Apply values from EEPROM struct to runtime globals
-void syncSettingsToGlobals() {
-  sidetoneFreq = deviceSettings.sidetoneFreq;
-  volume = deviceSettings.volume;
-  currentWaveform = deviceSettings.waveform;
-  useHeadphones = deviceSettings.useHeadphones;
-  decoderEnabled = deviceSettings.decoderEnabled;
-  useExternalAudio = deviceSettings.useExternalAudio;
-  kochModeEnabled = deviceSettings.kochModeEnabled;
+  potChannel ^= 1;
 }
 
-// Copy current globals into struct before persisting
-void syncGlobalsToSettings() {
-  deviceSettings.sidetoneFreq = sidetoneFreq;
-  deviceSettings.volume = volume;
-  deviceSettings.waveform = currentWaveform;
-  deviceSettings.useHeadphones = useHeadphones;
-  deviceSettings.decoderEnabled = decoderEnabled;
-  deviceSettings.useExternalAudio = useExternalAudio;
-  deviceSettings.kochModeEnabled = kochModeEnabled;
+void startPotSampling() {
+  adc.adc0->setResolution(12);
+  adc.adc0->setAveraging(4);
+  adc.adc0->setConversionSpeed(ADC_CONVERSION_SPEED::MED_SPEED);
+  adc.adc0->setSamplingSpeed(ADC_SAMPLING_SPEED::MED_SPEED);
+  adc.adc0->enableInterrupts(potAdcIsr);
+  potTimer.begin(potTimerIsr, POT_SAMPLE_PERIOD_US);
 }
 
-void loadSettings() {
-  EEPROM.get(STATS_ADDR, stats);
-  EEPROM.get(KOCH_LESSON_ADDR, kochLesson);
-  EEPROM.get(SETTINGS_ADDR, deviceSettings);
-
-  // If first run, set reasonable defaults
-  if (isnan(deviceSettings.sidetoneFreq) || deviceSettings.sidetoneFreq < 100.0 || deviceSettings.sidetoneFreq > 2000.0) {
-    deviceSettings = { 600.0, 0.5, 0, true, true, false, false };
-  }
-  syncSettingsToGlobals();
-
-  // Validate loaded data
-  if (kochLesson < 1 || kochLesson > 40) {
-    kochLesson = 1;
-  }
-
-  // Calculate average accuracy
-  float totalAccuracy = 0;
-  int validLessons = 0;
-  for (int i = 0; i < 40; i++) {
-    if (stats.lessonAccuracy[i] > 0) {
-      totalAccuracy += stats.lessonAccuracy[i];
-      validLessons++;
-    }
-  }
-  if (validLessons > 0) {
-    stats.averageAccuracy = totalAccuracy / validLessons;
-  }
-}
-
-void saveSettings() {
-  syncGlobalsToSettings();
-  stats.totalTrainingMinutes += (millis() - sessionStartTime) / 60000.0;
-  stats.lastSessionTime = millis();
-
-  EEPROM.put(STATS_ADDR, stats);
-  EEPROM.put(KOCH_LESSON_ADDR, kochLesson);
-
-  EEPROM.put(SETTINGS_ADDR, deviceSettings);
-
-  sessionStartTime = millis();  // Reset session timer
-}
-
-
 void updateWaveform() {
   mixer1.gain(0, 0);
   mixer1.gain(1, 0);
@@ -1424,6 +702,11 @@ void updateOutputRouting() {
   }
 }
 
+void updateAudioInput() {
+  decodeMixer.gain(0, useExternalAudio ? 0.0 : 1.0);
+  decodeMixer.gain(1, useExternalAudio ? 1.0 : 0.0);
+}
+
 float mapFloat(float x, float in_min, float in_max, float out_min, float out_max) {
   return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
 }
@@ -1457,41 +740,36 @@ void initializeWiFiComm() {
   // Begin UART handshake
   Serial1.println("TEENSY:READY");
 
+  // The PONG handler (processWiFiMessage) marks the companion connected
+  bool readySignal = espConnected;
   unsigned long timeout = millis() + 5000;
   while (millis() < timeout && !espConnected) {
-    if (Serial1.available()) {
-      String response = Serial1.readStringUntil('\n');
-      response.trim();
-      if (response == MSG_PONG) {
-        espConnected = true;
-        lastWiFiHeartbeat = millis();
-        digitalWrite(LED_BUILTIN, LOW);
-        Serial.println("WiFi companion connected");
-      }
+    while (Serial1.available()) {
+      linkReceiveByte(Serial1.read());
     }
   }
+  if (espConnected && !readySignal) Serial.println("WiFi companion connected");
 
   if (!espConnected) {
     Serial.println("WiFi companion not responding. Disabling WiFi features.");
     wifiEnabled = false;
   } else {
-    // Send initial status/stats so web UI is populated
+    // Offer frames, then send initial status/stats so web UI is populated
+    linkSendHello();
     sendStatusToWiFi();
     sendStatsToWiFi();
   }
 }
 
 void handleWiFiComm() {
-  // Check for incoming commands from wifi companion
-  if (Serial1.available()) {
-    String wifiIncomingData = Serial1.readStringUntil('\n');
-    wifiIncomingData.trim();
-    processWiFiMessage(wifiIncomingData);
+  // Check for incoming lines and frames from wifi companion
+  while (Serial1.available()) {
+    linkReceiveByte(Serial1.read());
   }
 
   // Send periodic heartbeat ping to ESP32-S3 WiFi companion
   if (espConnected && millis() - lastPingTime > PING_INTERVAL) {
-    Serial1.println(MSG_PING);
+    linkPing();
     lastPingTime = millis();
   }
 
@@ -1501,6 +779,7 @@ void handleWiFiComm() {
       espConnected = false;
       digitalWrite(LED_BUILTIN, HIGH);
       Serial.println("WiFi companion heartbeat lost");
+      linkDown();  // a reset companion comes back at the default rate
     }
     // Attempt recovery every 10 seconds
     static unsigned long lastRecovery = 0;
@@ -1519,165 +798,3 @@ void handleWiFiComm() {
     }
   }
 }
-
-void processWiFiMessage(String message) {
-  // Strip optional ESP32 debug prefix
-  if (message.startsWith("TEENSY >> ")) {
-    message = message.substring(10);
-  }
-  message.trim();
-
-  // --- ESP32-S3 protocol handling ---
-  if (message == MSG_PONG) {
-    lastWiFiHeartbeat = millis();
-    espConnected = true;
-    digitalWrite(LED_BUILTIN, LOW);
-  } else if (message == "GET_STATUS") {
-    sendStatusToWiFi();
-  } else if (message == "GET_STATS") {
-    sendStatsToWiFi();
-  } else if (message == "START") {
-    startPracticeMode();
-    sendStatusToWiFi();
-  } else if (message == "STOP") {
-    stopKochLesson();
-    sendStatusToWiFi();
-  } else if (message == "RESET") {
-    resetAllStats();
-    sendStatusToWiFi();
-  } else
-
-    // Deprecated: original firmware expected a separate HEARTBEAT message which the ESP32 no longer sends.
-    // PONG handling (above) now refreshes lastWiFiHeartbeat, so ignore any legacy HEARTBEAT string.
-    if (message == MSG_HEARTBEAT) {
-      // Intentionally left blank for backward compatibility
-    } else if (message == MSG_READY_ESP01 || message == MSG_READY_ESP32) {
-      espConnected = true;
-      lastWiFiHeartbeat = millis();
-      digitalWrite(LED_BUILTIN, LOW);
-      Serial.println("WiFi companion reconnected");
-      // Send current status
-      sendStatusToWiFi();
-      sendStatsToWiFi();
-    } else if (message.startsWith("TEENSY:")) {
-      processRemoteCommand(message.substring(7));
-    }
-}
-
-void processRemoteCommand(String command) {
-  command.trim();
-  Serial.println("WiFi Command: " + command);
-
-  if (command == "START_KOCH") {
-    kochModeEnabled = true;
-    currentPracticeMode = KOCH_TRAINING;
-    startKochLesson();
-  } else if (command == "CALLSIGN_PRACTICE") {
-    currentPracticeMode = CALLSIGN_PRACTICE;
-    generateCallsignLesson();
-  } else if (command == "QSO_SIMULATION") {
-    currentPracticeMode = QSO_SIMULATION;
-    startQSOSimulation();
-  } else if (command == "TOGGLE_DECODER") {
-    decoderEnabled = !decoderEnabled;
-    if (decoderEnabled) {
-      currentCharacter = "";
-      lastCharacterTime = millis();
-      lastWordTime = millis();
-    }
-  } else if (command.startsWith("SET_FREQ:")) {
-    int freq = command.substring(9).toInt();
-    if (freq >= 300 && freq <= 1200) {
-      sidetoneFreq = freq;
-      applySettings();
-    }
-  } else if (command.startsWith("SET_SPEED:")) {
-    int speed = command.substring(10).toInt();
-    if (speed >= 5 && speed <= 50) {
-      kochSpeed = speed;
-      kochEffectiveSpeed = max(5, speed * 0.6);  // Auto-adjust Farnsworth
-      applySettings();
-    }
-  } else if (command.startsWith("SET_LESSON:")) {
-    int lesson = command.substring(11).toInt();
-    if (lesson >= 1 && lesson <= 40) {
-      kochLesson = lesson;
-      initializeKoch();
-    }
-  } else if (command == "STOP_TRAINING") {
-    stopKochLesson();
-  } else if (command == "REPEAT_LESSON") {
-    if (kochModeEnabled) {
-      startKochLesson();
-    }
-  } else if (command == "EVALUATE_SESSION") {
-    if (kochModeEnabled) {
-      evaluateKochSession();
-    }
-  }
-
-  // Send updated status after processing command
-  sendStatusToWiFi();
-}
-
-void sendStatusToWiFi() {
-  if (!wifiEnabled || !espConnected) return;
-
-  String status = "STATUS:";
-  status += "LESSON=" + String(kochLesson) + ",";
-  status += "FREQ=" + String(sidetoneFreq, 0) + ",";
-  status += "SPEED=" + String(kochSpeed) + ",";
-  status += "EFFSPEED=" + String(kochEffectiveSpeed) + ",";
-  status += "ACC=" + String(kochAccuracy, 1) + ",";
-  status += "DEC=" + String(decoderEnabled ? 1 : 0) + ",";
-  status += "KOCH=" + String(kochModeEnabled ? 1 : 0) + ",";
-  status += "WAVE=" + String(waveformNames[currentWaveform]) + ",";
-  status += "OUT=" + String(useHeadphones ? "Headphones" : "Speaker") + ",";
-  status += "SEND=" + String(kochSending ? 1 : 0) + ",";
-  status += "LISTEN=" + String(kochListening ? 1 : 0);
-
-  const unsigned long MIN_STATUS_INTERVAL = 1000;  // ms
-  if (millis() - lastStatusSentTime < MIN_STATUS_INTERVAL) {
-    return;  // throttle to 1 msg/sec
-  }
-  if (status != lastStatusSent || millis() - lastStatusSentTime > STATUS_KEEPALIVE_INTERVAL) {
-    Serial1.println(status);
-    lastStatusSent = status;
-    lastStatusSentTime = millis();
-  }
-}
-
-void sendStatsToWiFi() {
-  if (!wifiEnabled || !espConnected) return;
-
-  String statsMsg = "STATS:";
-  statsMsg += "SESSIONS=" + String(stats.sessionsCompleted) + ",";
-  statsMsg += "CHARS=" + String(stats.charactersDecoded) + ",";
-  statsMsg += "BESTWPM=" + String(stats.bestWPM, 1);
-
-  Serial1.println(statsMsg);
-}
-
-void sendDecodedTextToWiFi(String text) {
-  if (!wifiEnabled || !espConnected) return;
-
-  // Send decoded characters to WiFi module
-  Serial1.println("DECODED:" + text);
-}
-
-void sendCurrentTextToWiFi(String text) {
-  if (!wifiEnabled || !espConnected) return;
-
-  // Send current lesson text to WiFi module
-  Serial1.println("CURRENT:" + text);
-}
-
-// -------------------------------------------------------------------------
-//  Stub implementations (TODO: implement full functionality later)
-void startQSOSimulation() {
-  // Placeholder – future QSO simulation setup
-}
-
-void continueQSOSimulation() {
-  // Placeholder – continue / advance QSO simulation
-}
\ No newline at end of file
@@ -0,0 +1,82 @@
+// Converts a binary session log (CWLOGnnn.BIN from the SD card, or a
+// cw_sim --log file) to CSV on stdout.
+//
+//   ./build/cwlog2csv CWLOG000.BIN > session.csv
+
+#include <stdio.h>
+#include <string.h>
+#include "../trainer_sessionlog.h"
+
+static const char* typeName(uint8_t type) {
+  switch (type) {
+    case SLOG_CHAR: return "char";
+    case SLOG_SESSION_START: return "start";
+    case SLOG_SESSION_END: return "end";
+    default: return "unknown";
+  }
+}
+
+// Characters go out quoted so ',' and '"' survive
+static void printChar(char c) {
+  if (c == 0) return;
+  if (c == '"') printf("\"\"\"\"");
+  else printf("\"%c\"", c);
+}
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s LOGFILE\n", argv[0]);
+    return 2;
+  }
+  FILE* f = fopen(argv[1], "rb");
+  if (!f) {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 2;
+  }
+
+  uint8_t block[SESSION_LOG_BLOCK];
+  SessionLogHeader header;
+  if (fread(block, 1, sizeof(block), f) != sizeof(block)) {
+    fprintf(stderr, "%s: too short for a session log\n", argv[1]);
+    return 1;
+  }
+  memcpy(&header, block, sizeof(header));
+  if (memcmp(header.magic, "CWLOG1", sizeof(header.magic)) != 0 || header.version != SESSION_LOG_VERSION ||
+      header.recordSize != sizeof(SessionLogRecord) || header.blockSize != SESSION_LOG_BLOCK) {
+    fprintf(stderr, "%s: not a version %u session log\n", argv[1], (unsigned)SESSION_LOG_VERSION);
+    return 1;
+  }
+
+  printf("seq,time_ms,type,mode,lesson,scored,external,expected,decoded,correct,wpm,gap_ms,elements");
+  for (int i = 1; i <= SESSION_LOG_MAX_ELEMENTS; i++) printf(",e%d_ms", i);
+  printf("\n");
+
+  unsigned long records = 0;
+  while (fread(block, 1, sizeof(block), f) == sizeof(block)) {
+    for (size_t off = 0; off + sizeof(SessionLogRecord) <= sizeof(block); off += sizeof(SessionLogRecord)) {
+      SessionLogRecord r;
+      memcpy(&r, block + off, sizeof(r));
+      if (r.type == SLOG_PAD) continue;
+
+      printf("%u,%lu,%s,%u,%u,%d,%d,", (unsigned)r.sequence, (unsigned long)r.time, typeName(r.type),
+             (unsigned)r.mode, (unsigned)r.lesson, (r.flags & 0x01) != 0, (r.flags & 0x02) != 0);
+      printChar(r.expected);
+      printf(",");
+      printChar(r.decoded);
+      printf(",");
+      if (r.type == SLOG_CHAR && r.expected) printf("%d", r.expected == r.decoded);
+      printf(",%.1f,%u,%u", r.wpmX10 / 10.0, (unsigned)r.gapBefore, (unsigned)r.elementCount);
+      // Session records carry their counts in the element slots
+      int fields = r.type == SLOG_CHAR ? r.elementCount : 2;
+      for (int i = 0; i < SESSION_LOG_MAX_ELEMENTS; i++) {
+        if (i < fields) printf(",%u", (unsigned)r.elements[i]);
+        else printf(",");
+      }
+      printf("\n");
+      records++;
+    }
+  }
+  fclose(f);
+  fprintf(stderr, "%lu records\n", records);
+  return 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+/* Just enough of ESP-IDF for the host tools to build the companion's
+ * trainer_protocol.c and trainer_status.c on Linux; link_fuzz.cpp and
+ * status_stress.cpp implement the functions. */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "../esp_log.h"
+#include "../freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int uart_port_t;
+typedef int esp_err_t;
+
+#define UART_NUM_0 0
+#define UART_NUM_1 1
+
+int uart_write_bytes(uart_port_t port, const void *data, size_t len);
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks);
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud);
+
+#ifdef __cplusplus
+}
+#endif
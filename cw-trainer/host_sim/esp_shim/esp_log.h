@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Printed only with link_fuzz --verbose */
+void shim_log(char level, const char *tag, const char *format, ...) __attribute__((format(printf, 3, 4)));
+uint32_t esp_log_timestamp(void);
+
+#define ESP_LOGE(tag, ...) shim_log('E', tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) shim_log('W', tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) shim_log('I', tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) shim_log('D', tag, __VA_ARGS__)
+
+#ifdef __cplusplus
+}
+#endif
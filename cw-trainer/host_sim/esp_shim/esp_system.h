@@ -0,0 +1,11 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void esp_restart(void);  /* counted by link_fuzz; the process carries on */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,167 @@
+// Throughput and allocation check for the lesson generators: streams a long
+// lesson from each one in small chunks and reports characters per second and
+// heap allocations made while generating (expected: 0). Also checks that a
+// seed reproduces its lesson.
+//
+//   ./build/gen_bench
+//   ./build/gen_bench --mb 64 --chunk 16 --seed 7
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+#include "host_hal.h"
+#include "../trainer_core.h"
+#include "../trainer_generator.h"
+#include "../trainer_drill.h"
+
+// ---- Allocation counting ------------------------------------------------------
+// operator new is replaced here; malloc and friends are wrapped at link time
+// (-Wl,--wrap=...), so both C and C++ allocations are seen.
+
+static unsigned long allocations = 0;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t size);
+
+void* __wrap_malloc(size_t size) {
+  allocations++;
+  return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+  allocations++;
+  return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+  allocations++;
+  return __real_realloc(p, size);
+}
+}
+
+void* operator new(size_t size) {
+  allocations++;
+  void* p = __real_malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size) {
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+  free(p);
+}
+
+// ---- Benchmark ------------------------------------------------------------------
+
+struct Generator {
+  const char* name;
+  LessonGenerator& (*get)();
+};
+
+static const Generator generators[] = {
+  { "koch", kochGenerator },
+  { "custom", customGenerator },
+  { "callsign", callsignGenerator },
+  { "contest", contestGenerator },
+  { "qso", qsoGenerator },
+};
+
+static double seconds() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t fnv1a(uint32_t hash, const char* data, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    hash ^= (uint8_t)data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t streamHash(LessonGenerator& generator, uint32_t seed, size_t total, size_t chunk) {
+  static char buf[4096];
+  LessonStream stream(generator, seed);
+  uint32_t hash = 2166136261u;
+  for (size_t done = 0; done < total; done += chunk) {
+    hash = fnv1a(hash, buf, stream.read(buf, chunk));
+  }
+  return hash;
+}
+
+int main(int argc, char** argv) {
+  double megabytes = 16;
+  size_t chunk = 256;
+  uint32_t seed = 1;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--mb") && i + 1 < argc) megabytes = atof(argv[++i]);
+    else if (!strcmp(argv[i], "--chunk") && i + 1 < argc) chunk = strtoul(argv[++i], nullptr, 0);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoul(argv[++i], nullptr, 0);
+    else {
+      fprintf(stderr, "usage: %s [--mb N] [--chunk BYTES] [--seed N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (chunk == 0 || chunk > 4096) chunk = 256;
+
+  simReset(seed);
+  simSetEcho(false, false);
+  loadSettings();
+  kochLesson = 10;
+  initializeKoch();
+
+  size_t total = (size_t)(megabytes * 1024 * 1024);
+  bool ok = true;
+  printf("%-9s %12s %14s %7s %s\n", "generator", "chars", "chars/sec", "allocs", "repeatable");
+  for (const Generator& g : generators) {
+    LessonGenerator& generator = g.get();
+
+    // Short repeatability check first. A lesson depends on the seed and on
+    // trainer state: drill recency is restored between the two streams, as
+    // trace replay does from its snapshot, and the contest serial keeps
+    // counting, so digits are not compared there
+    uint8_t recency[MORSE_SYMBOL_COUNT];
+    for (int i = 0; i < MORSE_SYMBOL_COUNT; i++) recency[i] = drillRecency(i);
+    char a[512], b[512];
+    LessonStream first(generator, seed);
+    size_t n = first.read(a, sizeof(a));
+    for (int i = 0; i < MORSE_SYMBOL_COUNT; i++) drillSetRecency(i, recency[i]);
+    LessonStream second(generator, seed);
+    second.read(b, sizeof(b));
+    bool repeatable = true;
+    for (size_t i = 0; i < n; i++) {
+      bool digit = a[i] >= '0' && a[i] <= '9' && b[i] >= '0' && b[i] <= '9';
+      if (a[i] != b[i] && !(g.get == contestGenerator && digit)) repeatable = false;
+    }
+
+    unsigned long before = allocations;
+    double start = seconds();
+    streamHash(generator, seed, total, chunk);
+    double elapsed = seconds() - start;
+    unsigned long allocated = allocations - before;
+
+    printf("%-9s %12zu %14.0f %7lu %s\n", g.name, total, total / elapsed, allocated, repeatable ? "yes" : "NO");
+    if (allocated != 0 || !repeatable) ok = false;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,508 @@
+#include "host_hal.h"
+#include "../trainer_core.h"
+#include "../trainer_input.h"
+#include "../trainer_protocol.h"
+#include "../trainer_frame.h"
+#include "../trainer_monitor.h"
+#include "../trainer_spectrum.h"
+#include <math.h>
+
+// Virtual platform state
+static uint32_t simNow = 0;
+static bool keyDown = false;
+static bool externalTone = false;
+static bool sidetone = false;
+static bool sidetonePrev = false;
+static uint32_t sidetoneEdge = 0;
+static uint8_t eeprom[SIM_EEPROM_SIZE];
+static uint8_t profileImages[SIM_PROFILE_IMAGES][SIM_PROFILE_IMAGE_SIZE];  // stands in for the SD files
+static size_t profileImageSize[SIM_PROFILE_IMAGES];
+static uint8_t historyFiles[SIM_PROFILE_IMAGES][SIM_HISTORY_FILE_SIZE];
+static size_t historyFileSize[SIM_PROFILE_IMAGES];
+static uint32_t clockOffset = 0;  // seconds added by simAdvanceClock()
+static TextScreen lastScreen;
+static SimCounters counters;
+static bool echoConsole = false;
+static bool echoLink = false;
+static uint8_t linkMonitorBuffer[FRAME_ENCODED_MAX];
+static FrameReceiver linkMonitor;  // checks every frame the trainer sends
+static FrameStatus linkStatus;     // the companion's view, from STATUS and STATUS_DELTA frames
+static void (*linkTap)(const uint8_t* data, size_t len) = nullptr;
+
+// Audio monitor: blocks of the decode mix, made as simulated time passes
+static bool monitorCapturing = false;
+static uint32_t monitorSince = 0;
+static uint64_t monitorBlocks = 0;  // made or dropped since the start
+static uint32_t monitorDropped = 0;
+static double monitorPhase = 0;
+static uint32_t audioNextSample = 0;  // of the next FRAME_AUDIO, as the browser expects it
+static AdpcmState audioDecoder;
+static bool audioStarted = false;
+
+// Spectrum: an FFT1024 result every 512 samples while enabled
+static bool spectrumEnabled = false;
+static uint64_t spectrumFfts = 0;  // handed out since simNow 0
+static uint32_t spectrumNoise = 1;
+
+// Simulated companion (simCompanionStart)
+struct WireChunk {
+  uint64_t at;    // microseconds; delivered once simNow passes it
+  uint32_t baud;  // rate it was sent at
+  uint16_t len;
+  uint8_t data[FRAME_ENCODED_MAX];
+};
+const int WIRE_CHUNKS = 32;
+static bool companion = false;
+static uint32_t companionBaud = LINK_BAUD_DEFAULT;
+static uint32_t teensyBaud = LINK_BAUD_DEFAULT;
+static uint8_t companionSeq = 0;
+static uint64_t toCompanionFree = 0;  // when each direction of the wire is idle again
+static uint64_t toTeensyFree = 0;
+static uint64_t lastArrival = 0;  // of the Teensy's latest bytes at the companion
+static WireChunk toTeensy[WIRE_CHUNKS];
+static int toTeensyHead = 0;
+static int toTeensyCount = 0;
+
+void simReset(uint32_t seed) {
+  simNow = 0;
+  trainerRandomSeed(seed);
+  keyDown = false;
+  externalTone = false;
+  sidetone = sidetonePrev = false;
+  sidetoneEdge = 0;
+  memset(eeprom, 0xFF, sizeof(eeprom));  // erased flash reads back as 0xFF
+  memset(profileImageSize, 0, sizeof(profileImageSize));
+  memset(historyFileSize, 0, sizeof(historyFileSize));
+  clockOffset = 0;
+  memset(&lastScreen, 0, sizeof(lastScreen));
+  memset(&counters, 0, sizeof(counters));
+  frameReceiverInit(&linkMonitor, linkMonitorBuffer, sizeof(linkMonitorBuffer));
+  memset(&linkStatus, 0, sizeof(linkStatus));
+  companion = false;
+  companionBaud = teensyBaud = LINK_BAUD_DEFAULT;
+  companionSeq = 0;
+  toCompanionFree = toTeensyFree = lastArrival = 0;
+  toTeensyHead = toTeensyCount = 0;
+  monitorCapturing = false;
+  audioStarted = false;
+  spectrumEnabled = false;
+  spectrumFfts = 0;
+}
+
+static uint64_t wireMicros(size_t bytes, uint32_t baud) {
+  return bytes * 10 * 1000000ULL / baud;  // start, eight data bits, stop
+}
+
+// The Teensy's bytes reach the companion after the wire time
+static void teensySent(size_t bytes) {
+  uint64_t now = simNow * 1000ULL;
+  toCompanionFree = (toCompanionFree > now ? toCompanionFree : now) + wireMicros(bytes, teensyBaud);
+  lastArrival = toCompanionFree;
+}
+
+static void companionSend(const void* data, size_t len) {
+  if (toTeensyCount == WIRE_CHUNKS || len > FRAME_ENCODED_MAX) return;  // an overrun the Teensy never sees
+  WireChunk& c = toTeensy[(toTeensyHead + toTeensyCount++) % WIRE_CHUNKS];
+  toTeensyFree = (toTeensyFree > lastArrival ? toTeensyFree : lastArrival) + wireMicros(len, companionBaud);
+  c.at = toTeensyFree;
+  c.baud = companionBaud;
+  c.len = (uint16_t)len;
+  memcpy(c.data, data, len);
+}
+
+static void companionReply(bool framed, uint8_t type, const void* body, size_t len) {
+  if (framed) {
+    uint8_t frame[FRAME_ENCODED_MAX];
+    companionSend(frame, frameEncode(type, companionSeq++, body, len, frame));
+    return;
+  }
+  char line[FRAME_BODY_MAX + 3];
+  memcpy(line, body, len);
+  memcpy(line + len, "\r\n", 2);
+  companionSend(line, len + 2);
+}
+
+static void companionLine(const char* line, size_t len, bool framed) {
+  if (!companion || teensyBaud != companionBaud) return;  // garbled on the way
+  if (len == strlen(MSG_PING) && memcmp(line, MSG_PING, len) == 0) {
+    companionReply(framed, FRAME_TEXT, MSG_PONG, strlen(MSG_PONG));
+  } else if (len > strlen(PREFIX_BAUD) && memcmp(line, PREFIX_BAUD, strlen(PREFIX_BAUD)) == 0) {
+    char reply[32];
+    unsigned long rate = strtoul(line + strlen(PREFIX_BAUD), nullptr, 10);
+    int n = snprintf(reply, sizeof(reply), PREFIX_BAUD_OK "%lu", rate);
+    companionReply(framed, FRAME_TEXT, reply, n);
+    companionBaud = rate;  // once the answer is out, as uart_wait_tx_done() on the ESP32
+  }
+}
+
+static void companionFrame(const FrameReceiver& rx) {
+  if (!companion || teensyBaud != companionBaud) return;
+  switch (rx.type) {
+    case FRAME_TEXT:
+      companionLine((const char*)rx.body, rx.bodyLen, true);
+      break;
+    case FRAME_PING:
+      companionReply(true, FRAME_PONG, nullptr, 0);
+      break;
+    case FRAME_BENCH:
+      companionReply(true, FRAME_BENCH, rx.body, rx.bodyLen);
+      break;
+  }
+}
+
+void simCompanionStart(uint32_t maxBaud, bool flowControl) {
+  companion = true;
+  char hello[32];
+  int n = snprintf(hello, sizeof(hello), PREFIX_HELLO "%d,%d,%lu", LINK_VERSION,
+                   LINK_CAP_FRAMES | (flowControl ? LINK_CAP_FLOW : 0), (unsigned long)maxBaud);
+  lastArrival = simNow * 1000ULL;
+  companionReply(false, FRAME_TEXT, hello, n);
+}
+
+void simSetLinkTap(void (*tap)(const uint8_t* data, size_t len)) {
+  linkTap = tap;
+}
+
+// Companion bytes due by now; a chunk sent at another rate than the Teensy's is noise
+static void deliverToTeensy() {
+  static WireChunk c;
+  while (toTeensyCount > 0 && toTeensy[toTeensyHead].at <= simNow * 1000ULL) {
+    c = toTeensy[toTeensyHead];
+    toTeensyHead = (toTeensyHead + 1) % WIRE_CHUNKS;
+    toTeensyCount--;
+    if (c.baud != teensyBaud) {
+      counters.linkGarbled += c.len;
+      continue;
+    }
+    for (size_t i = 0; i < c.len; i++) linkReceiveByte(c.data[i]);
+  }
+}
+
+void simAdvanceClock(uint32_t seconds) {
+  clockOffset += seconds;
+}
+
+void simAdvance(uint32_t ms) {
+  simNow += ms;
+  deliverToTeensy();
+}
+
+// Inputs reach the core as queued events, as from the Teensy's pin interrupts
+void simSetKey(bool down) {
+  if (down == keyDown) return;
+  keyDown = down;
+  inputQueue.push({ simNow, INPUT_KEY, (int8_t)down });
+}
+
+void simSetButton(bool pressed) {
+  inputQueue.push({ simNow, INPUT_BUTTON, (int8_t)pressed });
+}
+
+void simTurnEncoder(int detents) {
+  inputQueue.push({ simNow, INPUT_ENCODER, (int8_t)detents });
+}
+
+void simSetExternalTone(bool on) {
+  externalTone = on;
+}
+
+bool simToneOn() {
+  return sidetone;
+}
+
+void simSetEcho(bool console, bool link) {
+  echoConsole = console;
+  echoLink = link;
+}
+
+const FrameStatus& simLinkStatus() {
+  return linkStatus;
+}
+
+const SimCounters& simCounters() {
+  return counters;
+}
+
+const TextScreen& simScreen() {
+  return lastScreen;
+}
+
+void simDumpScreen(FILE* out) {
+  fprintf(out, "+---------------------+\n");
+  for (int r = 0; r < SCREEN_TEXT_ROWS; r++) {
+    fprintf(out, "|%-21.21s|\n", lastScreen.rows[r]);
+  }
+  fprintf(out, "+---------------------+\n");
+}
+
+// ---- trainer_hal.h ------------------------------------------------------------
+
+uint32_t halMillis() {
+  return simNow;
+}
+
+uint32_t halClockSeconds() {
+  return SIM_CLOCK_START + clockOffset + simNow / 1000;
+}
+
+uint32_t halMicros() {
+  return simNow * 1000;
+}
+
+// The decoder hears the sidetone (loopback) or the radio input, and like the
+// Goertzel block on the Teensy it only reports an edge one window later.
+bool halToneDetected() {
+  if (useExternalAudio) return externalTone;
+  return (simNow - sidetoneEdge >= SIM_DETECT_LATENCY) ? sidetone : sidetonePrev;
+}
+
+void halToneOn() {
+  if (!sidetone) {
+    sidetonePrev = sidetone;
+    sidetone = true;
+    sidetoneEdge = simNow;
+  }
+}
+
+void halToneOff() {
+  if (sidetone) {
+    sidetonePrev = sidetone;
+    sidetone = false;
+    sidetoneEdge = simNow;
+  }
+}
+
+// No audio graph on the host
+void updateWaveform() {}
+void updateFrequency() {}
+void updateVolume() {}
+void updateOutputRouting() {}
+void updateToneDetector() {}
+void updateAudioInput() {}
+
+void halStorageRead(int addr, void* dst, size_t len) {
+  if (addr < 0 || addr + len > sizeof(eeprom)) {
+    memset(dst, 0xFF, len);
+    return;
+  }
+  memcpy(dst, eeprom + addr, len);
+}
+
+void halStorageWrite(int addr, const void* src, size_t len) {
+  if (addr < 0 || addr + len > sizeof(eeprom)) return;
+  memcpy(eeprom + addr, src, len);
+  counters.storageWrites++;
+  counters.storageBytes += len;
+}
+
+bool halProfileWrite(int profile, const uint8_t* data, size_t len) {
+  if (profile < 0 || profile >= SIM_PROFILE_IMAGES || len > SIM_PROFILE_IMAGE_SIZE) return false;
+  memcpy(profileImages[profile], data, len);
+  profileImageSize[profile] = len;
+  counters.profileBytes += len;
+  return true;
+}
+
+size_t halProfileRead(int profile, uint8_t* dst, size_t max) {
+  if (profile < 0 || profile >= SIM_PROFILE_IMAGES) return 0;
+  size_t len = profileImageSize[profile] < max ? profileImageSize[profile] : max;
+  memcpy(dst, profileImages[profile], len);
+  counters.profileBytes += len;
+  return len;
+}
+
+bool halHistoryRead(int profile, uint32_t offset, void* dst, size_t len) {
+  if (profile < 0 || profile >= SIM_PROFILE_IMAGES || offset + len > historyFileSize[profile]) return false;
+  memcpy(dst, historyFiles[profile] + offset, len);
+  return true;
+}
+
+bool halHistoryWrite(int profile, uint32_t offset, const void* src, size_t len) {
+  if (profile < 0 || profile >= SIM_PROFILE_IMAGES || offset + len > SIM_HISTORY_FILE_SIZE) return false;
+  memcpy(historyFiles[profile] + offset, src, len);
+  if (offset + len > historyFileSize[profile]) historyFileSize[profile] = offset + len;
+  counters.historyBytes += len;
+  return true;
+}
+
+void halConsoleWrite(const char* text) {
+  counters.consoleBytes += strlen(text);
+  if (echoConsole) fputs(text, stdout);
+}
+
+void halLinkWriteLine(const char* line) {
+  counters.linkLines++;
+  counters.linkBytes += strlen(line) + 2;  // println adds CR LF
+  if (echoLink) printf("LINK> %s\n", line);
+  if (linkTap) {
+    linkTap((const uint8_t*)line, strlen(line));
+    linkTap((const uint8_t*)"\r\n", 2);
+  }
+  teensySent(strlen(line) + 2);
+  companionLine(line, strlen(line), false);
+}
+
+// A FRAME_AUDIO decoded: numbering and coder state checked against the
+// previous frame, and how much of the energy is the sidetone (Goertzel)
+static void checkAudioFrame(const uint8_t* body, size_t len) {
+  FrameAudio head;
+  if (len < sizeof(head)) {
+    counters.linkBadFrames++;
+    return;
+  }
+  memcpy(&head, body, sizeof(head));
+  if (audioStarted && head.sample != audioNextSample) counters.audioLost += head.sample - audioNextSample;
+  else if (audioStarted && (head.predictor != audioDecoder.predictor || head.index != audioDecoder.index)) counters.audioStateErrors++;
+  audioDecoder = { head.predictor, head.index };
+  audioStarted = true;
+
+  size_t samples = (len - sizeof(head)) * 2;
+  double w = 2 * M_PI * sidetoneFreq / MONITOR_RATE;
+  double s1 = 0, s2 = 0, energy = 0;
+  for (size_t i = 0; i < samples; i++) {
+    uint8_t code = body[sizeof(head) + i / 2] >> (i & 1 ? 4 : 0);
+    double x = adpcmDecode(audioDecoder, code & 0x0F);
+    double s0 = x + 2 * cos(w) * s1 - s2;
+    s2 = s1;
+    s1 = s0;
+    energy += x * x;
+  }
+  double tone = s1 * s1 + s2 * s2 - 2 * cos(w) * s1 * s2;
+  counters.audioFrames++;
+  counters.audioSamples += samples;
+  counters.audioEnergy += energy;
+  counters.audioToneEnergy += samples ? 2 * tone / samples : 0;
+  audioNextSample = head.sample + samples;
+}
+
+// The peak point must hold the sidetone's bin, give or take the leakage
+static void checkSpectrumFrame(const uint8_t* body, size_t len) {
+  FrameSpectrum head;
+  if (len < sizeof(head) || len - sizeof(head) > (size_t)SPECTRUM_POINTS_MAX) {
+    counters.linkBadFrames++;
+    return;
+  }
+  memcpy(&head, body, sizeof(head));
+  const uint8_t* levels = body + sizeof(head);
+  size_t points = len - sizeof(head);
+  size_t peak = 0;
+  for (size_t p = 1; p < points; p++) {
+    if (levels[p] > levels[peak]) peak = p;
+  }
+  counters.spectrumFrames++;
+  counters.spectrumBytes += len;
+  if (points == 0 || levels[peak] < spectrumLevel(SIM_SPECTRUM_FLOOR) + SIM_SPECTRUM_TONE_DB * 2) return;
+  counters.spectrumToneFrames++;
+  long toneBin = lrint(sidetoneFreq * 1000 / head.binMilliHz);
+  long first = head.firstBin + (long)peak * head.merge;
+  if (toneBin < first - 1 || toneBin > first + head.merge) counters.spectrumOffTone++;
+}
+
+void halLinkWrite(const uint8_t* data, size_t len) {
+  counters.linkBytes += len;
+  if (linkTap) linkTap(data, len);
+  teensySent(len);
+  for (size_t i = 0; i < len; i++) {
+    if (frameReceiveByte(&linkMonitor, data[i]) != FRAME_RX_FRAME) continue;
+    counters.linkFrames++;
+    companionFrame(linkMonitor);
+    if (linkMonitor.type == FRAME_STATUS && linkMonitor.bodyLen == sizeof(linkStatus)) {
+      memcpy(&linkStatus, linkMonitor.body, sizeof(linkStatus));
+    } else if (linkMonitor.type == FRAME_STATUS_DELTA && !frameStatusApply(&linkStatus, linkMonitor.body, linkMonitor.bodyLen)) {
+      counters.linkBadFrames++;
+    } else if (linkMonitor.type == FRAME_AUDIO) {
+      checkAudioFrame(linkMonitor.body, linkMonitor.bodyLen);
+    } else if (linkMonitor.type == FRAME_SPECTRUM) {
+      checkSpectrumFrame(linkMonitor.body, linkMonitor.bodyLen);
+    }
+    if (!echoLink) continue;
+    if (linkMonitor.type == FRAME_TEXT) printf("LINK# %.*s\n", (int)linkMonitor.bodyLen, (const char*)linkMonitor.body);
+    else printf("LINK# type %u, %u bytes\n", linkMonitor.type, (unsigned)linkMonitor.bodyLen);
+  }
+  counters.linkBadFrames += linkMonitor.crcErrors + linkMonitor.seqGaps;
+  linkMonitor.crcErrors = linkMonitor.seqGaps = 0;
+}
+
+void halLinkSetBaud(uint32_t baud) {
+  teensyBaud = baud;
+}
+
+uint32_t halLinkMaxBaud() {
+  return SIM_LINK_MAX_BAUD;
+}
+
+bool halLinkFlowControl() {
+  return true;
+}
+
+void halSetLinkIndicator(bool connected) {
+  (void)connected;
+}
+
+void halMonitorCapture(bool on) {
+  monitorCapturing = on;
+  monitorSince = simNow;
+  monitorBlocks = 0;
+  monitorDropped = 0;
+  audioStarted = false;
+}
+
+// The sidetone (or radio tone) as a sine, switched with it; as on the Teensy,
+// no more than MONITOR_QUEUE_BLOCKS wait and older ones are lost
+int halMonitorRead(int16_t* block) {
+  if (!monitorCapturing) return 0;
+  uint64_t due = (uint64_t)((simNow - monitorSince) * (double)MONITOR_INPUT_RATE / 1000 / MONITOR_BLOCK_SAMPLES);
+  if (due <= monitorBlocks) return 0;
+  if (due - monitorBlocks > (uint64_t)MONITOR_QUEUE_BLOCKS) {
+    uint64_t lost = due - monitorBlocks - MONITOR_QUEUE_BLOCKS;
+    monitorDropped += lost;
+    monitorBlocks += lost;
+  }
+  bool on = useExternalAudio ? externalTone : sidetone;
+  double w = 2 * M_PI * sidetoneFreq / MONITOR_INPUT_RATE;
+  for (int i = 0; i < MONITOR_BLOCK_SAMPLES; i++) {
+    block[i] = on ? (int16_t)(SIM_TONE_AMPLITUDE * sin(monitorPhase)) : 0;
+    monitorPhase = fmod(monitorPhase + w, 2 * M_PI);
+  }
+  monitorBlocks++;
+  return MONITOR_BLOCK_SAMPLES;
+}
+
+uint32_t halMonitorDropped() {
+  return monitorDropped;
+}
+
+float halAudioLoadPeak() {
+  return 0;  // no audio interrupt on the host
+}
+
+void halSpectrumEnable(bool on) {
+  spectrumEnabled = on;
+}
+
+// Hann-windowed tone: the nearest bins carry it, falling off over two bins,
+// over a noise floor that wanders a few dB
+bool halSpectrumRead(float* magnitudes, int firstBin, int count) {
+  uint64_t due = (uint64_t)(simNow * (double)MONITOR_INPUT_RATE / 1000 / 512);
+  if (!spectrumEnabled || due <= spectrumFfts) return false;
+  spectrumFfts = due;
+  bool on = useExternalAudio ? externalTone : sidetone;
+  float toneBin = sidetoneFreq / SPECTRUM_BIN_HZ;
+  for (int i = 0; i < count; i++) {
+    spectrumNoise = spectrumNoise * 1103515245 + 12345;
+    float m = SIM_SPECTRUM_FLOOR * (0.5f + (spectrumNoise >> 16 & 0x7FFF) / 32768.0f);
+    float d = fabsf(firstBin + i - toneBin);
+    if (on && d < 2) m += SIM_TONE_AMPLITUDE / 32768 / 2 * (1 - d / 2);
+    magnitudes[i] = m;
+  }
+  return true;
+}
+
+void halDisplayShow(const TextScreen& screen) {
+  lastScreen = screen;
+  counters.displayFrames++;
+}
+
+void printHeapProbe() {
+  consolePrintf("Heap probe: not available on host\n");
+}
@@ -0,0 +1,67 @@
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+// Controls for the host implementation of trainer_hal.h. The simulation owns
+// the clock: nothing advances unless simAdvance() is called.
+
+#include <stdio.h>
+#include "../trainer_hal.h"
+#include "../trainer_frame.h"
+
+const size_t SIM_EEPROM_SIZE = STORAGE_SIZE;
+const uint32_t SIM_DETECT_LATENCY = 3;  // ms, tone detector analysis window
+const int SIM_PROFILE_IMAGES = 8;
+const size_t SIM_PROFILE_IMAGE_SIZE = 2048;
+const size_t SIM_HISTORY_FILE_SIZE = 4096;
+const uint32_t SIM_CLOCK_START = 1767225600;  // 2026-01-01 00:00 UTC
+const uint32_t SIM_LINK_MAX_BAUD = 4000000;  // the simulated Teensy, with RTS/CTS
+const float SIM_TONE_AMPLITUDE = 12000;  // decode mix while a tone is on, for the audio monitor
+const float SIM_SPECTRUM_FLOOR = 1e-5f;   // FFT noise floor, -100 dBFS
+const float SIM_SPECTRUM_TONE_DB = 40;    // a spectrum frame this far above the floor shows the tone
+
+struct SimCounters {
+  unsigned long linkLines;
+  unsigned long linkBytes;
+  unsigned long linkFrames;  // frames that passed their CRC
+  unsigned long linkBadFrames;
+  unsigned long linkGarbled;  // companion bytes that arrived at the wrong rate
+  unsigned long consoleBytes;
+  unsigned long displayFrames;
+  unsigned long storageWrites;
+  unsigned long storageBytes;
+  unsigned long profileBytes;  // profile image bytes written and read
+  unsigned long historyBytes;  // history file bytes written
+  unsigned long audioFrames;   // FRAME_AUDIO, decoded as the browser would
+  unsigned long audioSamples;
+  unsigned long audioLost;     // samples skipped in the frame numbering
+  unsigned long audioStateErrors;  // a frame's coder state not where the previous one left it
+  double audioEnergy;          // of the decoded samples
+  double audioToneEnergy;      // ... at sidetoneFreq
+  unsigned long spectrumFrames;
+  unsigned long spectrumBytes;     // frame bodies
+  unsigned long spectrumToneFrames;  // with a peak SIM_SPECTRUM_TONE_DB above the floor
+  unsigned long spectrumOffTone;     // ... whose peak is not at sidetoneFreq
+};
+
+void simReset(uint32_t seed);  // clock to 0, EEPROM and profile files erased, counters cleared
+void simAdvance(uint32_t ms);
+void simAdvanceClock(uint32_t seconds);  // wall clock only, e.g. the days between sessions
+void simSetKey(bool down);  // queued as input events, like the pin interrupts
+void simSetButton(bool pressed);
+void simTurnEncoder(int detents);
+void simSetExternalTone(bool on);  // radio input when useExternalAudio is set
+bool simToneOn();  // current sidetone state
+void simSetEcho(bool console, bool link);
+const SimCounters& simCounters();
+const FrameStatus& simLinkStatus();  // status as a framed companion would hold it
+// A companion on the far end of the link that answers like the ESP32: its
+// HELLO offers frames and maxBaud, then it takes BAUD:, answers PING and
+// echoes BENCH frames. Bytes take their wire time at the current rate.
+void simCompanionStart(uint32_t maxBaud, bool flowControl);
+// Sees every byte the trainer writes to the companion UART, lines with their
+// CR LF: a capture file (cw_sim --link-capture) or a real pty (link_fuzz)
+void simSetLinkTap(void (*tap)(const uint8_t* data, size_t len));
+const TextScreen& simScreen();
+void simDumpScreen(FILE* out);
+
+#endif  // HOST_HAL_H
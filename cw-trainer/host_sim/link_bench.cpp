@@ -0,0 +1,209 @@
+// Companion link benchmark: bytes on the wire and receive cost of typical
+// messages as text lines and as frames (trainer_frame.h), then a corruption
+// run that damages frames in flight and counts what the CRC lets through.
+//
+//   ./build/link_bench
+//   ./build/link_bench --count 200000 --seed 7
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../trainer_protocol.h"
+#include "../trainer_frame.h"
+
+static double seconds() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rng = 1;
+
+static uint32_t nextRandom() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+// ---- Messages ---------------------------------------------------------------------
+
+struct Message {
+  const char* name;
+  const char* line;  // as sendStatusToWiFi() and friends write it
+  uint8_t type;      // its frame
+  const void* body;
+  size_t bodyLen;
+};
+
+static const FrameStatus sampleStatus = { 12, 20, 12, 0, 600, 935, STATUS_DECODER | STATUS_KOCH | STATUS_HEADPHONES | STATUS_LISTENING };
+static const uint8_t sampleDelta[] = { 1 << 6, STATUS_DECODER | STATUS_KOCH | STATUS_HEADPHONES | STATUS_SENDING };  // flags only
+// "KMKKM " as one batch: the start time, then each character and its gap
+static const uint8_t sampleDecoded[] = { 0x40, 0xE2, 0x01, 0x00, 'K', 0, 0, 'M', 0x5E, 0x01, 'K', 0x77, 0x01,
+                                         'K' | DECODED_MISCOPY, 0x40, 0x01, 'M', 0x90, 0x01, ' ', 0xD0, 0x02 };
+static const FrameStats sampleStats = { 1234, 56789, 225 };
+static const char charstatLine[] = PREFIX_CHARSTAT "K|120|4|118|2 0 1 5 9 3 1 0|K 118,R 2";
+static const char historyLine[] = PREFIX_HISTORY "D 17 1767312000 6 14 1320 96.4 20.0 12.0";
+
+static const Message messages[] = {
+  { "status", PREFIX_STATUS "LESSON=12,FREQ=600,SPEED=20,EFFSPEED=12,ACC=93.5,DEC=1,KOCH=1,WAVE=Sine,OUT=Headphones,SEND=0,LISTEN=1",
+    FRAME_STATUS, &sampleStatus, sizeof(sampleStatus) },
+  { "delta", PREFIX_STATUS "SEND=1,LISTEN=0", FRAME_STATUS_DELTA, sampleDelta, sizeof(sampleDelta) },
+  { "stats", PREFIX_STATS "SESSIONS=1234,CHARS=56789,BESTWPM=22.5", FRAME_STATS, &sampleStats, sizeof(sampleStats) },
+  { "decoded", PREFIX_DECODED "KMK[K]M ", FRAME_DECODED, sampleDecoded, sizeof(sampleDecoded) },
+  { "ping", MSG_PING, FRAME_PING, nullptr, 0 },
+  { "charstat", charstatLine, FRAME_TEXT, charstatLine, sizeof(charstatLine) - 1 },
+  { "history", historyLine, FRAME_TEXT, historyLine, sizeof(historyLine) - 1 },
+};
+
+// The companion's handling of a text line: split KEY=VALUE pairs and convert
+static long parseText(const char* line) {
+  long sum = 0;
+  const char* p = strchr(line, ':');
+  p = p ? p + 1 : line;
+  while (*p) {
+    const char* eq = strchr(p, '=');
+    if (!eq) break;
+    const char* comma = strchr(eq, ',');
+    if (!comma) comma = p + strlen(p);
+    char value[32];
+    size_t n = comma - eq - 1;
+    if (n >= sizeof(value)) n = sizeof(value) - 1;
+    memcpy(value, eq + 1, n);
+    value[n] = '\0';
+    sum += atoi(value);
+    if (!*comma) break;
+    p = comma + 1;
+  }
+  return sum;
+}
+
+static long parseFrame(const FrameReceiver& rx) {
+  if (rx.type == FRAME_STATUS && rx.bodyLen == sizeof(FrameStatus)) {
+    FrameStatus s;
+    memcpy(&s, rx.body, sizeof(s));
+    return s.lesson + s.frequency + s.accuracy;
+  }
+  if (rx.type == FRAME_STATS && rx.bodyLen == sizeof(FrameStats)) {
+    FrameStats s;
+    memcpy(&s, rx.body, sizeof(s));
+    return s.sessions + s.characters;
+  }
+  return rx.bodyLen;
+}
+
+// ---- Benchmark --------------------------------------------------------------------
+
+static void measure(const Message& m, int count) {
+  static uint8_t wire[512];
+  static uint8_t rxBuffer[512];
+  FrameReceiver rx;
+  volatile long sink = 0;
+
+  size_t textLen = strlen(m.line);
+  memcpy(wire, m.line, textLen);
+  wire[textLen] = '\r';
+  wire[textLen + 1] = '\n';
+  size_t textBytes = textLen + 2;
+  frameReceiverInit(&rx, rxBuffer, sizeof(rxBuffer));
+  double start = seconds();
+  for (int i = 0; i < count; i++) {
+    for (size_t b = 0; b < textBytes; b++) {
+      if (frameReceiveByte(&rx, wire[b]) == FRAME_RX_TEXT) sink += parseText(rx.text);
+    }
+  }
+  double textNs = (seconds() - start) * 1e9 / count;
+
+  static uint8_t frame[FRAME_ENCODED_MAX];
+  size_t frameBytes = 0;
+  start = seconds();
+  for (int i = 0; i < count; i++) frameBytes = frameEncode(m.type, (uint8_t)i, m.body, m.bodyLen, frame);
+  double encodeNs = (seconds() - start) * 1e9 / count;
+
+  frameReceiverInit(&rx, rxBuffer, sizeof(rxBuffer));
+  start = seconds();
+  for (int i = 0; i < count; i++) {
+    for (size_t b = 0; b < frameBytes; b++) {
+      if (frameReceiveByte(&rx, frame[b]) == FRAME_RX_FRAME) sink += parseFrame(rx);
+    }
+  }
+  double frameNs = (seconds() - start) * 1e9 / count;
+  bool clean = rx.frames == (uint32_t)count && rx.crcErrors == 0;
+
+  printf("%-9s %6zu %7zu %9.0f %9.0f %9.0f %s\n", m.name, textBytes, frameBytes, textNs, encodeNs, frameNs,
+         clean ? "ok" : "FAILED");
+  (void)sink;
+}
+
+// Damages one byte of each frame (a bit flip, a dropped or an inserted byte)
+// and feeds it, then a clean frame, to one receiver. A damaged frame must be
+// rejected (or, rarely, slip past the CRC) and the clean one must still arrive.
+static bool corruptionRun(int count) {
+  static uint8_t rxBuffer[FRAME_ENCODED_MAX];
+  FrameReceiver rx;
+  frameReceiverInit(&rx, rxBuffer, sizeof(rxBuffer));
+  unsigned long delivered = 0, altered = 0, rejected = 0, resynced = 0;
+  uint8_t seq = 0;
+
+  for (int i = 0; i < count; i++) {
+    uint8_t body[FRAME_BODY_MAX];
+    size_t len = nextRandom() % 64;
+    for (size_t b = 0; b < len; b++) body[b] = nextRandom() % 4 ? nextRandom() : 0;  // plenty of zeros to stuff
+    static uint8_t frame[FRAME_ENCODED_MAX + 1];
+    size_t n = frameEncode(FRAME_TEXT, seq++, body, len, frame);
+
+    size_t at = 1 + nextRandom() % (n - 2);  // leave the delimiters alone
+    switch (nextRandom() % 3) {
+      case 0:
+        frame[at] ^= 1 << (nextRandom() % 8);
+        break;
+      case 1:
+        memmove(frame + at, frame + at + 1, n - at - 1);
+        n--;
+        break;
+      default:
+        memmove(frame + at + 1, frame + at, n - at);
+        frame[at] = nextRandom();
+        n++;
+        break;
+    }
+    uint32_t before = rx.crcErrors;
+    for (size_t b = 0; b < n; b++) {
+      if (frameReceiveByte(&rx, frame[b]) != FRAME_RX_FRAME) continue;
+      delivered++;
+      if (rx.bodyLen != len || memcmp(rx.body, body, len) != 0) altered++;
+    }
+    if (rx.crcErrors > before) rejected++;
+
+    n = frameEncode(FRAME_TEXT, seq++, body, len, frame);
+    bool got = false;
+    for (size_t b = 0; b < n; b++) got |= frameReceiveByte(&rx, frame[b]) == FRAME_RX_FRAME;
+    if (got) resynced++;
+  }
+  // A 16-bit CRC passes about one random corruption in 65536; a single bit flip never
+  printf("\ncorrupted frames: %d\n", count);
+  printf("rejected:         %lu\n", rejected);
+  printf("passed intact:    %lu (the damage missed the payload)\n", delivered - altered);
+  printf("undetected:       %lu (%.1f expected by chance)\n", altered, count * 2.0 / 3 / 65536);
+  printf("next frame ok:    %lu\n", resynced);
+  return resynced == (unsigned long)count;
+}
+
+int main(int argc, char** argv) {
+  int count = 100000;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--count") && i + 1 < argc) count = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc) rng = strtoul(argv[++i], nullptr, 0);
+    else {
+      fprintf(stderr, "usage: %s [--count N] [--seed N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (count <= 0) count = 100000;
+  if (rng == 0) rng = 1;
+
+  printf("%-9s %6s %7s %9s %9s %9s\n", "message", "text", "framed", "text ns", "encode ns", "frame ns");
+  for (const Message& m : messages) measure(m, count);
+  return corruptionRun(count) ? 0 : 1;
+}
@@ -0,0 +1,839 @@
+// Companion link harness: the trainer core and the ESP32-S3 companion's
+// parser (esp32s3_wifi_companion/.../trainer_protocol.c, built against
+// esp_shim/) talk through a real pty pair. Runs each link mode, text and
+// framed, through
+//   stream    random trainer activity as fast as the pty takes it (messages/s)
+//   lockstep  one action at a time: delivery latency and parse cost
+//             percentiles, and the companion's g_status compared with the
+//             trainer's state after every step
+//   fuzz      mutated lines, oversized fields, random and damaged frames and
+//             noise in both directions, then a resync; g_status must stay
+//             well formed and come back in step, commands must be acked right
+// and --replay feeds a captured trainer stream (cw_sim --link-capture).
+//
+//   ./build/link_fuzz
+//   ./build/link_fuzz --messages 50000 --seed 7 --mode framed
+//   ./build/link_fuzz --replay link.bin
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include "host_hal.h"
+#include "../trainer_core.h"
+#include "../trainer_charstats.h"
+#include "../trainer_profiles.h"
+#include "../trainer_history.h"
+#include "../trainer_frame.h"
+#include "esp_shim/driver/uart.h"
+#include "esp_shim/esp_system.h"
+#include "../../esp32s3_wifi_companion/wifi_companion/main/trainer_protocol.h"
+
+static double seconds() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t rng = 1;
+
+static uint32_t nextRandom() {
+  rng ^= rng << 13;
+  rng ^= rng >> 17;
+  rng ^= rng << 5;
+  return rng;
+}
+
+static int randomIn(int lo, int hi) {
+  return lo + (int)(nextRandom() % (uint32_t)(hi - lo + 1));
+}
+
+static bool verbose = false;
+static double startTime;
+
+// ---- The companion's platform ------------------------------------------------------
+
+// Bytes one side wrote that the pty has not taken yet
+struct Queue {
+  static const size_t SIZE = 1 << 20;
+  uint8_t data[SIZE];
+  size_t head, len;
+};
+
+static Queue toEsp, toTeensy;
+static unsigned long long teensyWritten, espWritten;    // into the queues
+static unsigned long long espReceived, teensyReceived;  // read from the pty
+static int teensyFd = -1, espFd = -1;  // pty master and slave
+static unsigned long espRestarts = 0;
+
+static void push(Queue& q, const void* data, size_t len) {
+  if (q.len + len > Queue::SIZE) {
+    fprintf(stderr, "link_fuzz: queue overflow\n");
+    exit(1);
+  }
+  const uint8_t* p = (const uint8_t*)data;
+  for (size_t i = 0; i < len; i++) q.data[(q.head + q.len + i) % Queue::SIZE] = p[i];
+  q.len += len;
+}
+
+// Acks the companion's web server would have matched to a waiting request
+static const int ACKS_MAX = 4096;
+static struct {
+  unsigned long id;
+  char result[12];
+} acks[ACKS_MAX];
+static int ackCount = 0;
+
+extern "C" {
+
+int uart_write_bytes(uart_port_t port, const void* data, size_t len) {
+  push(toTeensy, data, len);
+  espWritten += len;
+  return (int)len;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks) {
+  return 0;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud) {
+  return 0;  // the pty has no rate
+}
+
+uint32_t esp_log_timestamp(void) {
+  return (uint32_t)((seconds() - startTime) * 1000);
+}
+
+void esp_restart(void) {
+  espRestarts++;
+}
+
+void shim_log(char level, const char* tag, const char* fmt, ...) {
+  if (!verbose) return;
+  va_list args;
+  va_start(args, fmt);
+  printf("ESP %c (%s) ", level, tag);
+  vprintf(fmt, args);
+  printf("\n");
+  va_end(args);
+}
+
+void web_backup_line(const char* line) {
+}
+
+void web_command_ack(const char* ack) {
+  if (ackCount == ACKS_MAX) return;
+  char* end;
+  acks[ackCount].id = strtoul(ack, &end, 10);
+  snprintf(acks[ackCount].result, sizeof(acks[0].result), "%s", *end == ',' ? end + 1 : "");
+  ackCount++;
+}
+
+void web_audio_frame(const uint8_t* body, size_t len) {
+}
+
+void web_spectrum_frame(const uint8_t* body, size_t len) {
+}
+
+void web_link_hello(void) {
+}
+
+}  // extern "C"
+
+// ---- The pty ------------------------------------------------------------------------
+
+static void teensyTap(const uint8_t* data, size_t len) {
+  push(toEsp, data, len);
+  teensyWritten += len;
+}
+
+// Whatever state noise left a receiver in, two zeros leave it in an empty
+// frame, 'x' and a zero close that as bad and the newline ends any text:
+// the next line or frame is read whole
+static const uint8_t RECEIVER_RESET[] = { 0, 0, 'x', 0, '\n' };
+
+static double parseSeconds = 0;  // inside link_receive()
+static double deliveredAt = 0;   // the companion had read everything the trainer wrote
+
+static bool drain(Queue& q, int fd) {
+  bool moved = false;
+  while (q.len > 0) {
+    size_t run = q.len < Queue::SIZE - q.head ? q.len : Queue::SIZE - q.head;
+    ssize_t n = write(fd, q.data + q.head, run);
+    if (n <= 0) break;
+    q.head = (q.head + n) % Queue::SIZE;
+    q.len -= n;
+    moved = true;
+  }
+  return moved;
+}
+
+// Moves whatever the pty takes in both directions and lets each side read;
+// false if nothing moved
+static bool service() {
+  bool moved = drain(toEsp, teensyFd);
+  moved |= drain(toTeensy, espFd);
+
+  uint8_t buf[1024];
+  ssize_t n;
+  while ((n = read(espFd, buf, sizeof(buf))) > 0) {
+    double t = seconds();
+    link_receive(buf, n);
+    parseSeconds += seconds() - t;
+    espReceived += n;
+    if (espReceived == teensyWritten) deliveredAt = seconds();
+    moved = true;
+  }
+  while ((n = read(teensyFd, buf, sizeof(buf))) > 0) {
+    for (ssize_t i = 0; i < n; i++) linkReceiveByte(buf[i]);
+    teensyReceived += n;
+    moved = true;
+  }
+  return moved;
+}
+
+// Until both directions are delivered, answers included
+static void settle() {
+  double idleSince = seconds();
+  while (toEsp.len || toTeensy.len || espReceived != teensyWritten || teensyReceived != espWritten) {
+    if (service()) {
+      idleSince = seconds();
+      continue;
+    }
+    if (seconds() - idleSince > 1.0) {
+      fprintf(stderr, "link_fuzz: pty stalled (%llu of %llu bytes to the companion, %llu of %llu back)\n",
+              espReceived, teensyWritten, teensyReceived, espWritten);
+      exit(1);
+    }
+    pollfd fds[2] = { { espFd, POLLIN, 0 }, { teensyFd, POLLIN, 0 } };
+    poll(fds, 2, 10);
+  }
+}
+
+static void openPty() {
+  if (openpty(&teensyFd, &espFd, nullptr, nullptr, nullptr) < 0) {
+    perror("openpty");
+    exit(1);
+  }
+  termios t;
+  tcgetattr(espFd, &t);
+  cfmakeraw(&t);
+  tcsetattr(espFd, TCSANOW, &t);
+  fcntl(teensyFd, F_SETFL, fcntl(teensyFd, F_GETFL) | O_NONBLOCK);
+  fcntl(espFd, F_SETFL, fcntl(espFd, F_GETFL) | O_NONBLOCK);
+}
+
+// ---- The trainer's state and the companion's copy ----------------------------------
+
+static const char MORSE_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.,?/=";
+
+static char expectedDecoded[1024];  // everything the trainer decoded, as the companion shows it
+static size_t expectedDecodedLen = 0;
+static char lastCurrent[LESSON_TEXT_MAX + 1];
+
+static void expectDecoded(const char* text) {
+  size_t len = strlen(text);
+  if (expectedDecodedLen + len >= sizeof(expectedDecoded)) {
+    size_t drop = expectedDecodedLen + len - sizeof(expectedDecoded) / 2;
+    memmove(expectedDecoded, expectedDecoded + drop, expectedDecodedLen - drop);
+    expectedDecodedLen -= drop;
+  }
+  memcpy(expectedDecoded + expectedDecodedLen, text, len);
+  expectedDecodedLen += len;
+  expectedDecoded[expectedDecodedLen] = '\0';
+}
+
+// After a fuzz burst the companion's decoded text may hold noise; the
+// check starts again from what it shows
+static void acceptDecoded() {
+  expectedDecodedLen = 0;
+  expectedDecoded[0] = '\0';
+  expectDecoded(g_status.decoded_text);
+}
+
+struct Divergence {
+  const char* field;
+  unsigned long count;
+};
+
+static Divergence divergences[] = {
+  { "lesson", 0 }, { "freq", 0 }, { "speed", 0 }, { "effspeed", 0 }, { "accuracy", 0 }, { "flags", 0 },
+  { "waveform", 0 }, { "output", 0 }, { "stats", 0 }, { "profiles", 0 }, { "decoded", 0 }, { "current", 0 },
+};
+const int DIVERGENCE_FIELDS = sizeof(divergences) / sizeof(divergences[0]);
+
+static int expect(int field, bool ok) {
+  if (ok) return 0;
+  divergences[field].count++;
+  if (verbose) printf("diverged: %s\n", divergences[field].field);
+  return 1;
+}
+
+static bool near(float a, float b) {
+  return fabsf(a - b) <= 0.051f;
+}
+
+// Fields that differ between the trainer and g_status
+static int compareState() {
+  FrameStatus s;
+  s.lesson = kochLesson;
+  s.speed = kochSpeed;
+  s.effectiveSpeed = kochEffectiveSpeed;
+  s.frequency = (uint16_t)(sidetoneFreq + 0.5f);
+  int diverged = 0;
+  diverged += expect(0, g_status.lesson == s.lesson);
+  diverged += expect(1, g_status.frequency == s.frequency);
+  diverged += expect(2, g_status.speed == s.speed);
+  diverged += expect(3, g_status.effective_speed == s.effectiveSpeed);
+  diverged += expect(4, near(g_status.accuracy, (uint16_t)(kochAccuracy * 10 + 0.5f) / 10.0f));
+  diverged += expect(5, g_status.decoder_enabled == decoderEnabled && g_status.koch_mode == kochModeEnabled &&
+                          g_status.sending == kochSending && g_status.listening == kochListening);
+  diverged += expect(6, strcmp(g_status.waveform, waveformNames[currentWaveform]) == 0);
+  diverged += expect(7, strcmp(g_status.output, useHeadphones ? "Headphones" : "Speaker") == 0);
+  diverged += expect(8, g_status.sessions == stats.sessionsCompleted && g_status.characters == stats.charactersDecoded &&
+                          near(g_status.best_wpm, stats.bestWPM));
+
+  bool profilesOk = g_status.profile == profiles.active + 1 && g_status.profile_count == PROFILE_COUNT;
+  for (int i = 0; profilesOk && i < PROFILE_COUNT; i++) profilesOk = strcmp(g_status.profiles[i], profileName(i)) == 0;
+  diverged += expect(9, profilesOk);
+
+  // The companion keeps the tail of the decoded text
+  size_t shown = g_status.decoded_len;
+  size_t wanted = expectedDecodedLen < 200 ? expectedDecodedLen : 200;
+  diverged += expect(10, shown >= wanted && shown <= expectedDecodedLen &&
+                           memcmp(g_status.decoded_text, expectedDecoded + expectedDecodedLen - shown, shown) == 0);
+  diverged += expect(11, strncmp(g_status.current_text, lastCurrent, sizeof(g_status.current_text) - 1) == 0);
+  return diverged;
+}
+
+// Whatever arrived, g_status must stay usable by the web server
+static int checkInvariants() {
+  int broken = 0;
+  auto check = [&](bool ok, const char* what) {
+    if (ok) return;
+    broken++;
+    if (verbose) printf("invariant: %s\n", what);
+  };
+  check(memchr(g_status.current_text, 0, sizeof(g_status.current_text)) != nullptr, "current_text terminated");
+  check(g_status.decoded_len < sizeof(g_status.decoded_text) && g_status.decoded_text[g_status.decoded_len] == '\0' &&
+          strlen(g_status.decoded_text) == g_status.decoded_len,
+        "decoded_text length");
+  check(memchr(g_status.waveform, 0, sizeof(g_status.waveform)) && memchr(g_status.output, 0, sizeof(g_status.output)),
+        "waveform and output terminated");
+  bool known = false;
+  for (int i = 0; i < 4; i++) known |= strcmp(g_status.waveform, waveformNames[i]) == 0;
+  check(known, "waveform known");
+  check(strcmp(g_status.output, "Headphones") == 0 || strcmp(g_status.output, "Speaker") == 0, "output known");
+  check(isfinite(g_status.accuracy) && g_status.accuracy >= 0 && g_status.accuracy <= 100, "accuracy in range");
+  check(isfinite(g_status.best_wpm) && g_status.best_wpm >= 0 && g_status.best_wpm <= 100, "best wpm in range");
+  check(isfinite(g_status.copy_wpm) && g_status.copy_wpm >= 0, "copy wpm finite");
+  check(g_status.char_stat_count >= 0 && g_status.char_stat_count <= CHAR_STATS_MAX, "char stat count");
+  for (int i = 0; i < g_status.char_stat_count && i < CHAR_STATS_MAX; i++) {
+    check(g_status.char_stats[i].confusion_count <= CHAR_CONFUSIONS_MAX, "confusion count");
+  }
+  check(g_status.profile_count >= 0 && g_status.profile_count <= PROFILES_MAX, "profile count");
+  for (int i = 0; i < PROFILES_MAX; i++) check(memchr(g_status.profiles[i], 0, PROFILE_NAME_LEN) != nullptr, "profile name terminated");
+  for (int t = 0; t < HISTORY_TIER_COUNT; t++) {
+    check(g_status.history[t].newest >= 0 && g_status.history[t].newest < HISTORY_SLOTS_MAX, "history slot");
+  }
+  return broken;
+}
+
+// ---- Trainer activity ---------------------------------------------------------------
+
+static void randomText(char* out, size_t maxLen) {
+  size_t len = randomIn(1, (int)maxLen);
+  for (size_t i = 0; i < len; i++) {
+    out[i] = (i % 6 == 5) ? ' ' : MORSE_CHARS[nextRandom() % (sizeof(MORSE_CHARS) - 1)];
+  }
+  out[len] = '\0';
+}
+
+static unsigned long commandId = 1;
+
+// One thing the trainer does that the companion hears about; waits between
+// are virtual time, so decoded batches and status windows close as on the device
+static void trainerAction() {
+  switch (nextRandom() % 10) {
+  case 0:
+  case 1:
+  case 2: {  // a setting or the lesson state changes
+    switch (nextRandom() % 9) {
+    case 0: kochLesson = randomIn(1, KOCH_LESSON_COUNT); break;
+    case 1: sidetoneFreq = randomIn(300, 1200); break;
+    case 2: kochSpeed = randomIn(5, 50); break;
+    case 3: kochEffectiveSpeed = randomIn(5, kochSpeed); break;
+    case 4: kochAccuracy = randomIn(0, 1000) / 10.0f + randomIn(0, 9) / 100.0f; break;
+    case 5: decoderEnabled = !decoderEnabled; break;
+    case 6: currentWaveform = randomIn(0, 3); break;
+    case 7: useHeadphones = !useHeadphones; break;
+    default:
+      kochSending = nextRandom() & 1;
+      kochListening = !kochSending && (nextRandom() & 1);
+      break;
+    }
+    sendStatusToWiFi();
+    break;
+  }
+  case 3: {  // a decoded word
+    int len = randomIn(1, 8);
+    for (int i = 0; i < len; i++) {
+      char c = MORSE_CHARS[nextRandom() % (sizeof(MORSE_CHARS) - 1)];
+      bool miscopied = nextRandom() % 8 == 0;
+      char shown[4];
+      snprintf(shown, sizeof(shown), miscopied ? "[%c]" : "%c", c);
+      expectDecoded(shown);
+      sendDecodedCharToWiFi(c, miscopied);
+      simAdvance(randomIn(40, 200));
+      linkPoll();
+    }
+    expectDecoded(" ");
+    sendDecodedCharToWiFi(' ', false);
+    break;
+  }
+  case 4: {  // the lesson text
+    randomText(lastCurrent, LESSON_TEXT_MAX);
+    sendCurrentTextToWiFi(lastCurrent);
+    break;
+  }
+  case 5: {  // a session ends
+    stats.sessionsCompleted++;
+    stats.charactersDecoded += randomIn(10, 300);
+    stats.bestWPM = randomIn(50, 400) / 10.0f;
+    sendStatsToWiFi();
+    if (nextRandom() % 4 == 0) historyRecordSession(kochAccuracy, randomIn(10, 300));
+    break;
+  }
+  case 6: {  // the profile is renamed
+    char name[PROFILE_NAME_MAX + 1];
+    randomText(name, PROFILE_NAME_MAX);
+    for (char* p = name; *p; p++) {
+      if (!isalnum((unsigned char)*p)) *p = '-';
+    }
+    renameProfile(name);
+    break;
+  }
+  case 7:
+    linkPing();
+    break;
+  default: {  // a web page command, acked by the trainer
+    char line[64];
+    int value = randomIn(300, 1200);
+    switch (nextRandom() % 3) {
+    case 0: snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:SET_FREQ:%d", commandId++, value); break;
+    case 1: snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:SET_SPEED:%d", commandId++, randomIn(5, 50)); break;
+    default: snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:TOGGLE_DECODER", commandId++); break;
+    }
+    link_send_line(line);
+    break;
+  }
+  }
+  simAdvance(randomIn(0, 30));
+  linkPoll();
+}
+
+// Everything the trainer holds back goes out: decoded batches and status windows
+static void flushTrainer() {
+  simAdvance(2000);  // DECODED_LATENCY
+  linkPoll();
+}
+
+// ---- Runs --------------------------------------------------------------------------
+
+static int compareDoubles(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return x < y ? -1 : x > y;
+}
+
+static unsigned long companionMessages() {
+  return g_status.link.lines + g_status.link.frames;
+}
+
+static void reportStream(const char* mode, int count) {
+  unsigned long messages = companionMessages();
+  unsigned long long bytes = espReceived;
+  double t0 = seconds();
+  for (int i = 0; i < count; i++) {
+    trainerAction();
+    service();
+  }
+  flushTrainer();
+  settle();
+  double elapsed = seconds() - t0;
+  messages = companionMessages() - messages;
+  bytes = espReceived - bytes;
+  int diverged = compareState();
+  printf("%-7s stream    %8lu msgs  %9.0f msgs/s  %7.2f MB/s  diverged fields %d\n", mode, messages,
+         messages / elapsed, bytes / elapsed / 1e6, diverged);
+}
+
+static int reportLockstep(const char* mode, int count) {
+  static double latency[200000], parse[200000];
+  if (count > 200000) count = 200000;
+  int samples = 0, steps = 0;
+  unsigned long diverged = 0;
+  for (int i = 0; i < count; i++) {
+    unsigned long messages = companionMessages();
+    double parsed = parseSeconds;
+    unsigned long long target = teensyWritten;
+    trainerAction();
+    flushTrainer();
+    double queued = seconds();
+    settle();
+    steps++;
+    diverged += compareState() > 0;
+    unsigned long got = companionMessages() - messages;
+    if (got == 0 || teensyWritten == target) continue;
+    latency[samples] = (deliveredAt - queued) * 1e6;
+    parse[samples] = (parseSeconds - parsed) * 1e9 / got;
+    samples++;
+  }
+  qsort(latency, samples, sizeof(double), compareDoubles);
+  qsort(parse, samples, sizeof(double), compareDoubles);
+  auto pct = [&](double* v, double p) { return samples ? v[(int)(p * (samples - 1))] : 0.0; };
+  printf("%-7s lockstep  %8d steps  latency us p50 %6.1f p90 %6.1f p99 %6.1f max %7.1f  "
+         "parse ns/msg p50 %6.0f p99 %6.0f  diverged steps %lu\n",
+         mode, steps, pct(latency, 0.5), pct(latency, 0.9), pct(latency, 0.99), pct(latency, 1.0),
+         pct(parse, 0.5), pct(parse, 0.99), diverged);
+  return diverged > 0;
+}
+
+// ---- Fuzz --------------------------------------------------------------------------
+
+static const char* const FUZZ_PREFIXES[] = {
+  PREFIX_STATUS, PREFIX_STATS, PREFIX_DECODED, PREFIX_CURRENT, PREFIX_CHARSTAT, PREFIX_PROFILES,
+  PREFIX_HISTORY, PREFIX_HELLO, PREFIX_BAUD, PREFIX_ACK, MSG_PING, "TEENSY:READY", "",
+};
+static const char* const FUZZ_FIELDS[] = {
+  "LESSON", "FREQ", "SPEED", "EFFSPEED", "ACC", "DEC", "KOCH", "WAVE", "OUT", "SEND", "LISTEN",
+  "SESSIONS", "CHARS", "BESTWPM",
+};
+static const char* const FUZZ_VALUES[] = {
+  "0", "1", "-1", "12", "600", "99999999999", "1e308", "nan", "inf", "-0", "100.1", "93.5", "Sine",
+  "Square", "Speaker", "Headphones", "Chirp", "", "1x", " 5", "0x10", "4294967296",
+};
+
+static void randomPrintable(char* out, size_t len) {
+  for (size_t i = 0; i < len; i++) out[i] = (char)randomIn(0x20, 0x7E);
+  out[len] = '\0';
+}
+
+// A line for the companion built from protocol pieces, then damaged
+static void fuzzLine(char* line, size_t size) {
+  size_t n = snprintf(line, size, "%s", FUZZ_PREFIXES[nextRandom() % (sizeof(FUZZ_PREFIXES) / sizeof(FUZZ_PREFIXES[0]))]);
+  int fields = randomIn(0, 12);
+  for (int i = 0; i < fields && n < size - 1; i++) {
+    char key[48], value[64];
+    switch (nextRandom() % 6) {
+    case 0: randomPrintable(key, randomIn(0, 40)); break;  // overlong for the 16-byte key
+    default: snprintf(key, sizeof(key), "%s", FUZZ_FIELDS[nextRandom() % (sizeof(FUZZ_FIELDS) / sizeof(FUZZ_FIELDS[0]))]); break;
+    }
+    switch (nextRandom() % 5) {
+    case 0: randomPrintable(value, randomIn(0, 60)); break;  // overlong for the 32-byte value
+    default: snprintf(value, sizeof(value), "%s", FUZZ_VALUES[nextRandom() % (sizeof(FUZZ_VALUES) / sizeof(FUZZ_VALUES[0]))]); break;
+    }
+    n += snprintf(line + n, size - n, "%s%s%s%s", i ? "," : "", key, nextRandom() % 8 ? "=" : "", value);
+    if (n >= size) n = size - 1;
+  }
+  if (nextRandom() % 4 == 0) {  // separators and bytes where they do not belong
+    int hits = randomIn(1, 4);
+    for (int i = 0; i < hits && n > 0; i++) line[nextRandom() % n] = "=,|[] \t\x7f\x01"[nextRandom() % 10];
+  }
+}
+
+static void fuzzCompanion(int items) {
+  for (int i = 0; i < items; i++) {
+    uint8_t frame[FRAME_ENCODED_MAX];
+    char line[600];
+    size_t n;
+    switch (nextRandom() % 6) {
+    case 0:
+    case 1:  // a damaged protocol line, sometimes longer than the companion's buffer
+      fuzzLine(line, nextRandom() % 8 ? 200 : sizeof(line));
+      teensyTap((const uint8_t*)line, strlen(line));
+      teensyTap((const uint8_t*)"\n", 1);
+      break;
+    case 2: {  // a frame with a good CRC and any type and body
+      uint8_t body[FRAME_BODY_MAX];
+      size_t len = randomIn(0, FRAME_BODY_MAX);
+      for (size_t j = 0; j < len; j++) body[j] = nextRandom();
+      n = frameEncode(randomIn(0, FRAME_BENCH + 1), nextRandom(), body, len, frame);
+      teensyTap(frame, n);
+      break;
+    }
+    case 3: {  // a text frame carrying a damaged line
+      fuzzLine(line, FRAME_BODY_MAX + 1);
+      n = frameEncode(FRAME_TEXT, nextRandom(), line, strlen(line), frame);
+      teensyTap(frame, n);
+      break;
+    }
+    case 4: {  // a real status frame hit in flight
+      FrameStatus s = { (uint8_t)randomIn(0, 255), (uint8_t)randomIn(0, 255), (uint8_t)randomIn(0, 255), (uint8_t)randomIn(0, 255),
+                        (uint16_t)nextRandom(), (uint16_t)nextRandom(), (uint8_t)nextRandom() };
+      n = frameEncode(nextRandom() & 1 ? FRAME_STATUS : FRAME_STATUS_DELTA, nextRandom(), &s, sizeof(s), frame);
+      int hits = randomIn(0, 3);
+      for (int j = 0; j < hits; j++) frame[randomIn(0, (int)n - 1)] ^= 1 << randomIn(0, 7);
+      teensyTap(frame, n);
+      break;
+    }
+    default: {  // line noise
+      n = randomIn(1, 300);
+      for (size_t j = 0; j < n; j++) frame[j % sizeof(frame)] = nextRandom();
+      teensyTap(frame, n < sizeof(frame) ? n : sizeof(frame));
+      break;
+    }
+    }
+  }
+  teensyTap(RECEIVER_RESET, sizeof(RECEIVER_RESET));
+}
+
+// Commands and noise for the trainer; each command with an id must come back
+// acked with the result its value calls for
+struct ExpectedAck {
+  unsigned long id;
+  const char* result;
+};
+
+static int fuzzTrainer(int items, ExpectedAck* expected) {
+  int count = 0;
+  for (int i = 0; i < items; i++) {
+    char line[300];
+    switch (nextRandom() % 5) {
+    case 0:
+    case 1: {
+      unsigned long id = commandId++;
+      int v;
+      const char* result = ACK_OK;
+      switch (nextRandom() % 6) {
+      case 0:
+        v = randomIn(0, 1500);
+        snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:SET_FREQ:%d", id, v);
+        if (v < 300 || v > 1200) result = ACK_RANGE;
+        break;
+      case 1:
+        v = randomIn(0, 60);
+        snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:SET_SPEED:%d", id, v);
+        if (v < 5 || v > 50) result = ACK_RANGE;
+        break;
+      case 2:
+        v = randomIn(0, KOCH_LESSON_COUNT + 5);
+        snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:SET_LESSON:%d", id, v);
+        if (v < 1 || v > KOCH_LESSON_COUNT) result = ACK_RANGE;
+        break;
+      case 3:
+        v = randomIn(0, PROFILE_COUNT + 1);
+        snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:PROFILE:%d", id, v);
+        if (v < 1 || v > PROFILE_COUNT) result = ACK_RANGE;
+        break;
+      case 4:
+        snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:TOGGLE_DECODER", id);
+        break;
+      default: {
+        char name[24];
+        randomPrintable(name, randomIn(1, 20));
+        for (char* p = name; *p; p++) {
+          if (*p == ':') *p = '_';
+        }
+        snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:Z%s", id, name);
+        result = ACK_UNKNOWN;
+        break;
+      }
+      }
+      expected[count++] = { id, result };
+      link_send_line(line);
+      break;
+    }
+    case 2: {  // a command the trainer cannot answer
+      static const char* const unanswerable[] = { PREFIX_CMD, PREFIX_CMD ":START", PREFIX_CMD "12", PREFIX_CMD "x:START" };
+      link_send_line(unanswerable[nextRandom() % 4]);
+      break;
+    }
+    case 3: {  // a line or frame of junk
+      randomPrintable(line, randomIn(0, 120));
+      if (nextRandom() & 1) {
+        uart_write_bytes(UART_NUM_1, line, strlen(line));
+        uart_write_bytes(UART_NUM_1, "\n", 1);
+      } else {
+        uint8_t frame[FRAME_ENCODED_MAX];
+        size_t n = frameEncode(FRAME_TEXT, nextRandom(), line, strlen(line), frame);
+        if (nextRandom() & 1) frame[randomIn(0, (int)n - 1)] ^= 0x10;
+        uart_write_bytes(UART_NUM_1, frame, n);
+      }
+      uart_write_bytes(UART_NUM_1, RECEIVER_RESET, sizeof(RECEIVER_RESET));
+      break;
+    }
+    default: {  // noise
+      uint8_t noise[64];
+      size_t n = randomIn(1, sizeof(noise));
+      for (size_t j = 0; j < n; j++) noise[j] = nextRandom();
+      uart_write_bytes(UART_NUM_1, noise, n);
+      uart_write_bytes(UART_NUM_1, RECEIVER_RESET, sizeof(RECEIVER_RESET));
+      break;
+    }
+    }
+  }
+  return count;
+}
+
+// What a companion that lost track gets: its GET_ requests answered and the
+// periodic status snapshot
+static void resync() {
+  static char request[16];
+  const char* const requests[] = { "GET_STATS", "GET_PROFILES", "GET_HISTORY" };
+  for (const char* r : requests) {
+    snprintf(request, sizeof(request), "%s", r);
+    processWiFiMessage(request);
+  }
+  sendCurrentTextToWiFi(lastCurrent);
+  simAdvance(120000);
+  linkPoll();
+  settle();
+  acceptDecoded();
+}
+
+static int reportFuzz(const char* mode, int bursts) {
+  static ExpectedAck expected[64];
+  unsigned long broken = 0, outOfStep = 0, ackErrors = 0, commands = 0;
+  uint32_t badFields = g_status.link.bad_fields, badFrames = g_status.link.bad_frames;
+  uint32_t overflows = g_status.link.overflows, garbled = g_status.link.garbled;
+  unsigned long long bytes = teensyWritten + espWritten;
+  for (int b = 0; b < bursts; b++) {
+    fuzzCompanion(randomIn(1, 20));
+    settle();
+    broken += checkInvariants() > 0;
+    ackCount = 0;
+    int count = fuzzTrainer(randomIn(1, 20), expected);
+    commands += count;
+    settle();
+    for (int i = 0; i < count; i++) {
+      int j = 0;
+      while (j < ackCount && acks[j].id != expected[i].id) j++;
+      if (j < ackCount && strcmp(acks[j].result, expected[i].result) == 0) continue;
+      ackErrors++;
+      if (verbose) printf("ack %lu: expected %s, got %s\n", expected[i].id, expected[i].result, j < ackCount ? acks[j].result : "nothing");
+    }
+    resync();
+    outOfStep += compareState() > 0;
+  }
+  printf("%-7s fuzz      %8d bursts %9llu bytes  commands %lu  bad fields %lu, bad frames %lu, overflows %lu, "
+         "garbled %lu  |  broken %lu, out of step %lu, ack errors %lu\n",
+         mode, bursts, teensyWritten + espWritten - bytes, commands, (unsigned long)(g_status.link.bad_fields - badFields),
+         (unsigned long)(g_status.link.bad_frames - badFrames), (unsigned long)(g_status.link.overflows - overflows),
+         (unsigned long)(g_status.link.garbled - garbled), broken, outOfStep, ackErrors);
+  return broken || outOfStep || ackErrors;
+}
+
+// ---- Setup -------------------------------------------------------------------------
+
+// Both ends fresh; with frames the HELLO exchange runs first, as on the device
+static void startLink(bool framed) {
+  simReset(rng);
+  loadSettings();
+  wifiEnabled = true;
+  espConnected = true;
+  linkDown();
+  trainer_status_reset();
+  link_set_limits(LINK_BAUD_DEFAULT, false);
+  expectedDecodedLen = 0;
+  expectedDecoded[0] = '\0';
+  lastCurrent[0] = '\0';
+  for (int i = 0; i < DIVERGENCE_FIELDS; i++) divergences[i].count = 0;
+
+  // A restarted companion clears its link state with TEENSY:READY
+  static const char ready[] = "TEENSY:READY\n";
+  teensyTap((const uint8_t*)ready, sizeof(ready) - 1);
+  settle();
+  if (framed) {
+    linkSendHello();
+    settle();
+    if (!linkFramed || !g_status.link.framed) {
+      fprintf(stderr, "link_fuzz: HELLO exchange did not agree on frames\n");
+      exit(1);
+    }
+    // The page's stats reset clears training figures, not what HELLO agreed
+    trainer_status_reset();
+    if (!g_status.link.framed || !g_status.link.acks) {
+      fprintf(stderr, "link_fuzz: a status reset dropped the link state\n");
+      exit(1);
+    }
+  }
+  resync();
+}
+
+static int replay(const char* path) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return 1;
+  }
+  startLink(false);
+  unsigned long messages = companionMessages();
+  unsigned long long bytes = espReceived;
+  double t0 = seconds();
+  uint8_t buf[256];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    teensyTap(buf, n);
+    service();
+  }
+  fclose(f);
+  settle();
+  double elapsed = seconds() - t0;
+  messages = companionMessages() - messages;
+  printf("replay  %s: %llu bytes, %lu messages (%lu framed), %.0f msgs/s\n", path, espReceived - bytes, messages,
+         (unsigned long)g_status.link.frames, messages / elapsed);
+  printf("        bad frames %lu, lost %lu, overflows %lu, garbled %lu, bad fields %lu, invariants broken %d\n",
+         (unsigned long)g_status.link.bad_frames, (unsigned long)g_status.link.lost_frames, (unsigned long)g_status.link.overflows,
+         (unsigned long)g_status.link.garbled, (unsigned long)g_status.link.bad_fields, checkInvariants());
+  printf("        lesson %d, %d Hz, %d/%d WPM, accuracy %.1f, %lu sessions, decoded \"%s\"\n", g_status.lesson,
+         g_status.frequency, g_status.speed, g_status.effective_speed, g_status.accuracy, (unsigned long)g_status.sessions,
+         g_status.decoded_text + (g_status.decoded_len > 40 ? g_status.decoded_len - 40 : 0));
+  return checkInvariants() > 0;
+}
+
+int main(int argc, char** argv) {
+  int count = 20000;
+  const char* mode = "both";
+  const char* replayPath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--messages") == 0 && i + 1 < argc) count = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) rng = strtoul(argv[++i], nullptr, 10) | 1;
+    else if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) mode = argv[++i];
+    else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replayPath = argv[++i];
+    else if (strcmp(argv[i], "--verbose") == 0) verbose = true;
+    else {
+      fprintf(stderr, "usage: %s [--messages N] [--seed S] [--mode text|framed|both] [--replay FILE] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+  startTime = seconds();
+  simSetEcho(false, false);
+  simSetLinkTap(teensyTap);
+  openPty();
+  if (replayPath) return replay(replayPath);
+
+  printf("%d messages per run through a pty, seed %lu\n", count, (unsigned long)rng);
+  int failed = 0;
+  for (int framed = 0; framed < 2; framed++) {
+    const char* name = framed ? "framed" : "text";
+    if (strcmp(mode, "both") != 0 && strcmp(mode, name) != 0) continue;
+    startLink(framed);
+    reportStream(name, count);
+    failed |= compareState() > 0;
+    failed |= reportLockstep(name, count / 10);
+    failed |= reportFuzz(name, count / 20);
+  }
+  for (int i = 0; i < DIVERGENCE_FIELDS; i++) {
+    if (divergences[i].count) printf("diverged: %s %lu times\n", divergences[i].field, divergences[i].count);
+  }
+  printf("%s\n", failed ? "FAILED" : "ok");
+  return failed;
+}
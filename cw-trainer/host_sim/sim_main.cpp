@@ -0,0 +1,528 @@
+// Host simulation of the trainer core: runs Koch sessions against a simulated
+// student on a virtual clock, much faster than real time.
+//
+//   ./build/cw_sim --sessions 1000 --errors 0.02 --seed 7
+//   ./build/cw_sim --sessions 200 --drops 0.02 --extras 0.02   (scored by alignment)
+//   ./build/cw_sim --sessions 200 --profiles 4   (sessions rotate through operator profiles)
+//   ./build/cw_sim --sessions 300 --days 90 --history   (spread over 90 days, then the charts)
+//   ./build/cw_sim --sessions 50 --link --framed   (companion link traffic, text or framed)
+//   ./build/cw_sim --sessions 50 --monitor   (live audio frames, decoded and checked)
+//   ./build/cw_sim --sessions 50 --spectrum   (waterfall frames, peaks checked against the sidetone)
+//   ./build/cw_sim --sessions 50 --link-capture link.bin && ./build/link_fuzz --replay link.bin
+//   ./build/cw_sim --sessions 1 --verbose --dump-screen
+//   ./build/cw_sim --sessions 5 --record koch.trace
+//   ./build/cw_sim --replay koch.trace   (binary, or a TRACE DUMP console capture)
+//   ./build/cw_sim --sessions 20 --log koch.bin && ./build/cwlog2csv koch.bin
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "host_hal.h"
+#include "../trainer_core.h"
+#include "../trainer_trace.h"
+#include "../trainer_sessionlog.h"
+#include "../trainer_profiles.h"
+#include "../trainer_history.h"
+#include "../trainer_protocol.h"
+#include "../trainer_frame.h"
+#include "../trainer_monitor.h"
+#include "../trainer_spectrum.h"
+
+struct SimOptions {
+  int sessions = 200;
+  int lesson = 1;
+  int speed = 20;       // character speed; Farnsworth follows the core's 0.6 rule
+  float errors = 0.0f;  // chance the student keys a wrong character
+  float drops = 0.0f;   // chance the student misses a character altogether
+  float extras = 0.0f;  // chance the student keys an extra character after one
+  float jitter = 0.0f;  // +/- fraction applied to every keyed element and gap
+  int profiles = 1;     // operator profiles the sessions rotate through
+  float days = 0;       // wall-clock days the sessions are spread over
+  bool history = false;
+  uint32_t seed = 1;
+  bool verbose = false;
+  bool link = false;
+  bool framed = false;  // the simulated companion answers HELLO with frames
+  uint32_t baud = LINK_BAUD_DEFAULT;  // the simulated companion's highest rate
+  bool flow = true;                   // ... and whether it has RTS/CTS
+  int linkBench = 0;                  // seconds of LINK BENCH after the sessions
+  bool monitor = false;               // a browser listens to the audio throughout
+  bool spectrum = false;              // ... and watches the waterfall
+  bool dumpScreen = false;
+  const char* recordPath = nullptr;
+  const char* replayPath = nullptr;
+  const char* logPath = nullptr;
+  const char* linkCapturePath = nullptr;  // every byte written to the companion
+};
+
+// ---- Simulated student --------------------------------------------------------
+// The student copies the lesson by keying it back: a schedule of key edges at
+// absolute virtual times, replayed one millisecond tick at a time.
+
+const int MAX_KEY_EDGES = 2048;
+
+struct KeyEdge {
+  uint32_t at;
+  bool down;
+};
+
+static KeyEdge edges[MAX_KEY_EDGES];
+static int edgeCount = 0;
+static uint32_t studentRng = 1;
+
+static float studentUniform() {
+  studentRng ^= studentRng << 13;
+  studentRng ^= studentRng >> 17;
+  studentRng ^= studentRng << 5;
+  return (studentRng & 0xFFFFFF) / (float)0x1000000;
+}
+
+static uint32_t jittered(float ms, float jitter) {
+  float scale = 1.0f + jitter * (2.0f * studentUniform() - 1.0f);
+  return (uint32_t)(ms * scale + 0.5f);
+}
+
+static void addEdge(uint32_t at, bool down) {
+  if (edgeCount < MAX_KEY_EDGES) {
+    edges[edgeCount].at = at;
+    edges[edgeCount].down = down;
+    edgeCount++;
+  }
+}
+
+// Build the key schedule for the lesson text, starting at 'start'
+static uint32_t scheduleCopy(const char* text, uint32_t start, const SimOptions& opt) {
+  float dit = 1200.0f / kochSpeed;
+  float spacingDit = 1200.0f / kochEffectiveSpeed;  // Farnsworth gaps
+  size_t setLength = strlen(kochCharSet);
+  uint32_t t = start;
+
+  edgeCount = 0;
+  for (const char* p = text; *p; p++) {
+    if (*p == ' ') {
+      t += jittered(spacingDit * 4, opt.jitter);  // 3 already spent after the last char
+      continue;
+    }
+
+    if (opt.drops > 0 && studentUniform() < opt.drops) continue;
+
+    char keyed[2] = { *p, 0 };
+    if (opt.errors > 0 && studentUniform() < opt.errors && setLength > 1) {
+      keyed[0] = kochCharSet[(size_t)(studentUniform() * setLength) % setLength];
+    }
+    if (opt.extras > 0 && studentUniform() < opt.extras && setLength > 0) {
+      keyed[1] = kochCharSet[(size_t)(studentUniform() * setLength) % setLength];
+    }
+
+    for (int i = 0; i < 2 && keyed[i]; i++) {
+      const char* code = getMorseCode(keyed[i]);
+      for (const char* e = code; *e; e++) {
+        addEdge(t, true);
+        t += jittered(*e == '.' ? dit : dit * 3, opt.jitter);
+        addEdge(t, false);
+        t += jittered(dit, opt.jitter);
+      }
+      t += jittered(spacingDit * 3 - dit, opt.jitter);
+    }
+  }
+  return t;
+}
+
+// ---- Session driver -----------------------------------------------------------
+
+static unsigned long ticks = 0;
+static FILE* sessionLogFile = nullptr;
+static FILE* linkCaptureFile = nullptr;
+
+static void captureLink(const uint8_t* data, size_t len) {
+  fwrite(data, 1, len, linkCaptureFile);
+}
+
+// One main loop iteration: the tick, then the session log writer as on the Teensy
+static void step() {
+  trainerTick();
+  if (sessionLogFile) {
+    const uint8_t* block = sessionLogTakeBlock();
+    if (block) {
+      fwrite(block, 1, SESSION_LOG_BLOCK, sessionLogFile);
+      sessionLogRelease();
+    }
+  }
+  simAdvance(1);
+  ticks++;
+}
+
+static void tickUntil(uint32_t end) {
+  int next = 0;
+  while (halMillis() < end) {
+    while (next < edgeCount && edges[next].at <= halMillis()) {
+      simSetKey(edges[next].down);
+      next++;
+    }
+    step();
+  }
+}
+
+// Drive the trainer the way the web UI does, so traces capture it too
+static void companionCommand(const char* command) {
+  static unsigned long id = 0;
+  char line[64];
+  snprintf(line, sizeof(line), PREFIX_CMD "%lu:TEENSY:%s", ++id, command);
+  processWiFiMessage(line);
+}
+
+static bool runSession(const SimOptions& opt) {
+  companionCommand("START_KOCH");
+
+  // Listen while the trainer sends (bounded in case sending never completes)
+  uint32_t limit = halMillis() + 10 * 60 * 1000UL;
+  while (kochSending && halMillis() < limit) {
+    step();
+  }
+  if (kochSending) return false;
+
+  // Copy it back, then leave time for the last character to be decoded
+  edgeCount = 0;
+  uint32_t done = scheduleCopy(kochSentText, halMillis() + 500, opt);
+  tickUntil(done + 1500);
+  simSetKey(false);
+
+  companionCommand("EVALUATE_SESSION");
+  step();  // let the writer take the session's final block
+  return true;
+}
+
+static void usage(const char* prog) {
+  fprintf(stderr,
+          "usage: %s [--sessions N] [--lesson L] [--speed WPM] [--errors P]\n"
+          "          [--drops P] [--extras P] [--profiles N] [--days D] [--history]\n"
+          "          [--jitter F] [--seed S] [--verbose] [--link] [--framed]\n"
+          "          [--baud RATE] [--no-flow] [--link-bench SECONDS] [--monitor]\n"
+          "          [--spectrum]\n"
+          "          [--dump-screen] [--record FILE | --replay FILE] [--log FILE]\n"
+          "          [--link-capture FILE]\n",
+          prog);
+}
+
+static bool parseOptions(int argc, char** argv, SimOptions& opt) {
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (strcmp(a, "--sessions") == 0 && hasValue) opt.sessions = atoi(argv[++i]);
+    else if (strcmp(a, "--lesson") == 0 && hasValue) opt.lesson = atoi(argv[++i]);
+    else if (strcmp(a, "--speed") == 0 && hasValue) opt.speed = atoi(argv[++i]);
+    else if (strcmp(a, "--errors") == 0 && hasValue) opt.errors = atof(argv[++i]);
+    else if (strcmp(a, "--drops") == 0 && hasValue) opt.drops = atof(argv[++i]);
+    else if (strcmp(a, "--extras") == 0 && hasValue) opt.extras = atof(argv[++i]);
+    else if (strcmp(a, "--jitter") == 0 && hasValue) opt.jitter = atof(argv[++i]);
+    else if (strcmp(a, "--profiles") == 0 && hasValue) opt.profiles = atoi(argv[++i]);
+    else if (strcmp(a, "--days") == 0 && hasValue) opt.days = atof(argv[++i]);
+    else if (strcmp(a, "--history") == 0) opt.history = true;
+    else if (strcmp(a, "--seed") == 0 && hasValue) opt.seed = strtoul(argv[++i], NULL, 0);
+    else if (strcmp(a, "--verbose") == 0) opt.verbose = true;
+    else if (strcmp(a, "--link") == 0) opt.link = true;
+    else if (strcmp(a, "--framed") == 0) opt.link = opt.framed = true;
+    else if (strcmp(a, "--baud") == 0 && hasValue) {
+      opt.baud = strtoul(argv[++i], NULL, 0);
+      opt.link = opt.framed = true;
+    } else if (strcmp(a, "--no-flow") == 0) opt.flow = false;
+    else if (strcmp(a, "--monitor") == 0) opt.link = opt.framed = opt.monitor = true;
+    else if (strcmp(a, "--spectrum") == 0) opt.link = opt.framed = opt.spectrum = true;
+    else if (strcmp(a, "--link-bench") == 0 && hasValue) {
+      opt.linkBench = atoi(argv[++i]);
+      opt.link = opt.framed = true;
+    }
+    else if (strcmp(a, "--dump-screen") == 0) opt.dumpScreen = true;
+    else if (strcmp(a, "--record") == 0 && hasValue) opt.recordPath = argv[++i];
+    else if (strcmp(a, "--replay") == 0 && hasValue) opt.replayPath = argv[++i];
+    else if (strcmp(a, "--log") == 0 && hasValue) opt.logPath = argv[++i];
+    else if (strcmp(a, "--link-capture") == 0 && hasValue) {
+      opt.linkCapturePath = argv[++i];
+      opt.link = true;
+    }
+    else return false;
+  }
+  return opt.sessions > 0 && opt.profiles >= 1 && opt.profiles <= PROFILE_COUNT && opt.lesson >= 1 && opt.lesson <= KOCH_LESSON_COUNT && opt.speed >= 5 && opt.speed <= 50;
+}
+
+// ---- Trace files ----------------------------------------------------------------
+
+static uint8_t traceFile[TRACE_BUFFER_SIZE];
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// Raw binary as written by --record, or the text of a TRACE DUMP capture
+static size_t loadTrace(const char* path) {
+  static char file[TRACE_BUFFER_SIZE * 3];
+  FILE* f = fopen(path, "rb");
+  if (!f) return 0;
+  size_t len = fread(file, 1, sizeof(file) - 1, f);
+  fclose(f);
+  file[len] = '\0';
+
+  if (len >= 4 && memcmp(file, "CWT2", 4) == 0) {
+    if (len > sizeof(traceFile)) len = sizeof(traceFile);
+    memcpy(traceFile, file, len);
+    return len;
+  }
+
+  char* p = strstr(file, "TRACE BEGIN");
+  if (!p) return 0;
+  p = strchr(p, '\n');
+  size_t out = 0;
+  while (p && *p) {
+    p++;
+    if (strncmp(p, "TRACE END", 9) == 0) break;
+    while (*p && *p != '\n') {
+      int hi = hexValue(p[0]);
+      int lo = hi < 0 ? -1 : hexValue(p[1]);
+      if (lo < 0) {
+        p++;
+        continue;
+      }
+      if (out < sizeof(traceFile)) traceFile[out++] = (hi << 4) | lo;
+      p += 2;
+    }
+  }
+  return out;
+}
+
+static int replayTrace(const SimOptions& opt) {
+  size_t len = loadTrace(opt.replayPath);
+  if (len == 0) {
+    fprintf(stderr, "cannot read trace %s\n", opt.replayPath);
+    return 2;
+  }
+  if (!traceReplayBegin(traceFile, len, 1)) {
+    fprintf(stderr, "%s is not a trace\n", opt.replayPath);
+    return 2;
+  }
+
+  clock_t wallStart = clock();
+  uint32_t start = halMillis();
+  while (traceReplayPoll()) {
+    trainerTick();
+    simAdvance(1);
+    ticks++;
+  }
+  double wallSec = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+  double simSec = (halMillis() - start) / 1000.0;
+
+  printf("trace:          %s (%u bytes)\n", opt.replayPath, (unsigned)len);
+  printf("virtual time:   %.1f s\n", simSec);
+  printf("wall time:      %.3f s\n", wallSec);
+  if (wallSec > 0) printf("speedup:        %.0fx real time\n", simSec / wallSec);
+  printf("output:         %s\n", traceReplayMatched() ? "matches recording" : "DIFFERS from recording");
+  if (opt.dumpScreen) simDumpScreen(stdout);
+  return traceReplayMatched() ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+  SimOptions opt;
+  if (!parseOptions(argc, argv, opt)) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  simReset(opt.seed);
+  simSetEcho(opt.verbose, opt.verbose && opt.link);
+  if (opt.linkCapturePath) {
+    linkCaptureFile = fopen(opt.linkCapturePath, "wb");
+    if (!linkCaptureFile) {
+      fprintf(stderr, "cannot write link capture %s\n", opt.linkCapturePath);
+      return 2;
+    }
+    simSetLinkTap(captureLink);
+  }
+  studentRng = opt.seed * 2654435761u + 1;
+
+  // Same bring-up order as setup() on the Teensy
+  loadSettings();
+  espConnected = opt.link;
+  trainerBegin();
+
+  if (opt.replayPath) return replayTrace(opt);
+  if (opt.framed) {
+    simCompanionStart(opt.baud, opt.flow);
+    tickUntil(halMillis() + 50);  // HELLO, and BAUD: if the rates allow
+  }
+  if (opt.monitor) {
+    char line[] = PREFIX_AUDIO "1";  // as the companion sends it for the first listener
+    processWiFiMessage(line);
+  }
+  if (opt.spectrum) {
+    char line[40];
+    snprintf(line, sizeof(line), PREFIX_SPECTRUM "%d,%d,%d,%d", SPECTRUM_DEFAULT.lowHz, SPECTRUM_DEFAULT.highHz,
+             SPECTRUM_DEFAULT.points, SPECTRUM_DEFAULT.rate);
+    processWiFiMessage(line);
+  }
+
+  // Copy our own keying through the sidetone loopback
+  useExternalAudio = false;
+  decoderEnabled = true;
+  kochModeEnabled = true;
+  currentPracticeMode = KOCH_TRAINING;
+  kochLesson = opt.lesson;
+  kochSpeed = opt.speed;
+  kochEffectiveSpeed = opt.speed * 0.6 > 5 ? opt.speed * 0.6 : 5;
+  initializeKoch();
+  if (opt.recordPath) traceRecordStart();
+  if (opt.logPath) {
+    sessionLogFile = fopen(opt.logPath, "wb");
+    if (!sessionLogFile) {
+      fprintf(stderr, "cannot write session log %s\n", opt.logPath);
+      return 2;
+    }
+    sessionLogBegin();
+  }
+
+  clock_t wallStart = clock();
+  int completed = 0;
+  int advanced = 0;
+  double accuracySum = 0;
+  int switches = 0;
+  double switchSec = 0;
+  for (int s = 0; s < opt.sessions; s++) {
+    if (opt.days > 0) simAdvanceClock((uint32_t)(opt.days * 86400 / opt.sessions));
+    if (opt.profiles > 1) {
+      char command[16];
+      snprintf(command, sizeof(command), "PROFILE:%d", s % opt.profiles + 1);
+      clock_t switchStart = clock();
+      int before = profiles.active;
+      companionCommand(command);
+      switchSec += (double)(clock() - switchStart) / CLOCKS_PER_SEC;
+      if (profiles.active != before) switches++;
+    }
+    int lessonBefore = kochLesson;
+    if (!runSession(opt)) {
+      fprintf(stderr, "session %d: sending did not finish\n", s + 1);
+      break;
+    }
+    completed++;
+    accuracySum += kochAccuracy;
+    if (kochLesson > lessonBefore) advanced++;
+  }
+  double wallSec = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+  double simSec = halMillis() / 1000.0;
+
+  if (opt.recordPath) {
+    traceRecordStop();
+    FILE* f = fopen(opt.recordPath, "wb");
+    if (!f || fwrite(traceData(), 1, traceLength(), f) != traceLength()) {
+      fprintf(stderr, "cannot write trace %s\n", opt.recordPath);
+      return 2;
+    }
+    fclose(f);
+    printf("trace:          %lu events, %u bytes%s\n", (unsigned long)traceEventCount(),
+           (unsigned)traceLength(), traceOverflowed() ? " (buffer full, events dropped)" : "");
+  }
+
+  if (sessionLogFile) {
+    fclose(sessionLogFile);
+    const SessionLogStats& ls = sessionLogStats();
+    printf("session log:    %lu records, %lu blocks, %lu dropped\n", ls.records, ls.blocksWritten, ls.dropped);
+  }
+
+  const SimCounters& c = simCounters();
+  printf("sessions:       %d\n", completed);
+  printf("virtual time:   %.1f s (%.2f h)\n", simSec, simSec / 3600.0);
+  printf("wall time:      %.3f s\n", wallSec);
+  if (wallSec > 0) {
+    printf("speedup:        %.0fx real time\n", simSec / wallSec);
+    printf("sessions/sec:   %.1f\n", completed / wallSec);
+    printf("ticks/sec:      %.0f\n", ticks / wallSec);
+  }
+  printf("mean accuracy:  %.1f%%\n", completed ? accuracySum / completed : 0.0);
+  printf("lessons:        %d advanced, now at %d (%s)\n", advanced, kochLesson, kochCharSet);
+  printf("display frames: %lu\n", c.displayFrames);
+  printf("storage writes: %lu (%lu bytes)\n", c.storageWrites, c.storageBytes);
+  if (opt.profiles > 1) {
+    printf("profiles:       %d switches, %.0f us each (wall), %lu image bytes\n", switches,
+           switches ? switchSec * 1e6 / switches : 0.0, c.profileBytes);
+  }
+  printf("link output:    %lu lines, %lu frames (%lu bad), %lu bytes\n", c.linkLines, c.linkFrames, c.linkBadFrames,
+         c.linkBytes);
+  bool linkOk = true;
+  if (opt.link) {
+    const LinkCounters& l = linkStats();
+    printf("link status:    %lu snapshots, %lu deltas, %.0f bytes/min\n", l.statusSnapshots, l.statusDeltas,
+           simSec > 0 ? l.statusBytes * 60.0 / simSec : 0.0);
+    printf("link decoded:   %lu characters in %lu batches, %.1f bytes/character\n", l.decodedChars, l.decodedBatches,
+           l.decodedChars ? (double)l.decodedBytes / l.decodedChars : 0.0);
+    printf("link commands:  %lu acknowledged, %lu rejected\n", l.commands, l.commandsRejected);
+    if (l.commandsRejected) linkOk = false;  // every command the simulation sends is valid
+  }
+  if (opt.framed) {
+    // After the coalescing window the companion must hold the final state
+    tickUntil(halMillis() + 200);
+    const FrameStatus& s = simLinkStatus();
+    bool inStep = s.lesson == kochLesson && s.speed == kochSpeed && s.effectiveSpeed == kochEffectiveSpeed &&
+                  s.accuracy == (uint16_t)(kochAccuracy * 10 + 0.5f) && !(s.flags & STATUS_SENDING) == !kochSending &&
+                  !(s.flags & STATUS_LISTENING) == !kochListening;
+    printf("companion view: %s\n", inStep ? "in step" : "DIFFERS");
+    printf("link rate:      %lu baud, %lu bytes garbled\n", (unsigned long)linkBaud, c.linkGarbled);
+    if (!inStep) linkOk = false;
+  }
+  if (opt.monitor) {
+    // The companion's side: every frame decoded and numbered in sequence
+    const MonitorCounters& m = monitorStats();
+    double purity = c.audioEnergy > 0 ? c.audioToneEnergy / c.audioEnergy : 0.0;
+    double snr = m.errorEnergy > 0 ? 10 * log10(m.signalEnergy / m.errorEnergy) : 0.0;
+    printf("link audio:     %lu frames, %.0f bytes/s (%.0f%% of the line), %lu samples lost, %lu state errors\n",
+           c.audioFrames, simSec > 0 ? m.bytes / simSec : 0.0, simSec > 0 ? m.bytes * 1000.0 / simSec / linkBaud : 0.0,
+           c.audioLost, c.audioStateErrors);
+    printf("audio quality:  %.1f%% sidetone, %.1f dB coding SNR, %lu ms average age, %lu us per block\n",
+           purity * 100, snr, m.frames ? m.ageTotal / m.frames : 0, m.blocks ? m.encodeMicros / m.blocks : 0);
+    if (!monitorActive() || c.audioFrames == 0 || c.audioLost || c.audioStateErrors || purity < 0.9) linkOk = false;
+  }
+  if (opt.spectrum) {
+    const SpectrumCounters& sp = spectrumStats();
+    double seconds = (halMillis() - sp.startedAt) / 1000.0;
+    double rate = seconds > 0 ? sp.frames / seconds : 0.0;
+    printf("link spectrum:  %lu frames, %.1f/s, %.0f bytes each, %.0f bytes/s (%.1f%% of the line)\n", c.spectrumFrames,
+           rate, c.spectrumFrames ? (double)c.spectrumBytes / c.spectrumFrames : 0.0,
+           seconds > 0 ? sp.bytes / seconds : 0.0, seconds > 0 ? sp.bytes * 1000.0 / seconds / linkBaud : 0.0);
+    printf("spectrum peaks: %lu frames with the tone, %lu off it, %.1f FFTs a frame\n", c.spectrumToneFrames,
+           c.spectrumOffTone, sp.frames ? (double)sp.ffts / sp.frames : 0.0);
+    if (!spectrumActive() || c.spectrumToneFrames == 0 || c.spectrumOffTone ||
+        fabs(rate - SPECTRUM_DEFAULT.rate) > 0.05 * SPECTRUM_DEFAULT.rate) {
+      linkOk = false;
+    }
+  }
+  if (opt.linkBench > 0) {
+    linkBenchStart(opt.linkBench);
+    tickUntil(halMillis() + opt.linkBench * 1000 + 1000);
+    const LinkCounters& l = linkStats();
+    double rate = l.benchMillis ? l.benchBytes * 1000.0 / l.benchMillis : 0.0;
+    printf("link bench:     %lu frames, %.0f bytes/s each way (%.0f%% of the line), %lu damaged, %lu lost\n",
+           l.benchFrames, rate, rate * 1000.0 / linkBaud, l.benchErrors, l.benchLost);
+    if (l.benchFrames == 0 || l.benchErrors || l.benchLost) linkOk = false;
+  }
+  if (linkCaptureFile) {
+    simSetLinkTap(nullptr);
+    printf("link capture:   %ld bytes in %s\n", ftell(linkCaptureFile), opt.linkCapturePath);
+    fclose(linkCaptureFile);
+  }
+  printf("lesson arena:   peak %u/%u bytes, %lu failures\n", (unsigned)lessonArena.highWater(),
+         (unsigned)lessonArena.capacity(), (unsigned long)lessonArena.failures());
+
+  if (opt.history) {
+    simSetEcho(true, false);
+    printHistory(HISTORY_SESSIONS, HISTORY_SESSION_POINTS);
+    printHistory(HISTORY_DAYS, HISTORY_DAY_POINTS);
+    printHistory(HISTORY_WEEKS, HISTORY_WEEK_POINTS);
+  }
+
+  if (opt.dumpScreen) {
+    updateDisplay();
+    simDumpScreen(stdout);
+  }
+  return completed == opt.sessions && linkOk ? 0 : 1;
+}
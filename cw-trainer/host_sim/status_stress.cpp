@@ -0,0 +1,232 @@
+// Stress run of the companion's status snapshots (esp32s3_wifi_companion/
+// .../trainer_status.c). One thread plays the UART task: it feeds the real
+// parser (trainer_protocol.c) generation after generation of STATUS:, STATS:
+// and DECODED: lines, every field derived from the generation number, and
+// publishes after each. Reader threads play the web handlers: they take
+// snapshots and check that every field comes from the same generation and
+// that decoded_text is whole, which the buffer shift in append_decoded_text()
+// would break if a reader saw it half done. Every reader also asks for a
+// reset now and then, as POST /api/stats does, and checks that it was carried
+// out after it asked, even with another reader's request in flight.
+//
+//   ./build/status_stress
+//   ./build/status_stress --seconds 5 --readers 4
+//   ./build/status_stress --direct    read g_status unsynchronised: shows the tears the check finds
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdarg.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "driver/uart.h"
+#include "esp_system.h"
+#include "trainer_protocol.h"
+#include "trainer_status.h"
+#include "web_server.h"
+
+static const char CYCLE[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+static const int CYCLE_LEN = sizeof(CYCLE) - 1;
+static const int RESET_EVERY = 5000;  // snapshots between a reader's reset requests
+
+static std::atomic<bool> running(true);
+static std::atomic<unsigned long> published(0);
+static bool direct = false;
+
+extern "C" {
+
+int uart_write_bytes(uart_port_t port, const void* data, size_t len) {
+  return (int)len;  // PONGs and the like go nowhere
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks) {
+  return 0;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud) {
+  return 0;
+}
+
+uint32_t esp_log_timestamp(void) {
+  static const auto start = std::chrono::steady_clock::now();
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void esp_restart(void) {
+}
+
+void shim_log(char level, const char* tag, const char* fmt, ...) {
+}
+
+void web_backup_line(const char* line) {
+}
+
+void web_command_ack(const char* ack) {
+}
+
+void web_audio_frame(const uint8_t* body, size_t len) {
+}
+
+void web_spectrum_frame(const uint8_t* body, size_t len) {
+}
+
+void web_link_hello(void) {
+}
+
+}  // extern "C"
+
+// Characters sent by generations 1..n: generation i sends 1 + i % 23
+static unsigned long decodedThrough(unsigned long n) {
+  unsigned long r = n % 23;
+  return n + n / 23 * (22 * 23 / 2) + r * (r + 1) / 2;
+}
+
+static void sendGeneration(unsigned long n) {
+  char line[128];
+  snprintf(line, sizeof(line), "STATUS:LESSON=%lu,FREQ=%lu,SPEED=%lu,EFFSPEED=%lu,ACC=%.1f", n % 40 + 1,
+           400 + n % 1000, 5 + n % 40, 5 + n % 37, (n % 1000) / 10.0);
+  process_teensy_message(line);
+  snprintf(line, sizeof(line), "STATS:SESSIONS=%lu,CHARS=%lu", n, n * 3);
+  process_teensy_message(line);
+  int len = 1 + n % 23;
+  unsigned long at = decodedThrough(n - 1);
+  int p = snprintf(line, sizeof(line), "DECODED:");
+  for (int i = 0; i < len; i++) line[p++] = CYCLE[(at + i) % CYCLE_LEN];
+  line[p] = '\0';
+  process_teensy_message(line);
+}
+
+static void writer() {
+  for (unsigned long n = 2; running.load(std::memory_order_relaxed); n++) {
+    sendGeneration(n);
+    trainer_status_publish();
+    published.store(n, std::memory_order_relaxed);
+  }
+}
+
+// A reset copy, or one generation throughout
+static bool consistent(const trainer_status_t& s) {
+  if (s.decoded_len >= sizeof(s.decoded_text) || strlen(s.decoded_text) != s.decoded_len) return false;
+  unsigned long n = s.sessions;
+  if (n == 0) {
+    return s.lesson == 0 && s.frequency == 600 && s.speed == 20 && s.effective_speed == 13 && s.characters == 0 &&
+           s.decoded_len == 0;
+  }
+  if (s.lesson != (int)(n % 40 + 1) || s.frequency != (int)(400 + n % 1000) || s.speed != (int)(5 + n % 40) ||
+      s.effective_speed != (int)(5 + n % 37) || fabsf(s.accuracy - (n % 1000) / 10.0f) > 0.01f ||
+      s.characters != n * 3) {
+    return false;
+  }
+  // A run of the cycle ending where generation n left it; shorter after a reset
+  unsigned long end = decodedThrough(n);
+  for (size_t i = 0; i < s.decoded_len; i++) {
+    if (s.decoded_text[i] != CYCLE[(end - s.decoded_len + i) % CYCLE_LEN]) return false;
+  }
+  return true;
+}
+
+struct ReaderResult {
+  unsigned long snapshots = 0;
+  unsigned long torn = 0;
+  unsigned long retries = 0;
+  unsigned maxRetries = 0;
+  unsigned long resetsAsked = 0;
+  unsigned long resetsDone = 0;  // carried out by the writer within a second
+  unsigned long resetsLost = 0;  // done, but the copy after it holds text from before the request
+};
+
+static void reader(int index, ReaderResult* r) {
+  static trainer_status_t views[16];
+  trainer_status_t& view = views[index];
+  while (running.load(std::memory_order_relaxed)) {
+    unsigned retries = 0;
+    if (direct) {
+      memcpy(&view, (const void*)&g_status, sizeof(view));
+    } else {
+      retries = trainer_status_snapshot(&view);
+    }
+    r->snapshots++;
+    r->retries += retries;
+    if (retries > r->maxRetries) r->maxRetries = retries;
+    if (!consistent(view)) r->torn++;
+    if (!direct && (r->snapshots + index * RESET_EVERY / 4) % RESET_EVERY == 0) {
+      // The generation under way may have looked for requests already; the
+      // reset comes with that one at the latest, so only later text survives
+      unsigned long asked = published.load() + 1;
+      trainer_status_request_reset();
+      r->resetsAsked++;
+      for (int i = 0; i < 1000 && trainer_status_reset_pending(); i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      if (trainer_status_reset_pending()) continue;
+      r->resetsDone++;
+      trainer_status_snapshot(&view);
+      if (view.sessions > asked && view.decoded_len > decodedThrough(view.sessions) - decodedThrough(asked)) {
+        r->resetsLost++;
+      }
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  double seconds = 2;
+  int readers = 3;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atof(argv[++i]);
+    else if (strcmp(argv[i], "--readers") == 0 && i + 1 < argc) readers = atoi(argv[++i]);
+    else if (strcmp(argv[i], "--direct") == 0) direct = true;
+    else {
+      fprintf(stderr, "usage: %s [--seconds S] [--readers N] [--direct]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (readers < 1 || readers > 16) {
+    fprintf(stderr, "status_stress: 1 to 16 readers\n");
+    return 2;
+  }
+
+  // Generation 1 is published before anyone reads, as the UART task
+  // publishes before the web server starts
+  trainer_status_reset();
+  sendGeneration(1);
+  trainer_status_publish();
+
+  std::vector<ReaderResult> results(readers);
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  threads.emplace_back(writer);
+  for (int i = 0; i < readers; i++) threads.emplace_back(reader, i, &results[i]);
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  running = false;
+  for (auto& t : threads) t.join();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  ReaderResult total;
+  for (const ReaderResult& r : results) {
+    total.snapshots += r.snapshots;
+    total.torn += r.torn;
+    total.retries += r.retries;
+    if (r.maxRetries > total.maxRetries) total.maxRetries = r.maxRetries;
+    total.resetsAsked += r.resetsAsked;
+    total.resetsDone += r.resetsDone;
+    total.resetsLost += r.resetsLost;
+  }
+  printf("%s reads, %d readers, %.1f s, %zu-byte status\n", direct ? "Unsynchronised" : "Snapshot", readers, elapsed,
+         sizeof(trainer_status_t));
+  printf("Published:  %lu generations, %.0f/s\n", published.load(), published.load() / elapsed);
+  printf("Read:       %lu copies, %.0f/s\n", total.snapshots, total.snapshots / elapsed);
+  if (!direct) {
+    printf("Retries:    %.3f per copy, at most %u\n", total.snapshots ? (double)total.retries / total.snapshots : 0.0,
+           total.maxRetries);
+    printf("Resets:     %lu asked, %lu done, %lu lost\n", total.resetsAsked, total.resetsDone, total.resetsLost);
+  }
+  printf("Torn:       %lu\n", total.torn);
+  if (direct) {
+    printf("%s\n", total.torn ? "tears found, as expected without snapshots" : "no tears seen this run");
+    return 0;
+  }
+  bool failed = total.torn > 0 || total.resetsDone != total.resetsAsked || total.resetsLost > 0;
+  printf("%s\n", failed ? "FAILED" : "ok");
+  return failed;
+}
@@ -0,0 +1,147 @@
+#include "trainer_align.h"
+
+static const uint16_t UNREACHABLE = 0xFFFF;
+
+void CopyAligner::begin(const char* sent) {
+  sentLength_ = 0;
+  for (const char* p = sent; *p && sentLength_ < LESSON_TEXT_MAX; p++) {
+    if (*p != ' ') sent_[sentLength_++] = *p;
+  }
+  sent_[sentLength_] = '\0';
+  origin_ = 0;
+  openCount_ = 0;
+  openCost_ = 0;
+  memset(&counts_, 0, sizeof(counts_));
+}
+
+// Edit distance from the origin over the open characters. Row r holds sent
+// positions origin_ + r - ALIGN_BAND + k for k in [0, ALIGN_WIDTH), so the cell
+// diagonally above has the same k and the one straight above has k + 1.
+// Returns the sent position the best path ends at; when finishing, sent
+// characters past the end count as missed.
+uint16_t CopyAligner::solve(bool finishing) {
+  uint16_t previous[ALIGN_WIDTH];
+  uint16_t current[ALIGN_WIDTH];
+  int base = (int)origin_ - ALIGN_BAND;
+
+  for (int k = 0; k < ALIGN_WIDTH; k++) {
+    int j = base + k;
+    bool reachable = j >= origin_ && j <= sentLength_;
+    current[k] = reachable ? j - origin_ : UNREACHABLE;
+    moves_[0][k] = ALIGN_DELETION;
+  }
+
+  for (int r = 1; r <= openCount_; r++) {
+    memcpy(previous, current, sizeof(current));
+    base++;
+    char c = open_[r - 1];
+    for (int k = 0; k < ALIGN_WIDTH; k++) {
+      int j = base + k;
+      uint16_t best = UNREACHABLE;
+      AlignOp move = ALIGN_MATCH;
+      if (j >= origin_ && j <= sentLength_) {
+        if (j > origin_ && previous[k] != UNREACHABLE) {
+          bool same = sent_[j - 1] == c;
+          best = previous[k] + (same ? 0 : 1);
+          move = same ? ALIGN_MATCH : ALIGN_SUBSTITUTION;
+        }
+        if (k + 1 < ALIGN_WIDTH && previous[k + 1] != UNREACHABLE && previous[k + 1] + 1 < best) {
+          best = previous[k + 1] + 1;
+          move = ALIGN_INSERTION;
+        }
+        if (k > 0 && current[k - 1] != UNREACHABLE && current[k - 1] + 1 < best) {
+          best = current[k - 1] + 1;
+          move = ALIGN_DELETION;
+        }
+      }
+      current[k] = best;
+      moves_[r][k] = move;
+    }
+  }
+
+  // Best end cell; ties go to the one nearest the diagonal
+  uint16_t bestCost = UNREACHABLE;
+  int bestK = ALIGN_BAND;
+  for (int k = 0; k < ALIGN_WIDTH; k++) {
+    if (current[k] == UNREACHABLE) continue;
+    uint16_t cost = current[k] + (finishing ? sentLength_ - (base + k) : 0);
+    int distance = abs(k - ALIGN_BAND);
+    if (cost < bestCost || (cost == bestCost && distance < abs(bestK - ALIGN_BAND))) {
+      bestCost = cost;
+      bestK = k;
+    }
+  }
+  openCost_ = bestCost;
+  return base + bestK;
+}
+
+// Walks the best path back from end and records, for each open character, how
+// it was copied and the sent positions before (from) and after (to) it; sent
+// characters between one step's to and the next one's from were missed
+void CopyAligner::trace(uint16_t end) {
+  int j = end;
+  for (int r = openCount_; r >= 1; r--) {
+    int base = (int)origin_ + r - ALIGN_BAND;
+    if (r < openCount_) path_[r + 1].from = j;
+    while (moves_[r][j - base] == ALIGN_DELETION) j--;
+    path_[r].op = (AlignOp)moves_[r][j - base];
+    path_[r].to = j;
+    if (path_[r].op != ALIGN_INSERTION) j--;
+  }
+  if (openCount_ > 0) path_[1].from = j;
+}
+
+void CopyAligner::report(AlignOp op, char expected, char copied, uint32_t responseMs) {
+  switch (op) {
+    case ALIGN_MATCH: counts_.matches++; break;
+    case ALIGN_SUBSTITUTION: counts_.substitutions++; break;
+    case ALIGN_INSERTION: counts_.insertions++; break;
+    case ALIGN_DELETION: counts_.deletions++; break;
+  }
+  if (sink_) {
+    AlignEvent event = { op, expected, copied, responseMs };
+    sink_(event);
+  }
+}
+
+// Reports the oldest open character and the sent characters missed before it,
+// then makes its position the new origin
+void CopyAligner::commitFirst() {
+  const Step& step = path_[1];
+  for (uint16_t j = origin_; j < step.from; j++) report(ALIGN_DELETION, sent_[j], 0, 0);
+  char expected = step.op == ALIGN_INSERTION ? 0 : sent_[step.to - 1];
+  report(step.op, expected, open_[0], openResponse_[0]);
+
+  uint16_t cost = (step.from - origin_) + (step.op == ALIGN_MATCH ? 0 : 1);
+  openCost_ = openCost_ > cost ? openCost_ - cost : 0;
+  origin_ = step.to;
+  openCount_--;
+  memmove(open_, open_ + 1, openCount_);
+  memmove(openResponse_, openResponse_ + 1, openCount_ * sizeof(openResponse_[0]));
+}
+
+char CopyAligner::copied(char c, uint32_t responseMs) {
+  open_[openCount_] = c;
+  openResponse_[openCount_] = responseMs;
+  openCount_++;
+
+  trace(solve(false));
+  const Step& newest = path_[openCount_];
+  char expected = newest.op == ALIGN_INSERTION ? 0 : sent_[newest.to - 1];
+
+  if (openCount_ == ALIGN_LOOKAHEAD) commitFirst();
+  return expected;
+}
+
+void CopyAligner::finish() {
+  uint16_t end = solve(true);
+  trace(end);
+  while (openCount_ > 0) {
+    commitFirst();
+    // Shift the traced steps down with the open characters
+    memmove(path_ + 1, path_ + 2, openCount_ * sizeof(path_[0]));
+  }
+  for (uint16_t j = origin_; j < sentLength_; j++) report(ALIGN_DELETION, sent_[j], 0, 0);
+  origin_ = sentLength_;
+  openCost_ = 0;
+}
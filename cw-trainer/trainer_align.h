@@ -0,0 +1,88 @@
+#ifndef TRAINER_ALIGN_H
+#define TRAINER_ALIGN_H
+
+// Copy scoring by alignment. The sent lesson (spaces dropped, as the decoder
+// never copies them) is aligned against the copied characters with an edit
+// distance over a band of ALIGN_BAND characters either side of the diagonal,
+// so one dropped or extra character costs one error instead of shifting the
+// rest of the lesson out of step.
+//
+// The alignment runs as characters arrive. Only the last ALIGN_LOOKAHEAD
+// copied characters are open; older ones are committed along the best path and
+// reported as AlignEvents, and the committed position becomes the origin for
+// the rest. Memory is fixed and each character costs at most
+// (ALIGN_LOOKAHEAD + 1) * (2 * ALIGN_BAND + 1) cell updates.
+
+#include "trainer_core.h"
+
+const int ALIGN_BAND = 8;
+const int ALIGN_LOOKAHEAD = 8;
+const int ALIGN_WIDTH = 2 * ALIGN_BAND + 1;
+
+enum AlignOp : uint8_t {
+  ALIGN_MATCH,
+  ALIGN_SUBSTITUTION,  // copied the wrong character
+  ALIGN_INSERTION,     // copied a character that was not sent
+  ALIGN_DELETION       // missed a sent character
+};
+
+struct AlignEvent {
+  AlignOp op;
+  char expected;  // 0 for an insertion
+  char copied;    // 0 for a deletion
+  uint32_t responseMs;  // as passed to copied(); 0 for a deletion
+};
+
+struct AlignCounts {
+  uint16_t matches;
+  uint16_t substitutions;
+  uint16_t insertions;
+  uint16_t deletions;
+
+  uint16_t columns() const { return matches + substitutions + insertions + deletions; }
+};
+
+class CopyAligner {
+public:
+  typedef void (*Sink)(const AlignEvent& event);
+
+  explicit CopyAligner(Sink sink) : sink_(sink) { begin(""); }
+
+  void begin(const char* sent);
+  // Returns the sent character this copy provisionally lines up with, 0 if
+  // it looks like an insertion; the committed event may still differ
+  char copied(char c, uint32_t responseMs);
+  // Commits the open characters and reports sent characters never copied as deletions
+  void finish();
+
+  const AlignCounts& counts() const { return counts_; }  // committed events only
+  uint16_t openErrors() const { return openCost_; }      // best cost over the open characters
+
+private:
+  struct Step {
+    AlignOp op;
+    uint16_t from;  // sent position the path leaves the previous row at
+    uint16_t to;    // sent position after this copied character
+  };
+
+  uint16_t solve(bool finishing);
+  void trace(uint16_t end);
+  void commitFirst();
+  void report(AlignOp op, char expected, char copied, uint32_t responseMs);
+
+  Sink sink_;
+  char sent_[LESSON_TEXT_MAX + 1];
+  uint16_t sentLength_;
+  uint16_t origin_;  // sent characters consumed by committed events
+  char open_[ALIGN_LOOKAHEAD];
+  uint32_t openResponse_[ALIGN_LOOKAHEAD];
+  uint8_t openCount_;
+  uint16_t openCost_;
+  uint8_t moves_[ALIGN_LOOKAHEAD + 1][ALIGN_WIDTH];  // how each cell was reached
+  Step path_[ALIGN_LOOKAHEAD + 1];  // steps 1..openCount_ of the best path, from trace()
+  AlignCounts counts_;
+};
+
+extern CopyAligner copyAligner;  // scores the current lesson (trainer_lessons.cpp)
+
+#endif  // TRAINER_ALIGN_H
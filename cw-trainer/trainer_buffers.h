@@ -0,0 +1,228 @@
+#ifndef TRAINER_BUFFERS_H
+#define TRAINER_BUFFERS_H
+
+// Fixed-capacity text helpers and a resettable arena.
+// Everything that runs after setup() uses these instead of Arduino String so
+// the heap never grows or fragments on a trainer left running all day.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// ---- Bounded string ----------------------------------------------------------
+// Appends past capacity are dropped and remembered in truncated().
+template <size_t N>
+class FixedText {
+public:
+  FixedText() { clear(); }
+
+  void clear() {
+    len_ = 0;
+    buf_[0] = '\0';
+    truncated_ = false;
+  }
+
+  bool append(char c) {
+    if (len_ + 1 >= N) {
+      truncated_ = true;
+      return false;
+    }
+    buf_[len_++] = c;
+    buf_[len_] = '\0';
+    return true;
+  }
+
+  bool append(const char* s) {
+    while (*s) {
+      if (!append(*s++)) return false;
+    }
+    return true;
+  }
+
+  // printf-style append. Avoid %f here: newlib's float formatting may touch
+  // the heap, use appendFloat() instead.
+  bool appendf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf_ + len_, N - len_, fmt, ap);
+    va_end(ap);
+    if (n < 0) {
+      buf_[len_] = '\0';
+      return false;
+    }
+    if ((size_t)n >= N - len_) {
+      len_ = N - 1;
+      truncated_ = true;
+      return false;
+    }
+    len_ += n;
+    return true;
+  }
+
+  // Fixed-point float formatting without printf's float path.
+  bool appendFloat(float v, uint8_t decimals) {
+    if (v != v) return append("nan");
+    if (v < 0) {
+      append('-');
+      v = -v;
+    }
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+    uint32_t fixed = (uint32_t)(v * scale + 0.5f);
+    if (!appendf("%lu", (unsigned long)(fixed / scale))) return false;
+    if (decimals == 0) return true;
+    return appendf(".%0*lu", (int)decimals, (unsigned long)(fixed % scale));
+  }
+
+  void set(const char* s) {
+    clear();
+    append(s);
+  }
+
+  const char* c_str() const { return buf_; }
+  size_t length() const { return len_; }
+  size_t capacity() const { return N - 1; }
+  bool truncated() const { return truncated_; }
+  char charAt(size_t i) const { return i < len_ ? buf_[i] : '\0'; }
+  bool endsWith(char c) const { return len_ > 0 && buf_[len_ - 1] == c; }
+
+private:
+  char buf_[N];
+  size_t len_;
+  bool truncated_;
+};
+
+// A float as fixed-point text for a %s, so console output stays off printf's
+// float path too. The temporary lives to the end of the statement:
+//   consolePrintf("Best WPM: %s\n", fixedFloat(stats.bestWPM, 1).c_str());
+inline FixedText<16> fixedFloat(float v, uint8_t decimals) {
+  FixedText<16> text;
+  text.appendFloat(v, decimals);
+  return text;
+}
+
+// ---- Writer over external storage ---------------------------------------------
+// Same append semantics as FixedText, but the bytes live elsewhere (an arena
+// block or a caller-supplied buffer).
+class TextWriter {
+public:
+  TextWriter(char* buf, size_t size)
+    : buf_(buf), size_(size), len_(0), truncated_(false) {
+    if (size_) buf_[0] = '\0';
+  }
+
+  bool append(char c) {
+    if (len_ + 1 >= size_) {
+      truncated_ = true;
+      return false;
+    }
+    buf_[len_++] = c;
+    buf_[len_] = '\0';
+    return true;
+  }
+
+  bool append(const char* s) {
+    while (*s) {
+      if (!append(*s++)) return false;
+    }
+    return true;
+  }
+
+  const char* c_str() const { return buf_; }
+  size_t length() const { return len_; }
+  size_t remaining() const { return size_ > len_ + 1 ? size_ - len_ - 1 : 0; }
+  bool truncated() const { return truncated_; }
+
+private:
+  char* buf_;
+  size_t size_;
+  size_t len_;
+  bool truncated_;
+};
+
+// ---- Rolling text ------------------------------------------------------------
+// Keeps the newest N characters; the oldest is overwritten first.
+template <size_t N>
+class TextRing {
+public:
+  void clear() {
+    head_ = 0;
+    count_ = 0;
+  }
+
+  void append(char c) {
+    buf_[head_] = c;
+    head_ = (head_ + 1) % N;
+    if (count_ < N) count_++;
+  }
+
+  size_t length() const { return count_; }
+
+  // 0 = oldest character still held
+  char charAt(size_t i) const {
+    if (i >= count_) return '\0';
+    return buf_[(head_ + N - count_ + i) % N];
+  }
+
+  bool endsWith(char c) const { return count_ > 0 && charAt(count_ - 1) == c; }
+
+  // Copy the newest (outSize - 1) characters or fewer into out, NUL-terminated.
+  size_t tail(char* out, size_t outSize) const {
+    if (outSize == 0) return 0;
+    size_t n = count_ < outSize - 1 ? count_ : outSize - 1;
+    for (size_t i = 0; i < n; i++) out[i] = charAt(count_ - n + i);
+    out[n] = '\0';
+    return n;
+  }
+
+private:
+  char buf_[N];
+  size_t head_ = 0;
+  size_t count_ = 0;
+};
+
+// ---- Resettable arena --------------------------------------------------------
+// Bump allocator over caller-provided storage. Lesson generators take their
+// scratch and output text from here and the whole lot is released by reset()
+// when the next lesson starts.
+class Arena {
+public:
+  Arena(uint8_t* mem, size_t size)
+    : mem_(mem), size_(size), used_(0), highWater_(0), failures_(0) {}
+
+  void* alloc(size_t n, size_t align = 4) {
+    size_t start = (used_ + align - 1) & ~(align - 1);
+    if (start + n > size_) {
+      failures_++;
+      return nullptr;
+    }
+    used_ = start + n;
+    if (used_ > highWater_) highWater_ = used_;
+    return mem_ + start;
+  }
+
+  // NUL-terminated text buffer of up to maxLen characters
+  char* allocText(size_t maxLen) {
+    char* p = (char*)alloc(maxLen + 1, 1);
+    if (p) p[0] = '\0';
+    return p;
+  }
+
+  void reset() { used_ = 0; }
+
+  size_t used() const { return used_; }
+  size_t capacity() const { return size_; }
+  size_t highWater() const { return highWater_; }
+  uint32_t failures() const { return failures_; }
+
+private:
+  uint8_t* mem_;
+  size_t size_;
+  size_t used_;
+  size_t highWater_;
+  uint32_t failures_;
+};
+
+#endif  // TRAINER_BUFFERS_H
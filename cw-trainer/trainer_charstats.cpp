@@ -0,0 +1,148 @@
+#include "trainer_charstats.h"
+#include "trainer_protocol.h"
+
+const uint16_t latencyBinLimits[LATENCY_BINS - 1] = { 300, 600, 1200, 2400, 4800 };
+
+uint16_t confusionMatrix[MORSE_SYMBOL_COUNT][MORSE_SYMBOL_COUNT];
+static uint16_t otherErrors[MORSE_SYMBOL_COUNT];  // errors folded out of a stored summary
+// Bins halve when one would overflow, so the shape survives and recent copy weighs more
+static uint8_t latencyHistogram[MORSE_SYMBOL_COUNT][LATENCY_BINS];
+static uint8_t unsentSymbols[(MORSE_SYMBOL_COUNT + 7) / 8];  // rows changed since the last CHARSTAT
+
+static void saturatingIncrement(uint16_t& counter) {
+  if (counter < 0xFFFF) counter++;
+}
+
+void recordCopiedCharacter(char expected, char copied, uint32_t responseMs) {
+  int row = morseSymbolIndex(expected);
+  int column = morseSymbolIndex(copied);
+  if (row < 0) return;
+
+  if (column >= 0) {
+    saturatingIncrement(confusionMatrix[row][column]);
+  } else {
+    saturatingIncrement(otherErrors[row]);
+  }
+  unsentSymbols[row / 8] |= 1 << (row % 8);
+  if (!copied) return;  // missed entirely, so there is no response time
+
+  int bin = 0;
+  while (bin < LATENCY_BINS - 1 && responseMs >= latencyBinLimits[bin]) bin++;
+  uint8_t* histogram = latencyHistogram[row];
+  if (histogram[bin] == 0xFF) {
+    for (int i = 0; i < LATENCY_BINS; i++) histogram[i] /= 2;
+  }
+  histogram[bin]++;
+}
+
+uint32_t symbolAttempts(int symbol) {
+  uint32_t total = otherErrors[symbol];
+  for (int i = 0; i < MORSE_SYMBOL_COUNT; i++) total += confusionMatrix[symbol][i];
+  return total;
+}
+
+uint32_t symbolErrors(int symbol) {
+  return symbolAttempts(symbol) - confusionMatrix[symbol][symbol];
+}
+
+int topConfusions(int symbol, uint8_t* copied, uint16_t* counts, int max) {
+  int found = 0;
+  for (int i = 0; i < MORSE_SYMBOL_COUNT; i++) {
+    uint16_t count = confusionMatrix[symbol][i];
+    if (i == symbol || count == 0) continue;
+
+    // Insertion into the short sorted list; ties keep table order
+    int pos = found;
+    while (pos > 0 && counts[pos - 1] < count) pos--;
+    if (pos >= max) continue;
+    for (int j = (found < max ? found : max - 1); j > pos; j--) {
+      copied[j] = copied[j - 1];
+      counts[j] = counts[j - 1];
+    }
+    copied[pos] = i;
+    counts[pos] = count;
+    if (found < max) found++;
+  }
+  return found;
+}
+
+void summarizeSymbol(int symbol, CharSummary& out) {
+  memset(&out, 0, sizeof(out));
+  out.correct = confusionMatrix[symbol][symbol];
+
+  int found = topConfusions(symbol, out.confusedWith, out.confusedCount, SUMMARY_CONFUSIONS);
+  uint32_t listed = 0;
+  for (int i = 0; i < found; i++) listed += out.confusedCount[i];
+  uint32_t other = symbolErrors(symbol) - listed;
+  out.otherErrors = other > 0xFFFF ? 0xFFFF : other;
+  memcpy(out.latency, latencyHistogram[symbol], LATENCY_BINS);
+}
+
+void restoreSymbol(int symbol, const CharSummary& in) {
+  memset(confusionMatrix[symbol], 0, sizeof(confusionMatrix[symbol]));
+  confusionMatrix[symbol][symbol] = in.correct;
+  for (int i = 0; i < SUMMARY_CONFUSIONS; i++) {
+    uint8_t column = in.confusedWith[i];
+    if (in.confusedCount[i] && column < MORSE_SYMBOL_COUNT && column != symbol) confusionMatrix[symbol][column] = in.confusedCount[i];
+  }
+  otherErrors[symbol] = in.otherErrors;
+  memcpy(latencyHistogram[symbol], in.latency, LATENCY_BINS);
+}
+
+void resetCharacterStats() {
+  memset(confusionMatrix, 0, sizeof(confusionMatrix));
+  memset(otherErrors, 0, sizeof(otherErrors));
+  memset(latencyHistogram, 0, sizeof(latencyHistogram));
+  memset(unsentSymbols, 0xFF, sizeof(unsentSymbols));
+}
+
+void printCharacterStats() {
+  consolePrintf("\nCharacter Copy (accuracy, confusions, response ms <300/600/1200/2400/4800/more):\n");
+  for (int s = 0; s < MORSE_SYMBOL_COUNT; s++) {
+    uint32_t attempts = symbolAttempts(s);
+    if (attempts == 0) continue;
+
+    uint8_t copied[3];
+    uint16_t counts[3];
+    int found = topConfusions(s, copied, counts, 3);
+    FixedText<32> confusions;
+    for (int i = 0; i < found; i++) {
+      confusions.appendf("%s%c:%u", i ? " " : "", morseTable[copied[i]].character, (unsigned)counts[i]);
+    }
+    if (otherErrors[s]) confusions.appendf("%s?:%u", found ? " " : "", (unsigned)otherErrors[s]);
+
+    const uint8_t* h = latencyHistogram[s];
+    consolePrintf("%c %5s%% %lu/%lu  %-16s %u/%u/%u/%u/%u/%u\n", morseTable[s].character,
+                  fixedFloat(100.0f * confusionMatrix[s][s] / attempts, 1).c_str(), (unsigned long)confusionMatrix[s][s],
+                  (unsigned long)attempts, confusions.c_str(), h[0], h[1], h[2], h[3], h[4], h[5]);
+  }
+}
+
+// CHARSTAT:<symbol>|<correct>|<errors>|<copied><count> ...|<latency bins>
+// '|' separates fields because ',' and '=' are symbols themselves
+void sendCharStatsToWiFi(bool all) {
+  if (!wifiEnabled || !espConnected) return;
+
+  static FixedText<96> msg;
+  for (int s = 0; s < MORSE_SYMBOL_COUNT; s++) {
+    bool unsent = unsentSymbols[s / 8] & (1 << (s % 8));
+    if (!unsent && !all) continue;
+    unsentSymbols[s / 8] &= ~(1 << (s % 8));
+    uint32_t attempts = symbolAttempts(s);
+    if (attempts == 0) continue;
+
+    uint8_t copied[3];
+    uint16_t counts[3];
+    int found = topConfusions(s, copied, counts, 3);
+
+    msg.set(PREFIX_CHARSTAT);
+    msg.appendf("%c|%u|%lu|", morseTable[s].character, (unsigned)confusionMatrix[s][s],
+                (unsigned long)symbolErrors(s));
+    for (int i = 0; i < found; i++) {
+      msg.appendf("%s%c%u", i ? " " : "", morseTable[copied[i]].character, (unsigned)counts[i]);
+    }
+    const uint8_t* h = latencyHistogram[s];
+    msg.appendf("|%u %u %u %u %u %u", h[0], h[1], h[2], h[3], h[4], h[5]);
+    linkWriteLine(msg.c_str());
+  }
+}
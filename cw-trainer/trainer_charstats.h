@@ -0,0 +1,43 @@
+#ifndef TRAINER_CHARSTATS_H
+#define TRAINER_CHARSTATS_H
+
+// Per-symbol copy statistics for every morseTable entry: a confusion matrix
+// of saturating 16-bit counters (row = expected, column = copied, diagonal =
+// correct) and a histogram of response times per expected symbol.
+//
+// The matrix lives in RAM. The store keeps a 16-byte CharSummary per symbol
+// with exact correct/error totals and the two most frequent confusions; rarer
+// confusions are folded into otherErrors, so after a reboot they still count
+// as errors, just without the copied symbol.
+
+#include "trainer_core.h"
+
+const int LATENCY_BINS = 6;
+extern const uint16_t latencyBinLimits[LATENCY_BINS - 1];  // ms, upper bound of each bin but the last
+const int SUMMARY_CONFUSIONS = 2;
+
+struct CharSummary {
+  uint16_t correct;
+  uint16_t otherErrors;  // errors not broken out in confusedWith
+  uint8_t confusedWith[SUMMARY_CONFUSIONS];  // morseTable index; unused entries have a zero count
+  uint16_t confusedCount[SUMMARY_CONFUSIONS];
+  uint8_t latency[LATENCY_BINS];
+};
+
+extern uint16_t confusionMatrix[MORSE_SYMBOL_COUNT][MORSE_SYMBOL_COUNT];
+
+// responseMs is the silence before the copied character's first element;
+// copied is 0 for a sent character that was missed altogether
+void recordCopiedCharacter(char expected, char copied, uint32_t responseMs);
+uint32_t symbolAttempts(int symbol);
+uint32_t symbolErrors(int symbol);
+int topConfusions(int symbol, uint8_t* copied, uint16_t* counts, int max);  // most frequent first
+
+void summarizeSymbol(int symbol, CharSummary& out);
+void restoreSymbol(int symbol, const CharSummary& in);
+void resetCharacterStats();
+
+void printCharacterStats();   // STATS section
+void sendCharStatsToWiFi(bool all);  // CHARSTAT lines; only changed symbols unless all
+
+#endif  // TRAINER_CHARSTATS_H
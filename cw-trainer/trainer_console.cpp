@@ -0,0 +1,192 @@
+#include "trainer_core.h"
+#include "trainer_trace.h"
+#include "trainer_input.h"
+#include "trainer_store.h"
+#include "trainer_sessionlog.h"
+#include "trainer_drill.h"
+#include "trainer_export.h"
+#include "trainer_profiles.h"
+#include "trainer_history.h"
+#include "trainer_protocol.h"
+#include "trainer_monitor.h"
+#include "trainer_spectrum.h"
+#include <ctype.h>
+
+// The command line being assembled, a byte at a time as the USB serial
+// buffer hands them over, so a half-typed line never holds up the loop
+static char consoleLine[CONSOLE_LINE_MAX];
+static size_t consoleLength = 0;
+static bool consoleOverlong = false;
+static bool consoleGarbled = false;
+static ConsoleCounters consoleCounters;
+
+bool consoleReceiveByte(uint8_t c) {
+  if (c == '\r' || c == '\n') {
+    bool complete = consoleLength > 0 && !consoleOverlong && !consoleGarbled;
+    if (consoleOverlong) consoleCounters.overlong++;
+    else if (consoleGarbled) consoleCounters.garbled++;
+    consoleLine[consoleLength] = '\0';
+    consoleLength = 0;
+    consoleOverlong = false;
+    consoleGarbled = false;
+    if (!complete) return false;  // also the LF of a CR LF
+    consoleCounters.lines++;
+    processSerialCommand(consoleLine);
+    return true;
+  }
+  if (c == '\b' || c == 0x7F) {  // backspace from a terminal
+    if (consoleLength > 0) consoleLength--;
+    return false;
+  }
+  if ((c < 0x20 && c != '\t') || c >= 0x80) consoleGarbled = true;
+  if (consoleOverlong) return false;
+  if (consoleLength + 1 >= CONSOLE_LINE_MAX) {
+    consoleOverlong = true;
+    return false;
+  }
+  consoleLine[consoleLength++] = c;
+  return false;
+}
+
+const ConsoleCounters& consoleStats() {
+  return consoleCounters;
+}
+
+static void printConsoleStats() {
+  consolePrintf("\n=== CONSOLE ===\n");
+  consolePrintf("Commands: %lu\n", consoleCounters.lines);
+  consolePrintf("Overlong: %lu (over %u bytes)\n", consoleCounters.overlong, (unsigned)(CONSOLE_LINE_MAX - 1));
+  consolePrintf("Garbled:  %lu\n", consoleCounters.garbled);
+  consolePrintf("===============\n\n");
+}
+
+// One complete command line from the USB serial console
+void processSerialCommand(char* line) {
+  char* command = trimLine(line);
+  for (char* c = command; *c; c++) *c = toupper(*c);
+
+  // Trace control is never itself traced
+  if (startsWith(command, "TRACE")) {
+    processTraceCommand(trimLine(command + 5));
+    return;
+  }
+  traceSerialLine(command);
+
+  if (startsWith(command, "SPEED ")) {
+    int speed = atoi(command + 6);
+    if (speed >= 5 && speed <= 50) {
+      kochSpeed = speed;
+      applySettings();
+      consolePrintf("Speed set to %d WPM\n", speed);
+    }
+  } else if (startsWith(command, "FARNSWORTH ")) {
+    int farnsworth = atoi(command + 11);
+    if (farnsworth >= 5 && farnsworth <= kochSpeed) {
+      kochEffectiveSpeed = farnsworth;
+      applySettings();
+      consolePrintf("Farnsworth speed set to %d WPM\n", farnsworth);
+    }
+  } else if (startsWith(command, "LESSON ")) {
+    int lesson = atoi(command + 7);
+    if (lesson >= 1 && lesson <= KOCH_LESSON_COUNT) {
+      kochLesson = lesson;
+      initializeKoch();
+      consolePrintf("Jumped to lesson %d\n", lesson);
+    }
+  } else if (strcmp(command, "STATS") == 0) {
+    displayDetailedStats();
+  } else if (strcmp(command, "RESET") == 0) {
+    resetAllStats();
+    consolePrintf("All statistics reset\n");
+  } else if (startsWith(command, "FREQ ")) {
+    int freq = atoi(command + 5);
+    if (freq >= 300 && freq <= 1200) {
+      sidetoneFreq = freq;
+      applySettings();
+      consolePrintf("Frequency set to %d Hz\n", freq);
+    }
+  } else if (strcmp(command, "HEAP") == 0) {
+    printHeapProbe();
+  } else if (strcmp(command, "INPUT") == 0) {
+    printInputStats();
+  } else if (strcmp(command, "CONSOLE") == 0) {
+    printConsoleStats();
+  } else if (strcmp(command, "STORE") == 0) {
+    printStoreStats();
+  } else if (strcmp(command, "LINK") == 0) {
+    printLinkStats();
+  } else if (startsWith(command, "LINK BENCH")) {
+    linkBenchStart(atoi(command + 10));
+  } else if (strcmp(command, "MONITOR") == 0) {
+    printMonitorStats();
+  } else if (strcmp(command, "MONITOR ON") == 0) {
+    monitorStart();
+  } else if (strcmp(command, "MONITOR OFF") == 0) {
+    monitorStop();
+  } else if (strcmp(command, "SPECTRUM") == 0) {
+    printSpectrumStats();
+  } else if (strcmp(command, "SPECTRUM ON") == 0) {
+    spectrumStartLine("1");
+  } else if (strcmp(command, "SPECTRUM OFF") == 0) {
+    spectrumStop();
+  } else if (strcmp(command, "LOG") == 0) {
+    printSessionLogStats();
+  } else if (strcmp(command, "DRILL") == 0) {
+    printDrillTable();
+  } else if (strcmp(command, "EXPORT") == 0 || strcmp(command, "EXPORT BIN") == 0) {
+    exportStart(EXPORT_BINARY, EXPORT_CONSOLE);
+  } else if (strcmp(command, "EXPORT CSV") == 0) {
+    exportStart(EXPORT_CSV, EXPORT_CONSOLE);
+  } else if (startsWith(command, PREFIX_IMPORT)) {
+    importLine(command + strlen(PREFIX_IMPORT), EXPORT_CONSOLE);
+  } else if (startsWith(command, "HISTORY")) {
+    // HISTORY [SESSIONS|DAYS|WEEKS] [points]
+    char* args = trimLine(command + 7);
+    HistoryTier tier = HISTORY_DAYS;
+    if (*args == 'S') tier = HISTORY_SESSIONS;
+    else if (*args == 'W') tier = HISTORY_WEEKS;
+    while (*args && (*args < '0' || *args > '9')) args++;
+    int points = *args ? atoi(args) : 14;
+    printHistory(tier, points);
+  } else if (strcmp(command, "PROFILES") == 0) {
+    printProfiles();
+  } else if (startsWith(command, "PROFILE NAME ")) {
+    renameProfile(trimLine(command + 13));
+    consolePrintf("Profile %d is now %s\n", profiles.active + 1, profileName(profiles.active));
+  } else if (startsWith(command, "PROFILE ")) {
+    switchProfile(atoi(command + 8) - 1);
+  } else if (strcmp(command, "HELP") == 0) {
+    printHelp();
+  }
+}
+
+void printHelp() {
+  consolePrintf("\n=== COMMAND REFERENCE ===\n");
+  consolePrintf("SPEED [5-50]     - Set character speed\n");
+  consolePrintf("FARNSWORTH [5-50] - Set effective speed\n");
+  consolePrintf("LESSON [1-40]    - Jump to Koch lesson\n");
+  consolePrintf("FREQ [300-1200]  - Set sidetone frequency\n");
+  consolePrintf("STATS            - Show detailed statistics\n");
+  consolePrintf("RESET            - Reset this profile's statistics\n");
+  consolePrintf("HISTORY [S|D|W] n - Progress by session/day/week\n");
+  consolePrintf("PROFILES         - List operator profiles\n");
+  consolePrintf("PROFILE [1-8]    - Switch operator profile\n");
+  consolePrintf("PROFILE NAME x   - Name the current profile\n");
+  consolePrintf("HEAP             - Show heap probe\n");
+  consolePrintf("INPUT            - Show input queue stats\n");
+  consolePrintf("CONSOLE          - Show dropped console lines\n");
+  consolePrintf("STORE            - Show settings store stats\n");
+  consolePrintf("LINK             - Show companion link stats\n");
+  consolePrintf("LINK BENCH [s]   - Loopback throughput test\n");
+  consolePrintf("MONITOR [ON|OFF] - Live audio stream to the web\n");
+  consolePrintf("SPECTRUM [ON|OFF] - Waterfall feed to the web\n");
+  consolePrintf("LOG              - Show SD session log stats\n");
+  consolePrintf("DRILL            - Show drill character weights\n");
+  consolePrintf("EXPORT [CSV]     - Dump all stats as a backup\n");
+  consolePrintf("IMPORT:...       - Paste backup lines to restore\n");
+  consolePrintf("TRACE START|STOP - Record input trace\n");
+  consolePrintf("TRACE DUMP       - Print trace as hex\n");
+  consolePrintf("TRACE REPLAY [x] - Replay trace at x speed\n");
+  consolePrintf("HELP             - Show this help\n");
+  consolePrintf("========================\n\n");
+}
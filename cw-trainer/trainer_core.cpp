@@ -0,0 +1,145 @@
+#include "trainer_core.h"
+#include "trainer_trace.h"
+#include "trainer_input.h"
+#include "trainer_store.h"
+#include "trainer_export.h"
+#include "trainer_history.h"
+#include "trainer_monitor.h"
+#include "trainer_spectrum.h"
+
+// Configuration variables
+float sidetoneFreq = 600.0;
+float volume = 0.5;
+int currentWaveform = 0;
+bool useHeadphones = false;
+bool keyPressed = false;
+bool decoderEnabled = true;
+bool kochModeEnabled = false;
+bool useExternalAudio = true;  // false = sidetone, true = radio input
+
+PracticeMode currentPracticeMode = KOCH_TRAINING;
+
+const char* waveformNames[] = { "Sine", "Square", "Sawtooth", "Triangle" };
+const char* practiceModeNames[] = { "Koch", "Callsign", "QSO", "Contest", "Custom" };
+
+static unsigned long lastDisplayUpdate = 0;
+static unsigned long lastSave = 0;
+
+void trainerBegin() {
+  updateWaveform();
+  updateFrequency();
+  updateVolume();
+  updateOutputRouting();
+  updateToneDetector();
+  updateAudioInput();
+  initializeKoch();
+  historyLoad();
+
+  sessionStartTime = halMillis();
+  lastSave = sessionStartTime;
+  updateDisplay();
+}
+
+void trainerTick() {
+  // Key, button and encoder events queued by the input interrupts
+  serviceInput();
+
+  // Handle CW key (manual keying)
+  if (!kochSending) {
+    handleManualKeying();
+  }
+
+  // Handle decoder
+  if (decoderEnabled && !kochSending) {
+    processCWDecoder();
+  }
+
+  // Handle various training modes
+  if (kochModeEnabled) {
+    processKochSending();
+  }
+
+  // Update display periodically
+  if (halMillis() - lastDisplayUpdate > 100) {
+    updateDisplay();
+    lastDisplayUpdate = halMillis();
+  }
+
+  // Auto-save statistics every 5 minutes
+  if (halMillis() - lastSave > 300000) {
+    saveSettings();
+    lastSave = halMillis();
+  }
+
+  // Background compaction of the settings log
+  storeService();
+
+  // Paced bulk export lines
+  exportService();
+
+  // Live audio for the web page, when a browser listens
+  monitorPoll();
+  spectrumPoll();
+
+  // Coalesced status changes to the companion
+  linkPoll();
+}
+
+// Centralised settings application – updates all subsystems after any config change
+void applySettings() {
+  updateFrequency();
+  updateToneDetector();
+  calculateKochTiming();
+  updateDisplay();
+  sendStatusToWiFi();
+}
+
+void consolePrintf(const char* fmt, ...) {
+  static char line[160];
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(line, sizeof(line), fmt, ap);
+  va_end(ap);
+  traceOutput(line);
+  halConsoleWrite(line);
+}
+
+// Lesson PRNG (xorshift32). Lives in the core rather than the HAL so a seed
+// produces the same lesson text on the Teensy and on the host.
+static uint32_t rngState = 0x2545F491;
+
+void trainerRandomSeed(uint32_t seed) {
+  rngState = seed ? seed : 0x2545F491;
+}
+
+uint32_t trainerRandom32() {
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+long trainerRandom(long howBig) {
+  if (howBig <= 0) return 0;
+  return trainerRandom32() % (uint32_t)howBig;
+}
+
+long trainerRandom(long howSmall, long howBig) {
+  if (howSmall >= howBig) return howSmall;
+  return howSmall + trainerRandom(howBig - howSmall);
+}
+
+// Line helpers shared by the USB and companion command parsers
+bool startsWith(const char* s, const char* prefix) {
+  return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+// Strip leading/trailing whitespace in place; returns the trimmed start
+char* trimLine(char* s) {
+  while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n') s++;
+  size_t len = strlen(s);
+  while (len > 0 && (s[len - 1] == ' ' || s[len - 1] == '\t' || s[len - 1] == '\r' || s[len - 1] == '\n')) {
+    s[--len] = '\0';
+  }
+  return s;
+}
@@ -0,0 +1,234 @@
+#ifndef TRAINER_CORE_H
+#define TRAINER_CORE_H
+
+// Hardware-independent trainer core: Koch lessons, generators, decoder,
+// statistics, companion protocol and menu state. Talks to the outside world
+// only through trainer_hal.h, so it builds both for the Teensy and on the host.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "trainer_hal.h"
+#include "trainer_buffers.h"
+
+// ---- Configuration (trainer_core.cpp) ----------------------------------------
+extern float sidetoneFreq;
+extern float volume;
+extern int currentWaveform;
+extern bool useHeadphones;
+extern bool keyPressed;
+extern bool decoderEnabled;
+extern bool kochModeEnabled;
+extern bool useExternalAudio;  // false = sidetone, true = radio input
+
+extern const char* waveformNames[];
+extern const char* practiceModeNames[];
+
+// ---- Practice modes -----------------------------------------------------------
+enum PracticeMode { KOCH_TRAINING,
+                    CALLSIGN_PRACTICE,
+                    QSO_SIMULATION,
+                    CONTEST_MODE,
+                    CUSTOM_LESSON };
+extern PracticeMode currentPracticeMode;
+
+// ---- Menu system (trainer_menu.cpp) -------------------------------------------
+enum MenuMode { MAIN_SCREEN,
+                KOCH_MENU,
+                PRACTICE_MENU,
+                SETTINGS_MENU,
+                STATS_MENU,
+                QSO_MENU };
+extern MenuMode currentMenu;
+extern int menuSelection;
+extern bool inMenu;
+extern bool editMode;
+
+// ---- Statistics and persisted settings (trainer_stats.cpp) -------------------
+struct TrainingStats {
+  unsigned long totalDits;
+  unsigned long totalDahs;
+  unsigned long charactersDecoded;
+  unsigned long sessionsCompleted;
+  float bestWPM;
+  float totalTrainingMinutes;
+  int highestLesson;
+  float lessonAccuracy[40];           // Accuracy for each Koch lesson
+  unsigned long lastSessionTime;
+  int customLessonsCompleted;
+  float averageAccuracy;
+};
+
+struct DeviceSettings {
+  float sidetoneFreq;
+  float volume;
+  uint8_t waveform;
+  bool useHeadphones;
+  bool decoderEnabled;
+  bool useExternalAudio;
+  bool kochModeEnabled;
+};
+
+extern TrainingStats stats;
+extern DeviceSettings deviceSettings;
+extern unsigned long sessionStartTime;
+extern float currentWPM;
+
+// ---- Koch method and lessons (trainer_lessons.cpp) ---------------------------
+const int KOCH_LESSON_COUNT = 40;
+const size_t LESSON_TEXT_MAX = 256;
+
+extern int kochLesson;
+extern const char* kochCharSet;
+extern int kochSpeed;
+extern int kochEffectiveSpeed;
+extern const char* kochSentText;  // lives in lessonArena until the next lesson starts
+extern size_t kochSentLength;
+extern FixedText<LESSON_TEXT_MAX + 1> kochReceivedText;
+extern int kochCharIndex;
+extern unsigned long kochSendTimer;
+extern bool kochSending;
+extern bool kochListening;
+extern int kochCorrect;
+extern int kochTotal;
+extern float kochAccuracy;
+extern Arena lessonArena;
+
+// ---- Decoder (trainer_decoder.cpp) ------------------------------------------
+struct MorseChar {
+  char character;
+  const char* code;
+};
+
+const int MORSE_SYMBOL_COUNT = 50;
+
+extern const MorseChar morseTable[];
+extern const int morseTableSize;
+
+extern float ditLength;
+extern float dahThreshold;
+extern float charSpaceThreshold;
+extern float wordSpaceThreshold;
+extern TextRing<64> decodedText;  // rolling decoded copy, oldest dropped first
+
+// ---- Companion link state (trainer_link.cpp) ---------------------------------
+extern bool wifiEnabled;
+extern bool espConnected;
+extern unsigned long lastWiFiHeartbeat;
+extern bool linkFramed;  // the companion offered frames in its HELLO (trainer_frame.h)
+extern uint32_t linkBaud;  // current companion UART rate
+const unsigned long PING_INTERVAL = 5000;
+
+// ---- Core entry points ---------------------------------------------------------
+void trainerBegin();  // after the platform is up: load settings, apply, init Koch
+void trainerTick();   // once per main loop iteration
+void applySettings();
+void consolePrintf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+bool startsWith(const char* s, const char* prefix);
+long trainerRandom(long howBig);               // [0, howBig)
+long trainerRandom(long howSmall, long howBig);  // [howSmall, howBig)
+void trainerRandomSeed(uint32_t seed);
+uint32_t trainerRandom32();
+char* trimLine(char* s);
+
+// Lessons
+void initializeKoch();
+void startKochLesson();
+void stopKochLesson();
+void evaluateKochSession();
+void calculateKochTiming();
+void startPracticeMode();
+void handlePracticeModeButton();
+void processKochSending();
+void generateCallsignLesson();
+void generateContestExchange();
+void generateCustomLesson();
+void startQSOSimulation();
+void continueQSOSimulation();
+
+// Decoder
+void handleManualKeying();
+void processCWDecoder();
+void resetDecoder();
+bool decoderIdle();  // no tone and no half-decoded character
+const char* getMorseCode(char c);
+int morseSymbolIndex(char c);  // position in morseTable, -1 if absent
+char lookupMorseCharacter(const char* morseCode);
+
+// Statistics / persistence
+void loadSettings();
+void saveSettings();
+void resetAllStats();  // also clears the per-character stats (trainer_charstats.h)
+void displayDetailedStats();
+
+// Menu / display
+void menuShortPress();
+void menuLongPress();
+void menuRotate(int delta);
+void updateDisplay();
+
+// USB console
+const size_t CONSOLE_LINE_MAX = 64;  // bytes, terminator included; longer lines are dropped
+bool consoleReceiveByte(uint8_t c);  // true once a complete command has run
+void processSerialCommand(char* line);
+void printHelp();
+
+struct ConsoleCounters {
+  unsigned long lines;
+  unsigned long overlong;
+  unsigned long garbled;  // control or non-ASCII bytes
+};
+
+const ConsoleCounters& consoleStats();
+
+// Companion link
+void linkReceiveByte(uint8_t c);  // every byte from the companion UART
+void linkWriteLine(const char* line);  // a protocol line, framed once negotiated
+bool linkHeld();                      // a rate change is under way: output waits
+void linkSendHello();
+void linkPing();
+void linkPoll();  // every tick: status deltas and snapshots, rate change timeouts
+void linkDown();  // heartbeat lost: back to text at LINK_BAUD_DEFAULT
+void linkBenchStart(int seconds);  // LINK BENCH: loopback throughput through the companion
+size_t linkSendStream(uint8_t type, const void* body, size_t len);  // FRAME_AUDIO, FRAME_SPECTRUM; bytes written, 0 unless framed
+
+struct LinkCounters {
+  unsigned long txFrames;
+  unsigned long txBytes;
+  unsigned long statusSnapshots;
+  unsigned long statusDeltas;
+  unsigned long statusBytes;  // snapshots and deltas
+  unsigned long decodedBatches;
+  unsigned long decodedChars;
+  unsigned long decodedBytes;
+  unsigned long commands;          // acknowledged (CMD:)
+  unsigned long commandsRejected;  // of those, answered with other than OK
+  unsigned long linesHeld;         // written while the rate moved, sent once it settled
+  unsigned long heldResyncs;       // more than fitted was held: everything resent instead
+  unsigned long decodedDropped;    // a held batch was full
+
+  // The last LINK BENCH run
+  unsigned long benchFrames;  // echoed intact
+  unsigned long benchBytes;   // body bytes echoed intact
+  unsigned long benchErrors;  // echoed damaged
+  unsigned long benchLost;
+  unsigned long benchMillis;
+};
+
+const LinkCounters& linkStats();
+void printLinkStats();
+void processWiFiMessage(char* message);
+
+// Outcome of a companion command, reported in ACK: lines
+enum CommandResult : uint8_t { COMMAND_OK,
+                               COMMAND_RANGE,
+                               COMMAND_REFUSED,
+                               COMMAND_UNKNOWN };
+CommandResult processRemoteCommand(char* command);  // after TEENSY:
+
+void sendStatusToWiFi();
+void sendStatsToWiFi();
+void sendDecodedCharToWiFi(char c, bool miscopied = false);  // batched, see linkPoll
+void sendCurrentTextToWiFi(const char* text);
+
+#endif  // TRAINER_CORE_H
@@ -0,0 +1,35 @@
+#include "trainer_corpus.h"
+
+const int CODE_BITS = 6;
+
+uint16_t corpusCount(CorpusList list) {
+  return pgm_read_word(&CORPUS_LISTS[list].count);
+}
+
+// Code i starts at bit 6*i and never spans more than two bytes
+static uint8_t codeAt(uint16_t position) {
+  uint32_t bit = (uint32_t)position * CODE_BITS;
+  uint16_t pair = (pgm_read_byte(&CORPUS_PACKED[bit / 8]) << 8) | pgm_read_byte(&CORPUS_PACKED[bit / 8 + 1]);
+  return (pair >> (16 - CODE_BITS - bit % 8)) & ((1 << CODE_BITS) - 1);
+}
+
+// Index fields are at most 16 bits wide, so they fit a three-byte window
+static uint16_t tokenStart(uint16_t token) {
+  uint32_t bit = (uint32_t)token * CORPUS_INDEX_BITS;
+  const uint8_t* p = &CORPUS_INDEX[bit / 8];
+  uint32_t window = ((uint32_t)pgm_read_byte(p) << 16) | (pgm_read_byte(p + 1) << 8) | pgm_read_byte(p + 2);
+  return (window >> (24 - CORPUS_INDEX_BITS - bit % 8)) & ((1UL << CORPUS_INDEX_BITS) - 1);
+}
+
+bool corpusToken(CorpusList list, uint16_t index, TextWriter& out) {
+  if (index >= corpusCount(list)) return true;
+  uint16_t token = pgm_read_word(&CORPUS_LISTS[list].first) + index;
+  uint16_t end = tokenStart(token + 1);
+  for (uint16_t position = tokenStart(token); position < end; position++) {
+    uint8_t code = codeAt(position);
+    if (!out.append((char)pgm_read_byte(&CORPUS_CODES[code][0]))) return false;
+    char second = pgm_read_byte(&CORPUS_CODES[code][1]);
+    if (second && !out.append(second)) return false;
+  }
+  return true;
+}
@@ -0,0 +1,39 @@
+#ifndef TRAINER_CORPUS_H
+#define TRAINER_CORPUS_H
+
+// Practice corpus in flash: English words, CW abbreviations and Q-codes,
+// callsign prefixes, contest exchanges and QSO phrases. The lists live in
+// corpus/*.txt; corpus/make_corpus.py packs them into trainer_corpus_data.cpp
+// as 6-bit codes (single characters or common pairs) with a bit-packed
+// per-token offset index, so any token decodes on its own without unpacking
+// the rest.
+
+#include "trainer_core.h"
+
+#ifdef ARDUINO
+#include <pgmspace.h>
+#endif
+
+enum CorpusList { CORPUS_WORDS,
+                  CORPUS_ABBREVIATIONS,
+                  CORPUS_PREFIXES,
+                  CORPUS_EXCHANGES,
+                  CORPUS_PHRASES,
+                  CORPUS_LIST_COUNT };
+
+struct CorpusRange {
+  uint16_t first;  // index of the list's first token
+  uint16_t count;
+};
+
+// Generated tables (trainer_corpus_data.cpp)
+extern const char CORPUS_CODES[][2];
+extern const uint8_t CORPUS_PACKED[];
+extern const uint8_t CORPUS_INDEX[];
+extern const uint8_t CORPUS_INDEX_BITS;
+extern const CorpusRange CORPUS_LISTS[CORPUS_LIST_COUNT];
+
+uint16_t corpusCount(CorpusList list);
+bool corpusToken(CorpusList list, uint16_t index, TextWriter& out);  // false if out filled up
+
+#endif  // TRAINER_CORPUS_H
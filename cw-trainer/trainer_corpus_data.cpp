@@ -0,0 +1,177 @@
+// Generated by corpus/make_corpus.py from corpus/*.txt -- do not edit.
+// 637 tokens: 2554 bytes packed with index, 5555 as a string table.
+
+#include "trainer_corpus.h"
+
+static_assert(CORPUS_LIST_COUNT == 5, "CorpusList does not match make_corpus.py");
+
+const char CORPUS_CODES[64][2] PROGMEM = {
+  { ' ', 0 }, { '+', 0 }, { '0', 0 }, { '1', 0 }, { '2', 0 }, { '3', 0 }, { '4', 0 }, { '5', 0 }, { '6', 0 }, { '7', 0 }, { '8', 0 }, { '9', 0 }, { '=', 0 }, { '?', 0 }, { 'A', 0 }, { 'B', 0 }, { 'C', 0 }, { 'D', 0 }, { 'E', 0 }, { 'F', 0 }, { 'G', 0 }, { 'H', 0 }, { 'I', 0 }, { 'J', 0 }, { 'K', 0 }, { 'L', 0 }, { 'M', 0 }, { 'N', 0 }, { 'O', 0 }, { 'P', 0 }, { 'Q', 0 }, { 'R', 0 }, { 'S', 0 }, { 'T', 0 }, { 'U', 0 }, { 'V', 0 }, { 'W', 0 }, { 'X', 0 }, { 'Y', 0 }, { 'Z', 0 }, { 'A', 'L' }, { 'A', 'N' }, { 'A', 'R' }, { 'E', 'A' }, { 'E', 'N' }, { 'E', 'R' }, { 'H', 'E' }, { 'H', 'I' }, { 'I', 'N' }, { 'I', 'S' }, { 'L', 'L' }, { 'M', 'E' }, { 'N', 'D' }, { 'N', 'T' }, { 'O', 'U' }, { 'Q', 'R' }, { 'R', ' ' }, { 'R', 'E' }, { 'S', ' ' }, { 'S', 'E' }, { 'S', 'T' }, { 'T', 'E' }, { 'T', 'H' }, { 'V', 'E' }
+};
+
+const uint8_t CORPUS_PACKED[1526] PROGMEM = {
+  0xF9, 0x27, 0x13, 0xA5, 0x18, 0x5C, 0xC3, 0x19, 0xB6, 0xF8, 0xE8, 0x56, 0x86, 0xE9, 0x0E, 0x81,
+  0x37, 0x1F, 0x71, 0xBA, 0x92, 0x3A, 0x09, 0x16, 0xFA, 0xF8, 0x3E, 0x4A, 0x63, 0xA1, 0x3D, 0x2F,
+  0xB1, 0x54, 0xEF, 0xD3, 0x7D, 0xC6, 0x9C, 0x7D, 0xC6, 0xD2, 0x54, 0xE4, 0x4F, 0x9A, 0x47, 0x1F,
+  0x44, 0xF8, 0xA1, 0x6D, 0xC8, 0x64, 0x54, 0xE8, 0x68, 0x66, 0x4B, 0x52, 0x91, 0x29, 0x2E, 0x6E,
+  0x6D, 0x9F, 0x42, 0x98, 0x0E, 0x59, 0x1F, 0xAD, 0x4A, 0x2E, 0xE9, 0xAD, 0x05, 0x64, 0xBD, 0x05,
+  0x60, 0xB9, 0x17, 0x15, 0x72, 0x4F, 0x92, 0x59, 0xF5, 0x93, 0x91, 0x6C, 0xA2, 0x75, 0xCF, 0xAD,
+  0x38, 0xFD, 0xA1, 0xDA, 0x16, 0xA9, 0x9B, 0xEB, 0x3E, 0x49, 0xAF, 0x92, 0xEE, 0x07, 0x20, 0x73,
+  0x3B, 0x9F, 0x93, 0x66, 0x51, 0x68, 0xE6, 0x12, 0x65, 0x66, 0x12, 0xBD, 0xAC, 0x21, 0x72, 0x15,
+  0xB3, 0x54, 0xE8, 0x19, 0x71, 0xC6, 0x21, 0x91, 0xC6, 0x9C, 0xE6, 0x47, 0xD6, 0xF5, 0x47, 0x3B,
+  0x49, 0xB8, 0x9A, 0x3E, 0xD6, 0xDC, 0x90, 0xE9, 0x90, 0xD9, 0x94, 0x5D, 0x49, 0xC7, 0x59, 0x49,
+  0xA9, 0xBE, 0xA5, 0x35, 0x9F, 0xF2, 0x43, 0xBD, 0x7C, 0xF4, 0xAC, 0x42, 0x86, 0x64, 0x55, 0xC7,
+  0x16, 0x65, 0x68, 0x60, 0x6D, 0xC9, 0x13, 0xC1, 0x16, 0x5C, 0x6D, 0x44, 0x5C, 0x91, 0xB4, 0x4E,
+  0x99, 0x15, 0x91, 0x51, 0x28, 0x50, 0x73, 0x36, 0x8E, 0x45, 0x26, 0x8E, 0x99, 0xDA, 0xA1, 0x73,
+  0xF7, 0xDB, 0x4A, 0x48, 0x36, 0xD2, 0x13, 0x98, 0x49, 0xC6, 0xD9, 0x99, 0x95, 0xA1, 0x85, 0x94,
+  0xA4, 0x71, 0xF6, 0x18, 0x6D, 0xC9, 0x1D, 0x64, 0xE4, 0x12, 0x9A, 0xB7, 0xD9, 0x5B, 0xFC, 0xCF,
+  0x39, 0x06, 0x14, 0x5B, 0xF6, 0x9C, 0xF3, 0xF7, 0xE6, 0x39, 0x3F, 0x5F, 0xFB, 0x05, 0x36, 0x7D,
+  0x78, 0xBC, 0x6C, 0xEC, 0xD4, 0x71, 0xC4, 0x7B, 0xD6, 0xC4, 0x12, 0x6A, 0x9F, 0xB0, 0x62, 0x03,
+  0xA6, 0x53, 0x93, 0xA1, 0x92, 0xEE, 0x6E, 0x65, 0xDF, 0x9F, 0xD9, 0x45, 0x5A, 0x89, 0x05, 0x4F,
+  0x49, 0x37, 0x39, 0x67, 0x04, 0x9F, 0x59, 0x45, 0x61, 0x85, 0xC7, 0x33, 0xA5, 0xC6, 0x51, 0xA6,
+  0x68, 0x0E, 0xCF, 0xDC, 0x8F, 0x72, 0x64, 0xDC, 0xC9, 0xC9, 0x10, 0x3B, 0x39, 0x29, 0x86, 0x05,
+  0x5C, 0x92, 0x88, 0x1C, 0xAB, 0x6D, 0x13, 0x71, 0xF6, 0xBE, 0xE5, 0x28, 0x1A, 0xA1, 0x9E, 0xE1,
+  0x76, 0x28, 0x6C, 0x45, 0x17, 0x12, 0x82, 0x97, 0x3E, 0xB6, 0x44, 0xB2, 0x66, 0xA5, 0x12, 0x6A,
+  0x2F, 0x0F, 0x59, 0x44, 0xBF, 0x6E, 0x08, 0x90, 0x54, 0xF4, 0x90, 0x3A, 0x2E, 0xE1, 0x89, 0xF6,
+  0xEE, 0xE6, 0x45, 0x66, 0x3A, 0x06, 0x24, 0xB2, 0x1C, 0xDB, 0xE4, 0xE4, 0x5B, 0x49, 0x24, 0x59,
+  0xA5, 0x14, 0x56, 0x4D, 0x3B, 0x6C, 0x85, 0x57, 0x33, 0x8A, 0x06, 0x9C, 0xFE, 0x17, 0xE6, 0x63,
+  0x04, 0x55, 0xA5, 0x17, 0x56, 0x42, 0x18, 0xB9, 0x39, 0x43, 0xB0, 0x41, 0x5A, 0x54, 0x49, 0xC4,
+  0xD3, 0x75, 0x93, 0xA6, 0x81, 0xD4, 0xB2, 0x39, 0x67, 0xCE, 0x90, 0xE9, 0xA9, 0x59, 0xAA, 0x15,
+  0xDB, 0xB7, 0x5C, 0xC2, 0x17, 0x4E, 0x51, 0x26, 0x52, 0x87, 0xD7, 0xDA, 0x73, 0xEB, 0x69, 0x82,
+  0x4B, 0x53, 0xDB, 0x4F, 0x22, 0x46, 0x6F, 0x16, 0xC9, 0x9A, 0xDF, 0x6E, 0x05, 0x76, 0x65, 0x19,
+  0x1C, 0x7D, 0x94, 0x6F, 0x51, 0x54, 0xBF, 0x7E, 0x66, 0xEB, 0x7C, 0xE4, 0x51, 0x4D, 0xC7, 0x11,
+  0x3D, 0x28, 0x64, 0x4A, 0xC7, 0x24, 0x6C, 0xF4, 0x99, 0x72, 0x44, 0x36, 0xD5, 0xF9, 0x9D, 0x66,
+  0x98, 0x59, 0x3B, 0xC8, 0x10, 0x55, 0xC7, 0x19, 0x4C, 0xEF, 0xAD, 0x61, 0x24, 0x9D, 0x87, 0x94,
+  0x9B, 0x4B, 0xF7, 0xFC, 0xAA, 0x14, 0x16, 0x86, 0x6A, 0xDF, 0xF9, 0x29, 0x92, 0x65, 0x65, 0x15,
+  0x87, 0xED, 0x94, 0x56, 0x1B, 0x8E, 0x46, 0x2D, 0x2D, 0xF1, 0xC7, 0xE6, 0x80, 0xE9, 0x19, 0x49,
+  0x38, 0x53, 0x4A, 0x49, 0x2F, 0x65, 0x2A, 0x1C, 0x6D, 0x46, 0x96, 0x51, 0x58, 0x50, 0x65, 0xCE,
+  0xE0, 0x73, 0x3F, 0xB0, 0x53, 0xB4, 0x9A, 0x6D, 0x29, 0x61, 0x56, 0xA4, 0x5C, 0x76, 0xC4, 0xA5,
+  0x39, 0xA7, 0x59, 0x48, 0xF4, 0x94, 0xC1, 0x95, 0x93, 0x4A, 0x89, 0x0E, 0x9A, 0x0F, 0x9C, 0xEC,
+  0xF7, 0x3E, 0x74, 0xE7, 0x6D, 0x85, 0xC5, 0x12, 0xFA, 0xD5, 0x1C, 0x85, 0x47, 0xF6, 0x75, 0xC4,
+  0xFD, 0x6D, 0xF8, 0x9B, 0x59, 0xA7, 0x5C, 0x7E, 0x1A, 0x61, 0x8B, 0x55, 0x99, 0x42, 0xF6, 0x51,
+  0xE5, 0xB8, 0x16, 0x45, 0x24, 0xD2, 0x4A, 0x14, 0x2A, 0x69, 0x66, 0x52, 0x6D, 0x65, 0x15, 0x86,
+  0x4A, 0x18, 0x92, 0xFF, 0x7B, 0x38, 0xF4, 0x94, 0xA5, 0x47, 0xDC, 0x92, 0x17, 0x1C, 0x61, 0xF5,
+  0xBF, 0x7D, 0x3D, 0x9F, 0x42, 0xA7, 0xE6, 0xF0, 0xEF, 0x5C, 0x6D, 0x04, 0x8F, 0x71, 0xC6, 0x2E,
+  0xAB, 0xC7, 0x1D, 0x91, 0x6F, 0xB6, 0x87, 0xB4, 0x1C, 0xD1, 0x93, 0xBD, 0x7D, 0xAC, 0x60, 0x59,
+  0x1A, 0xEC, 0xD9, 0x45, 0x6B, 0x85, 0x33, 0x90, 0x4A, 0x43, 0xA1, 0x41, 0x54, 0xEA, 0xE6, 0x86,
+  0x66, 0xA1, 0xA7, 0x3C, 0x65, 0x28, 0x4E, 0x3D, 0xCF, 0xD4, 0x59, 0xF6, 0x60, 0x73, 0x38, 0x56,
+  0xCE, 0x06, 0xB6, 0xD4, 0xEC, 0x10, 0x8A, 0x19, 0xB6, 0x6D, 0x48, 0x68, 0x62, 0x07, 0x1C, 0x6D,
+  0x9C, 0x61, 0x81, 0xC6, 0xD4, 0x3D, 0x2C, 0x14, 0x66, 0xBF, 0xD3, 0x39, 0xA5, 0x99, 0x99, 0xF3,
+  0x91, 0x59, 0xCA, 0x7D, 0x6D, 0xB3, 0xA0, 0x59, 0x46, 0xE8, 0x75, 0xC9, 0x2D, 0x92, 0xBF, 0xAD,
+  0x41, 0xE4, 0x52, 0x61, 0x86, 0xCF, 0x62, 0x06, 0x2A, 0x04, 0xC7, 0xE1, 0x8A, 0x16, 0xE5, 0x4C,
+  0xF7, 0x1A, 0x99, 0x99, 0x66, 0x66, 0x27, 0xDF, 0xF0, 0x76, 0xDB, 0x1C, 0xB2, 0xC7, 0x24, 0xB6,
+  0xCE, 0xCD, 0xEF, 0x9F, 0x59, 0x4A, 0x61, 0x92, 0x55, 0x5F, 0x4A, 0x05, 0x64, 0x41, 0xD9, 0x8E,
+  0x51, 0xB7, 0x7B, 0x3E, 0x15, 0x1A, 0x50, 0xE5, 0x12, 0x51, 0xB2, 0x45, 0x28, 0xA4, 0x22, 0x65,
+  0x17, 0xD5, 0x75, 0x27, 0x64, 0x7D, 0x3B, 0x60, 0x7D, 0x66, 0xDF, 0x7D, 0xD8, 0x4E, 0x3E, 0x19,
+  0x16, 0x46, 0x46, 0x11, 0x92, 0x24, 0x4F, 0x41, 0xB8, 0x9C, 0x76, 0x05, 0x94, 0xF7, 0xC4, 0x13,
+  0x69, 0xB5, 0x99, 0xDD, 0x9D, 0xDA, 0xDD, 0xBD, 0xDC, 0xDD, 0xDD, 0xDE, 0xDE, 0x0D, 0xE1, 0xDE,
+  0x2D, 0xE3, 0xDE, 0x5D, 0xE7, 0x7A, 0x03, 0xDE, 0x81, 0x97, 0xA0, 0x71, 0xE8, 0x26, 0x7A, 0x17,
+  0xDE, 0x81, 0x8D, 0xD4, 0xDD, 0x87, 0xA0, 0x75, 0x89, 0x1B, 0x38, 0xE3, 0x8F, 0x39, 0x03, 0x91,
+  0x39, 0x23, 0x93, 0x39, 0x43, 0x96, 0x39, 0x73, 0x98, 0x61, 0x96, 0x15, 0x61, 0xDF, 0xE3, 0x3A,
+  0x37, 0x23, 0x9A, 0x54, 0xA1, 0x59, 0x57, 0x50, 0x72, 0xF7, 0x66, 0x76, 0x26, 0x62, 0x41, 0x24,
+  0x25, 0x70, 0xE5, 0x58, 0x9A, 0x35, 0x50, 0x51, 0xA5, 0x1A, 0x52, 0x45, 0x16, 0x49, 0x64, 0xD1,
+  0x65, 0x16, 0x11, 0x5D, 0x14, 0xD1, 0x71, 0xC6, 0xDD, 0x39, 0xD4, 0x59, 0x95, 0x53, 0xDC, 0x49,
+  0x65, 0x98, 0x5A, 0x7A, 0xD2, 0x3D, 0x08, 0x60, 0x6A, 0x03, 0x99, 0x39, 0xC5, 0x5C, 0x9E, 0x14,
+  0xE0, 0x76, 0x07, 0x9C, 0x61, 0xC6, 0x5C, 0x69, 0x53, 0xA6, 0x71, 0x99, 0xE0, 0x8E, 0x13, 0xA6,
+  0x88, 0xB3, 0xA0, 0x1D, 0x22, 0x67, 0x15, 0x28, 0x26, 0x65, 0x99, 0xA2, 0x7E, 0x28, 0x52, 0x92,
+  0xD8, 0x8E, 0x7C, 0xE7, 0xE4, 0x7E, 0x77, 0xE2, 0x6C, 0x69, 0x46, 0x9C, 0xE1, 0x8E, 0x20, 0xE2,
+  0x55, 0x9D, 0x27, 0x63, 0x88, 0xE7, 0x60, 0x10, 0x68, 0x15, 0x82, 0x58, 0xCB, 0x68, 0xB8, 0xE6,
+  0x3D, 0x18, 0x8F, 0x8C, 0xF9, 0x8F, 0x52, 0x37, 0xD7, 0x39, 0x75, 0x57, 0x7D, 0x74, 0x97, 0x4D,
+  0x75, 0x17, 0x59, 0x56, 0x51, 0x82, 0x36, 0x27, 0x66, 0x78, 0x23, 0x1C, 0xE1, 0x27, 0x10, 0x79,
+  0xC7, 0x54, 0x76, 0xCB, 0x50, 0x89, 0x10, 0x6C, 0x99, 0x45, 0x8E, 0x08, 0x92, 0x86, 0x83, 0x98,
+  0x3A, 0x7A, 0x90, 0x39, 0x07, 0x10, 0x85, 0x14, 0x93, 0x65, 0x43, 0xAF, 0x59, 0x15, 0x99, 0xC1,
+  0x63, 0x98, 0x81, 0x89, 0x99, 0x3B, 0x36, 0x91, 0x68, 0xE6, 0x96, 0x69, 0xB6, 0xA0, 0x69, 0xC6,
+  0xA1, 0x6D, 0x26, 0xE3, 0x6D, 0x56, 0xD7, 0x6D, 0xA6, 0xE6, 0x6D, 0x0D, 0x1C, 0x55, 0xC6, 0x1C,
+  0x7D, 0xD3, 0x9F, 0x5A, 0x04, 0x20, 0x46, 0x16, 0xE1, 0x96, 0x28, 0x63, 0x86, 0x33, 0xA4, 0x3A,
+  0x48, 0xE4, 0x5A, 0x49, 0x9B, 0x3D, 0xB8, 0x1D, 0x49, 0xE4, 0x1C, 0x6D, 0xA3, 0xE0, 0x60, 0xE3,
+  0xCF, 0x41, 0xB6, 0x66, 0x87, 0x56, 0xE2, 0x08, 0x70, 0x8A, 0x0C, 0x60, 0xC7, 0x0C, 0x81, 0x07,
+  0x10, 0x91, 0x0A, 0x0C, 0x20, 0x98, 0x90, 0x79, 0x21, 0x6E, 0x50, 0x13, 0xB4, 0x04, 0x28, 0x66,
+  0x2E, 0x1F, 0xF0, 0x01, 0xC9, 0x2C, 0x01, 0xC9, 0x2E, 0x2E, 0x1F, 0xF0, 0x01, 0xDB, 0x6D, 0xB3,
+  0xB3, 0x01, 0x5E, 0x31, 0x00, 0xF7, 0x0F, 0x6C, 0xEC, 0xC0, 0xC4, 0x0A, 0x5B, 0x02, 0x96, 0xDE,
+  0xF8, 0x06, 0xF8, 0x46, 0xCF, 0xDF, 0x7B, 0xE0, 0x31, 0x00, 0xF7, 0x3C, 0x71, 0xB0, 0x1A, 0x39,
+  0xF5, 0x94, 0x01, 0x5E, 0x31, 0x01, 0x89, 0x45, 0x7D, 0x65, 0x00, 0xC4, 0x05, 0x5C, 0xCC, 0xFE,
+  0x64, 0x76, 0x4E, 0x03, 0x08, 0x29, 0x1D, 0x93, 0x81, 0xE4, 0x03, 0x77, 0x69, 0x84, 0x0C, 0x40,
+  0x45, 0x67, 0x5C, 0x65, 0x2A, 0x61, 0x03, 0x10, 0x3F, 0x7E, 0x15, 0x90, 0xA2, 0x98, 0x40, 0xC4,
+  0x01, 0x40, 0x49, 0x90, 0x26, 0x39, 0x45, 0xA4, 0x94, 0x05, 0x78, 0x82, 0x26, 0xDB, 0x9A, 0x49,
+  0x40, 0xC4, 0x04, 0x19, 0xD9, 0x19, 0x80, 0x4B, 0xA4, 0x1C, 0x65, 0x19, 0x25, 0x01, 0xF3, 0xB0,
+  0x03, 0xD6, 0x9D, 0x00, 0x31, 0x10, 0x56, 0x40, 0x10, 0x76, 0x63, 0x5D, 0xEC, 0x0D, 0xE0, 0x77,
+  0xB0, 0x1F, 0x76, 0x10, 0x22, 0xE1, 0xB3, 0xB3, 0x81, 0xF5, 0x80, 0xDD, 0xA7, 0xA0, 0x3C, 0x05,
+  0x5F, 0x4C, 0xF0, 0x1C, 0x68, 0x08, 0x5B, 0x94, 0x07, 0xA0, 0x72, 0x16, 0xE5, 0x01, 0x3B, 0x40,
+  0x4C, 0xF0, 0x1E, 0x81, 0xC5, 0x5D, 0x48, 0x04, 0x22, 0x64, 0x91, 0x40, 0x4B, 0xA5, 0x22, 0x44,
+  0x04, 0x65, 0x51, 0x90, 0x12, 0xE8, 0x91, 0x77, 0x88, 0xD0, 0x37, 0x85, 0xE8, 0x19, 0x02, 0x35,
+  0x8E, 0x00, 0xF8, 0x9F, 0x71, 0xE8, 0x19, 0x02, 0x35, 0x8E, 0x01, 0x97, 0x21, 0x90, 0xE5, 0x12,
+  0x00, 0x61, 0xC0, 0x99, 0xF8, 0x19, 0x59, 0x00, 0x03, 0x2C, 0xB2, 0x9C, 0x74, 0x08, 0x30, 0x41,
+  0x20, 0x03, 0x2C, 0x91, 0xE8, 0x64, 0x07, 0x18, 0x01, 0x57, 0xD0, 0x76, 0x60, 0x28, 0x64, 0x07,
+  0x18, 0x3E, 0x18, 0x94, 0x68, 0x07, 0x1A, 0x50, 0xE0, 0x11, 0xE1, 0xC6, 0x94, 0x48, 0x04, 0xBA,
+  0x85, 0xB9, 0x77, 0x64, 0xDD, 0xE7, 0x35, 0x07, 0x80, 0x41, 0xE0, 0x10, 0x78, 0x04, 0x52, 0x41,
+  0xE0, 0x3D, 0xF1, 0x07, 0x80, 0x46, 0x58, 0x9D, 0x00, 0x41, 0xDB, 0x6C, 0x08, 0x62, 0x86, 0x20,
+  0x09, 0x17, 0x8E, 0x21, 0x88, 0x00
+};
+
+// Start of each token in codes, CORPUS_INDEX_BITS wide; one extra entry marks the end
+const uint8_t CORPUS_INDEX_BITS = 11;
+const uint8_t CORPUS_INDEX[880] PROGMEM = {
+  0x00, 0x00, 0x08, 0x02, 0x00, 0x60, 0x10, 0x02, 0x40, 0x50, 0x0C, 0x01, 0xE0, 0x44, 0x09, 0x01,
+  0x50, 0x30, 0x06, 0x80, 0xE0, 0x1E, 0x04, 0x20, 0x8C, 0x13, 0x02, 0x80, 0x54, 0x0B, 0x01, 0x78,
+  0x33, 0x06, 0xA0, 0xE0, 0x1D, 0x83, 0xD0, 0x82, 0x11, 0x02, 0x38, 0x4B, 0x09, 0xA1, 0x40, 0x29,
+  0x05, 0x50, 0xB0, 0x16, 0x82, 0xF0, 0x61, 0x0C, 0x61, 0x90, 0x33, 0x86, 0xB0, 0xDA, 0x1B, 0xC3,
+  0x90, 0x76, 0x0F, 0x01, 0xEC, 0x3E, 0x88, 0x01, 0x08, 0x21, 0x84, 0x48, 0x8B, 0x11, 0xC2, 0x44,
+  0x49, 0x89, 0x61, 0x30, 0x27, 0x05, 0x00, 0xA4, 0x14, 0xC2, 0xA4, 0x56, 0x0A, 0xF1, 0x66, 0x2D,
+  0x85, 0xC8, 0xBD, 0x17, 0xE3, 0x04, 0x63, 0x0C, 0x81, 0x96, 0x33, 0xC6, 0xA8, 0xD7, 0x1B, 0x23,
+  0x74, 0x70, 0x8E, 0x41, 0xCE, 0x3A, 0x87, 0x68, 0xF0, 0x1E, 0x63, 0xD8, 0x7D, 0x0F, 0xE2, 0x02,
+  0x41, 0x08, 0x39, 0x0A, 0x21, 0xC4, 0x44, 0x8A, 0x11, 0x72, 0x34, 0x47, 0x49, 0x09, 0x25, 0x25,
+  0x64, 0xBC, 0x99, 0x93, 0x82, 0x76, 0x4F, 0x89, 0xF9, 0x43, 0x28, 0xC5, 0x24, 0xA6, 0x15, 0x02,
+  0xA6, 0x55, 0x4A, 0xC1, 0x5B, 0x2B, 0xE5, 0x90, 0xB3, 0x16, 0x92, 0xD8, 0x5C, 0x0B, 0x99, 0x76,
+  0x2F, 0x65, 0xFC, 0xC2, 0x18, 0x73, 0x18, 0x63, 0xCC, 0x89, 0x94, 0x32, 0xC6, 0x64, 0xCD, 0x99,
+  0xE3, 0x46, 0x69, 0x8D, 0x49, 0xAD, 0x36, 0x06, 0xCC, 0xDB, 0x9B, 0xA3, 0x7C, 0x70, 0x0E, 0x19,
+  0xC5, 0x39, 0x27, 0x34, 0xE8, 0x1D, 0x43, 0xAE, 0x76, 0x8E, 0xE9, 0xE1, 0x3C, 0xE7, 0xAC, 0xF6,
+  0x9F, 0x03, 0xE6, 0x7D, 0x8F, 0xC1, 0xFB, 0x3F, 0xE8, 0x09, 0x04, 0xA0, 0xC4, 0x1C, 0x84, 0x50,
+  0xA2, 0x17, 0x43, 0x48, 0x81, 0x12, 0x22, 0x94, 0x58, 0x8C, 0x11, 0xA2, 0x37, 0x47, 0x68, 0xFD,
+  0x21, 0x24, 0x64, 0x94, 0x93, 0xD2, 0x9A, 0x57, 0x4B, 0x49, 0x79, 0x30, 0xA6, 0x54, 0xD4, 0x9B,
+  0xD3, 0x92, 0x76, 0x4F, 0x29, 0xF1, 0x40, 0x28, 0x65, 0x12, 0xA3, 0x94, 0x9A, 0x97, 0x53, 0x4A,
+  0x81, 0x52, 0x2A, 0x85, 0x56, 0xAB, 0xD5, 0x92, 0xB6, 0x57, 0x2A, 0xF1, 0x60, 0xAC, 0x65, 0x92,
+  0xB3, 0x16, 0x82, 0xD3, 0x5A, 0xEB, 0x69, 0x6F, 0x2E, 0x25, 0xCE, 0xBA, 0xD7, 0x8A, 0xF4, 0x5F,
+  0x0B, 0xED, 0x7F, 0x30, 0x56, 0x12, 0xC3, 0x58, 0x93, 0x15, 0x63, 0x0C, 0x71, 0x91, 0x32, 0x56,
+  0x52, 0xCB, 0x59, 0x83, 0x38, 0x67, 0x8D, 0x09, 0xA3, 0x34, 0xA6, 0x98, 0xD4, 0x1A, 0xAB, 0x58,
+  0x6B, 0x6D, 0x75, 0xB0, 0xB6, 0x56, 0xD2, 0xDB, 0x5B, 0x83, 0x74, 0x6E, 0xED, 0xED, 0xBF, 0xB8,
+  0x17, 0x08, 0xE2, 0x5C, 0x6B, 0x91, 0x72, 0x8E, 0x5D, 0xCD, 0xB9, 0xD7, 0x42, 0xE9, 0x9D, 0x43,
+  0xAC, 0x76, 0x0E, 0xCD, 0xDB, 0xBB, 0xB7, 0x84, 0xF1, 0xDE, 0x53, 0xCE, 0x7A, 0x2F, 0x55, 0xEC,
+  0x3D, 0xC7, 0xC0, 0xF8, 0xDF, 0x4B, 0xEE, 0x7E, 0x6F, 0xE1, 0xFE, 0x40, 0x08, 0x05, 0x01, 0x20,
+  0x2C, 0x07, 0x81, 0x30, 0x2E, 0x06, 0x40, 0xD8, 0x1D, 0x03, 0xE0, 0x8C, 0x14, 0x82, 0xD0, 0x62,
+  0x0D, 0x41, 0xD8, 0x3F, 0x08, 0x61, 0x24, 0x27, 0x85, 0x50, 0xB6, 0x17, 0xC3, 0x28, 0x69, 0x0D,
+  0xA1, 0xC4, 0x3A, 0x87, 0x90, 0xFE, 0x21, 0x44, 0x48, 0x8D, 0x12, 0x22, 0x54, 0x4C, 0x89, 0xD1,
+  0x42, 0x29, 0x45, 0x58, 0xAF, 0x16, 0xA2, 0xEC, 0x5F, 0x8C, 0x51, 0x92, 0x33, 0xC6, 0xA8, 0xDB,
+  0x1C, 0x23, 0x9C, 0x77, 0x8F, 0x31, 0xF2, 0x3F, 0x48, 0x19, 0x09, 0x21, 0xA4, 0x44, 0x8A, 0x91,
+  0x92, 0x3A, 0x48, 0x49, 0x29, 0x29, 0x25, 0xA4, 0xC4, 0x9A, 0x93, 0x92, 0x7E, 0x51, 0x4A, 0x59,
+  0x51, 0x2A, 0xE5, 0x74, 0xB0, 0x96, 0x52, 0xD6, 0x5B, 0x4B, 0x79, 0x71, 0x2E, 0xA5, 0xE4, 0xBE,
+  0x98, 0x13, 0x0A, 0x62, 0x4C, 0x69, 0x91, 0x32, 0xA6, 0x64, 0xCE, 0x9A, 0x13, 0x4A, 0x69, 0xCD,
+  0x59, 0xAF, 0x36, 0x66, 0xDC, 0xDD, 0x9B, 0xF3, 0x86, 0x71, 0x4E, 0x49, 0xCD, 0x3A, 0x27, 0x54,
+  0xEC, 0x9D, 0xD3, 0xC2, 0x79, 0x4F, 0x49, 0xEB, 0x3D, 0xA7, 0xC4, 0xFA, 0x9F, 0x93, 0xFA, 0x7F,
+  0xD0, 0x1A, 0x07, 0x41, 0x68, 0x3D, 0x09, 0xA1, 0x74, 0x36, 0x87, 0xD1, 0x1A, 0x27, 0x45, 0x68,
+  0xB5, 0x18, 0xA3, 0x54, 0x6E, 0x8E, 0xD1, 0xFA, 0x43, 0x48, 0xE9, 0x2D, 0x27, 0xA5, 0x34, 0xAE,
+  0x96, 0xD2, 0xFA, 0x63, 0x4C, 0xE9, 0xAD, 0x37, 0xA7, 0x34, 0xEE, 0x9E, 0xD3, 0xFA, 0x83, 0x50,
+  0xEA, 0x2D, 0x47, 0xA9, 0x35, 0x2E, 0xA6, 0xD4, 0xFA, 0xA3, 0x54, 0xEA, 0xAD, 0x56, 0xAB, 0x15,
+  0x6A, 0xAE, 0x55, 0xEA, 0xBF, 0x58, 0x6B, 0x1D, 0x65, 0xAC, 0xF5, 0xA6, 0xB5, 0xD6, 0xDA, 0xDF,
+  0x5C, 0x6B, 0x9D, 0x75, 0xAE, 0xF5, 0xE6, 0xBD, 0xD7, 0xDA, 0xFF, 0x60, 0x6C, 0x1D, 0x85, 0xB0,
+  0xF6, 0x26, 0xC5, 0xD8, 0xDB, 0x1F, 0x64, 0x6C, 0x9D, 0x95, 0xB2, 0xF6, 0x66, 0xCD, 0xD9, 0xDB,
+  0x3F, 0x68, 0x6D, 0x1D, 0xA5, 0xB4, 0xF6, 0xA6, 0xD5, 0xDA, 0xDB, 0x5F, 0x6C, 0x6D, 0x9D, 0xB5,
+  0xB6, 0xF6, 0xE6, 0xDD, 0xDB, 0xDB, 0x7D, 0x70, 0x2E, 0x15, 0xC3, 0xB8, 0xB7, 0x1E, 0xE4, 0xDC,
+  0xBB, 0x9B, 0x73, 0xEE, 0x85, 0xD2, 0xBA, 0x97, 0x56, 0xEB, 0xDD, 0x9B, 0xB7, 0x77, 0x6E, 0xF5,
+  0xE0, 0xBC, 0x57, 0x92, 0xF3, 0x5E, 0x8B, 0xD5, 0x7B, 0x2F, 0x75, 0xF0, 0xBE, 0x57, 0xD2, 0xFB,
+  0x5F, 0x8B, 0xF5, 0x7E, 0xEF, 0xED, 0xFF, 0xC0, 0x38, 0x0F, 0x02, 0xE0, 0x7C, 0x13, 0x82, 0xF0,
+  0x6E, 0x0F, 0xC2, 0x38, 0x4F, 0x0A, 0xE1, 0x7C, 0x33, 0x86, 0xF0, 0xEE, 0x1F, 0xC4, 0x38, 0x8F,
+  0x12, 0xE2, 0x7C, 0x53, 0x8A, 0xF1, 0x6E, 0x2F, 0xC6, 0x38, 0xCB, 0x1A, 0x63, 0x6C, 0x71, 0x8E,
+  0xB1, 0xE6, 0x3E, 0xC8, 0x19, 0x0B, 0x22, 0x64, 0x7C, 0x93, 0x92, 0xF2, 0xAE, 0x61, 0xCD, 0x39,
+  0xD3, 0x3F, 0xE8, 0x8D, 0x2B, 0xA8, 0x35, 0x66, 0xB3, 0xD7, 0x7B, 0x1B, 0x68, 0xED, 0xFD, 0xD3,
+  0xBE, 0xB8, 0x47, 0x0F, 0xE2, 0x9C, 0x83, 0x93, 0x72, 0xCE, 0x73, 0xD1, 0xBA, 0x6F, 0x58, 0xEB,
+  0xFD, 0x97, 0xB8, 0xF7, 0xDF, 0x0F, 0xE3, 0xFC, 0xDF, 0xA3, 0xF5, 0x9E, 0xBF, 0xDA, 0x7B, 0xBF,
+  0x87, 0xF1, 0xBE, 0x4F, 0xD4, 0xFB, 0x3F, 0x7B, 0xF1, 0x7E, 0x8F, 0xDB, 0xFC, 0x40, 0x00, 0x00
+};
+
+const CorpusRange CORPUS_LISTS[CORPUS_LIST_COUNT] PROGMEM = {
+  { 0, 299 },  // CORPUS_WORDS
+  { 299, 78 },  // CORPUS_ABBREVIATIONS
+  { 377, 138 },  // CORPUS_PREFIXES
+  { 515, 74 },  // CORPUS_EXCHANGES
+  { 589, 48 },  // CORPUS_PHRASES
+};
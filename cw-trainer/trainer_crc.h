@@ -0,0 +1,25 @@
+#ifndef TRAINER_CRC_H
+#define TRAINER_CRC_H
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF). Plain C so the ESP32
+// companion can share it. A nibble at a time from a 32-byte table: every
+// link frame is checked, and this is several times faster than bit by bit.
+
+#include <stdint.h>
+#include <stddef.h>
+
+static inline uint16_t crc16Update(uint16_t crc, const uint8_t* data, size_t len) {
+  static const uint16_t nibble[16] = { 0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+                                       0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF };
+  while (len--) {
+    crc = (uint16_t)((crc << 4) ^ nibble[(crc >> 12) ^ (*data >> 4)]);
+    crc = (uint16_t)((crc << 4) ^ nibble[(crc >> 12) ^ (*data++ & 0x0F)]);
+  }
+  return crc;
+}
+
+static inline uint16_t crc16(const uint8_t* data, size_t len) {
+  return crc16Update(0xFFFF, data, len);
+}
+
+#endif  // TRAINER_CRC_H
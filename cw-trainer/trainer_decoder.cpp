@@ -0,0 +1,225 @@
+#include "trainer_core.h"
+#include "trainer_trace.h"
+#include "trainer_sessionlog.h"
+#include "trainer_align.h"
+
+// Morse code lookup table
+const MorseChar morseTable[] = {
+  { 'A', ".-" }, { 'B', "-..." }, { 'C', "-.-." }, { 'D', "-.." }, { 'E', "." }, { 'F', "..-." }, { 'G', "--." }, { 'H', "...." }, { 'I', ".." }, { 'J', ".---" }, { 'K', "-.-" }, { 'L', ".-.." }, { 'M', "--" }, { 'N', "-." }, { 'O', "---" }, { 'P', ".--." }, { 'Q', "--.-" }, { 'R', ".-." }, { 'S', "..." }, { 'T', "-" }, { 'U', "..-" }, { 'V', "...-" }, { 'W', ".--" }, { 'X', "-..-" }, { 'Y', "-.--" }, { 'Z', "--.." }, { '1', ".----" }, { '2', "..---" }, { '3', "...--" }, { '4', "....-" }, { '5', "....." }, { '6', "-...." }, { '7', "--..." }, { '8', "---.." }, { '9', "----." }, { '0', "-----" }, { '/', "-..-." }, { '?', "..--.." }, { ',', "--..--" }, { '.', ".-.-.-" }, { '=', "-...-" }, { '+', ".-.-." }, { '-', "-....-" }, { '(', "-.--." }, { ')', "-.--.-" }, { '"', ".-..-." }, { ':', "---..." }, { ';', "-.-.-." }, { '@', ".--.-." }, { '!', "-.-.--" }
+};
+const int morseTableSize = sizeof(morseTable) / sizeof(MorseChar);
+static_assert(sizeof(morseTable) / sizeof(MorseChar) == MORSE_SYMBOL_COUNT, "MORSE_SYMBOL_COUNT must match morseTable");
+
+// CW Decoder variables
+static unsigned long keyDownTime = 0;
+static unsigned long keyUpTime = 0;
+static unsigned long lastKeyChange = 0;   // manual key edges
+static unsigned long lastToneChange = 0;  // detector edges, timed separately
+static bool lastToneState = false;
+static FixedText<8> currentCharacter;  // dots/dashes of the character being keyed
+TextRing<64> decodedText;
+static unsigned long lastCharacterTime = 0;
+static unsigned long lastWordTime = 0;
+static bool wordOpen = false;  // characters went to the companion since its last space
+static uint16_t elementDurations[SESSION_LOG_MAX_ELEMENTS];  // for the session log
+static uint8_t elementCount = 0;
+static unsigned long characterGap = 0;  // silence before the character's first element
+
+// Timing
+float ditLength = 100;
+float dahThreshold = 200;
+float charSpaceThreshold = 300;
+float wordSpaceThreshold = 700;
+
+static void processElement(unsigned long duration);
+static void processSpace(unsigned long duration);
+static void processCharacter();
+
+void handleManualKeying() {
+  bool currentKeyState = traceKeyDown();
+  if (currentKeyState != keyPressed) {
+    keyPressed = currentKeyState;
+    if (keyPressed) {
+      halToneOn();
+      keyDownTime = halMillis();
+    } else {
+      halToneOff();
+      keyUpTime = halMillis();
+    }
+    lastKeyChange = halMillis();
+  }
+}
+
+// Drop any half-keyed character, e.g. when the decoder is switched back on
+void resetDecoder() {
+  currentCharacter.clear();
+  elementCount = 0;
+  lastToneState = traceToneDetected();
+  lastToneChange = halMillis();
+  lastCharacterTime = halMillis();
+  lastWordTime = halMillis();
+  wordOpen = false;
+}
+
+// Silence that ends a word for the companion (and closes its batch): halfway
+// between a character and a word gap, in the lesson's Farnsworth units while
+// copying one
+static float companionWordGap() {
+  float unit = kochListening ? 1200.0f / kochEffectiveSpeed : wordSpaceThreshold / 7.0f;
+  return unit * 5.0f;
+}
+
+void processCWDecoder() {
+  bool toneDetected = traceToneDetected();
+  unsigned long currentTime = halMillis();
+
+  if (toneDetected != lastToneState) {
+    if (toneDetected) {
+      if (currentCharacter.length() == 0) characterGap = currentTime - lastToneChange;
+      if (lastToneState == false && currentTime - lastToneChange > 50) {
+        unsigned long spaceLength = currentTime - lastToneChange;
+        processSpace(spaceLength);
+      }
+    } else {
+      if (lastToneState == true && currentTime - lastToneChange > 30) {
+        unsigned long toneLength = currentTime - lastToneChange;
+        processElement(toneLength);
+      }
+    }
+    lastToneChange = currentTime;
+    lastToneState = toneDetected;
+  }
+
+  // Character gaps are measured in silence only; a long dah must not close the character
+  if (!toneDetected && currentCharacter.length() > 0 && currentTime - lastCharacterTime > charSpaceThreshold) {
+    processCharacter();
+  }
+
+  if (currentTime - lastWordTime > wordSpaceThreshold && decodedText.length() > 0 && !decodedText.endsWith(' ')) {
+    decodedText.append(' ');
+    if (!kochModeEnabled) consolePrintf(" ");
+  }
+  if (wordOpen && !toneDetected && currentCharacter.length() == 0 && currentTime - lastToneChange > companionWordGap()) {
+    sendDecodedCharToWiFi(' ');  // also closes the batch
+    wordOpen = false;
+  }
+}
+
+bool decoderIdle() {
+  return !lastToneState && currentCharacter.length() == 0;
+}
+
+static void processElement(unsigned long duration) {
+  if (elementCount < SESSION_LOG_MAX_ELEMENTS) {
+    elementDurations[elementCount++] = duration > 0xFFFF ? 0xFFFF : duration;
+  }
+
+  if (stats.totalDits + stats.totalDahs < 10) {
+    if (duration < 150) {
+      currentCharacter.append('.');
+      stats.totalDits++;
+    } else {
+      currentCharacter.append('-');
+      stats.totalDahs++;
+    }
+  } else {
+    float avgDitLength = ditLength;
+    dahThreshold = avgDitLength * 2.5;
+
+    if (duration < dahThreshold) {
+      currentCharacter.append('.');
+      stats.totalDits++;
+      ditLength = (ditLength * 0.9) + (duration * 0.1);
+    } else {
+      currentCharacter.append('-');
+      stats.totalDahs++;
+    }
+  }
+
+  lastCharacterTime = halMillis();
+  charSpaceThreshold = ditLength * 3.0;
+  wordSpaceThreshold = ditLength * 7.0;
+}
+
+static void processSpace(unsigned long duration) {
+  if (duration > wordSpaceThreshold && currentCharacter.length() == 0) {
+    if (!decodedText.endsWith(' ')) {
+      decodedText.append(' ');
+      if (!kochModeEnabled) consolePrintf(" ");
+    }
+    lastWordTime = halMillis();
+  }
+}
+
+static void processCharacter() {
+  char decodedChar = lookupMorseCharacter(currentCharacter.c_str());
+  char expectedChar = 0;
+
+  if (kochListening && decodedChar != '?') {
+    kochReceivedText.append(decodedChar);
+
+    // Scored by the aligner; the echo uses its provisional match
+    expectedChar = copyAligner.copied(decodedChar, characterGap);
+    if (decodedChar == expectedChar) consolePrintf("%c", decodedChar);
+    else consolePrintf("[%c]", decodedChar);
+    sendDecodedCharToWiFi(decodedChar, decodedChar != expectedChar);
+    wordOpen = true;
+  } else if (!kochModeEnabled) {
+    if (decodedChar != '?') {
+      decodedText.append(decodedChar);
+      consolePrintf("%c", decodedChar);
+      sendDecodedCharToWiFi(decodedChar);
+      wordOpen = true;
+      stats.charactersDecoded++;
+
+      if (stats.charactersDecoded > 0) {
+        float timeMinutes = (halMillis() - sessionStartTime) / 60000.0;
+        currentWPM = (stats.charactersDecoded * 2.4) / timeMinutes;
+        if (currentWPM > stats.bestWPM) {
+          stats.bestWPM = currentWPM;
+        }
+      }
+
+      if (stats.charactersDecoded % 10 == 0) {
+        consolePrintf(" |Stats: %lu/%lu/%lu/%swpm|\n", stats.totalDits, stats.totalDahs,
+                      stats.charactersDecoded, fixedFloat(currentWPM, 1).c_str());
+      }
+    } else if (currentCharacter.length() > 0) {
+      consolePrintf("?");
+      sendDecodedCharToWiFi('?');
+      wordOpen = true;
+    }
+  }
+
+  sessionLogCharacter(expectedChar, decodedChar, elementDurations, elementCount, characterGap);
+  currentCharacter.clear();
+  elementCount = 0;
+  lastWordTime = halMillis();
+}
+
+const char* getMorseCode(char c) {
+  for (int i = 0; i < morseTableSize; i++) {
+    if (morseTable[i].character == c) {
+      return morseTable[i].code;
+    }
+  }
+  return "";
+}
+
+int morseSymbolIndex(char c) {
+  for (int i = 0; i < morseTableSize; i++) {
+    if (morseTable[i].character == c) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+char lookupMorseCharacter(const char* morseCode) {
+  for (int i = 0; i < morseTableSize; i++) {
+    if (strcmp(morseTable[i].code, morseCode) == 0) {
+      return morseTable[i].character;
+    }
+  }
+  return '?';
+}
@@ -0,0 +1,119 @@
+#include "trainer_drill.h"
+#include "trainer_charstats.h"
+
+// Weights are in 1/16ths so unchanged statistics give bit-identical tables
+const uint16_t BASE_WEIGHT = 16;      // every symbol of the set
+const uint16_t ERROR_WEIGHT = 64;     // scaled by the smoothed error rate
+const uint16_t RECENCY_WEIGHT = 4;    // per lesson the symbol went undrawn
+const uint8_t RECENCY_CAP = 8;
+const uint16_t NEW_CHAR_BOOST = 2;    // multiplier for the newest Koch character
+const uint32_t ALIAS_ONE = 0x10000;   // probability scale for the alias draw
+
+static uint8_t drillCount = 0;
+static uint8_t drillSymbols[MORSE_SYMBOL_COUNT];  // morseTable indices
+static uint16_t drillWeights[MORSE_SYMBOL_COUNT];
+static uint32_t aliasProb[MORSE_SYMBOL_COUNT];  // keep column i with probability aliasProb / ALIAS_ONE
+static uint8_t aliasOther[MORSE_SYMBOL_COUNT];
+static unsigned long tableRebuilds = 0;
+
+// Lessons since each symbol was last drawn: cleared by a draw, aged by a prepare
+static uint8_t undrawnLessons[MORSE_SYMBOL_COUNT];
+
+static uint16_t symbolWeight(int symbol, bool newest) {
+  // Laplace-smoothed error rate: an unseen symbol counts as 50 % wrong
+  uint32_t attempts = symbolAttempts(symbol);
+  uint32_t errors = symbolErrors(symbol);
+  uint32_t weight = BASE_WEIGHT + ERROR_WEIGHT * (errors + 1) / (attempts + 2) + RECENCY_WEIGHT * undrawnLessons[symbol];
+  if (newest) weight *= NEW_CHAR_BOOST;
+  return weight > 0xFFFF ? 0xFFFF : weight;
+}
+
+// Vose's alias method in integer arithmetic: every column holds scaled weight
+// total, split between its own symbol and at most one alias
+static void buildAliasTable() {
+  uint32_t total = 0;
+  for (int i = 0; i < drillCount; i++) total += drillWeights[i];
+
+  uint32_t scaled[MORSE_SYMBOL_COUNT];
+  uint8_t small[MORSE_SYMBOL_COUNT], large[MORSE_SYMBOL_COUNT];
+  int smallCount = 0, largeCount = 0;
+  for (int i = 0; i < drillCount; i++) {
+    scaled[i] = drillWeights[i] * drillCount;
+    if (scaled[i] < total) small[smallCount++] = i;
+    else large[largeCount++] = i;
+  }
+
+  while (smallCount > 0 && largeCount > 0) {
+    uint8_t s = small[--smallCount];
+    uint8_t l = large[largeCount - 1];
+    aliasProb[s] = (uint64_t)scaled[s] * ALIAS_ONE / total;
+    aliasOther[s] = l;
+    scaled[l] -= total - scaled[s];
+    if (scaled[l] < total) {
+      largeCount--;
+      small[smallCount++] = l;
+    }
+  }
+  // Whatever is left is full up to rounding
+  while (largeCount > 0) aliasProb[large[--largeCount]] = ALIAS_ONE;
+  while (smallCount > 0) aliasProb[small[--smallCount]] = ALIAS_ONE;
+
+  tableRebuilds++;
+}
+
+void drillPrepare(const char* charset, char newest) {
+  for (int i = 0; i < MORSE_SYMBOL_COUNT; i++) {
+    if (undrawnLessons[i] < RECENCY_CAP) undrawnLessons[i]++;
+  }
+
+  uint8_t symbols[MORSE_SYMBOL_COUNT];
+  uint16_t weights[MORSE_SYMBOL_COUNT];
+  uint8_t count = 0;
+  uint8_t seen[(MORSE_SYMBOL_COUNT + 7) / 8] = { 0 };
+  for (const char* c = charset; *c; c++) {
+    int symbol = morseSymbolIndex(*c);
+    if (symbol < 0 || (seen[symbol / 8] & (1 << (symbol % 8)))) continue;  // lesson sets repeat letters
+    seen[symbol / 8] |= 1 << (symbol % 8);
+    symbols[count] = symbol;
+    weights[count] = symbolWeight(symbol, *c == newest);
+    count++;
+  }
+
+  if (count == drillCount && memcmp(symbols, drillSymbols, count) == 0 && memcmp(weights, drillWeights, count * sizeof(uint16_t)) == 0) {
+    return;
+  }
+  drillCount = count;
+  memcpy(drillSymbols, symbols, count);
+  memcpy(drillWeights, weights, count * sizeof(uint16_t));
+  if (count > 0) buildAliasTable();
+}
+
+char drillNext(uint32_t r) {
+  if (drillCount == 0) return 'E';
+  uint8_t column = (r >> 16) % drillCount;
+  uint8_t pick = (r & 0xFFFF) < aliasProb[column] ? column : aliasOther[column];
+  uint8_t symbol = drillSymbols[pick];
+  undrawnLessons[symbol] = 0;
+  return morseTable[symbol].character;
+}
+
+uint8_t drillRecency(int symbol) {
+  return undrawnLessons[symbol];
+}
+
+void drillSetRecency(int symbol, uint8_t lessons) {
+  undrawnLessons[symbol] = lessons < RECENCY_CAP ? lessons : RECENCY_CAP;
+}
+
+void printDrillTable() {
+  uint32_t total = 0;
+  for (int i = 0; i < drillCount; i++) total += drillWeights[i];
+  consolePrintf("\n=== DRILL WEIGHTS ===\n");
+  for (int i = 0; i < drillCount; i++) {
+    int symbol = drillSymbols[i];
+    consolePrintf("%c %5s%%  (undrawn %u lessons)\n", morseTable[symbol].character,
+                  fixedFloat(100.0f * drillWeights[i] / total, 1).c_str(), (unsigned)undrawnLessons[symbol]);
+  }
+  consolePrintf("Alias table rebuilds: %lu\n", tableRebuilds);
+  consolePrintf("=====================\n\n");
+}
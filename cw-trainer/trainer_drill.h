@@ -0,0 +1,18 @@
+#ifndef TRAINER_DRILL_H
+#define TRAINER_DRILL_H
+
+// Weighted character drills. Each symbol of the drill set gets a weight from
+// its copy error rate (trainer_charstats.h) and from how many lessons it has
+// gone undrawn; the newest Koch character gets an extra boost. Draws come from
+// a Walker/Vose alias table in O(1), and the table is only rebuilt when a
+// prepared set's integer weights differ from the current ones.
+
+#include "trainer_core.h"
+
+void drillPrepare(const char* charset, char newest);  // newest = 0 for no boost
+char drillNext(uint32_t random);  // random: 32 uniform bits from the caller's generator
+uint8_t drillRecency(int symbol);  // lessons since last drawn, for the trace snapshot
+void drillSetRecency(int symbol, uint8_t lessons);
+void printDrillTable();
+
+#endif  // TRAINER_DRILL_H
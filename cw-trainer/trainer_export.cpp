@@ -0,0 +1,376 @@
+#include "trainer_export.h"
+#include "trainer_store.h"
+#include "trainer_charstats.h"
+#include "trainer_protocol.h"
+#include "trainer_crc.h"
+
+enum BackupPhase { BACKUP_IDLE,
+                   BACKUP_BEGIN,
+                   BACKUP_DATA };
+
+// An export snapshots into this and an import decodes into it; never both at once
+static StoreState backupState;
+static BackupPhase exportPhase = BACKUP_IDLE;
+static BackupPhase importPhase = BACKUP_IDLE;
+
+static void sendLine(ExportPort port, const char* prefix, const char* body) {
+  static FixedText<96> line;
+  line.set(prefix);
+  line.append(body);
+  if (port == EXPORT_LINK) linkWriteLine(line.c_str());
+  else consolePrintf("%s\n", line.c_str());
+}
+
+static void appendHex(FixedText<96>& out, const uint8_t* data, size_t n) {
+  for (size_t i = 0; i < n; i++) out.appendf("%02X", data[i]);
+}
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+// ---- Export -----------------------------------------------------------------------
+
+static ExportFormat exportFormat;
+static ExportPort exportPort;
+static uint32_t exportLastLine = 0;
+static uint16_t exportLines = 0;
+static uint16_t exportCrc = 0;
+
+// BIN: the backup record being cut into chunks
+static int exportSlot = -1;
+static uint8_t exportRecord[BACKUP_RECORD_MAX];
+static size_t exportRecordLen = 0;
+static size_t exportRecordPos = 0;
+
+// CSV: one row per (section, item, field); empty rows are skipped
+enum CsvSection { CSV_HEADER,
+                  CSV_SETTINGS,
+                  CSV_STATS,
+                  CSV_LESSONS,
+                  CSV_SYMBOLS,
+                  CSV_CONFUSIONS,
+                  CSV_DONE };
+
+static const char* const settingsFields[] = { "sidetone_hz", "volume", "waveform", "headphones",
+                                              "decoder", "external_audio", "koch_mode", "koch_lesson" };
+static const char* const statsFields[] = { "total_dits", "total_dahs", "characters_decoded", "sessions_completed",
+                                           "best_wpm", "average_accuracy", "highest_lesson", "custom_lessons_completed",
+                                           "training_minutes", "last_session_ms" };
+const int SYMBOL_FIELDS = 2 + LATENCY_BINS;  // correct, errors, response time bins
+
+static int csvSection = CSV_HEADER;
+static int csvItem = 0;
+static int csvField = 0;
+
+static int csvItems(int section) {
+  switch (section) {
+    case CSV_LESSONS: return KOCH_LESSON_COUNT;
+    case CSV_SYMBOLS: return MORSE_SYMBOL_COUNT;
+    case CSV_CONFUSIONS: return MORSE_SYMBOL_COUNT;
+    default: return 1;
+  }
+}
+
+static int csvFields(int section) {
+  switch (section) {
+    case CSV_SETTINGS: return sizeof(settingsFields) / sizeof(settingsFields[0]);
+    case CSV_STATS: return sizeof(statsFields) / sizeof(statsFields[0]);
+    case CSV_SYMBOLS: return SYMBOL_FIELDS;
+    case CSV_CONFUSIONS: return SUMMARY_CONFUSIONS;
+    default: return 1;
+  }
+}
+
+// ',' and '"' are Morse symbols too
+static void appendCsvSymbol(FixedText<96>& row, char c) {
+  if (c == ',') row.append("\",\"");
+  else if (c == '"') row.append("\"\"\"\"");
+  else row.append(c);
+}
+
+static uint32_t summaryErrors(const CharSummary& c) {
+  uint32_t errors = c.otherErrors;
+  for (int i = 0; i < SUMMARY_CONFUSIONS; i++) errors += c.confusedCount[i];
+  return errors;
+}
+
+// False when this cell has nothing to report
+static bool csvRow(int section, int item, int field, FixedText<96>& row) {
+  const StoreState& s = backupState;
+  row.clear();
+  switch (section) {
+    case CSV_HEADER:
+      row.append("section,item,field,value");
+      return true;
+
+    case CSV_SETTINGS:
+      row.appendf("settings,,%s,", settingsFields[field]);
+      switch (field) {
+        case 0: row.appendFloat(s.settings.sidetoneFreq, 1); break;
+        case 1: row.appendFloat(s.settings.volume, 2); break;
+        case 2: row.appendf("%u", (unsigned)s.settings.waveform); break;
+        case 3: row.appendf("%d", s.settings.useHeadphones ? 1 : 0); break;
+        case 4: row.appendf("%d", s.settings.decoderEnabled ? 1 : 0); break;
+        case 5: row.appendf("%d", s.settings.useExternalAudio ? 1 : 0); break;
+        case 6: row.appendf("%d", s.settings.kochModeEnabled ? 1 : 0); break;
+        default: row.appendf("%d", s.kochLesson); break;
+      }
+      return true;
+
+    case CSV_STATS:
+      row.appendf("stats,,%s,", statsFields[field]);
+      switch (field) {
+        case 0: row.appendf("%lu", (unsigned long)s.stats.totalDits); break;
+        case 1: row.appendf("%lu", (unsigned long)s.stats.totalDahs); break;
+        case 2: row.appendf("%lu", (unsigned long)s.stats.charactersDecoded); break;
+        case 3: row.appendf("%lu", (unsigned long)s.stats.sessionsCompleted); break;
+        case 4: row.appendFloat(s.stats.bestWPM, 1); break;
+        case 5: row.appendFloat(s.stats.averageAccuracy, 1); break;
+        case 6: row.appendf("%d", s.stats.highestLesson); break;
+        case 7: row.appendf("%d", s.stats.customLessonsCompleted); break;
+        case 8: row.appendFloat(s.stats.totalTrainingMinutes, 1); break;
+        default: row.appendf("%lu", (unsigned long)s.stats.lastSessionTime); break;
+      }
+      return true;
+
+    case CSV_LESSONS:
+      if (s.stats.lessonAccuracy[item] <= 0) return false;
+      row.appendf("lesson,%d,accuracy,", item + 1);
+      row.appendFloat(s.stats.lessonAccuracy[item], 1);
+      return true;
+
+    case CSV_SYMBOLS:
+      {
+        const CharSummary& c = s.chars[item];
+        if (c.correct == 0 && summaryErrors(c) == 0) return false;
+        row.append("symbol,");
+        appendCsvSymbol(row, morseTable[item].character);
+        if (field == 0) {
+          row.appendf(",correct,%u", (unsigned)c.correct);
+        } else if (field == 1) {
+          row.appendf(",errors,%lu", (unsigned long)summaryErrors(c));
+        } else {
+          int bin = field - 2;
+          if (bin < LATENCY_BINS - 1) row.appendf(",response_lt%ums,", (unsigned)latencyBinLimits[bin]);
+          else row.appendf(",response_ge%ums,", (unsigned)latencyBinLimits[LATENCY_BINS - 2]);
+          row.appendf("%u", (unsigned)c.latency[bin]);
+        }
+        return true;
+      }
+
+    case CSV_CONFUSIONS:
+      {
+        const CharSummary& c = s.chars[item];
+        if (c.confusedCount[field] == 0 || c.confusedWith[field] >= MORSE_SYMBOL_COUNT) return false;
+        row.append("confusion,");
+        appendCsvSymbol(row, morseTable[item].character);
+        row.append(',');
+        appendCsvSymbol(row, morseTable[c.confusedWith[field]].character);
+        row.appendf(",%u", (unsigned)c.confusedCount[field]);
+        return true;
+      }
+  }
+  return false;
+}
+
+static bool nextCsvRow(FixedText<96>& row) {
+  while (csvSection != CSV_DONE) {
+    bool written = csvRow(csvSection, csvItem, csvField, row);
+    if (++csvField == csvFields(csvSection)) {
+      csvField = 0;
+      if (++csvItem == csvItems(csvSection)) {
+        csvItem = 0;
+        csvSection++;
+      }
+    }
+    if (written) return true;
+  }
+  return false;
+}
+
+static size_t nextBinaryChunk(uint8_t* out) {
+  size_t n = 0;
+  while (n < EXPORT_CHUNK_BYTES) {
+    if (exportRecordPos == exportRecordLen) {
+      exportRecordLen = storeBackupRecord(exportSlot, backupState, exportRecord);
+      exportRecordPos = 0;
+      if (exportRecordLen == 0) break;
+    }
+    size_t take = exportRecordLen - exportRecordPos;
+    if (take > EXPORT_CHUNK_BYTES - n) take = EXPORT_CHUNK_BYTES - n;
+    memcpy(out + n, exportRecord + exportRecordPos, take);
+    exportRecordPos += take;
+    n += take;
+  }
+  return n;
+}
+
+// The next data line into body; false once the data is exhausted
+static bool nextExportLine(FixedText<96>& body) {
+  if (exportFormat == EXPORT_CSV) {
+    static FixedText<96> row;
+    if (!nextCsvRow(row)) return false;
+    exportCrc = crc16Update(exportCrc, (const uint8_t*)row.c_str(), row.length());
+    exportCrc = crc16Update(exportCrc, (const uint8_t*)"\n", 1);
+    body.clear();
+    body.appendf("%u %s %04X", (unsigned)(exportLines + 1), row.c_str(),
+                 crc16((const uint8_t*)row.c_str(), row.length()));
+    return true;
+  }
+
+  uint8_t chunk[EXPORT_CHUNK_BYTES];
+  size_t n = nextBinaryChunk(chunk);
+  if (n == 0) return false;
+  exportCrc = crc16Update(exportCrc, chunk, n);
+  body.clear();
+  body.appendf("%u ", (unsigned)(exportLines + 1));
+  appendHex(body, chunk, n);
+  body.appendf(" %04X", crc16(chunk, n));
+  return true;
+}
+
+void exportStart(ExportFormat format, ExportPort port) {
+  if (exportPhase != BACKUP_IDLE || importPhase != BACKUP_IDLE) {
+    sendLine(port, PREFIX_EXPORT, "ERROR busy");
+    return;
+  }
+  captureStoreState(backupState);
+  exportFormat = format;
+  exportPort = port;
+  exportLines = 0;
+  exportCrc = 0xFFFF;
+  exportSlot = -1;
+  exportRecordLen = exportRecordPos = 0;
+  csvSection = CSV_HEADER;
+  csvItem = csvField = 0;
+  exportPhase = BACKUP_BEGIN;
+}
+
+void exportService() {
+  if (exportPhase == BACKUP_IDLE || halMillis() - exportLastLine < EXPORT_LINE_INTERVAL) return;
+  if (exportPort == EXPORT_LINK && linkHeld()) return;  // paused, not queued
+  exportLastLine = halMillis();
+
+  static FixedText<96> body;
+  if (exportPhase == BACKUP_BEGIN) {
+    body.clear();
+    body.appendf("BEGIN %s %u", exportFormat == EXPORT_CSV ? "CSV" : "BIN", (unsigned)EXPORT_VERSION);
+    exportPhase = BACKUP_DATA;
+  } else if (nextExportLine(body)) {
+    exportLines++;
+  } else {
+    body.clear();
+    body.appendf("END %u %04X", (unsigned)exportLines, exportCrc);
+    exportPhase = BACKUP_IDLE;
+  }
+  sendLine(exportPort, PREFIX_EXPORT, body.c_str());
+}
+
+bool exportActive() {
+  return exportPhase != BACKUP_IDLE;
+}
+
+// ---- Import -----------------------------------------------------------------------
+
+static ExportPort importPort;
+static uint16_t importLines = 0;
+static uint16_t importCrc = 0;
+static BackupReader importReader;
+
+static void importReply(ExportPort port, const char* fmt, unsigned value) {
+  static FixedText<96> body;
+  body.clear();
+  body.appendf(fmt, value);
+  sendLine(port, PREFIX_IMPORT, body.c_str());
+}
+
+static void importFail(ExportPort port, const char* reason) {
+  static FixedText<96> body;
+  body.set("ERROR ");
+  body.append(reason);
+  sendLine(port, PREFIX_IMPORT, body.c_str());
+  importPhase = BACKUP_IDLE;
+}
+
+// The imported state replaces the current one, is pushed to the audio graph and saved
+static void applyImport() {
+  restoreStoreState(backupState);
+  updateWaveform();
+  updateVolume();
+  updateOutputRouting();
+  updateAudioInput();
+  initializeKoch();
+  applySettings();
+  saveSettings();
+}
+
+void importLine(const char* body, ExportPort port) {
+  char* p;
+  if (startsWith(body, "BEGIN")) {
+    if (exportPhase != BACKUP_IDLE) {
+      importFail(port, "busy");
+      return;
+    }
+    const char* args = body + 5;
+    while (*args == ' ') args++;
+    if (!startsWith(args, "BIN") || strtoul(args + 3, nullptr, 10) != EXPORT_VERSION) {
+      importFail(port, "unsupported format");
+      return;
+    }
+    importPhase = BACKUP_DATA;
+    importPort = port;
+    importLines = 0;
+    importCrc = 0xFFFF;
+    storeBackupBegin(importReader, backupState);
+    importReply(port, "ACK %u", 0);
+    return;
+  }
+
+  if (importPhase == BACKUP_IDLE || port != importPort) {
+    importFail(port, "no import in progress");
+    return;
+  }
+
+  if (startsWith(body, "END")) {
+    unsigned long lines = strtoul(body + 3, &p, 10);
+    unsigned long crc = strtoul(p, nullptr, 16);
+    if (lines != importLines) importFail(port, "line count");
+    else if (crc != importCrc) importFail(port, "checksum");
+    else if (!importReader.finished) importFail(port, "truncated");
+    else {
+      applyImport();
+      importPhase = BACKUP_IDLE;
+      importReply(port, "OK %u", importReader.records);
+      consolePrintf("Imported %u records\n", (unsigned)importReader.records);
+    }
+    return;
+  }
+
+  unsigned long seq = strtoul(body, &p, 10);
+  if (seq != (unsigned long)importLines + 1) {
+    importFail(port, "sequence");
+    return;
+  }
+  while (*p == ' ') p++;
+  uint8_t chunk[EXPORT_CHUNK_BYTES];
+  size_t n = 0;
+  while (hexDigit(p[0]) >= 0 && hexDigit(p[1]) >= 0 && n < sizeof(chunk)) {
+    chunk[n++] = (hexDigit(p[0]) << 4) | hexDigit(p[1]);
+    p += 2;
+  }
+  if (*p != ' ' || strtoul(p, nullptr, 16) != crc16(chunk, n)) {
+    importFail(port, "line checksum");
+    return;
+  }
+  if (!storeBackupFeed(importReader, chunk, n, backupState)) {
+    importFail(port, "not a backup");
+    return;
+  }
+  importCrc = crc16Update(importCrc, chunk, n);
+  importLines = seq;
+  importReply(port, "ACK %u", (unsigned)seq);
+}
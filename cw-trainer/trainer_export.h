@@ -0,0 +1,39 @@
+#ifndef TRAINER_EXPORT_H
+#define TRAINER_EXPORT_H
+
+// Bulk export and import of the persisted data (settings, Koch progress,
+// counters, per-lesson accuracy, per-character copy summaries) over the USB
+// console or the companion link, as text lines that both carry:
+//
+//   EXPORT:BEGIN BIN 1            format (BIN or CSV) and export version
+//   EXPORT:<seq> <payload> <crc>  seq from 1; CRC-16 (trainer_crc.h) of the payload, 4 hex digits
+//   EXPORT:END <lines> <crc>      data line count; CRC-16 of everything the payloads decode to
+//
+// BIN payloads are up to EXPORT_CHUNK_BYTES of a backup (trainer_store.h) in
+// hex. CSV payloads are one row each of "section,item,field,value", and the
+// file is the rows joined with newlines. The export snapshots the state once
+// and then emits one line per EXPORT_LINE_INTERVAL ms from exportService(),
+// so nothing larger than a line is ever buffered.
+//
+// Import takes the same lines with the IMPORT: prefix (BIN only) and answers
+// each one with IMPORT:ACK <seq>, so a sender can wait instead of overrunning
+// the receive buffer. The backup is decoded into a staging copy and applied
+// only after END checks out: IMPORT:OK <records> or IMPORT:ERROR <reason>.
+
+#include "trainer_core.h"
+
+const size_t EXPORT_CHUNK_BYTES = 20;  // 40 hex digits; an import line fits the 64-byte console buffer
+const uint32_t EXPORT_LINE_INTERVAL = 5;  // ms; a line takes about 5 ms at 115200 baud
+const uint8_t EXPORT_VERSION = 1;
+
+enum ExportFormat { EXPORT_BINARY,
+                    EXPORT_CSV };
+enum ExportPort { EXPORT_CONSOLE,
+                  EXPORT_LINK };
+
+void exportStart(ExportFormat format, ExportPort port);
+void exportService();  // once per tick
+bool exportActive();
+void importLine(const char* body, ExportPort port);  // body follows "IMPORT:"
+
+#endif  // TRAINER_EXPORT_H
@@ -0,0 +1,322 @@
+#ifndef TRAINER_FRAME_H
+#define TRAINER_FRAME_H
+
+// Binary framing for the companion link. Plain C so the ESP32 companion
+// shares it (like trainer_crc.h).
+//
+// A frame is 0x00, the COBS encoding of
+//   type, sequence, body (up to FRAME_BODY_MAX bytes), CRC-16 (little endian)
+// and 0x00 again. COBS leaves no zero byte inside a frame, so text lines and
+// frames can share the wire: the receiver treats bytes after a zero as a
+// frame and everything else as newline-terminated text. Both sides start in
+// text and exchange HELLO:<version>,<capabilities>,<max baud> lines; a side
+// only sends frames after the peer's HELLO offered LINK_CAP_FRAMES, so
+// firmware that predates framing never sees one.
+//
+// Both sides start at LINK_BAUD_DEFAULT. After the HELLOs the Teensy proposes
+// the highest rate both support (BAUD:, answered by BAUD_OK:), switches once
+// the answer is out of the companion's UART and pings at the new rate; no PONG
+// and it returns to the default, as does a companion that hears nothing valid.
+// Without RTS/CTS on both sides the rate stays at or below LINK_BAUD_UNPACED,
+// where the receive buffers cover a busy main loop.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "trainer_crc.h"
+
+#define LINK_VERSION 1
+#define LINK_CAP_FRAMES 0x01
+#define LINK_CAP_FLOW 0x02  // RTS/CTS wired on this side
+#define LINK_CAP_ACKS 0x04  // answers CMD: with ACK: (trainer_protocol.h)
+
+#define LINK_BAUD_DEFAULT 115200
+#define LINK_BAUD_UNPACED 460800
+
+#define FRAME_BODY_MAX 240
+#define FRAME_PAYLOAD_MAX (FRAME_BODY_MAX + 4)                     // type, sequence, body, CRC
+#define FRAME_ENCODED_MAX (FRAME_PAYLOAD_MAX + FRAME_PAYLOAD_MAX / 254 + 3)  // COBS and two delimiters
+
+// Frame types. Anything without a typed form travels as FRAME_TEXT, the
+// line it would otherwise have been, so every message gets the CRC.
+enum {
+  FRAME_TEXT = 1,  // a protocol line without its newline
+  FRAME_PING = 2,  // empty
+  FRAME_PONG = 3,  // empty
+  FRAME_STATUS = 4,  // FrameStatus
+  FRAME_STATS = 5,   // FrameStats
+  FRAME_DECODED = 6,  // FrameDecoded, then FrameDecodedChar per character
+  FRAME_STATUS_DELTA = 7,  // changed FrameStatus members, see frameStatusDelta()
+  FRAME_BENCH = 8,         // loopback benchmark: the companion echoes it unchanged
+  FRAME_AUDIO = 9,         // FrameAudio, then the IMA-ADPCM codes (trainer_monitor.h)
+  FRAME_SPECTRUM = 10      // FrameSpectrum, then one level per point (trainer_spectrum.h)
+};
+
+// Flags in FrameStatus
+#define STATUS_DECODER 0x01
+#define STATUS_KOCH 0x02
+#define STATUS_HEADPHONES 0x04
+#define STATUS_SENDING 0x08
+#define STATUS_LISTENING 0x10
+
+// Little-endian on both MCUs
+typedef struct __attribute__((packed)) {
+  uint8_t lesson;
+  uint8_t speed;
+  uint8_t effectiveSpeed;
+  uint8_t waveform;  // waveformNames[] index
+  uint16_t frequency;
+  uint16_t accuracy;  // tenths of a percent
+  uint8_t flags;
+} FrameStatus;
+
+// FrameStatus members in STATUS_DELTA mask bit order
+#define STATUS_FIELD_COUNT 7
+static const struct {
+  uint8_t offset;
+  uint8_t size;
+} frameStatusFields[STATUS_FIELD_COUNT] = {
+  { offsetof(FrameStatus, lesson), 1 },
+  { offsetof(FrameStatus, speed), 1 },
+  { offsetof(FrameStatus, effectiveSpeed), 1 },
+  { offsetof(FrameStatus, waveform), 1 },
+  { offsetof(FrameStatus, frequency), 2 },
+  { offsetof(FrameStatus, accuracy), 2 },
+  { offsetof(FrameStatus, flags), 1 },
+};
+
+// Mask of the members that differ between a and b
+static inline uint8_t frameStatusChanges(const FrameStatus* a, const FrameStatus* b) {
+  uint8_t mask = 0;
+  for (int i = 0; i < STATUS_FIELD_COUNT; i++) {
+    if (memcmp((const uint8_t*)a + frameStatusFields[i].offset, (const uint8_t*)b + frameStatusFields[i].offset,
+               frameStatusFields[i].size) != 0) {
+      mask |= 1 << i;
+    }
+  }
+  return mask;
+}
+
+// STATUS_DELTA body: the mask, then the masked members of s in order; returns its length
+static inline size_t frameStatusDelta(const FrameStatus* s, uint8_t mask, uint8_t* body) {
+  size_t len = 0;
+  body[len++] = mask;
+  for (int i = 0; i < STATUS_FIELD_COUNT; i++) {
+    if (!(mask & (1 << i))) continue;
+    memcpy(body + len, (const uint8_t*)s + frameStatusFields[i].offset, frameStatusFields[i].size);
+    len += frameStatusFields[i].size;
+  }
+  return len;
+}
+
+// Applies a STATUS_DELTA body to s; false (and s untouched) if it is malformed
+static inline bool frameStatusApply(FrameStatus* s, const uint8_t* body, size_t len) {
+  if (len < 1 || body[0] >> STATUS_FIELD_COUNT) return false;
+  size_t need = 1;
+  for (int i = 0; i < STATUS_FIELD_COUNT; i++) {
+    if (body[0] & (1 << i)) need += frameStatusFields[i].size;
+  }
+  if (need != len) return false;
+  const uint8_t* p = body + 1;
+  for (int i = 0; i < STATUS_FIELD_COUNT; i++) {
+    if (!(body[0] & (1 << i))) continue;
+    memcpy((uint8_t*)s + frameStatusFields[i].offset, p, frameStatusFields[i].size);
+    p += frameStatusFields[i].size;
+  }
+  return true;
+}
+
+// A batch of decoded characters with their Teensy times, so the companion can
+// work out copy speed. The gaps are milliseconds since the previous character
+// of the batch (0 for the first).
+typedef struct __attribute__((packed)) {
+  uint32_t start;  // halMillis() of the first character
+} FrameDecoded;
+
+#define DECODED_MISCOPY 0x80  // in FrameDecodedChar.c: copied, but not what was sent
+
+typedef struct __attribute__((packed)) {
+  uint8_t c;
+  uint16_t gap;
+} FrameDecodedChar;
+
+typedef struct __attribute__((packed)) {
+  uint32_t sessions;
+  uint32_t characters;
+  uint16_t bestWpm;  // tenths
+} FrameStats;
+
+// Live audio at MONITOR_RATE: two 4-bit IMA-ADPCM codes a byte, low nibble
+// first. Each frame carries the coder state it starts from, so a lost frame
+// costs only its own samples.
+typedef struct __attribute__((packed)) {
+  uint32_t sample;    // index of the first sample since the monitor started; gaps are lost audio
+  uint32_t time;      // halMillis() when the first sample was captured
+  uint16_t age;       // ms from that capture to the frame leaving the Teensy
+  int16_t predictor;  // coder state before the first sample
+  uint8_t index;
+} FrameAudio;
+
+// Spectrum of the decode mix: each point is the peak, over the frame's
+// interval, of `merge` adjacent FFT bins starting at firstBin. Levels are
+// half-dB steps, 0 at SPECTRUM_LEVEL_FLOOR_DB or below, 255 at 0 dBFS.
+#define SPECTRUM_LEVEL_FLOOR_DB -127.5f
+typedef struct __attribute__((packed)) {
+  uint32_t time;         // halMillis() at the end of the interval
+  uint16_t firstBin;
+  uint16_t binMilliHz;   // FFT resolution
+  uint8_t merge;         // FFT bins per point
+} FrameSpectrum;
+
+// ---- Encoding -----------------------------------------------------------------
+
+typedef struct {
+  uint8_t* out;
+  size_t len;
+  size_t code;  // where the current COBS block's length byte goes
+  uint16_t crc;
+} FrameWriter;
+
+static inline void frameWriterPut(FrameWriter* w, uint8_t b) {
+  if (b == 0) {
+    w->out[w->code] = (uint8_t)(w->len - w->code);
+    w->code = w->len++;
+    return;
+  }
+  w->out[w->len++] = b;
+  if (w->len - w->code == 0xFF) {  // 254 data bytes close a block without a zero
+    w->out[w->code] = 0xFF;
+    w->code = w->len++;
+  }
+}
+
+static inline void frameWriterPutData(FrameWriter* w, const uint8_t* data, size_t len) {
+  w->crc = crc16Update(w->crc, data, len);
+  while (len--) frameWriterPut(w, *data++);
+}
+
+// Encodes a whole frame into out (FRAME_ENCODED_MAX bytes); 0 if the body is too long
+static inline size_t frameEncode(uint8_t type, uint8_t seq, const void* body, size_t len, uint8_t* out) {
+  if (len > FRAME_BODY_MAX) return 0;
+  FrameWriter w = { out, 2, 1, 0xFFFF };
+  out[0] = 0;
+  uint8_t head[2] = { type, seq };
+  frameWriterPutData(&w, head, 2);
+  frameWriterPutData(&w, (const uint8_t*)body, len);
+  uint16_t crc = w.crc;
+  frameWriterPut(&w, (uint8_t)crc);
+  frameWriterPut(&w, (uint8_t)(crc >> 8));
+  out[w.code] = (uint8_t)(w.len - w.code);
+  out[w.len++] = 0;
+  return w.len;
+}
+
+// ---- Receiving ------------------------------------------------------------------
+
+enum { FRAME_RX_NONE,
+       FRAME_RX_TEXT,      // a complete line, NUL-terminated, in text
+       FRAME_RX_FRAME };   // a frame that passed its CRC, in type/seq/body
+
+typedef struct {
+  uint8_t* buf;  // caller's storage, at least FRAME_ENCODED_MAX bytes
+  size_t size;
+  size_t len;
+  bool inFrame;
+  bool discarding;  // rest of an overlong line or frame
+  bool garbledLine;  // the line so far holds a control byte
+
+  // Result of the last FRAME_RX_TEXT or FRAME_RX_FRAME
+  const char* text;
+  uint8_t type;
+  uint8_t seq;
+  const uint8_t* body;
+  size_t bodyLen;
+
+  uint8_t nextSeq;
+  bool seqKnown;
+  uint32_t lines;
+  uint32_t frames;
+  uint32_t crcErrors;  // also malformed COBS
+  uint32_t seqGaps;    // frames lost between two good ones
+  uint32_t overflows;  // overlong lines and frames, dropped
+  uint32_t garbled;    // lines with control bytes (noise, a rate mismatch), dropped
+} FrameReceiver;
+
+static inline void frameReceiverInit(FrameReceiver* r, uint8_t* buf, size_t size) {
+  memset(r, 0, sizeof(*r));
+  r->buf = buf;
+  r->size = size;
+}
+
+// Undoes COBS in place (the output never overtakes the input) and checks the CRC
+static inline bool frameDecode(FrameReceiver* r) {
+  size_t in = 0, out = 0;
+  while (in < r->len) {
+    uint8_t code = r->buf[in++];
+    if (code == 0 || in + code - 1 > r->len) return false;
+    for (uint8_t i = 1; i < code; i++) r->buf[out++] = r->buf[in++];
+    if (code < 0xFF && in < r->len) r->buf[out++] = 0;
+  }
+  if (out < 4) return false;
+  uint16_t crc = (uint16_t)(r->buf[out - 2] | (r->buf[out - 1] << 8));
+  if (crc16(r->buf, out - 2) != crc) return false;
+  r->type = r->buf[0];
+  r->seq = r->buf[1];
+  r->body = r->buf + 2;
+  r->bodyLen = out - 4;
+  return true;
+}
+
+// Feeds one received byte; returns FRAME_RX_TEXT or FRAME_RX_FRAME when one is complete
+static inline int frameReceiveByte(FrameReceiver* r, uint8_t c) {
+  if (c == 0) {
+    bool ended = r->inFrame && r->len > 0 && !r->discarding;
+    bool good = ended && frameDecode(r);
+    // A zero after a frame closes it; any other zero opens one
+    r->inFrame = !ended;
+    r->len = 0;
+    r->discarding = false;
+    r->garbledLine = false;
+    if (!ended) return FRAME_RX_NONE;
+    if (!good) {
+      r->crcErrors++;
+      return FRAME_RX_NONE;
+    }
+    if (r->seqKnown && r->seq != r->nextSeq) r->seqGaps += (uint8_t)(r->seq - r->nextSeq);
+    r->nextSeq = (uint8_t)(r->seq + 1);
+    r->seqKnown = true;
+    r->frames++;
+    return FRAME_RX_FRAME;
+  }
+  if (!r->inFrame) {
+    if (c == '\r') return FRAME_RX_NONE;
+    if (c == '\n') {
+      bool complete = r->len > 0 && !r->discarding && !r->garbledLine;
+      if (r->garbledLine && !r->discarding) r->garbled++;
+      r->buf[r->len] = '\0';
+      r->len = 0;
+      r->discarding = false;
+      r->garbledLine = false;
+      if (!complete) return FRAME_RX_NONE;
+      r->text = (const char*)r->buf;
+      r->lines++;
+      return FRAME_RX_TEXT;
+    }
+    if ((c < 0x20 && c != '\t') || c == 0x7F) r->garbledLine = true;
+  }
+  if (r->discarding) return FRAME_RX_NONE;
+  // Room for the text terminator. No frame is longer than FRAME_ENCODED_MAX,
+  // so a longer one began with a stray zero on a text link: it is dropped as
+  // text, to the next newline, or the receiver would wait for a zero forever.
+  if (r->len + 1 >= r->size || (r->inFrame && r->len + 2 >= FRAME_ENCODED_MAX)) {
+    r->discarding = true;
+    r->inFrame = false;
+    r->overflows++;
+    return FRAME_RX_NONE;
+  }
+  r->buf[r->len++] = c;
+  return FRAME_RX_NONE;
+}
+
+#endif  // TRAINER_FRAME_H
@@ -0,0 +1,153 @@
+#include "trainer_generator.h"
+#include "trainer_corpus.h"
+#include "trainer_charstats.h"
+#include "trainer_drill.h"
+
+const int GROUP_LENGTH = 5;
+
+// ---- Stream -------------------------------------------------------------------------
+
+LessonStream::LessonStream(LessonGenerator& generator, uint32_t seed)
+  : generator_(generator), rng_(seed), tokens_(0), pendingLen_(0), pendingPos_(0) {
+  generator_.begin();
+}
+
+bool LessonStream::appendToken(TextWriter& out) {
+  char token[GENERATOR_TOKEN_MAX + 1];
+  TextWriter writer(token, sizeof(token));
+  generator_.token(writer, rng_);
+  if (tokens_ > 0 && !out.append(' ')) return false;
+  tokens_++;
+  return out.append(token);
+}
+
+size_t LessonStream::read(char* out, size_t n) {
+  size_t written = 0;
+  while (written < n) {
+    if (pendingPos_ == pendingLen_) {
+      TextWriter writer(pending_, sizeof(pending_));
+      appendToken(writer);
+      pendingLen_ = writer.length();
+      pendingPos_ = 0;
+      if (pendingLen_ == 0) break;  // generator produced nothing
+    }
+    size_t chunk = pendingLen_ - pendingPos_;
+    if (chunk > n - written) chunk = n - written;
+    memcpy(out + written, pending_ + pendingPos_, chunk);
+    pendingPos_ += chunk;
+    written += chunk;
+  }
+  return written;
+}
+
+size_t generateLesson(LessonGenerator& generator, uint32_t seed, int tokens, TextWriter& out) {
+  LessonStream stream(generator, seed);
+  for (int i = 0; i < tokens; i++) {
+    if (!stream.appendToken(out)) break;
+  }
+  return out.length();
+}
+
+// ---- Shared token pieces ----------------------------------------------------------
+
+static void appendCorpusToken(TextWriter& out, CorpusList list, GeneratorRng& rng) {
+  corpusToken(list, rng.below(corpusCount(list)), out);
+}
+
+// Country prefix, call area digit and a one to three letter suffix
+static void appendCallsign(TextWriter& out, GeneratorRng& rng) {
+  appendCorpusToken(out, CORPUS_PREFIXES, rng);
+  out.append((char)('0' + rng.below(10)));
+  int suffixLength = 1 + rng.below(3);
+  for (int i = 0; i < suffixLength; i++) {
+    out.append((char)('A' + rng.below(26)));
+  }
+}
+
+// ---- Generators ---------------------------------------------------------------------
+
+// Code groups drawn by the drill engine; subclasses choose the character set
+class DrillGroupGenerator : public LessonGenerator {
+public:
+  void token(TextWriter& out, GeneratorRng& rng) override {
+    for (int i = 0; i < GROUP_LENGTH; i++) out.append(drillNext(rng.next()));
+  }
+};
+
+class KochGenerator : public DrillGroupGenerator {
+public:
+  void begin() override {
+    size_t setLength = strlen(kochCharSet);
+    drillPrepare(kochCharSet, kochLesson > 1 && setLength > 0 ? kochCharSet[setLength - 1] : 0);
+  }
+};
+
+class CustomGenerator : public DrillGroupGenerator {
+public:
+  void begin() override {
+    // Every symbol the student has copied; weights favour the ones they miss
+    char copied[MORSE_SYMBOL_COUNT + 1];
+    size_t n = 0;
+    for (int i = 0; i < MORSE_SYMBOL_COUNT; i++) {
+      if (symbolAttempts(i) > 0) copied[n++] = morseTable[i].character;
+    }
+    copied[n] = '\0';
+    drillPrepare(n > 0 ? copied : "ABCDEFGHIJKLMNOPQRSTUVWXYZ", 0);
+  }
+};
+
+class CallsignGenerator : public LessonGenerator {
+public:
+  void token(TextWriter& out, GeneratorRng& rng) override {
+    appendCallsign(out, rng);
+  }
+};
+
+class ContestGenerator : public LessonGenerator {
+public:
+  void token(TextWriter& out, GeneratorRng& rng) override {
+    appendCallsign(out, rng);
+    char number[8];
+    snprintf(number, sizeof(number), " %03u ", (unsigned)(serial_++ % 1000));
+    out.append(number);
+    appendCorpusToken(out, CORPUS_EXCHANGES, rng);
+  }
+
+private:
+  uint32_t serial_ = 1;
+};
+
+// Ragchew copy: QSO phrases, with abbreviations and plain words mixed in
+class QsoGenerator : public LessonGenerator {
+public:
+  void token(TextWriter& out, GeneratorRng& rng) override {
+    uint32_t pick = rng.below(4);
+    appendCorpusToken(out, pick < 2 ? CORPUS_PHRASES : pick == 2 ? CORPUS_ABBREVIATIONS : CORPUS_WORDS, rng);
+  }
+};
+
+static KochGenerator koch;
+static CustomGenerator custom;
+static CallsignGenerator callsign;
+static ContestGenerator contest;
+static QsoGenerator qso;
+
+LessonGenerator& kochGenerator() {
+  return koch;
+}
+
+LessonGenerator& customGenerator() {
+  return custom;
+}
+
+LessonGenerator& callsignGenerator() {
+  return callsign;
+}
+
+LessonGenerator& contestGenerator() {
+  return contest;
+}
+
+LessonGenerator& qsoGenerator() {
+  return qso;
+}
@@ -0,0 +1,70 @@
+#ifndef TRAINER_GENERATOR_H
+#define TRAINER_GENERATOR_H
+
+// Lesson text generators. Each practice mode implements LessonGenerator and
+// writes one token at a time (a code group, a callsign, a contest exchange)
+// into a caller-supplied TextWriter, drawing randomness only from the
+// GeneratorRng it is handed, so a seed reproduces a lesson. LessonStream joins
+// tokens with spaces and hands the text out in chunks of any size, so a lesson
+// can be arbitrarily long without a buffer that holds all of it.
+
+#include "trainer_core.h"
+
+// xorshift32 owned by one lesson, independent of trainerRandom()
+struct GeneratorRng {
+  uint32_t state;
+
+  explicit GeneratorRng(uint32_t seed)
+    : state(seed ? seed : 0x2545F491) {}
+
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  uint32_t below(uint32_t n) {
+    return n ? next() % n : 0;
+  }
+};
+
+const size_t GENERATOR_TOKEN_MAX = 24;
+
+class LessonGenerator {
+public:
+  virtual void begin() {}  // once per lesson, before the first token
+  virtual void token(TextWriter& out, GeneratorRng& rng) = 0;  // at most GENERATOR_TOKEN_MAX chars
+};
+
+class LessonStream {
+public:
+  LessonStream(LessonGenerator& generator, uint32_t seed);
+
+  bool appendToken(TextWriter& out);  // separator and next token; false once out is full
+  size_t read(char* out, size_t n);   // next n characters of the endless lesson, not NUL-terminated
+  uint32_t tokens() const { return tokens_; }
+
+private:
+  LessonGenerator& generator_;
+  GeneratorRng rng_;
+  uint32_t tokens_;
+  char pending_[GENERATOR_TOKEN_MAX + 2];  // separator, token, NUL
+  size_t pendingLen_;
+  size_t pendingPos_;
+};
+
+// tokens space-separated tokens from a fresh stream into out
+size_t generateLesson(LessonGenerator& generator, uint32_t seed, int tokens, TextWriter& out);
+
+// Koch: five-character groups from the current lesson set, newest character boosted
+LessonGenerator& kochGenerator();
+// Custom: five-character groups weighted toward the student's weak symbols
+LessonGenerator& customGenerator();
+LessonGenerator& callsignGenerator();
+// Contest: callsign, serial number and exchange; the serial runs on across lessons
+LessonGenerator& contestGenerator();
+// QSO: phrases, abbreviations and words from the flash corpus
+LessonGenerator& qsoGenerator();
+
+#endif  // TRAINER_GENERATOR_H
@@ -0,0 +1,96 @@
+#ifndef TRAINER_HAL_H
+#define TRAINER_HAL_H
+
+// Thin hardware interface between the trainer core and the platform.
+// cw-trainer.ino implements these on the Teensy (Audio, pin interrupts, EEPROM,
+// SSD1306, Serial/Serial1); host_sim/host_hal.cpp implements them with a
+// virtual clock, in-memory EEPROM and a text framebuffer.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef ARDUINO
+// Host builds: flash tables are ordinary const data
+#include <string.h>
+#define PROGMEM
+#define PGM_P const char*
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+#define pgm_read_ptr(addr) (*(addr))
+#define strcpy_P(dst, src) strcpy((dst), (src))
+#endif
+
+// ---- Time ---------------------------------------------------------------------
+uint32_t halMillis();
+uint32_t halMicros();
+
+// ---- Keying and audio ---------------------------------------------------------
+// Key, menu button and encoder are not polled: the platform pushes their
+// edges into inputQueue (trainer_input.h) from its interrupts.
+bool halToneDetected();   // decoder tone detector above threshold
+void halToneOn();         // sidetone envelope on
+void halToneOff();        // sidetone envelope off
+
+// Push the current audio settings (core globals) to the audio graph
+void updateWaveform();
+void updateFrequency();
+void updateVolume();
+void updateOutputRouting();
+void updateToneDetector();
+void updateAudioInput();
+
+// ---- Persistent storage -------------------------------------------------------
+const int STORAGE_SIZE = 4284;  // Teensy 4.1 emulated EEPROM
+void halStorageRead(int addr, void* dst, size_t len);
+void halStorageWrite(int addr, const void* src, size_t len);
+
+// ---- Wall clock -----------------------------------------------------------------
+uint32_t halClockSeconds();  // Unix time from the RTC; small values mean it was never set
+
+// ---- Profile images -----------------------------------------------------------
+// One saved image per inactive operator profile (trainer_profiles.h); the
+// Teensy keeps them as files on the SD card.
+bool halProfileWrite(int profile, const uint8_t* data, size_t len);  // replaces the image; false on failure
+size_t halProfileRead(int profile, uint8_t* dst, size_t max);         // 0 if there is none
+
+// Random access to each profile's session history file (trainer_history.h)
+bool halHistoryRead(int profile, uint32_t offset, void* dst, size_t len);  // false if missing or short
+bool halHistoryWrite(int profile, uint32_t offset, const void* src, size_t len);
+
+// ---- Text output --------------------------------------------------------------
+void halConsoleWrite(const char* text);  // USB serial console
+void halLinkWriteLine(const char* line);  // companion UART, newline appended
+void halLinkWrite(const uint8_t* data, size_t len);  // companion UART, raw bytes (frames)
+void halLinkSetBaud(uint32_t baud);  // after the pending output has left
+uint32_t halLinkMaxBaud();  // highest rate the UART and wiring take
+bool halLinkFlowControl();  // RTS/CTS wired to the companion
+void halSetLinkIndicator(bool connected);  // status LED
+
+// ---- Audio monitor (trainer_monitor.h) ----------------------------------------
+// The audio interrupt only copies blocks of the decode mix into a short queue;
+// blocks the main loop does not collect in time are dropped, not waited for.
+void halMonitorCapture(bool on);
+int halMonitorRead(int16_t* block);  // fills MONITOR_BLOCK_SAMPLES; 0 if no block is waiting
+uint32_t halMonitorDropped();  // blocks dropped since capture started
+float halAudioLoadPeak();  // audio interrupt's peak share of the CPU, percent
+
+// ---- Spectrum (trainer_spectrum.h) --------------------------------------------
+void halSpectrumEnable(bool on);
+// Magnitudes (0 to 1.0 full scale) of bins firstBin.. of the latest FFT of the
+// decode mix; false if none has finished since the last call
+bool halSpectrumRead(float* magnitudes, int firstBin, int count);
+
+// ---- Display ------------------------------------------------------------------
+const int SCREEN_TEXT_ROWS = 8;
+const int SCREEN_TEXT_COLS = 21;
+
+struct TextScreen {
+  char rows[SCREEN_TEXT_ROWS][SCREEN_TEXT_COLS + 1];
+};
+
+void halDisplayShow(const TextScreen& screen);
+
+// ---- Diagnostics --------------------------------------------------------------
+void printHeapProbe();
+
+#endif  // TRAINER_HAL_H
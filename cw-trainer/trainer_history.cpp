@@ -0,0 +1,225 @@
+#include "trainer_history.h"
+#include "trainer_profiles.h"
+#include "trainer_protocol.h"
+#include "trainer_trace.h"
+#include "trainer_crc.h"
+
+struct __attribute__((packed)) HistoryHeader {
+  char magic[4];  // "CWHS"
+  uint8_t version;
+  uint8_t tiers;
+  uint16_t points[HISTORY_TIERS];
+  uint16_t head[HISTORY_TIERS];  // next bucket to open
+  uint16_t count[HISTORY_TIERS];
+  uint16_t crc;  // CRC-16 of the bytes before it
+};
+
+static const uint16_t tierPoints[HISTORY_TIERS] = { HISTORY_SESSION_POINTS, HISTORY_DAY_POINTS, HISTORY_WEEK_POINTS };
+static const uint16_t tierBase[HISTORY_TIERS] = { 0, HISTORY_SESSION_POINTS, HISTORY_SESSION_POINTS + HISTORY_DAY_POINTS };
+static const char tierLetters[HISTORY_TIERS] = { 'S', 'D', 'W' };
+const int HISTORY_BUCKETS = HISTORY_SESSION_POINTS + HISTORY_DAY_POINTS + HISTORY_WEEK_POINTS;
+
+static HistoryBucket buckets[HISTORY_BUCKETS];
+static uint16_t head[HISTORY_TIERS];
+static uint16_t count[HISTORY_TIERS];
+static int touched[HISTORY_TIERS] = { -1, -1, -1 };  // bucket the last session updated
+static bool fileValid = false;  // the file holds a matching header and every bucket
+
+static uint32_t bucketOffset(int bucket) {
+  return sizeof(HistoryHeader) + bucket * sizeof(HistoryBucket);
+}
+
+// Days count from the Unix epoch, a Thursday; weeks start on Monday
+static uint32_t periodOf(HistoryTier tier, uint32_t seconds) {
+  uint32_t day = seconds / 86400;
+  return tier == HISTORY_WEEKS ? (day + 3) / 7 : day;
+}
+
+static void fillHeader(HistoryHeader& h) {
+  memcpy(h.magic, "CWHS", 4);
+  h.version = HISTORY_VERSION;
+  h.tiers = HISTORY_TIERS;
+  memcpy(h.points, tierPoints, sizeof(h.points));
+  memcpy(h.head, head, sizeof(h.head));
+  memcpy(h.count, count, sizeof(h.count));
+  h.crc = crc16((const uint8_t*)&h, offsetof(HistoryHeader, crc));
+}
+
+static bool validHeader(const HistoryHeader& h) {
+  return memcmp(h.magic, "CWHS", 4) == 0 && h.version == HISTORY_VERSION && h.tiers == HISTORY_TIERS && memcmp(h.points, tierPoints, sizeof(h.points)) == 0 && h.crc == crc16((const uint8_t*)&h, offsetof(HistoryHeader, crc));
+}
+
+// Buckets are written before the header, so a reset in between loses at most
+// the session being recorded
+static void writeHeader() {
+  HistoryHeader h;
+  fillHeader(h);
+  halHistoryWrite(profiles.active, 0, &h, sizeof(h));
+}
+
+static void writeAll() {
+  fileValid = halHistoryWrite(profiles.active, bucketOffset(0), buckets, sizeof(buckets));
+  writeHeader();
+}
+
+void historyLoad() {
+  memset(buckets, 0, sizeof(buckets));
+  memset(head, 0, sizeof(head));
+  memset(count, 0, sizeof(count));
+  for (int t = 0; t < HISTORY_TIERS; t++) touched[t] = -1;
+
+  HistoryHeader h;
+  fileValid = halHistoryRead(profiles.active, 0, &h, sizeof(h)) && validHeader(h) && halHistoryRead(profiles.active, bucketOffset(0), buckets, sizeof(buckets));
+  if (!fileValid) {
+    memset(buckets, 0, sizeof(buckets));
+    return;  // a missing or foreign file is replaced on the first session
+  }
+  for (int t = 0; t < HISTORY_TIERS; t++) {
+    head[t] = h.head[t] % tierPoints[t];
+    count[t] = h.count[t] <= tierPoints[t] ? h.count[t] : tierPoints[t];
+  }
+}
+
+void historyReset() {
+  memset(buckets, 0, sizeof(buckets));
+  memset(head, 0, sizeof(head));
+  memset(count, 0, sizeof(count));
+  for (int t = 0; t < HISTORY_TIERS; t++) touched[t] = -1;
+  if (!traceReplaying()) writeAll();
+  sendHistoryToWiFi(true);
+}
+
+void historyRecordSession(float accuracy, int characters) {
+  if (traceReplaying()) return;  // replayed sessions are already in the history
+  uint32_t now = halClockSeconds();
+
+  for (int t = 0; t < HISTORY_TIERS; t++) {
+    HistoryTier tier = (HistoryTier)t;
+    int last = tierBase[t] + (head[t] + tierPoints[t] - 1) % tierPoints[t];
+    int index = last;
+    if (count[t] == 0 || tier == HISTORY_SESSIONS || periodOf(tier, buckets[last].start) != periodOf(tier, now)) {
+      index = tierBase[t] + head[t];
+      head[t] = (head[t] + 1) % tierPoints[t];
+      if (count[t] < tierPoints[t]) count[t]++;
+      memset(&buckets[index], 0, sizeof(HistoryBucket));
+      buckets[index].start = now;
+    }
+
+    HistoryBucket& b = buckets[index];
+    if (b.sessions < 0xFFFF) b.sessions++;
+    b.lesson = kochLesson;
+    b.characters += characters;
+    b.accuracySum += accuracy;
+    b.speedSum += kochSpeed;
+    b.effectiveSum += kochEffectiveSpeed;
+    touched[t] = index;
+
+    if (fileValid) halHistoryWrite(profiles.active, bucketOffset(index), &b, sizeof(b));
+  }
+
+  if (fileValid) writeHeader();
+  else writeAll();
+  sendHistoryToWiFi(false);
+}
+
+static void toPoint(const HistoryBucket& b, HistoryPoint& p) {
+  float n = b.sessions ? b.sessions : 1;
+  p.start = b.start;
+  p.sessions = b.sessions;
+  p.lesson = b.lesson;
+  p.characters = b.characters;
+  p.accuracy = b.accuracySum / n;
+  p.speed = b.speedSum / n;
+  p.effectiveSpeed = b.effectiveSum / n;
+}
+
+int historyQuery(HistoryTier tier, int wanted, HistoryPoint* out) {
+  if (tier >= HISTORY_TIERS || wanted <= 0) return 0;
+  int n = wanted < count[tier] ? wanted : count[tier];
+  int first = (head[tier] + tierPoints[tier] - n) % tierPoints[tier];
+  for (int i = 0; i < n; i++) {
+    toPoint(buckets[tierBase[tier] + (first + i) % tierPoints[tier]], out[i]);
+  }
+  return n;
+}
+
+// ---- Output -----------------------------------------------------------------------
+
+// Proleptic Gregorian date of a day number (days since 1970-01-01)
+static void civilDate(uint32_t days, int& year, unsigned& month, unsigned& day) {
+  uint32_t z = days + 719468;
+  uint32_t era = z / 146097;
+  uint32_t doe = z - era * 146097;
+  uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  uint32_t mp = (5 * doy + 2) / 153;
+  day = doy - (153 * mp + 2) / 5 + 1;
+  month = mp < 10 ? mp + 3 : mp - 9;
+  year = yoe + era * 400 + (month <= 2);
+}
+
+const uint32_t CLOCK_VALID_AFTER = 1577836800;  // 2020-01-01; earlier means the RTC was never set
+
+static void appendLabel(FixedText<24>& label, HistoryTier tier, uint32_t start) {
+  if (start < CLOCK_VALID_AFTER) {
+    label.append("-");
+    return;
+  }
+  uint32_t days = tier == HISTORY_WEEKS ? periodOf(tier, start) * 7 - 3 : start / 86400;
+  int year;
+  unsigned month, day;
+  civilDate(days, year, month, day);
+  label.appendf("%04d-%02u-%02u", year, month, day);
+  if (tier == HISTORY_SESSIONS) label.appendf(" %02u:%02u", (unsigned)(start / 3600 % 24), (unsigned)(start / 60 % 60));
+}
+
+void printHistory(HistoryTier tier, int wanted) {
+  static const char* titles[HISTORY_TIERS] = { "SESSIONS", "DAYS", "WEEKS (from Monday)" };
+  consolePrintf("\n=== HISTORY: %s ===\n", titles[tier]);
+  consolePrintf("%-16s %5s %7s %5s %5s %6s\n", "Start", "Sess", "Acc", "WPM", "Eff", "Lesson");
+  // One point at a time from the oldest wanted, so no array is needed
+  int n = count[tier] < wanted ? count[tier] : wanted;
+  int first = (head[tier] + tierPoints[tier] - n) % tierPoints[tier];
+  for (int i = 0; i < n; i++) {
+    HistoryPoint p;
+    toPoint(buckets[tierBase[tier] + (first + i) % tierPoints[tier]], p);
+    FixedText<24> label;
+    appendLabel(label, tier, p.start);
+    consolePrintf("%-16s %5u %6s%% %5s %5s %6u\n", label.c_str(), (unsigned)p.sessions,
+                  fixedFloat(p.accuracy, 1).c_str(), fixedFloat(p.speed, 1).c_str(),
+                  fixedFloat(p.effectiveSpeed, 1).c_str(), (unsigned)p.lesson);
+  }
+  consolePrintf("========================\n\n");
+}
+
+// HISTORY:<tier> <slot> <start> <sessions> <lesson> <characters> <accuracy> <speed> <effective>
+// The slot is the bucket's place in its ring and the newest line of a tier is
+// its newest bucket, so the companion can mirror the rings without the heads.
+static void sendBucket(HistoryTier tier, int index) {
+  HistoryPoint p;
+  toPoint(buckets[index], p);
+  static FixedText<80> msg;
+  msg.set(PREFIX_HISTORY);
+  msg.appendf("%c %d %lu %u %u %lu ", tierLetters[tier], index - tierBase[tier], (unsigned long)p.start,
+              (unsigned)p.sessions, (unsigned)p.lesson, (unsigned long)p.characters);
+  msg.appendFloat(p.accuracy, 1);
+  msg.append(' ');
+  msg.appendFloat(p.speed, 1);
+  msg.append(' ');
+  msg.appendFloat(p.effectiveSpeed, 1);
+  linkWriteLine(msg.c_str());
+}
+
+void sendHistoryToWiFi(bool all) {
+  if (!wifiEnabled || !espConnected) return;
+
+  if (all) linkWriteLine(PREFIX_HISTORY "CLEAR");
+  for (int t = 0; t < HISTORY_TIERS; t++) {
+    if (!all) {
+      if (touched[t] >= 0) sendBucket((HistoryTier)t, touched[t]);
+      continue;
+    }
+    int first = (head[t] + tierPoints[t] - count[t]) % tierPoints[t];
+    for (int i = 0; i < count[t]; i++) sendBucket((HistoryTier)t, tierBase[t] + (first + i) % tierPoints[t]);
+  }
+}
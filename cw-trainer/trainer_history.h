@@ -0,0 +1,62 @@
+#ifndef TRAINER_HISTORY_H
+#define TRAINER_HISTORY_H
+
+// Session history for progress charts. Every scored Koch session is folded
+// into three fixed rings at once: the last sessions one by one, then daily and
+// weekly rollups, so a year of training costs a few kilobytes and the longer
+// views are always up to date. Buckets keep sums and the means are taken when
+// queried.
+//
+// Each profile has its own history file (halHistoryRead/Write): a header with
+// the ring positions, then the rings at fixed offsets. A session end rewrites
+// only the three buckets it touched and the header. Days and weeks (from
+// Monday) come from halClockSeconds(); with the clock unset every session
+// lands in the same day and week and only the session ring is useful.
+
+#include "trainer_core.h"
+
+enum HistoryTier : uint8_t { HISTORY_SESSIONS,
+                             HISTORY_DAYS,
+                             HISTORY_WEEKS,
+                             HISTORY_TIERS };
+
+const int HISTORY_SESSION_POINTS = 30;
+const int HISTORY_DAY_POINTS = 42;   // six weeks
+const int HISTORY_WEEK_POINTS = 52;  // a year
+const uint8_t HISTORY_VERSION = 1;
+
+struct __attribute__((packed)) HistoryBucket {
+  uint32_t start;  // halClockSeconds() of the first session in it
+  uint16_t sessions;
+  uint8_t lesson;  // Koch lesson after the last session
+  uint8_t reserved;
+  uint32_t characters;  // scored characters
+  float accuracySum;    // percent, per session
+  float speedSum;       // character speed, WPM
+  float effectiveSum;   // Farnsworth speed, WPM
+};
+
+static_assert(sizeof(HistoryBucket) == 24, "history file layout");
+
+struct HistoryPoint {
+  uint32_t start;
+  uint16_t sessions;
+  uint8_t lesson;
+  uint32_t characters;
+  float accuracy;  // means over the bucket's sessions
+  float speed;
+  float effectiveSpeed;
+};
+
+void historyLoad();   // the active profile's history; once storage is up and on a profile switch
+void historyReset();  // with the statistics
+void historyRecordSession(float accuracy, int characters);  // at the end of a scored session
+
+// The most recent count points of a tier (fewer if it holds fewer), oldest first
+int historyQuery(HistoryTier tier, int count, HistoryPoint* out);
+
+void printHistory(HistoryTier tier, int count);  // HISTORY console command
+// HISTORY lines: the buckets the last session touched, or HISTORY:CLEAR and every bucket
+void sendHistoryToWiFi(bool all);
+
+#endif  // TRAINER_HISTORY_H
@@ -0,0 +1,61 @@
+#include "trainer_core.h"
+#include "trainer_input.h"
+#include "trainer_trace.h"
+
+InputQueue inputQueue;
+
+static bool keyDown = false;
+static bool buttonHeld = false;
+static bool longPressSent = false;
+static uint32_t buttonDownTime = 0;
+static uint32_t eventsHandled = 0;
+static uint8_t maxDepth = 0;
+
+void serviceInput() {
+  uint8_t depth = inputQueue.depth();
+  if (depth > maxDepth) maxDepth = depth;
+
+  // A trace replay stands in for the physical controls
+  bool replaying = traceReplaying();
+
+  InputEvent event;
+  while (inputQueue.pop(event)) {
+    eventsHandled++;
+    switch (event.type) {
+      case INPUT_KEY:
+        keyDown = event.value;
+        break;
+
+      case INPUT_BUTTON:
+        if (event.value) {
+          buttonHeld = true;
+          longPressSent = false;
+          buttonDownTime = event.time;
+        } else if (buttonHeld) {
+          buttonHeld = false;
+          if (!longPressSent && !replaying) menuShortPress();
+        }
+        break;
+
+      case INPUT_ENCODER:
+        if (!replaying) menuRotate(event.value);
+        break;
+    }
+  }
+
+  // Long press fires once while the button is still held
+  if (buttonHeld && !longPressSent && halMillis() - buttonDownTime >= LONG_PRESS_DURATION) {
+    longPressSent = true;
+    if (!replaying) menuLongPress();
+  }
+}
+
+bool inputKeyDown() {
+  return keyDown;
+}
+
+void printInputStats() {
+  consolePrintf("Input events: %lu handled, max queue depth %u/%u, %lu overflows\n",
+                (unsigned long)eventsHandled, (unsigned)maxDepth, (unsigned)InputQueue::CAPACITY - 1,
+                (unsigned long)inputQueue.overflows());
+}
@@ -0,0 +1,77 @@
+#ifndef TRAINER_INPUT_H
+#define TRAINER_INPUT_H
+
+// Timestamped input events. The platform's pin-change and encoder interrupts
+// push into inputQueue; serviceInput() drains it once per tick and hands key,
+// button and encoder events to the keyer and menu. Nothing polls hardware, and
+// edges that arrive during a long loop iteration wait in the queue.
+
+#include <stdint.h>
+#include <atomic>
+
+enum InputEventType : uint8_t {
+  INPUT_KEY,      // value = 1 down, 0 up
+  INPUT_BUTTON,   // value = 1 pressed, 0 released (long press derived here)
+  INPUT_ENCODER   // value = signed detents
+};
+
+struct InputEvent {
+  uint32_t time;  // halMillis() when the edge was seen
+  InputEventType type;
+  int8_t value;
+};
+
+// Single-producer / single-consumer ring. The Teensy input ISRs all run at the
+// GPIO interrupt priority, so they never preempt each other and act as one
+// producer; the loop is the only consumer.
+class InputQueue {
+public:
+  static const uint8_t CAPACITY = 64;  // power of two
+
+  bool push(const InputEvent& event) {
+    uint8_t head = head_;
+    uint8_t next = (head + 1) & (CAPACITY - 1);
+    if (next == tail_) {
+      overflows_ = overflows_ + 1;
+      return false;
+    }
+    events_[head] = event;
+    std::atomic_signal_fence(std::memory_order_release);
+    head_ = next;
+    return true;
+  }
+
+  bool pop(InputEvent& event) {
+    uint8_t tail = tail_;
+    if (tail == head_) return false;
+    std::atomic_signal_fence(std::memory_order_acquire);
+    event = events_[tail];
+    std::atomic_signal_fence(std::memory_order_release);
+    tail_ = (tail + 1) & (CAPACITY - 1);
+    return true;
+  }
+
+  uint8_t depth() const {
+    return (head_ - tail_) & (CAPACITY - 1);
+  }
+
+  uint32_t overflows() const {
+    return overflows_;
+  }
+
+private:
+  InputEvent events_[CAPACITY];
+  volatile uint8_t head_ = 0;
+  volatile uint8_t tail_ = 0;
+  volatile uint32_t overflows_ = 0;
+};
+
+extern InputQueue inputQueue;
+
+const uint32_t LONG_PRESS_DURATION = 1000;  // ms held before the menu button counts as a long press
+
+void serviceInput();   // drain the queue; called at the top of trainerTick()
+bool inputKeyDown();   // key state as of the last drained event
+void printInputStats();
+
+#endif  // TRAINER_INPUT_H
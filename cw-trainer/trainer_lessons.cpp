@@ -0,0 +1,323 @@
+#include "trainer_core.h"
+#include "trainer_sessionlog.h"
+#include "trainer_generator.h"
+#include "trainer_align.h"
+#include "trainer_charstats.h"
+#include "trainer_history.h"
+
+// Lesson text storage. Every generator builds its text in this arena, which is
+// reset when the next lesson starts, so lesson generation never touches the heap.
+const size_t LESSON_ARENA_SIZE = 1024;
+static uint8_t lessonArenaMem[LESSON_ARENA_SIZE];
+Arena lessonArena(lessonArenaMem, sizeof(lessonArenaMem));
+const int GROUPS_PER_LESSON = 9;  // five-character code groups per Koch or custom lesson
+
+// Koch Method Variables
+int kochLesson = 1;
+const char* kochCharSet = "";
+int kochSpeed = 20;
+int kochEffectiveSpeed = 13;
+const char* kochSentText = "";
+size_t kochSentLength = 0;
+FixedText<LESSON_TEXT_MAX + 1> kochReceivedText;
+int kochCharIndex = 0;
+unsigned long kochSendTimer = 0;
+bool kochSending = false;
+bool kochListening = false;
+int kochCorrect = 0;
+int kochTotal = 0;
+float kochAccuracy = 0.0;
+
+// Committed copy events feed the score and the per-character statistics
+static void scoreAlignedCharacter(const AlignEvent& event) {
+  kochTotal++;
+  if (event.op == ALIGN_MATCH) kochCorrect++;
+  if (event.op != ALIGN_INSERTION) recordCopiedCharacter(event.expected, event.copied, event.responseMs);
+}
+
+CopyAligner copyAligner(scoreAlignedCharacter);
+
+// Koch method character progression
+const char* const kochLessons[] = {
+  "KM", "KMR", "KMRS", "KMRSU", "KMRSUA", "KMRSUAP", "KMRSUAPT", "KMRSUAPTL",
+  "KMRSUAPTLO", "KMRSUAPTLOW", "KMRSUAPTLOWI", "KMRSUAPTLOWIN", "KMRSUAPTLOWING",
+  "KMRSUAPTLOWINGD", "KMRSUAPTLOWINGDK", "KMRSUAPTLOWINGDKG", "KMRSUAPTLOWINGDKGO",
+  "KMRSUAPTLOWINGDKGOH", "KMRSUAPTLOWINGDKGOHV", "KMRSUAPTLOWINGDKGOHVF",
+  "KMRSUAPTLOWINGDKGOHVFU", "KMRSUAPTLOWINGDKGOHVFUJ", "KMRSUAPTLOWINGDKGOHVFUJE",
+  "KMRSUAPTLOWINGDKGOHVFUJEL", "KMRSUAPTLOWINGDKGOHVFUJELB", "KMRSUAPTLOWINGDKGOHVFUJELBY",
+  "KMRSUAPTLOWINGDKGOHVFUJELBYC", "KMRSUAPTLOWINGDKGOHVFUJELBYCK", "KMRSUAPTLOWINGDKGOHVFUJELBYCKX",
+  "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQ", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ5",
+  "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ54", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ543", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ5432",
+  "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ54321", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ543210", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ5432109",
+  "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ54321098", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ543210987", "KMRSUAPTLOWINGDKGOHVFUJELBYCKXQZ5432109876"
+};
+
+// Element sender state for the character currently being keyed
+static bool elementActive = false;
+static int elementIndex = 0;
+static unsigned long elementTimer = 0;
+static bool elementState = false;
+
+static void resetElementSender() {
+  elementActive = false;
+  elementIndex = 0;
+  elementState = false;
+}
+
+void handlePracticeModeButton() {
+  switch (currentPracticeMode) {
+    case KOCH_TRAINING:
+      if (kochSending || kochListening) {
+        startKochLesson();  // Repeat
+      } else {
+        evaluateKochSession();
+      }
+      break;
+
+    case CALLSIGN_PRACTICE:
+      generateCallsignLesson();
+      break;
+
+    case QSO_SIMULATION:
+      continueQSOSimulation();
+      break;
+
+    case CONTEST_MODE:
+      generateContestExchange();
+      break;
+
+    case CUSTOM_LESSON:
+      generateCustomLesson();
+      break;
+  }
+}
+
+void startPracticeMode() {
+  switch (currentPracticeMode) {
+    case KOCH_TRAINING:
+      kochModeEnabled = true;
+      startKochLesson();
+      break;
+
+    case CALLSIGN_PRACTICE:
+      generateCallsignLesson();
+      break;
+
+    case QSO_SIMULATION:
+      startQSOSimulation();
+      break;
+
+    case CONTEST_MODE:
+      generateContestExchange();
+      break;
+
+    case CUSTOM_LESSON:
+      generateCustomLesson();
+      break;
+  }
+}
+
+// Helper to initialize a generated lesson and update state/display
+static void startLesson(const char* lesson, const char* title) {
+  kochSentText = lesson;
+  kochSentLength = strlen(lesson);
+  kochReceivedText.clear();
+  kochCorrect = 0;
+  kochTotal = 0;
+  copyAligner.begin(lesson);
+  kochCharIndex = 0;
+  kochSendTimer = halMillis();
+  kochSending = true;
+  kochListening = false;
+  resetElementSender();
+  consolePrintf("%s\n%s\n", title, lesson);
+  updateDisplay();
+}
+
+// Release the previous lesson and hand out a fresh text buffer from the arena
+static TextWriter beginLessonText() {
+  lessonArena.reset();
+  char* buf = lessonArena.allocText(LESSON_TEXT_MAX);
+  return TextWriter(buf, LESSON_TEXT_MAX + 1);
+}
+
+// Fills a fresh lesson buffer from a generator, seeded from the trainer PRNG so
+// trace replay reproduces the text
+static const char* generateLessonText(LessonGenerator& generator, int tokens) {
+  TextWriter lesson = beginLessonText();
+  generateLesson(generator, trainerRandom32(), tokens, lesson);
+  return lesson.c_str();
+}
+
+void generateCallsignLesson() {
+  startLesson(generateLessonText(callsignGenerator(), 10), "Callsign Practice:");
+}
+
+void generateContestExchange() {
+  startLesson(generateLessonText(contestGenerator(), 5), "Contest Practice:");
+}
+
+void generateCustomLesson() {
+  startLesson(generateLessonText(customGenerator(), GROUPS_PER_LESSON), "Custom Lesson (Weak Characters):");
+}
+
+void initializeKoch() {
+  kochCharSet = kochLessons[kochLesson - 1];
+  calculateKochTiming();
+}
+
+void startKochLesson() {
+  kochSentText = generateLessonText(kochGenerator(), GROUPS_PER_LESSON);
+  kochSentLength = strlen(kochSentText);
+  kochReceivedText.clear();
+  kochCharIndex = 0;
+  kochSendTimer = halMillis();
+  kochSending = true;
+  kochListening = false;
+  kochCorrect = 0;
+  kochTotal = 0;
+  copyAligner.begin(kochSentText);
+  resetElementSender();
+  sessionLogSession(SLOG_SESSION_START, kochSentLength, 0);
+
+  consolePrintf("\n=== KOCH LESSON %d ===\n", kochLesson);
+  consolePrintf("Characters: %s\n", kochCharSet);
+  consolePrintf("Speed: %d/%d WPM\n", kochSpeed, kochEffectiveSpeed);
+  consolePrintf("Text: %s\n", kochSentText);
+  consolePrintf("Sending...\n");
+
+  decodedText.clear();
+
+  // Send current lesson text to WiFi
+  sendCurrentTextToWiFi(kochSentText);
+  sendStatusToWiFi();
+
+  updateDisplay();
+}
+
+void stopKochLesson() {
+  kochSending = false;
+  kochListening = false;
+  resetElementSender();
+  halToneOff();
+  consolePrintf("Training stopped.\n");
+  updateDisplay();
+}
+
+// Keys one character element by element. The character starts once the
+// inter-character gap (kochSendTimer) has elapsed and returns true after its
+// last element and trailing element gap.
+static bool sendMorseCharacter(const char* morseCode, unsigned long currentTime) {
+  if (!elementActive) {
+    if ((long)(currentTime - kochSendTimer) < 0) return false;
+    elementActive = true;
+    elementIndex = 0;
+    elementTimer = currentTime;
+    elementState = true;
+    halToneOn();
+    return false;
+  }
+
+  char element = morseCode[elementIndex];
+  unsigned long elementDuration = (element == '.') ? ditLength : (ditLength * 3);
+
+  if (elementState) {
+    if (currentTime - elementTimer >= elementDuration) {
+      halToneOff();
+      elementState = false;
+      elementTimer = currentTime;
+    }
+  } else if (currentTime - elementTimer >= ditLength) {
+    elementIndex++;
+    if (morseCode[elementIndex] == '\0') {
+      elementActive = false;
+      return true;
+    }
+    halToneOn();
+    elementState = true;
+    elementTimer = currentTime;
+  }
+
+  return false;
+}
+
+void processKochSending() {
+  if (!kochSending || kochCharIndex >= (int)kochSentLength) {
+    if (kochSending) {
+      kochSending = false;
+      kochListening = true;
+      halToneOff();
+      consolePrintf("\nSending complete. Copy received:\n");
+      updateDisplay();
+    }
+    return;
+  }
+
+  unsigned long currentTime = halMillis();
+  char currentChar = kochSentText[kochCharIndex];
+  const char* morseCode = getMorseCode(currentChar);
+
+  if (currentChar == ' ' || morseCode[0] == '\0') {
+    if ((long)(currentTime - kochSendTimer) >= (long)wordSpaceThreshold) {
+      kochCharIndex++;
+      kochSendTimer = currentTime;
+    }
+  } else if (sendMorseCharacter(morseCode, currentTime)) {
+    kochCharIndex++;
+    kochSendTimer = currentTime + charSpaceThreshold;
+  }
+}
+
+void evaluateKochSession() {
+  if (kochReceivedText.length() == 0) {
+    consolePrintf("No characters to evaluate.\n");
+    return;
+  }
+
+  // Sent characters never copied count against the score
+  copyAligner.finish();
+  const AlignCounts& counts = copyAligner.counts();
+
+  kochAccuracy = (float)kochCorrect / kochTotal * 100.0;
+  stats.lessonAccuracy[kochLesson - 1] = kochAccuracy;
+  sessionLogSession(SLOG_SESSION_END, kochCorrect, kochTotal);
+
+  consolePrintf("\n=== LESSON RESULTS ===\n");
+  consolePrintf("Accuracy: %s%% (%d/%d)\n", fixedFloat(kochAccuracy, 1).c_str(), kochCorrect, kochTotal);
+  consolePrintf("Errors: %u wrong, %u extra, %u missed\n", counts.substitutions, counts.insertions, counts.deletions);
+
+  if (kochAccuracy >= 90.0) {
+    kochLesson++;
+    if (kochLesson > KOCH_LESSON_COUNT) kochLesson = KOCH_LESSON_COUNT;
+    kochCharSet = kochLessons[kochLesson - 1];
+    consolePrintf("Excellent! Advancing to lesson %d\n", kochLesson);
+
+    if (kochLesson > stats.highestLesson) {
+      stats.highestLesson = kochLesson;
+    }
+  } else {
+    consolePrintf("Practice more with lesson %d\n", kochLesson);
+  }
+
+  stats.sessionsCompleted++;
+  historyRecordSession(kochAccuracy, kochTotal);
+  saveSettings();
+  calculateKochTiming();
+  sendStatsToWiFi();
+  updateDisplay();
+}
+
+void calculateKochTiming() {
+  ditLength = 1200.0 / kochSpeed;
+  charSpaceThreshold = ditLength * 3.0;
+  wordSpaceThreshold = (1200.0 / kochEffectiveSpeed) * 7.0;
+}
+
+// QSO copy practice from the corpus; the button sends another over
+void startQSOSimulation() {
+  startLesson(generateLessonText(qsoGenerator(), 8), "QSO Practice:");
+}
+
+void continueQSOSimulation() {
+  startQSOSimulation();
+}
@@ -0,0 +1,740 @@
+#include "trainer_core.h"
+#include "trainer_protocol.h"
+#include "trainer_trace.h"
+#include "trainer_charstats.h"
+#include "trainer_export.h"
+#include "trainer_profiles.h"
+#include "trainer_history.h"
+#include "trainer_frame.h"
+#include "trainer_monitor.h"
+#include "trainer_spectrum.h"
+
+bool wifiEnabled = true;  // Set to true if you add WiFi module
+bool espConnected = false;
+unsigned long lastWiFiHeartbeat = 0;
+bool linkFramed = false;
+uint32_t linkBaud = LINK_BAUD_DEFAULT;
+
+// Status as the companion last heard it (see linkPoll)
+static FrameStatus statusSent;
+static bool statusSynced = false;  // a snapshot went out since the link came up
+static bool statusPending = false;  // a change is waiting for its window to close
+static unsigned long statusChangedAt = 0;
+static unsigned long lastSnapshotTime = 0;
+const unsigned long STATUS_COALESCE_WINDOW = 50;       // ms
+const unsigned long STATUS_SNAPSHOT_INTERVAL = 120000;  // full status as a resync
+static LinkCounters linkCounters;
+static void captureStatus(FrameStatus& s);
+static void sendStatusSnapshot(const FrameStatus& s);
+static void sendStatusDelta(const FrameStatus& s);
+static void flushDecoded();
+
+// Decoded characters waiting for the companion
+const int DECODED_BATCH_MAX = 32;
+const unsigned long DECODED_LATENCY = 2000;  // ms; the web page polls every five seconds
+static char decodedChars[DECODED_BATCH_MAX];  // DECODED_MISCOPY marks a mis-copy
+static unsigned long decodedTimes[DECODED_BATCH_MAX];
+static int decodedCount = 0;
+
+// Rate change after the HELLOs (see trainer_frame.h)
+enum BaudState : uint8_t { BAUD_SETTLED,
+                           BAUD_PROPOSED,   // BAUD: sent, waiting for BAUD_OK:
+                           BAUD_SWITCHED };  // at the new rate, waiting for a PONG
+static BaudState baudState = BAUD_SETTLED;
+static uint32_t baudTarget = 0;
+static unsigned long baudStateTime = 0;
+static bool baudGaveUp = false;  // until the next HELLO
+const unsigned long BAUD_ANSWER_TIMEOUT = 1000;  // ms
+
+// Output held while the rate moves (see linkHeld); released by baudSettle()
+const size_t HELD_LINES_MAX = 512;
+static char heldLines[HELD_LINES_MAX];  // NUL-terminated lines, oldest first
+static size_t heldLength = 0;
+static bool heldOverflow = false;  // lines were lost: resend everything
+static bool statsHeld = false;
+static bool currentHeld = false;  // currentMsg is waiting
+static FixedText<LESSON_TEXT_MAX + 16> currentMsg;
+
+// LINK BENCH: frames go out while fewer than BENCH_WINDOW are unanswered, and
+// each echo returns its credit, so the companion's buffers never overflow
+const int BENCH_WINDOW = 8;
+const unsigned long BENCH_STALL = 500;  // ms without an echo: the frames in flight are lost
+static struct {
+  bool active;
+  unsigned long start;
+  unsigned long end;
+  unsigned long lastEcho;
+  uint32_t next;      // index of the next frame to send
+  uint32_t expected;  // index of the next echo
+  int inFlight;
+} bench;
+
+static uint8_t linkRxBuffer[FRAME_ENCODED_MAX];
+static FrameReceiver linkRx;
+static uint8_t linkTxSeq = 0;
+
+static void linkSendFrame(uint8_t type, const void* body, size_t len) {
+  static uint8_t frame[FRAME_ENCODED_MAX];
+  size_t n = frameEncode(type, linkTxSeq++, body, len, frame);
+  halLinkWrite(frame, n);
+  linkCounters.txFrames++;
+  linkCounters.txBytes += n;
+}
+
+// Everything but the rate handshake waits while the rate moves: a companion
+// mid-switch would read it at the wrong rate
+bool linkHeld() {
+  return baudState != BAUD_SETTLED;
+}
+
+size_t linkSendStream(uint8_t type, const void* body, size_t len) {
+  if (!wifiEnabled || !espConnected || !linkFramed || linkHeld()) return 0;
+  unsigned long before = linkCounters.txBytes;
+  linkSendFrame(type, body, len);
+  return linkCounters.txBytes - before;
+}
+
+static void writeLine(const char* line) {
+  size_t len = strlen(line);
+  if (linkFramed && len <= FRAME_BODY_MAX) {
+    linkSendFrame(FRAME_TEXT, line, len);
+    return;
+  }
+  halLinkWriteLine(line);
+  linkCounters.txBytes += len + 2;
+}
+
+void linkWriteLine(const char* line) {
+  if (!linkHeld()) {
+    writeLine(line);
+    return;
+  }
+  size_t len = strlen(line) + 1;
+  if (heldLength + len > HELD_LINES_MAX) {
+    heldOverflow = true;
+    return;
+  }
+  memcpy(heldLines + heldLength, line, len);
+  heldLength += len;
+  linkCounters.linesHeld++;
+}
+
+void linkSendHello() {
+  FixedText<32> hello;
+  hello.set(PREFIX_HELLO);
+  hello.appendf("%d,%d,%lu", LINK_VERSION, LINK_CAP_FRAMES | LINK_CAP_ACKS | (halLinkFlowControl() ? LINK_CAP_FLOW : 0),
+                (unsigned long)halLinkMaxBaud());
+  halLinkWriteLine(hello.c_str());  // always text, the companion may predate frames
+}
+
+void linkPing() {
+  if (linkFramed) linkSendFrame(FRAME_PING, nullptr, 0);
+  else writeLine(MSG_PING);
+}
+
+static void setLinkBaud(uint32_t baud) {
+  if (baud == linkBaud) return;
+  halLinkSetBaud(baud);
+  linkBaud = baud;
+}
+
+// Highest rate both ends take, capped unless both have flow control
+static void negotiateBaud(uint32_t peerMax, bool peerFlow) {
+  uint32_t target = halLinkMaxBaud() < peerMax ? halLinkMaxBaud() : peerMax;
+  if (!(peerFlow && halLinkFlowControl()) && target > LINK_BAUD_UNPACED) target = LINK_BAUD_UNPACED;
+  if (target <= linkBaud || baudGaveUp) return;
+
+  FixedText<24> msg;
+  msg.set(PREFIX_BAUD);
+  msg.appendf("%lu", (unsigned long)target);
+  writeLine(msg.c_str());
+  baudTarget = target;
+  baudState = BAUD_PROPOSED;
+  baudStateTime = halMillis();
+}
+
+static void sendAllToWiFi() {
+  sendStatusToWiFi();
+  sendCharStatsToWiFi(true);
+  sendStatsToWiFi();
+  sendProfilesToWiFi();
+  sendHistoryToWiFi(true);
+}
+
+static void clearHeld() {
+  heldLength = 0;
+  heldOverflow = false;
+  statsHeld = false;
+  currentHeld = false;
+}
+
+// The rate stopped moving: a full status, then what was held in order, all
+// ahead of anything newer. The status goes first so a held ACK finds the
+// change it acknowledges already sent.
+static void baudSettle() {
+  baudState = BAUD_SETTLED;
+  statusSynced = false;  // the companion's state from before the switch may be garbled
+  if (!wifiEnabled || !espConnected) {
+    clearHeld();
+    return;
+  }
+  FrameStatus s;
+  captureStatus(s);
+  sendStatusSnapshot(s);
+  for (size_t at = 0; at < heldLength; at += strlen(heldLines + at) + 1) writeLine(heldLines + at);
+  if (currentHeld) writeLine(currentMsg.c_str());
+  bool stats = statsHeld;
+  bool overflow = heldOverflow;
+  clearHeld();
+  if (overflow) {
+    linkCounters.heldResyncs++;  // what did not fit is sent afresh; an ACK among it is not
+    sendAllToWiFi();
+  } else if (stats) {
+    sendStatsToWiFi();
+  }
+  flushDecoded();
+}
+
+static void baudAccepted(uint32_t rate) {
+  if (baudState != BAUD_PROPOSED) return;
+  if (rate != baudTarget) {
+    consolePrintf("Companion declined %lu baud\n", (unsigned long)baudTarget);
+    baudGaveUp = true;
+    baudSettle();
+    return;
+  }
+  setLinkBaud(rate);
+  baudState = BAUD_SWITCHED;
+  baudStateTime = halMillis();
+  linkPing();  // the PONG proves the new rate
+}
+
+static void baudTimeouts() {
+  if (baudState == BAUD_SETTLED || halMillis() - baudStateTime < BAUD_ANSWER_TIMEOUT) return;
+  if (baudState == BAUD_SWITCHED) {
+    consolePrintf("No answer at %lu baud, back to %lu\n", (unsigned long)linkBaud, (unsigned long)LINK_BAUD_DEFAULT);
+    setLinkBaud(LINK_BAUD_DEFAULT);
+  } else {
+    consolePrintf("Companion did not answer BAUD\n");
+  }
+  baudGaveUp = true;
+  baudSettle();
+}
+
+void linkDown() {
+  linkFramed = false;
+  monitorStop();  // the companion asks again once it has our HELLO
+  spectrumStop();
+  baudState = BAUD_SETTLED;
+  clearHeld();  // a restarted companion is sent everything afresh
+  bench.active = false;
+  setLinkBaud(LINK_BAUD_DEFAULT);  // where a restarted companion listens
+}
+
+// ---- Loopback benchmark -----------------------------------------------------------
+
+static void benchBody(uint32_t index, uint8_t* body) {
+  memcpy(body, &index, sizeof(index));
+  for (size_t i = sizeof(index); i < FRAME_BODY_MAX; i++) body[i] = (uint8_t)(index * 31 + i);
+}
+
+static void benchSend() {
+  static uint8_t body[FRAME_BODY_MAX];
+  while (bench.active && bench.inFlight < BENCH_WINDOW && halMillis() < bench.end) {
+    benchBody(bench.next++, body);
+    linkSendFrame(FRAME_BENCH, body, sizeof(body));
+    bench.inFlight++;
+  }
+}
+
+static void benchEcho() {
+  if (!bench.active || bench.inFlight == 0) return;
+  static uint8_t expected[FRAME_BODY_MAX];
+  uint32_t index;
+  memcpy(&index, linkRx.body, sizeof(index));
+  if (index < bench.expected || index >= bench.next) return;  // sent before a stall
+  linkCounters.benchLost += index - bench.expected;  // skipped over
+  bench.inFlight -= index - bench.expected;
+  bench.expected = index;
+  benchBody(bench.expected, expected);
+  if (linkRx.bodyLen == sizeof(expected) && memcmp(linkRx.body, expected, sizeof(expected)) == 0) {
+    linkCounters.benchFrames++;
+    linkCounters.benchBytes += linkRx.bodyLen;
+  } else {
+    linkCounters.benchErrors++;
+  }
+  bench.expected++;
+  bench.inFlight--;
+  bench.lastEcho = halMillis();
+  benchSend();  // the credit goes straight back out
+}
+
+void linkBenchStart(int seconds) {
+  if (!espConnected || !linkFramed) {
+    consolePrintf("LINK BENCH needs a framed companion link\n");
+    return;
+  }
+  memset(&bench, 0, sizeof(bench));
+  linkCounters.benchFrames = linkCounters.benchBytes = linkCounters.benchErrors = linkCounters.benchLost = 0;
+  linkCounters.benchMillis = 0;
+  bench.active = true;
+  bench.start = bench.lastEcho = halMillis();
+  bench.end = bench.start + (seconds > 0 ? seconds : 5) * 1000UL;
+  consolePrintf("Loopback for %d s at %lu baud...\n", seconds > 0 ? seconds : 5, (unsigned long)linkBaud);
+  benchSend();
+}
+
+static void benchService() {
+  if (!bench.active) return;
+  if (bench.inFlight > 0 && halMillis() - bench.lastEcho > BENCH_STALL) {
+    linkCounters.benchLost += bench.inFlight;
+    bench.expected = bench.next;
+    bench.inFlight = 0;
+    bench.lastEcho = halMillis();
+  }
+  if (halMillis() < bench.end) {
+    benchSend();
+    return;
+  }
+  if (bench.inFlight > 0) return;
+
+  bench.active = false;
+  linkCounters.benchMillis = halMillis() - bench.start;
+  unsigned long rate = linkCounters.benchMillis ? linkCounters.benchBytes * 1000ULL / linkCounters.benchMillis : 0;
+  consolePrintf("Loopback: %lu frames, %lu bytes/s each way (%lu%% of the line), %lu damaged, %lu lost\n",
+                linkCounters.benchFrames, rate, (unsigned long)(rate * 1000ULL / linkBaud), linkCounters.benchErrors,
+                linkCounters.benchLost);
+}
+
+// Typed frames become the lines they replace, so traces and replay see one protocol
+static void dispatchFrame() {
+  static char line[FRAME_BODY_MAX + 1];
+  switch (linkRx.type) {
+    case FRAME_TEXT:
+      memcpy(line, linkRx.body, linkRx.bodyLen);
+      line[linkRx.bodyLen] = '\0';
+      break;
+    case FRAME_PONG:
+      strcpy(line, MSG_PONG);
+      break;
+    case FRAME_BENCH:
+      benchEcho();
+      return;
+    default:
+      return;  // nothing else is sent to the Teensy yet
+  }
+  processWiFiMessage(line);
+}
+
+void linkReceiveByte(uint8_t c) {
+  if (!linkRx.buf) frameReceiverInit(&linkRx, linkRxBuffer, sizeof(linkRxBuffer));
+  switch (frameReceiveByte(&linkRx, c)) {
+    case FRAME_RX_TEXT:
+      processWiFiMessage((char*)linkRxBuffer);
+      break;
+    case FRAME_RX_FRAME:
+      dispatchFrame();
+      break;
+  }
+}
+
+void printLinkStats() {
+  consolePrintf("\n=== COMPANION LINK ===\n");
+  consolePrintf("Mode:        %s, %lu baud%s\n", linkFramed ? "framed" : "text", (unsigned long)linkBaud,
+                halLinkFlowControl() ? ", RTS/CTS" : "");
+  consolePrintf("Sent:        %lu frames, %lu bytes\n", linkCounters.txFrames, linkCounters.txBytes);
+  consolePrintf("Status:      %lu snapshots, %lu deltas, %lu bytes/min\n", linkCounters.statusSnapshots,
+                linkCounters.statusDeltas, halMillis() ? (unsigned long)(linkCounters.statusBytes * 60000ULL / halMillis()) : 0);
+  consolePrintf("Decoded:     %lu characters in %lu batches, %lu bytes\n", linkCounters.decodedChars,
+                linkCounters.decodedBatches, linkCounters.decodedBytes);
+  consolePrintf("Commands:    %lu acknowledged, %lu rejected\n", linkCounters.commands, linkCounters.commandsRejected);
+  consolePrintf("Held:        %lu lines over rate changes, %lu resent in full, %lu characters dropped\n",
+                linkCounters.linesHeld, linkCounters.heldResyncs, linkCounters.decodedDropped);
+  consolePrintf("Received:    %lu frames, %lu lines\n", (unsigned long)linkRx.frames, (unsigned long)linkRx.lines);
+  consolePrintf("Bad frames:  %lu\n", (unsigned long)linkRx.crcErrors);
+  consolePrintf("Lost frames: %lu\n", (unsigned long)linkRx.seqGaps);
+  consolePrintf("Overlong:    %lu\n", (unsigned long)linkRx.overflows);
+  consolePrintf("Garbled:     %lu lines\n", (unsigned long)linkRx.garbled);
+  if (linkCounters.benchMillis) {
+    consolePrintf("Last bench:  %lu frames in %lu ms, %lu damaged, %lu lost\n", linkCounters.benchFrames,
+                  linkCounters.benchMillis, linkCounters.benchErrors, linkCounters.benchLost);
+  }
+  consolePrintf("======================\n\n");
+}
+
+// A command from the web page, bare or inside CMD:
+static CommandResult companionCommand(char* command) {
+  command = trimLine(command);
+  if (startsWith(command, "TEENSY:")) return processRemoteCommand(command + 7);
+  if (strcmp(command, "START") == 0) {
+    startPracticeMode();
+  } else if (strcmp(command, "STOP") == 0) {
+    stopKochLesson();
+  } else if (strcmp(command, "RESET") == 0) {
+    resetAllStats();
+  } else {
+    return COMMAND_UNKNOWN;
+  }
+  sendStatusToWiFi();
+  return COMMAND_OK;
+}
+
+static void acknowledgeCommand(unsigned long id, CommandResult result) {
+  static const char* const names[] = { ACK_OK, ACK_RANGE, ACK_REFUSED, ACK_UNKNOWN };
+  // The change goes out ahead of its ACK, so the page reloads the new state
+  if (statusPending && espConnected && !linkHeld()) {
+    FrameStatus s;
+    captureStatus(s);
+    sendStatusDelta(s);
+  }
+  linkCounters.commands++;
+  if (result != COMMAND_OK) linkCounters.commandsRejected++;
+  if (!wifiEnabled || !espConnected) return;
+
+  FixedText<32> msg;
+  msg.set(PREFIX_ACK);
+  msg.appendf("%lu,%s", id, names[result]);
+  linkWriteLine(msg.c_str());
+}
+
+void processWiFiMessage(char* message) {
+  message = trimLine(message);
+  traceLinkLine(message);
+  // Strip optional ESP32 debug prefix
+  if (startsWith(message, "TEENSY >> ")) {
+    message = trimLine(message + 10);
+  }
+
+  // --- ESP32-S3 protocol handling ---
+  if (strcmp(message, MSG_PONG) == 0) {
+    lastWiFiHeartbeat = halMillis();
+    espConnected = true;
+    halSetLinkIndicator(true);
+    if (baudState == BAUD_SWITCHED) {
+      consolePrintf("Companion link at %lu baud\n", (unsigned long)linkBaud);
+      baudSettle();
+    }
+  } else if (startsWith(message, PREFIX_BAUD_OK)) {
+    baudAccepted(strtoul(message + strlen(PREFIX_BAUD_OK), nullptr, 10));
+  } else if (strcmp(message, "GET_STATUS") == 0) {
+    sendStatusToWiFi();
+  } else if (strcmp(message, "GET_STATS") == 0) {
+    sendStatsToWiFi();
+  } else if (strcmp(message, "GET_PROFILES") == 0) {
+    sendProfilesToWiFi();
+  } else if (strcmp(message, "GET_HISTORY") == 0) {
+    sendHistoryToWiFi(true);
+  } else if (startsWith(message, PREFIX_AUDIO)) {
+    if (atoi(message + strlen(PREFIX_AUDIO))) monitorStart();
+    else monitorStop();
+  } else if (startsWith(message, PREFIX_SPECTRUM)) {
+    const char* args = message + strlen(PREFIX_SPECTRUM);
+    if (strcmp(args, "0") == 0) spectrumStop();
+    else spectrumStartLine(args);
+  } else if (startsWith(message, PREFIX_CMD)) {
+    // CMD:<id>:<command>; a line without the id is not run, it cannot be answered
+    char* end;
+    unsigned long id = strtoul(message + strlen(PREFIX_CMD), &end, 10);
+    if (end != message + strlen(PREFIX_CMD) && *end == ':') acknowledgeCommand(id, companionCommand(end + 1));
+  } else
+
+    // Deprecated: original firmware expected a separate HEARTBEAT message which the ESP32 no longer sends.
+    // PONG handling (above) now refreshes lastWiFiHeartbeat, so ignore any legacy HEARTBEAT string.
+    if (strcmp(message, MSG_HEARTBEAT) == 0) {
+      // Intentionally left blank for backward compatibility
+    } else if (startsWith(message, PREFIX_HELLO)) {
+      // HELLO:<version>,<capabilities>[,<max baud>] answering ours
+      char* caps = strchr(message, ',');
+      char* maxBaud = caps ? strchr(caps + 1, ',') : nullptr;
+      int version = atoi(message + strlen(PREFIX_HELLO));
+      int capBits = caps ? atoi(caps + 1) : 0;
+      linkFramed = version >= 1 && (capBits & LINK_CAP_FRAMES);
+      if (!linkFramed) {
+        monitorStop();
+        spectrumStop();
+      }
+      linkRx.seqKnown = false;
+      statusSynced = false;  // a snapshot in the agreed form
+      consolePrintf("Companion link v%d, %s\n", version, linkFramed ? "framed" : "text");
+      baudGaveUp = false;
+      negotiateBaud(maxBaud ? strtoul(maxBaud + 1, nullptr, 10) : LINK_BAUD_DEFAULT, capBits & LINK_CAP_FLOW);
+    } else if (strcmp(message, MSG_READY_ESP01) == 0 || strcmp(message, MSG_READY_ESP32) == 0) {
+      espConnected = true;
+      lastWiFiHeartbeat = halMillis();
+      halSetLinkIndicator(true);
+      consolePrintf("WiFi companion reconnected\n");
+      // A restarted companion talks text at the default rate until it has our HELLO again
+      linkDown();
+      statusSynced = false;
+      linkSendHello();
+      sendAllToWiFi();
+    } else if (startsWith(message, PREFIX_IMPORT)) {
+      importLine(message + strlen(PREFIX_IMPORT), EXPORT_LINK);
+    } else {
+      companionCommand(message);
+    }
+}
+
+CommandResult processRemoteCommand(char* command) {
+  command = trimLine(command);
+  consolePrintf("WiFi Command: %s\n", command);
+  CommandResult result = COMMAND_OK;
+
+  if (strcmp(command, "START_KOCH") == 0) {
+    kochModeEnabled = true;
+    currentPracticeMode = KOCH_TRAINING;
+    startKochLesson();
+  } else if (strcmp(command, "CALLSIGN_PRACTICE") == 0) {
+    currentPracticeMode = CALLSIGN_PRACTICE;
+    generateCallsignLesson();
+  } else if (strcmp(command, "QSO_SIMULATION") == 0) {
+    currentPracticeMode = QSO_SIMULATION;
+    startQSOSimulation();
+  } else if (strcmp(command, "TOGGLE_DECODER") == 0) {
+    decoderEnabled = !decoderEnabled;
+    if (decoderEnabled) {
+      resetDecoder();
+    }
+  } else if (startsWith(command, "SET_FREQ:")) {
+    int freq = atoi(command + 9);
+    if (freq >= 300 && freq <= 1200) {
+      sidetoneFreq = freq;
+      applySettings();
+    } else {
+      result = COMMAND_RANGE;
+    }
+  } else if (startsWith(command, "SET_SPEED:")) {
+    int speed = atoi(command + 10);
+    if (speed >= 5 && speed <= 50) {
+      kochSpeed = speed;
+      kochEffectiveSpeed = speed * 0.6 > 5 ? speed * 0.6 : 5;  // Auto-adjust Farnsworth
+      applySettings();
+    } else {
+      result = COMMAND_RANGE;
+    }
+  } else if (startsWith(command, "SET_LESSON:")) {
+    int lesson = atoi(command + 11);
+    if (lesson >= 1 && lesson <= KOCH_LESSON_COUNT) {
+      kochLesson = lesson;
+      initializeKoch();
+    } else {
+      result = COMMAND_RANGE;
+    }
+  } else if (strcmp(command, "STOP_TRAINING") == 0) {
+    stopKochLesson();
+  } else if (strcmp(command, "REPEAT_LESSON") == 0) {
+    if (kochModeEnabled) {
+      startKochLesson();
+    } else {
+      result = COMMAND_REFUSED;
+    }
+  } else if (startsWith(command, "PROFILE_NAME:")) {
+    renameProfile(command + 13);
+  } else if (startsWith(command, "PROFILE:")) {
+    int profile = atoi(command + 8) - 1;
+    if (profile < 0 || profile >= PROFILE_COUNT) result = COMMAND_RANGE;
+    else if (profile != profiles.active && !switchProfile(profile)) result = COMMAND_REFUSED;
+  } else if (strcmp(command, "EXPORT BIN") == 0) {
+    exportStart(EXPORT_BINARY, EXPORT_LINK);
+  } else if (strcmp(command, "EXPORT CSV") == 0) {
+    exportStart(EXPORT_CSV, EXPORT_LINK);
+  } else if (strcmp(command, "EVALUATE_SESSION") == 0) {
+    if (kochModeEnabled) {
+      evaluateKochSession();
+    } else {
+      result = COMMAND_REFUSED;
+    }
+  } else {
+    result = COMMAND_UNKNOWN;
+  }
+
+  // Send updated status after processing command
+  sendStatusToWiFi();
+  return result;
+}
+
+static void captureStatus(FrameStatus& s) {
+  s.lesson = kochLesson;
+  s.speed = kochSpeed;
+  s.effectiveSpeed = kochEffectiveSpeed;
+  s.waveform = currentWaveform;
+  s.frequency = (uint16_t)(sidetoneFreq + 0.5f);
+  s.accuracy = (uint16_t)(kochAccuracy * 10 + 0.5f);
+  s.flags = (decoderEnabled ? STATUS_DECODER : 0) | (kochModeEnabled ? STATUS_KOCH : 0) | (useHeadphones ? STATUS_HEADPHONES : 0) | (kochSending ? STATUS_SENDING : 0) | (kochListening ? STATUS_LISTENING : 0);
+}
+
+// STATUS: line with the fields in mask; of the flags only those in flagMask.
+// The companion's parser takes any subset of the keys.
+static void writeStatusLine(const FrameStatus& s, uint8_t mask, uint8_t flagMask) {
+  static FixedText<192> fields;  // each with a leading comma
+  fields.clear();
+  if (mask & (1 << 0)) fields.appendf(",LESSON=%u", s.lesson);
+  if (mask & (1 << 4)) fields.appendf(",FREQ=%u", s.frequency);
+  if (mask & (1 << 1)) fields.appendf(",SPEED=%u", s.speed);
+  if (mask & (1 << 2)) fields.appendf(",EFFSPEED=%u", s.effectiveSpeed);
+  if (mask & (1 << 5)) fields.appendf(",ACC=%u.%u", s.accuracy / 10, s.accuracy % 10);
+  if (flagMask & STATUS_DECODER) fields.appendf(",DEC=%d", s.flags & STATUS_DECODER ? 1 : 0);
+  if (flagMask & STATUS_KOCH) fields.appendf(",KOCH=%d", s.flags & STATUS_KOCH ? 1 : 0);
+  if (mask & (1 << 3)) fields.appendf(",WAVE=%s", waveformNames[s.waveform]);
+  if (flagMask & STATUS_HEADPHONES) fields.appendf(",OUT=%s", s.flags & STATUS_HEADPHONES ? "Headphones" : "Speaker");
+  if (flagMask & STATUS_SENDING) fields.appendf(",SEND=%d", s.flags & STATUS_SENDING ? 1 : 0);
+  if (flagMask & STATUS_LISTENING) fields.appendf(",LISTEN=%d", s.flags & STATUS_LISTENING ? 1 : 0);
+
+  static FixedText<192> status;
+  status.set(PREFIX_STATUS);
+  status.append(fields.c_str() + 1);
+  linkWriteLine(status.c_str());
+}
+
+// The whole status; the companion's copy is in step afterwards
+static void sendStatusSnapshot(const FrameStatus& s) {
+  unsigned long before = linkCounters.txBytes;
+  if (linkFramed) linkSendFrame(FRAME_STATUS, &s, sizeof(s));
+  else writeStatusLine(s, (1 << STATUS_FIELD_COUNT) - 1, 0xFF);
+  statusSent = s;
+  statusSynced = true;
+  statusPending = false;
+  lastSnapshotTime = halMillis();
+  linkCounters.statusSnapshots++;
+  linkCounters.statusBytes += linkCounters.txBytes - before;
+}
+
+// Only what changed since the companion last heard
+static void sendStatusDelta(const FrameStatus& s) {
+  statusPending = false;
+  uint8_t mask = frameStatusChanges(&s, &statusSent);
+  if (!mask) return;  // changed and changed back within the window
+  unsigned long before = linkCounters.txBytes;
+  if (linkFramed) {
+    uint8_t body[1 + sizeof(FrameStatus)];
+    linkSendFrame(FRAME_STATUS_DELTA, body, frameStatusDelta(&s, mask, body));
+  } else {
+    writeStatusLine(s, mask, s.flags ^ statusSent.flags);
+  }
+  statusSent = s;
+  linkCounters.statusDeltas++;
+  linkCounters.statusBytes += linkCounters.txBytes - before;
+}
+
+// One DECODED frame with the character times, or for a text link the DECODED
+// line the companion always understood
+static void flushDecoded() {
+  if (decodedCount == 0) return;
+  unsigned long before = linkCounters.txBytes;
+  if (linkFramed) {
+    uint8_t body[sizeof(FrameDecoded) + DECODED_BATCH_MAX * sizeof(FrameDecodedChar)];
+    FrameDecoded head = { (uint32_t)decodedTimes[0] };
+    memcpy(body, &head, sizeof(head));
+    size_t len = sizeof(head);
+    for (int i = 0; i < decodedCount; i++) {
+      unsigned long gap = i ? decodedTimes[i] - decodedTimes[i - 1] : 0;
+      FrameDecodedChar entry = { (uint8_t)decodedChars[i], (uint16_t)(gap < 0xFFFF ? gap : 0xFFFF) };
+      memcpy(body + len, &entry, sizeof(entry));
+      len += sizeof(entry);
+    }
+    linkSendFrame(FRAME_DECODED, body, len);
+  } else {
+    static FixedText<DECODED_BATCH_MAX * 3 + 16> msg;
+    msg.set(PREFIX_DECODED);
+    for (int i = 0; i < decodedCount; i++) {
+      char c = decodedChars[i] & ~DECODED_MISCOPY;
+      if (decodedChars[i] & DECODED_MISCOPY) msg.appendf("[%c]", c);
+      else msg.append(c);
+    }
+    linkWriteLine(msg.c_str());
+  }
+  linkCounters.decodedBatches++;
+  linkCounters.decodedChars += decodedCount;
+  linkCounters.decodedBytes += linkCounters.txBytes - before;
+  decodedCount = 0;
+}
+
+// Status goes out field by field: the first change opens a short window, and
+// everything that changed by its end is sent in one delta. Polling from
+// trainerTick() guarantees the trailing flush, so the companion always ends up
+// with the final state. A full snapshot follows a (re)connect or a baud
+// change and repeats as a resync; nothing goes out while the rate is moving.
+void linkPoll() {
+  if (!wifiEnabled || !espConnected) return;
+
+  baudTimeouts();
+  if (linkHeld()) return;
+  benchService();
+  if (decodedCount > 0 && halMillis() - decodedTimes[0] >= DECODED_LATENCY) flushDecoded();
+
+  FrameStatus s;
+  captureStatus(s);
+  if (!statusSynced || halMillis() - lastSnapshotTime >= STATUS_SNAPSHOT_INTERVAL) {
+    sendStatusSnapshot(s);
+    return;
+  }
+  if (!statusPending) {
+    if (memcmp(&s, &statusSent, sizeof(s)) == 0) return;
+    statusPending = true;
+    statusChangedAt = halMillis();
+  }
+  if (halMillis() - statusChangedAt >= STATUS_COALESCE_WINDOW) sendStatusDelta(s);
+}
+
+// Status may have changed: open the window now rather than at the next poll
+void sendStatusToWiFi() {
+  linkPoll();
+}
+
+const LinkCounters& linkStats() {
+  return linkCounters;
+}
+
+void sendStatsToWiFi() {
+  if (!wifiEnabled || !espConnected) return;
+  if (linkHeld()) {
+    statsHeld = true;
+    return;
+  }
+
+  if (linkFramed) {
+    FrameStats s;
+    s.sessions = stats.sessionsCompleted;
+    s.characters = stats.charactersDecoded;
+    s.bestWpm = (uint16_t)(stats.bestWPM * 10 + 0.5f);
+    linkSendFrame(FRAME_STATS, &s, sizeof(s));
+    sendCharStatsToWiFi(false);
+    return;
+  }
+
+  static FixedText<96> statsMsg;
+  statsMsg.set(PREFIX_STATS);
+  statsMsg.appendf("SESSIONS=%lu,", stats.sessionsCompleted);
+  statsMsg.appendf("CHARS=%lu,", stats.charactersDecoded);
+  statsMsg.append("BESTWPM=");
+  statsMsg.appendFloat(stats.bestWPM, 1);
+
+  linkWriteLine(statsMsg.c_str());
+  sendCharStatsToWiFi(false);
+}
+
+// Characters are queued with their time and leave at the end of a word (a
+// space), when the batch is full or DECODED_LATENCY after the first one.
+// While the rate moves they only queue; a full batch then drops the newest.
+void sendDecodedCharToWiFi(char c, bool miscopied) {
+  if (!wifiEnabled || !espConnected) return;
+  if (decodedCount == DECODED_BATCH_MAX) {
+    linkCounters.decodedDropped++;
+    return;
+  }
+
+  decodedChars[decodedCount] = miscopied ? c | DECODED_MISCOPY : c;
+  decodedTimes[decodedCount++] = halMillis();
+  if (linkHeld()) return;
+  if (c == ' ' || decodedCount == DECODED_BATCH_MAX) flushDecoded();
+}
+
+// Only the newest text matters, so a held one is replaced rather than queued
+void sendCurrentTextToWiFi(const char* text) {
+  if (!wifiEnabled || !espConnected) return;
+
+  currentMsg.set(PREFIX_CURRENT);
+  currentMsg.append(text);
+  currentHeld = linkHeld();
+  if (!currentHeld) writeLine(currentMsg.c_str());
+}
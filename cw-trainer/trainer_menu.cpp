@@ -0,0 +1,294 @@
+#include "trainer_core.h"
+#include "trainer_trace.h"
+#include "trainer_profiles.h"
+
+// Menu system
+MenuMode currentMenu = MAIN_SCREEN;
+int menuSelection = 0;
+bool inMenu = false;
+bool editMode = false;
+static int menuProfile = 0;  // profile picked in the Koch menu, switched to on confirm
+
+// Text framebuffer the menu and main screen render into
+static TextScreen screen;
+static int screenRow = 0;
+
+static void screenPrintf(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+static void screenPrintf(const char* fmt, ...) {
+  if (screenRow >= SCREEN_TEXT_ROWS) return;
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(screen.rows[screenRow], sizeof(screen.rows[screenRow]), fmt, ap);
+  va_end(ap);
+  screenRow++;
+}
+
+// Rotary encoder helper: return number of items in each menu
+static int getMenuItemCount(MenuMode menu) {
+  switch (menu) {
+    case KOCH_MENU: return 4;      // Start, Lesson, Speed, Profile
+    case PRACTICE_MENU: return 5;  // Koch, Callsign, QSO, Contest, Custom
+    case SETTINGS_MENU: return 7;  // Freq, Vol, Waveform, Output, Decoder, Input, Koch Mode
+    case STATS_MENU: return 1;     // Stats page only
+    case QSO_MENU: return 3;       // Start, Contest, Ragchew
+    default: return 4;
+  }
+}
+
+static void handleMenuSelection() {
+  switch (currentMenu) {
+    case KOCH_MENU:
+      if (menuSelection == 0) {  // Start Koch lesson
+        kochModeEnabled = true;
+        currentPracticeMode = KOCH_TRAINING;
+        startKochLesson();
+        inMenu = false;
+      } else if (menuSelection == 1) {  // Set lesson
+        // Implement lesson selection
+        inMenu = false;
+      } else if (menuSelection == 3) {  // Profile edit
+        menuProfile = profiles.active;
+        editMode = true;
+        updateDisplay();
+      }
+      break;
+
+    case PRACTICE_MENU:
+      currentPracticeMode = (PracticeMode)menuSelection;
+      startPracticeMode();
+      inMenu = false;
+      break;
+
+    case SETTINGS_MENU:
+      switch (menuSelection) {
+        case 2:  // Waveform edit
+          editMode = true;
+          break;
+        case 3:  // Output toggle edit
+          editMode = true;
+          break;
+        case 4:  // Decoder toggle
+          decoderEnabled = !decoderEnabled;
+          if (decoderEnabled) {
+            resetDecoder();
+          }
+          applySettings();
+          updateDisplay();
+          break;
+        case 5:  // Input toggle
+          useExternalAudio = !useExternalAudio;
+          updateAudioInput();
+          applySettings();
+          updateDisplay();
+          break;
+        case 6:  // Koch Mode toggle
+          kochModeEnabled = !kochModeEnabled;
+          if (kochModeEnabled) {
+            currentPracticeMode = KOCH_TRAINING;
+            startKochLesson();
+          } else {
+            stopKochLesson();
+          }
+          applySettings();
+          updateDisplay();
+          break;
+        default:
+          // Non-editable items (Freq/Vol)
+          break;
+      }
+      // Remain in menu unless entering editMode
+      break;
+
+    case STATS_MENU:
+      // Display detailed stats
+      displayDetailedStats();
+      break;
+
+    case QSO_MENU:
+      startQSOSimulation();
+      inMenu = false;
+      break;
+
+    default:
+      inMenu = false;
+      break;
+  }
+}
+
+// Menu / select button released before the long-press threshold
+void menuShortPress() {
+  traceButton(false);
+  if (!inMenu) {
+    inMenu = true;
+    currentMenu = KOCH_MENU;
+    menuSelection = 0;
+    updateDisplay();
+  } else if (!editMode) {
+    handleMenuSelection();
+  } else {
+    editMode = false;
+    if (currentMenu == KOCH_MENU && menuSelection == 3) switchProfile(menuProfile);
+    applySettings();
+    updateDisplay();
+  }
+}
+
+// Menu / select button held past the long-press threshold: leave the menu
+void menuLongPress() {
+  traceButton(true);
+  if (inMenu || editMode) {
+    inMenu = false;
+    editMode = false;
+    updateDisplay();
+  }
+}
+
+// Encoder moved by delta detents
+void menuRotate(int delta) {
+  traceEncoder(delta);
+  if (inMenu && !editMode) {
+    int itemCount = getMenuItemCount(currentMenu);
+    menuSelection = ((menuSelection + delta) % itemCount + itemCount) % itemCount;
+    updateDisplay();
+  } else if (editMode) {
+    switch (currentMenu) {
+      case SETTINGS_MENU:
+        if (menuSelection == 2) {  // Waveform
+          currentWaveform = ((currentWaveform + delta) % 4 + 4) % 4;
+          updateWaveform();
+        } else if (menuSelection == 3) {  // Output
+          useHeadphones = !useHeadphones;
+          updateOutputRouting();
+        }
+        break;
+      case KOCH_MENU:
+        if (menuSelection == 3) {  // Profile
+          menuProfile = ((menuProfile + delta) % PROFILE_COUNT + PROFILE_COUNT) % PROFILE_COUNT;
+        }
+        break;
+      default:
+        break;
+    }
+    updateDisplay();
+  }
+}
+
+static void displayMenu() {
+  switch (currentMenu) {
+    case KOCH_MENU:
+      screenPrintf("KOCH TRAINING");
+      screenPrintf("> Start Lesson");
+      screenPrintf("  Set Lesson #");
+      screenPrintf("  Speed Control");
+      screenPrintf("  Profile: %s", profileName(editMode ? menuProfile : profiles.active));
+      break;
+
+    case PRACTICE_MENU:
+      screenPrintf("PRACTICE MODES");
+      screenPrintf("- Koch Method");
+      screenPrintf("- Callsigns");
+      screenPrintf("- QSO Simulation");
+      screenPrintf("- Contest Mode");
+      screenPrintf("- Custom Lesson");
+      break;
+
+    case SETTINGS_MENU:
+      screenPrintf("SETTINGS");
+      screenPrintf("Freq: %d Hz", (int)(sidetoneFreq + 0.5f));
+      screenPrintf("Vol: %d%%", (int)(volume * 100 + 0.5f));
+      screenPrintf("Waveform: %s", waveformNames[currentWaveform]);
+      screenPrintf("Output: %s", useHeadphones ? "HP" : "SPK");
+      screenPrintf("Decoder: %s", decoderEnabled ? "On" : "Off");
+      screenPrintf("Input: %s", useExternalAudio ? "EXT" : "INT");
+      screenPrintf("Koch Mode: %s", kochModeEnabled ? "On" : "Off");
+      break;
+
+    case STATS_MENU:
+      {
+        screenPrintf("STATISTICS");
+        screenPrintf("Sessions: %lu", stats.sessionsCompleted);
+        FixedText<22> line;
+        line.append("Best WPM: ");
+        line.appendFloat(stats.bestWPM, 1);
+        screenPrintf("%s", line.c_str());
+        screenPrintf("Chars: %lu", stats.charactersDecoded);
+        line.set("Accuracy: ");
+        line.appendFloat(stats.averageAccuracy, 1);
+        line.append('%');
+        screenPrintf("%s", line.c_str());
+      }
+      break;
+
+    case QSO_MENU:
+      screenPrintf("QSO SIMULATOR");
+      screenPrintf("- Start QSO");
+      screenPrintf("- Contest Mode");
+      screenPrintf("- Ragchew");
+      break;
+
+    default:
+      screenPrintf("MAIN MENU");
+      break;
+  }
+}
+
+static void displayMainScreen() {
+  // Line 1: Mode and lesson
+  if (kochModeEnabled) {
+    screenPrintf("Koch L%d: %s", kochLesson, kochCharSet);
+  } else {
+    screenPrintf("Mode: %s", practiceModeNames[currentPracticeMode]);
+  }
+
+  // Line 2: Frequency and waveform
+  screenPrintf("%dHz %s", (int)(sidetoneFreq + 0.5f), waveformNames[currentWaveform]);
+
+  // Line 3: Speed and volume
+  screenPrintf("Spd:%d/%d Vol:%d%%", kochSpeed, kochEffectiveSpeed, (int)(volume * 100 + 0.5f));
+
+  // Line 4: Status indicators
+  FixedText<22> line;
+  line.append(decoderEnabled ? "DEC " : "");
+  line.append(useHeadphones ? "HP " : "SPK ");
+  line.append(useExternalAudio ? "EXT " : "INT ");
+  line.append((wifiEnabled && espConnected) ? "WiFi" : "");
+  screenPrintf("%s", line.c_str());
+
+  // Line 5-6: Current activity
+  if (kochSending) {
+    screenPrintf("Sending...");
+    screenPrintf("Char %d/%u", kochCharIndex, (unsigned)kochSentLength);
+  } else if (kochListening) {
+    screenPrintf("Listening...");
+    line.set("Acc: ");
+    line.appendFloat(kochAccuracy, 1);
+    line.append('%');
+    screenPrintf("%s", line.c_str());
+  } else if (stats.charactersDecoded > 0) {
+    line.set("WPM: ");
+    line.appendFloat(currentWPM, 1);
+    screenPrintf("%s", line.c_str());
+    screenPrintf("Total: %lu chars", stats.charactersDecoded);
+  } else if (wifiEnabled && espConnected) {
+    screenPrintf("WiFi Ready");
+    screenPrintf("Web control active");
+  }
+
+  // Line 7-8: Recent decoded text (last 21 chars)
+  char recentText[SCREEN_TEXT_COLS + 1];
+  decodedText.tail(recentText, sizeof(recentText));
+  screenPrintf("%s", recentText);
+}
+
+void updateDisplay() {
+  memset(&screen, 0, sizeof(screen));
+  screenRow = 0;
+
+  if (inMenu) {
+    displayMenu();
+  } else {
+    displayMainScreen();
+  }
+
+  halDisplayShow(screen);
+}
@@ -0,0 +1,236 @@
+#include "trainer_monitor.h"
+#include "trainer_frame.h"
+#include <math.h>
+
+static const int16_t adpcmSteps[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+  107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+  876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428,
+  4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+  22385, 24623, 27086, 29794, 32767
+};
+static const int8_t adpcmIndexSteps[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+int16_t adpcmDecode(AdpcmState& s, uint8_t code) {
+  int step = adpcmSteps[s.index];
+  int diff = step >> 3;
+  if (code & 4) diff += step;
+  if (code & 2) diff += step >> 1;
+  if (code & 1) diff += step >> 2;
+  int predictor = s.predictor + ((code & 8) ? -diff : diff);
+  s.predictor = predictor > 32767 ? 32767 : predictor < -32768 ? -32768 : predictor;
+  int index = s.index + adpcmIndexSteps[code & 7];
+  s.index = index < 0 ? 0 : index > 88 ? 88 : index;
+  return s.predictor;
+}
+
+uint8_t adpcmEncode(AdpcmState& s, int16_t sample) {
+  int step = adpcmSteps[s.index];
+  int diff = sample - s.predictor;
+  uint8_t code = 0;
+  if (diff < 0) {
+    code = 8;
+    diff = -diff;
+  }
+  if (diff >= step) {
+    code |= 4;
+    diff -= step;
+  }
+  step >>= 1;
+  if (diff >= step) {
+    code |= 2;
+    diff -= step;
+  }
+  step >>= 1;
+  if (diff >= step) code |= 1;
+  adpcmDecode(s, code);  // track the decoder exactly, so rounding never drifts apart
+  return code;
+}
+
+// Fourth-order Butterworth low-pass, two biquads, well below the 4 kHz
+// Nyquist limit: the square and sawtooth sidetones are rich in harmonics
+const float MONITOR_CUTOFF = 3400;  // Hz
+static const float biquadQ[2] = { 0.5412f, 1.3066f };
+
+struct Biquad {
+  float b0, b1, b2, a1, a2;
+  float z1, z2;
+};
+
+static Biquad lowpass[2];
+static bool active = false;
+static MonitorCounters counters;
+
+// Resampling: the next output falls this far (in input samples) past the
+// previous filtered input sample
+static const float resampleStep = MONITOR_INPUT_RATE / MONITOR_RATE;
+static float resamplePos;
+static float previous;
+
+// The frame being filled
+static uint8_t frameBody[sizeof(FrameAudio) + MONITOR_FRAME_SAMPLES / 2];
+static FrameAudio frameHead;
+static int frameSamples;
+static AdpcmState coder;
+static uint32_t sampleIndex;  // of the next coded sample
+static uint32_t droppedSeen;
+
+static void designLowpass() {
+  float w0 = 2 * (float)M_PI * MONITOR_CUTOFF / MONITOR_INPUT_RATE;
+  for (int i = 0; i < 2; i++) {
+    float alpha = sinf(w0) / (2 * biquadQ[i]);
+    float a0 = 1 + alpha;
+    Biquad& f = lowpass[i];
+    f.b0 = (1 - cosf(w0)) / 2 / a0;
+    f.b1 = (1 - cosf(w0)) / a0;
+    f.b2 = f.b0;
+    f.a1 = -2 * cosf(w0) / a0;
+    f.a2 = (1 - alpha) / a0;
+    f.z1 = f.z2 = 0;
+  }
+}
+
+static inline float filter(Biquad& f, float x) {
+  float y = f.b0 * x + f.z1;
+  f.z1 = f.b1 * x - f.a1 * y + f.z2;
+  f.z2 = f.b2 * x - f.a2 * y;
+  return y;
+}
+
+static void sendFrame() {
+  unsigned long age = halMillis() - frameHead.time;
+  frameHead.age = age < 0xFFFF ? age : 0xFFFF;
+  memcpy(frameBody, &frameHead, sizeof(frameHead));
+  size_t n = linkSendStream(FRAME_AUDIO, frameBody, sizeof(frameBody));
+  frameSamples = 0;
+  if (n == 0) return;
+  counters.frames++;
+  counters.bytes += n;
+  counters.ageTotal += age;
+  if (age > counters.ageMax) counters.ageMax = age;
+}
+
+static void codeSample(float x, uint32_t captured) {
+  if (frameSamples == 0) {
+    frameHead.sample = sampleIndex;
+    frameHead.time = captured;
+    frameHead.predictor = coder.predictor;
+    frameHead.index = coder.index;
+  }
+  int16_t v = x > 32767 ? 32767 : x < -32768 ? -32768 : (int16_t)lrintf(x);
+  uint8_t code = adpcmEncode(coder, v);
+  float error = (float)v - coder.predictor;
+  counters.signalEnergy += (float)v * v;
+  counters.errorEnergy += error * error;
+
+  uint8_t* codes = frameBody + sizeof(FrameAudio);
+  if (frameSamples & 1) codes[frameSamples / 2] |= code << 4;
+  else codes[frameSamples / 2] = code;
+  frameSamples++;
+  sampleIndex++;
+  counters.samples++;
+  if (frameSamples == MONITOR_FRAME_SAMPLES) sendFrame();
+}
+
+// One input block, its last sample captured about now
+static void processBlock(const int16_t* block, uint32_t now) {
+  for (int i = 0; i < MONITOR_BLOCK_SAMPLES; i++) {
+    float y = filter(lowpass[1], filter(lowpass[0], block[i]));
+    while (resamplePos <= 1) {
+      uint32_t captured = now - (uint32_t)((MONITOR_BLOCK_SAMPLES - i) * 1000 / MONITOR_INPUT_RATE);
+      codeSample(previous + (y - previous) * resamplePos, captured);
+      resamplePos += resampleStep;
+    }
+    resamplePos -= 1;
+    previous = y;
+  }
+}
+
+bool monitorStart() {
+  if (!wifiEnabled || !espConnected || !linkFramed) {
+    consolePrintf("Audio monitor needs a framed companion link\n");
+    return false;
+  }
+  // Framing adds type, sequence, CRC, COBS and two delimiters
+  float need = (sizeof(frameBody) + 7) * (float)MONITOR_RATE / MONITOR_FRAME_SAMPLES;
+  if (need > linkBaud / 10 * MONITOR_LINK_SHARE_MAX) {
+    consolePrintf("Audio monitor needs %s bytes/s, too much for %lu baud\n", fixedFloat(need, 0).c_str(),
+                  (unsigned long)linkBaud);
+    return false;
+  }
+  if (active) return true;
+
+  designLowpass();
+  resamplePos = 1;
+  previous = 0;
+  frameSamples = 0;
+  coder = { 0, 0 };
+  sampleIndex = 0;
+  droppedSeen = 0;
+  counters = MonitorCounters();
+  counters.startedAt = halMillis();
+  halMonitorCapture(true);
+  active = true;
+  consolePrintf("Audio monitor on\n");
+  return true;
+}
+
+void monitorStop() {
+  if (!active) return;
+  halMonitorCapture(false);
+  active = false;
+  consolePrintf("Audio monitor off after %lu frames\n", counters.frames);
+}
+
+bool monitorActive() {
+  return active;
+}
+
+void monitorPoll() {
+  if (!active) return;
+  if (!espConnected || !linkFramed) {
+    monitorStop();
+    return;
+  }
+  static int16_t block[MONITOR_BLOCK_SAMPLES];
+  while (halMonitorRead(block) > 0) {
+    uint32_t start = halMicros();
+    uint32_t dropped = halMonitorDropped();
+    if (dropped != droppedSeen) {
+      // The lost audio becomes a gap in the sample numbers, not a shifted timeline
+      counters.droppedBlocks += dropped - droppedSeen;
+      sampleIndex += (uint32_t)((dropped - droppedSeen) * MONITOR_BLOCK_SAMPLES / resampleStep);
+      droppedSeen = dropped;
+      frameSamples = 0;
+    }
+    processBlock(block, halMillis());
+    counters.encodeMicros += halMicros() - start;
+    counters.blocks++;
+  }
+}
+
+const MonitorCounters& monitorStats() {
+  return counters;
+}
+
+void printMonitorStats() {
+  unsigned long elapsed = halMillis() - counters.startedAt;
+  float rate = elapsed ? counters.bytes * 1000.0f / elapsed : 0;
+  consolePrintf("\n=== AUDIO MONITOR ===\n");
+  consolePrintf("State:      %s, %lu Hz IMA-ADPCM, %d ms frames\n", active ? "on" : "off", (unsigned long)MONITOR_RATE,
+                (int)(MONITOR_FRAME_SAMPLES * 1000 / MONITOR_RATE));
+  consolePrintf("Sent:       %lu frames, %lu bytes, %s bytes/s (%s%% of %lu baud)\n", counters.frames,
+                counters.bytes, fixedFloat(rate, 0).c_str(), fixedFloat(rate * 1000 / linkBaud, 0).c_str(),
+                (unsigned long)linkBaud);
+  consolePrintf("Latency:    %lu ms average capture to send, %lu max\n",
+                counters.frames ? counters.ageTotal / counters.frames : 0, counters.ageMax);
+  consolePrintf("Coding SNR: %s dB\n",
+                fixedFloat(counters.errorEnergy > 0 ? 10 * log10(counters.signalEnergy / counters.errorEnergy) : 0.0,
+                           1).c_str());
+  consolePrintf("Loop cost:  %lu us per block, %s%% of the CPU\n",
+                counters.blocks ? counters.encodeMicros / counters.blocks : 0,
+                fixedFloat(elapsed ? counters.encodeMicros / 10.0f / elapsed : 0.0f, 2).c_str());
+  consolePrintf("Dropped:    %lu blocks\n", counters.droppedBlocks);
+  consolePrintf("Audio CPU:  %s%% peak\n", fixedFloat(halAudioLoadPeak(), 1).c_str());
+  consolePrintf("=====================\n\n");
+}
@@ -0,0 +1,52 @@
+#ifndef TRAINER_MONITOR_H
+#define TRAINER_MONITOR_H
+
+// Live audio for the web page. While the companion asks for it (AUDIO:1) the
+// platform copies the decode mix (sidetone or radio input) out of the audio
+// graph a block at a time; monitorPoll() collects the blocks from the main
+// loop, never the audio interrupt, low-passes them, resamples to MONITOR_RATE
+// and codes them as IMA-ADPCM at 4 bits a sample. Every MONITOR_FRAME_SAMPLES
+// leave as one FRAME_AUDIO (trainer_frame.h), so only framed links carry it:
+// about 4.9 kB/s, 43% of a 115200 baud link.
+
+#include "trainer_core.h"
+
+const float MONITOR_INPUT_RATE = 44117.647f;  // Teensy AUDIO_SAMPLE_RATE_EXACT
+const uint32_t MONITOR_RATE = 8000;
+const int MONITOR_BLOCK_SAMPLES = 128;   // input block, as the audio library hands it over
+const int MONITOR_QUEUE_BLOCKS = 8;     // waiting for the loop, 23 ms; more are dropped
+const int MONITOR_FRAME_SAMPLES = 160;   // 20 ms per frame
+const float MONITOR_LINK_SHARE_MAX = 0.6f;  // of the link's bytes/s; slower links are refused
+
+bool monitorStart();  // false on a text link or one too slow for the stream
+void monitorStop();
+bool monitorActive();
+void monitorPoll();  // every tick: code what the platform captured
+
+struct MonitorCounters {
+  unsigned long frames;
+  unsigned long bytes;          // on the wire, framing included
+  unsigned long samples;        // coded, at MONITOR_RATE
+  unsigned long droppedBlocks;  // input blocks the loop did not collect in time
+  unsigned long encodeMicros;   // filter, resample and code, all blocks
+  unsigned long blocks;
+  unsigned long ageTotal;       // ms, capture to send, over all frames
+  unsigned long ageMax;
+  double signalEnergy;  // for the coding SNR
+  double errorEnergy;
+  unsigned long startedAt;  // halMillis()
+};
+
+const MonitorCounters& monitorStats();
+void printMonitorStats();
+
+// IMA-ADPCM, one sample at a time; host_sim decodes with it to check the stream
+struct AdpcmState {
+  int16_t predictor;
+  uint8_t index;
+};
+
+uint8_t adpcmEncode(AdpcmState& s, int16_t sample);  // 4-bit code; s follows the decoder
+int16_t adpcmDecode(AdpcmState& s, uint8_t code);
+
+#endif  // TRAINER_MONITOR_H
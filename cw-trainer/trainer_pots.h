@@ -0,0 +1,71 @@
+#ifndef TRAINER_POTS_H
+#define TRAINER_POTS_H
+
+// Front-panel potentiometer filtering. The ADC completion interrupt feeds raw
+// samples into addSample(); the main loop calls update(), which only reports a
+// value once the oversampled, smoothed reading has moved past the hysteresis
+// band. Only settled changes reach applySettings(), so pot noise no longer
+// redraws the display or resends status.
+
+#include <stdint.h>
+#include <math.h>
+
+const uint16_t POT_ADC_MAX = 4095;   // 12-bit conversions
+const uint8_t POT_OVERSAMPLE = 16;   // raw samples averaged per block
+const float POT_SMOOTHING = 0.25f;   // IIR weight of each new block
+
+class PotFilter {
+public:
+  explicit PotFilter(uint16_t hysteresis)
+    : hysteresis_(hysteresis) {}
+
+  // Interrupt context: accumulate and publish one averaged block at a time
+  void addSample(uint16_t raw) {
+    sum_ += raw;
+    if (++count_ >= POT_OVERSAMPLE) {
+      block_ = sum_ / POT_OVERSAMPLE;
+      blocks_++;
+      sum_ = 0;
+      count_ = 0;
+    }
+  }
+
+  // Main loop: true when the settled value changed, which is written to value
+  bool update(uint16_t& value) {
+    uint32_t blocks = blocks_;
+    if (blocks == seenBlocks_) return false;
+    seenBlocks_ = blocks;
+
+    float sample = block_;  // 16-bit load, atomic against addSample()
+    if (!primed_) {
+      primed_ = true;
+      filtered_ = sample;
+    } else {
+      filtered_ += POT_SMOOTHING * (sample - filtered_);
+      if (fabsf(filtered_ - stable_) <= hysteresis_) return false;
+    }
+    stable_ = (uint16_t)(filtered_ + 0.5f);
+    value = stable_;
+    return true;
+  }
+
+  uint16_t value() const {
+    return stable_;
+  }
+
+private:
+  // Written by the ISR
+  uint32_t sum_ = 0;
+  uint8_t count_ = 0;
+  volatile uint16_t block_ = 0;
+  volatile uint32_t blocks_ = 0;
+
+  // Main loop only
+  uint32_t seenBlocks_ = 0;
+  bool primed_ = false;
+  float filtered_ = 0;
+  uint16_t stable_ = 0;
+  uint16_t hysteresis_;
+};
+
+#endif  // TRAINER_POTS_H
@@ -0,0 +1,119 @@
+#include "trainer_profiles.h"
+#include "trainer_store.h"
+#include "trainer_trace.h"
+#include "trainer_export.h"
+#include "trainer_protocol.h"
+#include "trainer_charstats.h"
+#include "trainer_history.h"
+#include <ctype.h>
+
+ProfileDirectory profiles;
+
+// Image of one profile on its way to or from the platform
+static uint8_t image[BACKUP_SIZE_MAX];
+static StoreState profileState;
+
+const char* profileName(int profile) {
+  static char fallback[16];
+  if (profiles.names[profile][0]) return profiles.names[profile];
+  snprintf(fallback, sizeof(fallback), "P%d", profile + 1);
+  return fallback;
+}
+
+static size_t encodeImage(const StoreState& state) {
+  size_t len = 0;
+  int slot = -1;
+  while (size_t n = storeBackupRecord(slot, state, image + len)) len += n;
+  return len;
+}
+
+// An absent image is a new profile; false if the image does not decode
+static bool decodeImage(size_t len, StoreState& state) {
+  if (len == 0) {
+    memset(&state, 0, sizeof(state));
+    defaultStoreState(state);
+    return true;
+  }
+  BackupReader reader;
+  storeBackupBegin(reader, state);
+  return storeBackupFeed(reader, image, len, state) && reader.finished && state.hasSettings;
+}
+
+bool switchProfile(int profile) {
+  if (profile < 0 || profile >= PROFILE_COUNT || profile == profiles.active) return false;
+  if (traceReplaying() || exportActive()) {
+    consolePrintf("Profile switch not possible now\n");
+    return false;
+  }
+  uint32_t start = halMicros();
+  if (kochSending || kochListening) stopKochLesson();
+
+  // The outgoing profile first, so a failure leaves it intact and active
+  saveSettings();
+  captureStoreState(profileState);
+  if (!halProfileWrite(profiles.active, image, encodeImage(profileState))) {
+    consolePrintf("Cannot save profile %s\n", profileName(profiles.active));
+    return false;
+  }
+  if (!decodeImage(halProfileRead(profile, image, sizeof(image)), profileState)) {
+    consolePrintf("Profile %s is damaged\n", profileName(profile));
+    return false;
+  }
+
+  profiles.active = profile;
+  historyLoad();
+  profileState.profiles = profiles;
+  storeReplace(profileState);
+  restoreStoreState(profileState);
+  updateWaveform();
+  updateVolume();
+  updateOutputRouting();
+  updateAudioInput();
+  initializeKoch();
+  applySettings();
+  sessionStartTime = halMillis();
+
+  consolePrintf("Profile %d (%s) active, switched in %lu ms\n", profile + 1, profileName(profile),
+                (unsigned long)((halMicros() - start + 500) / 1000));
+  sendProfilesToWiFi();  // the companion drops its character table on a new profile
+  sendCharStatsToWiFi(true);
+  sendHistoryToWiFi(true);
+  sendStatsToWiFi();
+  return true;
+}
+
+// Letters, digits and a little punctuation, so names survive the
+// upper-cased console and the '|' separated PROFILES line
+void renameProfile(const char* name) {
+  char* out = profiles.names[profiles.active];
+  size_t n = 0;
+  for (const char* p = name; *p && n < PROFILE_NAME_MAX; p++) {
+    char c = toupper(*p);
+    if ((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '/' || c == ' ') out[n++] = c;
+  }
+  while (n > 0 && out[n - 1] == ' ') n--;
+  out[n] = '\0';
+  saveSettings();
+  sendProfilesToWiFi();
+}
+
+void printProfiles() {
+  consolePrintf("\n=== PROFILES ===\n");
+  for (int i = 0; i < PROFILE_COUNT; i++) {
+    consolePrintf("%c %d %s\n", i == profiles.active ? '*' : ' ', i + 1, profileName(i));
+  }
+  consolePrintf("================\n\n");
+}
+
+void sendProfilesToWiFi() {
+  if (!wifiEnabled || !espConnected) return;
+
+  static FixedText<PROFILE_COUNT * (PROFILE_NAME_MAX + 1) + 16> msg;
+  msg.set(PREFIX_PROFILES);
+  msg.appendf("%d", profiles.active + 1);
+  for (int i = 0; i < PROFILE_COUNT; i++) {
+    msg.append('|');
+    msg.append(profileName(i));
+  }
+  linkWriteLine(msg.c_str());
+}
@@ -0,0 +1,33 @@
+#ifndef TRAINER_PROFILES_H
+#define TRAINER_PROFILES_H
+
+// Operator profiles. Each profile has its own stats, Koch lesson, character
+// statistics and settings. Only the active one is in RAM and in the store
+// (trainer_store.h); the others are kept by the platform as backup images
+// (the storeBackupRecord() format), one per profile, so a saved profile is
+// also a file /api/import or IMPORT: lines accept.
+//
+// The directory (names and the active number) lives in the store, so the last
+// profile comes back at boot without touching the images. Switching writes
+// the outgoing profile's image, reads the incoming one and hands the store
+// rewrite to background compaction, so it costs two image transfers.
+
+#include "trainer_core.h"
+
+const int PROFILE_COUNT = 8;
+const size_t PROFILE_NAME_MAX = 12;
+
+struct ProfileDirectory {
+  uint8_t active;  // 0-based
+  char names[PROFILE_COUNT][PROFILE_NAME_MAX + 1];  // empty until named
+};
+
+extern ProfileDirectory profiles;
+
+const char* profileName(int profile);  // "P<n>" for a profile without a name
+bool switchProfile(int profile);       // false if the profile could not be loaded
+void renameProfile(const char* name);  // the active profile
+void printProfiles();
+void sendProfilesToWiFi();  // PROFILES:<active>|<name>|<name>...
+
+#endif  // TRAINER_PROFILES_H
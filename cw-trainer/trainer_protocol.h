@@ -12,6 +12,33 @@
 #define MSG_READY_ESP01        "ESP01:READY"
 #define MSG_READY_ESP32        "ESP32:READY"
 
+// Link capability handshake: HELLO:<version>,<capability bits>[,<max baud>], see trainer_frame.h
+#define PREFIX_HELLO           "HELLO:"
+
+// Rate change: BAUD:<rate> from the Teensy, BAUD_OK:<rate> (the rate the
+// companion switched to, or its current one if it declines) in reply
+#define PREFIX_BAUD            "BAUD:"
+#define PREFIX_BAUD_OK         "BAUD_OK:"
+
+// Acknowledged command (Teensy offered LINK_CAP_ACKS): CMD:<id>:<command>,
+// where the command is any line the companion could send bare (START,
+// TEENSY:SET_FREQ:700, ...), answered with ACK:<id>,<result> once it has run
+#define PREFIX_CMD             "CMD:"
+#define PREFIX_ACK             "ACK:"
+#define ACK_OK                 "OK"
+#define ACK_RANGE              "RANGE"    // a value out of bounds, nothing changed
+#define ACK_REFUSED            "REFUSED"  // not possible in the current mode
+#define ACK_UNKNOWN            "UNKNOWN"
+
+// Live audio (trainer_monitor.h): AUDIO:1 from the companion while a browser
+// listens, AUDIO:0 when the last one leaves; FRAME_AUDIO frames in between
+#define PREFIX_AUDIO           "AUDIO:"
+
+// Spectrum (trainer_spectrum.h): SPECTRUM:<low Hz>,<high Hz>,<points>,<per second>
+// while a browser watches, SPECTRUM:0 when the last one leaves; FRAME_SPECTRUM
+// frames in between
+#define PREFIX_SPECTRUM        "SPECTRUM:"
+
 // Legacy heartbeat (no longer used but kept for backward compatibility)
 #define MSG_HEARTBEAT          "ESP01:HEARTBEAT"
 
@@ -20,5 +47,12 @@
 #define PREFIX_STATS           "STATS:"
 #define PREFIX_DECODED         "DECODED:"
 #define PREFIX_CURRENT         "CURRENT:"
+#define PREFIX_CHARSTAT        "CHARSTAT:"
+#define PREFIX_PROFILES        "PROFILES:"
+#define PREFIX_HISTORY         "HISTORY:"
+
+// Bulk export (Teensy to ESP32) and import (ESP32 to Teensy), see trainer_export.h
+#define PREFIX_EXPORT          "EXPORT:"
+#define PREFIX_IMPORT          "IMPORT:"
 
 #endif // TRAINER_PROTOCOL_H
@@ -0,0 +1,123 @@
+#include "trainer_core.h"
+#include "trainer_sessionlog.h"
+#include "trainer_trace.h"
+#include <string.h>
+
+const size_t RECORDS_PER_BLOCK = SESSION_LOG_BLOCK / sizeof(SessionLogRecord);
+
+// Two sector buffers: 'fill' collects records, a full one waits in 'ready'
+// until the platform has written it
+static uint8_t logBlocks[2][SESSION_LOG_BLOCK];
+static int fillBlock = 0;
+static size_t fillRecords = 0;
+static int readyBlock = -1;
+static bool logStarted = false;
+static uint16_t logSequence = 0;
+static bool flushPending = false;  // hand over the partial block once the writer is free
+
+static SessionLogStats logStats;
+
+static bool swapBlocks() {
+  if (readyBlock >= 0) return false;  // writer is behind; the caller drops
+  readyBlock = fillBlock;
+  fillBlock ^= 1;
+  fillRecords = 0;
+  flushPending = false;
+  memset(logBlocks[fillBlock], 0, SESSION_LOG_BLOCK);
+  return true;
+}
+
+void sessionLogBegin() {
+  memset(logBlocks, 0, sizeof(logBlocks));
+  fillBlock = 0;
+  fillRecords = 0;
+  readyBlock = -1;
+  logSequence = 0;
+  flushPending = false;
+
+  SessionLogHeader header;
+  memcpy(header.magic, "CWLOG1", sizeof(header.magic));
+  header.version = SESSION_LOG_VERSION;
+  header.recordSize = sizeof(SessionLogRecord);
+  header.blockSize = SESSION_LOG_BLOCK;
+  header.startMillis = halMillis();
+  memcpy(logBlocks[0], &header, sizeof(header));
+  swapBlocks();
+  logStarted = true;
+}
+
+static void appendRecord(SessionLogRecord& record) {
+  // Replayed sessions re-decode old input; logging them again would duplicate it
+  if (!logStarted || traceReplaying()) return;
+
+  record.time = halMillis();
+  record.mode = currentPracticeMode;
+  record.flags = (kochListening ? 0x01 : 0) | (useExternalAudio ? 0x02 : 0);
+  record.lesson = kochLesson;
+  record.wpmX10 = ditLength > 0 ? (uint16_t)(12000.0 / ditLength) : 0;
+  record.sequence = logSequence;
+
+  if (fillRecords == RECORDS_PER_BLOCK && !swapBlocks()) {
+    logStats.dropped++;
+    return;
+  }
+  memcpy(logBlocks[fillBlock] + fillRecords * sizeof(SessionLogRecord), &record, sizeof(record));
+  fillRecords++;
+  logSequence++;
+  logStats.records++;
+}
+
+void sessionLogCharacter(char expected, char decoded, const uint16_t* elements, uint8_t count, uint32_t gapBefore) {
+  SessionLogRecord record;
+  memset(&record, 0, sizeof(record));
+  record.type = SLOG_CHAR;
+  record.expected = expected;
+  record.decoded = decoded;
+  if (count > SESSION_LOG_MAX_ELEMENTS) count = SESSION_LOG_MAX_ELEMENTS;
+  record.elementCount = count;
+  memcpy(record.elements, elements, count * sizeof(uint16_t));
+  record.gapBefore = gapBefore > 0xFFFF ? 0xFFFF : gapBefore;
+  appendRecord(record);
+}
+
+void sessionLogSession(SessionLogType type, uint16_t a, uint16_t b) {
+  SessionLogRecord record;
+  memset(&record, 0, sizeof(record));
+  record.type = type;
+  record.elements[0] = a;
+  record.elements[1] = b;
+  appendRecord(record);
+
+  // Push the session out now; the rest of the block is left as padding
+  if (type == SLOG_SESSION_END && fillRecords > 0 && !swapBlocks()) {
+    flushPending = true;
+  }
+}
+
+const uint8_t* sessionLogTakeBlock() {
+  if (readyBlock < 0) return nullptr;
+  // A card write can take milliseconds; keep it out of keyed and decoded characters
+  if (keyPressed || kochSending || !decoderIdle()) return nullptr;
+  return logBlocks[readyBlock];
+}
+
+void sessionLogRelease() {
+  if (readyBlock < 0) return;
+  readyBlock = -1;
+  logStats.blocksWritten++;
+  // Records that arrived while the writer was busy may be waiting in the other buffer
+  if (fillRecords == RECORDS_PER_BLOCK || (flushPending && fillRecords > 0)) swapBlocks();
+}
+
+const SessionLogStats& sessionLogStats() {
+  return logStats;
+}
+
+void printSessionLogStats() {
+  if (!logStarted) {
+    consolePrintf("Session log: off (no storage)\n");
+    return;
+  }
+  consolePrintf("Session log: %lu records, %lu blocks written, %lu dropped, %u pending\n",
+                logStats.records, logStats.blocksWritten, logStats.dropped, (unsigned)fillRecords);
+}
@@ -0,0 +1,70 @@
+#ifndef TRAINER_SESSIONLOG_H
+#define TRAINER_SESSIONLOG_H
+
+// Binary per-character session log. Records are packed 32 bytes each into
+// 512-byte blocks (one SD sector) in two RAM buffers: the decoder fills one
+// while the platform writes the other out. Blocks are only handed over while
+// the keyer and decoder are idle, so a card write never lands mid-character.
+//
+// File layout: one header block (SessionLogHeader, zero padded), then record
+// blocks. A partly filled block is padded with zeroed (SLOG_PAD) records when
+// a session ends, so every write is a whole, sector-aligned block.
+// host_sim/cwlog2csv converts a log to CSV.
+
+#include <stdint.h>
+#include <stddef.h>
+
+const size_t SESSION_LOG_BLOCK = 512;
+const uint16_t SESSION_LOG_VERSION = 1;
+const uint8_t SESSION_LOG_MAX_ELEMENTS = 7;
+
+enum SessionLogType : uint8_t {
+  SLOG_PAD = 0,
+  SLOG_CHAR = 1,           // one decoded character
+  SLOG_SESSION_START = 2,  // elements[0] = characters sent
+  SLOG_SESSION_END = 3     // elements[0] = correct, elements[1] = total
+};
+
+struct __attribute__((packed)) SessionLogHeader {
+  char magic[6];  // "CWLOG1"
+  uint16_t version;
+  uint16_t recordSize;
+  uint16_t blockSize;
+  uint32_t startMillis;
+};
+
+struct __attribute__((packed)) SessionLogRecord {
+  uint32_t time;  // halMillis() at the end of the character
+  uint8_t type;   // SessionLogType
+  uint8_t mode;   // PracticeMode
+  uint8_t flags;  // bit 0 scored Koch copy, bit 1 external audio input
+  uint8_t lesson;
+  char expected;  // 0 when nothing was expected
+  char decoded;   // '?' when the pattern is not in morseTable
+  uint8_t elementCount;
+  uint8_t reserved;
+  uint16_t wpmX10;  // speed estimate from the adaptive dit length
+  uint16_t gapBefore;  // ms of silence before the first element
+  uint16_t elements[SESSION_LOG_MAX_ELEMENTS];  // tone durations in ms
+  uint16_t sequence;
+};
+
+static_assert(sizeof(SessionLogRecord) == 32, "log records must tile a 512-byte block");
+
+void sessionLogBegin();  // queue the file header; the platform calls it once storage is ready
+void sessionLogCharacter(char expected, char decoded, const uint16_t* elements, uint8_t count, uint32_t gapBefore);
+void sessionLogSession(SessionLogType type, uint16_t a, uint16_t b);
+
+struct SessionLogStats {
+  unsigned long records;
+  unsigned long blocksWritten;
+  unsigned long dropped;  // records lost because the writer fell two blocks behind
+};
+
+// Platform side: write the returned block, then release it
+const uint8_t* sessionLogTakeBlock();
+void sessionLogRelease();
+const SessionLogStats& sessionLogStats();
+void printSessionLogStats();
+
+#endif  // TRAINER_SESSIONLOG_H
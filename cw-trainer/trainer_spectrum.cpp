@@ -0,0 +1,140 @@
+#include "trainer_spectrum.h"
+#include "trainer_frame.h"
+#include <math.h>
+
+static bool active = false;
+static SpectrumConfig config = SPECTRUM_DEFAULT;
+static SpectrumCounters counters;
+
+// Passband in FFT bins, merged `merge` to a point
+static int firstBin;
+static int binCount;
+static int merge;
+static int points;
+
+static uint8_t peaks[SPECTRUM_POINTS_MAX];  // levels since the last frame
+static int peakFfts;                        // FFTs folded into them
+static unsigned long lastSent;
+
+uint8_t spectrumLevel(float magnitude) {
+  if (magnitude <= 0) return 0;
+  float steps = (20 * log10f(magnitude) - SPECTRUM_LEVEL_FLOOR_DB) * 2;
+  return steps <= 0 ? 0 : steps >= 255 ? 255 : (uint8_t)lrintf(steps);
+}
+
+static void sendFrame() {
+  uint8_t body[sizeof(FrameSpectrum) + SPECTRUM_POINTS_MAX];
+  FrameSpectrum head;
+  head.time = halMillis();
+  head.firstBin = firstBin;
+  head.binMilliHz = lrintf(SPECTRUM_BIN_HZ * 1000);
+  head.merge = merge;
+  memcpy(body, &head, sizeof(head));
+  memcpy(body + sizeof(head), peaks, points);
+  size_t n = linkSendStream(FRAME_SPECTRUM, body, sizeof(head) + points);
+  memset(peaks, 0, sizeof(peaks));
+  peakFfts = 0;
+  if (n == 0) return;
+  counters.frames++;
+  counters.bytes += n;
+}
+
+bool spectrumStart(const SpectrumConfig& c) {
+  if (!wifiEnabled || !espConnected || !linkFramed) {
+    consolePrintf("Spectrum needs a framed companion link\n");
+    return false;
+  }
+  if (c.lowHz < 0 || c.highHz <= c.lowHz || c.highHz > SPECTRUM_BIN_HZ * SPECTRUM_BINS || c.points < 1 ||
+      c.points > SPECTRUM_POINTS_MAX || c.rate < 1 || c.rate > SPECTRUM_RATE_MAX) {
+    consolePrintf("Spectrum: %d-%d Hz, %d points, %d/s is out of range\n", c.lowHz, c.highHz, c.points, c.rate);
+    return false;
+  }
+  config = c;
+  firstBin = (int)(c.lowHz / SPECTRUM_BIN_HZ);
+  int lastBin = (int)ceilf(c.highHz / SPECTRUM_BIN_HZ);
+  if (lastBin >= SPECTRUM_BINS) lastBin = SPECTRUM_BINS - 1;
+  binCount = lastBin - firstBin + 1;
+  merge = (binCount + c.points - 1) / c.points;
+  points = (binCount + merge - 1) / merge;
+  memset(peaks, 0, sizeof(peaks));
+  peakFfts = 0;
+  lastSent = halMillis();
+  if (!active) {
+    counters = SpectrumCounters();
+    counters.startedAt = halMillis();
+    halSpectrumEnable(true);
+  }
+  active = true;
+  consolePrintf("Spectrum on: %d-%d Hz in %d points of %s Hz, %d/s\n", c.lowHz, c.highHz, points,
+                fixedFloat(merge * SPECTRUM_BIN_HZ, 0).c_str(), c.rate);
+  return true;
+}
+
+bool spectrumStartLine(const char* args) {
+  SpectrumConfig c = config;
+  if (strchr(args, ',') && sscanf(args, "%d,%d,%d,%d", &c.lowHz, &c.highHz, &c.points, &c.rate) != 4) {
+    consolePrintf("Spectrum: expected <low>,<high>,<points>,<rate>\n");
+    return false;
+  }
+  return spectrumStart(c);
+}
+
+void spectrumStop() {
+  if (!active) return;
+  halSpectrumEnable(false);
+  active = false;
+  consolePrintf("Spectrum off after %lu frames\n", counters.frames);
+}
+
+bool spectrumActive() {
+  return active;
+}
+
+void spectrumPoll() {
+  if (!active) return;
+  if (!espConnected || !linkFramed) {
+    spectrumStop();
+    return;
+  }
+  static float bins[SPECTRUM_BINS];
+  if (halSpectrumRead(bins + firstBin, firstBin, binCount)) {
+    uint32_t start = halMicros();
+    for (int p = 0; p < points; p++) {
+      const float* b = bins + firstBin + p * merge;
+      int n = p == points - 1 ? binCount - p * merge : merge;
+      float m = 0;
+      for (int i = 0; i < n; i++) {
+        if (b[i] > m) m = b[i];
+      }
+      uint8_t level = spectrumLevel(m);
+      if (level > peaks[p]) peaks[p] = level;  // peak hold: a dit between frames still shows
+    }
+    peakFfts++;
+    counters.ffts++;
+    counters.encodeMicros += halMicros() - start;
+  }
+  if (peakFfts > 0 && halMillis() - lastSent >= 1000UL / config.rate) {
+    lastSent += 1000UL / config.rate;
+    if (halMillis() - lastSent >= 1000UL / config.rate) lastSent = halMillis();  // fell behind: no burst
+    sendFrame();
+  }
+}
+
+const SpectrumCounters& spectrumStats() {
+  return counters;
+}
+
+void printSpectrumStats() {
+  unsigned long elapsed = halMillis() - counters.startedAt;
+  float rate = elapsed ? counters.bytes * 1000.0f / elapsed : 0;
+  consolePrintf("\n=== SPECTRUM ===\n");
+  consolePrintf("State:      %s, %d-%d Hz, %d points of %s Hz, %d/s\n", active ? "on" : "off", config.lowHz,
+                config.highHz, points, fixedFloat(merge * SPECTRUM_BIN_HZ, 0).c_str(), config.rate);
+  consolePrintf("Sent:       %lu frames, %lu bytes, %s bytes/s (%s%% of %lu baud)\n", counters.frames,
+                counters.bytes, fixedFloat(rate, 0).c_str(), fixedFloat(rate * 1000 / linkBaud, 1).c_str(),
+                (unsigned long)linkBaud);
+  consolePrintf("FFTs:       %lu, %s per frame\n", counters.ffts,
+                fixedFloat(counters.frames ? (float)counters.ffts / counters.frames : 0.0f, 1).c_str());
+  consolePrintf("Loop cost:  %lu us per FFT\n", counters.ffts ? counters.encodeMicros / counters.ffts : 0);
+  consolePrintf("================\n\n");
+}
@@ -0,0 +1,47 @@
+#ifndef TRAINER_SPECTRUM_H
+#define TRAINER_SPECTRUM_H
+
+// Spectrum of the decode mix for the web page's waterfall. While the companion
+// asks for it (SPECTRUM:<low>,<high>,<points>,<rate>) spectrumPoll() takes each
+// FFT the platform finishes, keeps the peak of every bin in the passband
+// and, SpectrumConfig::rate times a second, sends the peaks as one
+// FRAME_SPECTRUM (trainer_frame.h) of 8-bit log levels. Wider passbands are
+// merged down to SpectrumConfig::points, so a frame never exceeds
+// SPECTRUM_POINTS_MAX + sizeof(FrameSpectrum) bytes.
+
+#include "trainer_core.h"
+
+const float SPECTRUM_BIN_HZ = 44117.647f / 1024;  // AudioAnalyzeFFT1024
+const int SPECTRUM_BINS = 512;
+const int SPECTRUM_POINTS_MAX = 64;
+const int SPECTRUM_RATE_MAX = 20;  // frames a second
+
+struct SpectrumConfig {
+  int lowHz;
+  int highHz;
+  int points;  // at most; adjacent bins are merged to fit
+  int rate;    // frames a second
+};
+
+const SpectrumConfig SPECTRUM_DEFAULT = { 300, 1200, 48, 10 };
+
+bool spectrumStart(const SpectrumConfig& config);  // false on a text link or a bad config
+bool spectrumStartLine(const char* args);  // "<low>,<high>,<points>,<rate>", or "1" for the last config
+void spectrumStop();
+bool spectrumActive();
+void spectrumPoll();  // every tick: fold in finished FFTs, send on schedule
+
+struct SpectrumCounters {
+  unsigned long frames;
+  unsigned long bytes;    // on the wire, framing included
+  unsigned long ffts;     // folded into frames
+  unsigned long encodeMicros;
+  unsigned long startedAt;  // halMillis()
+};
+
+const SpectrumCounters& spectrumStats();
+void printSpectrumStats();
+
+uint8_t spectrumLevel(float magnitude);  // 0 to 1.0 full scale, to the frame's half-dB steps
+
+#endif  // TRAINER_SPECTRUM_H
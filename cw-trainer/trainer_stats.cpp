@@ -0,0 +1,197 @@
+#include "trainer_core.h"
+#include "trainer_trace.h"
+#include "trainer_store.h"
+#include "trainer_charstats.h"
+#include "trainer_profiles.h"
+#include "trainer_history.h"
+#include <math.h>
+
+// Statistics (stored in EEPROM)
+TrainingStats stats;
+
+// Persisted device configuration
+DeviceSettings deviceSettings;
+unsigned long sessionStartTime;
+float currentWPM = 0;
+
+// Pre-store EEPROM layout: raw structs, imported once on the first boot
+struct LegacyTrainingStats {
+  unsigned long totalDits;
+  unsigned long totalDahs;
+  unsigned long charactersDecoded;
+  unsigned long sessionsCompleted;
+  float bestWPM;
+  float totalTrainingMinutes;
+  int highestLesson;
+  unsigned long characterErrors[26];  // A-Z error counts
+  float lessonAccuracy[40];
+  unsigned long lastSessionTime;
+  int customLessonsCompleted;
+  float averageAccuracy;
+};
+
+const int LEGACY_STATS_ADDR = 0;
+const int LEGACY_KOCH_LESSON_ADDR = sizeof(LegacyTrainingStats);
+const int LEGACY_SETTINGS_ADDR = LEGACY_KOCH_LESSON_ADDR + sizeof(int);
+
+void displayDetailedStats() {
+  consolePrintf("\n=== DETAILED STATISTICS ===\n");
+  consolePrintf("Total Sessions: %lu\n", stats.sessionsCompleted);
+  consolePrintf("Characters Decoded: %lu\n", stats.charactersDecoded);
+  consolePrintf("Best WPM: %s\n", fixedFloat(stats.bestWPM, 1).c_str());
+  consolePrintf("Training Time: %s hours\n", fixedFloat(stats.totalTrainingMinutes / 60, 1).c_str());
+  consolePrintf("Highest Koch Lesson: %d\n", stats.highestLesson);
+  consolePrintf("Average Accuracy: %s%%\n", fixedFloat(stats.averageAccuracy, 1).c_str());
+
+  printCharacterStats();
+
+  consolePrintf("\nKoch Lesson Accuracy:\n");
+  int shownLessons = stats.highestLesson < KOCH_LESSON_COUNT ? stats.highestLesson : KOCH_LESSON_COUNT;
+  for (int i = 0; i < shownLessons; i++) {
+    if (stats.lessonAccuracy[i] > 0) {
+      consolePrintf("Lesson %d: %s%%\n", i + 1, fixedFloat(stats.lessonAccuracy[i], 1).c_str());
+    }
+  }
+  consolePrintf("========================\n\n");
+}
+
+void resetAllStats() {
+  memset(&stats, 0, sizeof(stats));
+  resetCharacterStats();
+  historyReset();
+  stats.bestWPM = 0;
+  stats.averageAccuracy = 0;
+  kochLesson = 1;
+  initializeKoch();
+  saveSettings();
+}
+
+// Apply values from EEPROM struct to runtime globals
+static void syncSettingsToGlobals() {
+  sidetoneFreq = deviceSettings.sidetoneFreq;
+  volume = deviceSettings.volume;
+  currentWaveform = deviceSettings.waveform;
+  useHeadphones = deviceSettings.useHeadphones;
+  decoderEnabled = deviceSettings.decoderEnabled;
+  useExternalAudio = deviceSettings.useExternalAudio;
+  kochModeEnabled = deviceSettings.kochModeEnabled;
+}
+
+// Copy current globals into struct before persisting
+static void syncGlobalsToSettings() {
+  deviceSettings.sidetoneFreq = sidetoneFreq;
+  deviceSettings.volume = volume;
+  deviceSettings.waveform = currentWaveform;
+  deviceSettings.useHeadphones = useHeadphones;
+  deviceSettings.decoderEnabled = decoderEnabled;
+  deviceSettings.useExternalAudio = useExternalAudio;
+  deviceSettings.kochModeEnabled = kochModeEnabled;
+}
+
+static bool validSettings(const DeviceSettings& settings) {
+  return !isnan(settings.sidetoneFreq) && settings.sidetoneFreq >= 100.0 && settings.sidetoneFreq <= 2000.0;
+}
+
+// Firmware before the log-structured store kept raw structs at fixed addresses
+static bool loadLegacySettings(StoreState& state) {
+  memset(&state, 0, sizeof(state));
+  LegacyTrainingStats legacy;
+  halStorageRead(LEGACY_STATS_ADDR, &legacy, sizeof(legacy));
+  state.stats.totalDits = legacy.totalDits;
+  state.stats.totalDahs = legacy.totalDahs;
+  state.stats.charactersDecoded = legacy.charactersDecoded;
+  state.stats.sessionsCompleted = legacy.sessionsCompleted;
+  state.stats.bestWPM = legacy.bestWPM;
+  state.stats.totalTrainingMinutes = legacy.totalTrainingMinutes;
+  state.stats.highestLesson = legacy.highestLesson;
+  memcpy(state.stats.lessonAccuracy, legacy.lessonAccuracy, sizeof(state.stats.lessonAccuracy));
+  state.stats.lastSessionTime = legacy.lastSessionTime;
+  state.stats.customLessonsCompleted = legacy.customLessonsCompleted;
+  state.stats.averageAccuracy = legacy.averageAccuracy;
+  for (int i = 0; i < 26; i++) {
+    int symbol = morseSymbolIndex('A' + i);
+    state.chars[symbol].otherErrors = legacy.characterErrors[i] > 0xFFFF ? 0xFFFF : legacy.characterErrors[i];
+  }
+  halStorageRead(LEGACY_KOCH_LESSON_ADDR, &state.kochLesson, sizeof(state.kochLesson));
+  halStorageRead(LEGACY_SETTINGS_ADDR, &state.settings, sizeof(state.settings));
+  state.hasSettings = validSettings(state.settings);
+  return state.hasSettings;
+}
+
+void loadSettings() {
+  StoreState state;
+  bool loaded = storeLoad(state);
+  if (!loaded) {
+    if (loadLegacySettings(state)) {
+      consolePrintf("Importing settings from the old EEPROM layout\n");
+    }
+  }
+
+  // If first run, set reasonable defaults
+  if (!state.hasSettings || !validSettings(state.settings)) {
+    defaultStoreState(state);
+  }
+  if (!loaded) storeFormat(state);
+
+  profiles = state.profiles;
+  restoreStoreState(state);
+}
+
+// First-run values for one profile's data; the profile directory is left alone
+void defaultStoreState(StoreState& state) {
+  state.settings = { 600.0, 0.5, 0, true, true, false, false };
+  state.hasSettings = true;
+  memset(&state.stats, 0, sizeof(state.stats));
+  memset(state.chars, 0, sizeof(state.chars));
+  state.kochLesson = 1;
+}
+
+// Loaded or imported state into the globals; a state without settings keeps the current ones
+void restoreStoreState(const StoreState& state) {
+  stats = state.stats;
+  kochLesson = state.kochLesson;
+  if (state.hasSettings && validSettings(state.settings)) deviceSettings = state.settings;
+  for (int i = 0; i < MORSE_SYMBOL_COUNT; i++) restoreSymbol(i, state.chars[i]);
+  syncSettingsToGlobals();
+
+  // Validate loaded data
+  if (kochLesson < 1 || kochLesson > KOCH_LESSON_COUNT) {
+    kochLesson = 1;
+  }
+
+  // Calculate average accuracy
+  float totalAccuracy = 0;
+  int validLessons = 0;
+  for (int i = 0; i < KOCH_LESSON_COUNT; i++) {
+    if (stats.lessonAccuracy[i] > 0) {
+      totalAccuracy += stats.lessonAccuracy[i];
+      validLessons++;
+    }
+  }
+  if (validLessons > 0) {
+    stats.averageAccuracy = totalAccuracy / validLessons;
+  }
+}
+
+void saveSettings() {
+  if (traceReplaying()) return;  // replayed sessions must not overwrite the real stats
+  stats.totalTrainingMinutes += (halMillis() - sessionStartTime) / 60000.0;
+  stats.lastSessionTime = halMillis();
+
+  // Only the field groups that changed since the last save are written
+  StoreState state;
+  captureStoreState(state);
+  if (!storeSave(state)) consolePrintf("Store full: some settings were not saved\n");
+
+  sessionStartTime = halMillis();  // Reset session timer
+}
+
+void captureStoreState(StoreState& state) {
+  syncGlobalsToSettings();
+  state.stats = stats;
+  state.settings = deviceSettings;
+  state.kochLesson = kochLesson;
+  for (int i = 0; i < MORSE_SYMBOL_COUNT; i++) summarizeSymbol(i, state.chars[i]);
+  state.profiles = profiles;
+  state.hasSettings = true;
+}
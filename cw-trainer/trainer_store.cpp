@@ -0,0 +1,608 @@
+#include "trainer_store.h"
+#include "trainer_crc.h"
+
+static const uint8_t STORE_MAGIC[4] = { 'C', 'W', 'K', 'V' };
+const int SEGMENT_SIZE = STORAGE_SIZE / 2;
+const int HEADER_SIZE = 12;     // magic, schema, reserved, generation u32, crc16
+const int RECORD_OVERHEAD = 5;  // key, index, length, crc16
+const int MAX_PAYLOAD = 16;
+const uint8_t END_MARK = 0xFF;  // erased storage; no key uses it
+static const uint8_t BACKUP_MAGIC[4] = { 'C', 'W', 'B', 'K' };
+const size_t BACKUP_HEADER_SIZE = 6;  // magic, format version, schema version
+// Compact once the appends since the live values were last laid out fill
+// this share of the room left after them
+const int COMPACT_ROOM_DIVISOR = 2;
+const uint32_t COMPACT_STEP_INTERVAL = 20;  // ms between background copy steps
+
+enum StoreKey : uint8_t { KEY_SETTINGS = 1,
+                          KEY_LESSON,
+                          KEY_ELEMENTS,
+                          KEY_PROGRESS,
+                          KEY_TIME,
+                          KEY_CHAR_ERRORS,  // A-Z error counts before per-character stats; imported on load
+                          KEY_LESSON_ACCURACY,
+                          KEY_CHAR_STATS,
+                          KEY_PROFILE_ACTIVE,
+                          KEY_PROFILE_NAME };
+
+// One slot per persisted field group
+const int SLOT_FIXED = 5;  // settings, lesson, elements, progress, time
+const int SLOT_CHAR_STATS = SLOT_FIXED;
+const int SLOT_LESSON_ACCURACY = SLOT_CHAR_STATS + MORSE_SYMBOL_COUNT;
+const int SLOT_PROFILE_ACTIVE = SLOT_LESSON_ACCURACY + KOCH_LESSON_COUNT;
+const int SLOT_PROFILE_NAME = SLOT_PROFILE_ACTIVE + 1;
+const int STORE_SLOT_COUNT = SLOT_PROFILE_NAME + PROFILE_COUNT;
+const int BACKUP_SLOT_COUNT = SLOT_PROFILE_ACTIVE;  // one profile's data, without the directory
+
+static int activeSegment = 0;
+static uint32_t generation = 0;
+static int appendPos = 0;
+static int liveEnd = 0;  // where the live values end when laid out without stale records
+static StoreState stored;  // what the log currently says
+
+// Background compaction into the other segment
+static bool compacting = false;
+static bool replacing = false;  // compacting a new state in; saves wait for the switch
+static int compactSlot = 0;
+static int compactPos = 0;
+static uint32_t lastCompactStep = 0;
+static uint8_t dirtyDuringCompact[(STORE_SLOT_COUNT + 7) / 8];
+
+// Counters for STORE
+static uint32_t recordsWritten = 0;
+static uint32_t bytesWritten = 0;
+static uint32_t compactions = 0;
+static uint32_t compactRestarts = 0;  // re-saved groups overflowed the copy: copied afresh
+static uint32_t compactFailures = 0;  // the live values did not fit a segment
+static uint32_t droppedGroups = 0;    // changed groups a save could not write
+static uint32_t tornRecords = 0;
+static uint32_t writeMicros = 0;
+static uint32_t lastSaveMicros = 0;
+static uint8_t lastSaveRecords = 0;
+
+// ---- Encoding -------------------------------------------------------------------
+
+static uint8_t* putU16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+  return p + 2;
+}
+
+static uint8_t* putU32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+  return p + 4;
+}
+
+static uint8_t* putFloat(uint8_t* p, float f) {
+  uint32_t v;
+  memcpy(&v, &f, sizeof(v));
+  return putU32(p, v);
+}
+
+static uint16_t getU16(const uint8_t* p) {
+  return p[0] | (uint16_t)p[1] << 8;
+}
+
+static uint32_t getU32(const uint8_t* p) {
+  return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static float getFloat(const uint8_t* p) {
+  uint32_t v = getU32(p);
+  float f;
+  memcpy(&f, &v, sizeof(f));
+  return f;
+}
+
+static void slotKey(int slot, uint8_t& key, uint8_t& index) {
+  index = 0;
+  if (slot < SLOT_FIXED) {
+    key = KEY_SETTINGS + slot;
+  } else if (slot < SLOT_LESSON_ACCURACY) {
+    key = KEY_CHAR_STATS;
+    index = slot - SLOT_CHAR_STATS;
+  } else if (slot < SLOT_PROFILE_ACTIVE) {
+    key = KEY_LESSON_ACCURACY;
+    index = slot - SLOT_LESSON_ACCURACY;
+  } else if (slot == SLOT_PROFILE_ACTIVE) {
+    key = KEY_PROFILE_ACTIVE;
+  } else {
+    key = KEY_PROFILE_NAME;
+    index = slot - SLOT_PROFILE_NAME;
+  }
+}
+
+static int slotOf(uint8_t key, uint8_t index) {
+  if (key >= KEY_SETTINGS && key <= KEY_TIME && index == 0) return key - KEY_SETTINGS;
+  if (key == KEY_CHAR_STATS && index < MORSE_SYMBOL_COUNT) return SLOT_CHAR_STATS + index;
+  if (key == KEY_LESSON_ACCURACY && index < KOCH_LESSON_COUNT) return SLOT_LESSON_ACCURACY + index;
+  if (key == KEY_PROFILE_ACTIVE && index == 0) return SLOT_PROFILE_ACTIVE;
+  if (key == KEY_PROFILE_NAME && index < PROFILE_COUNT) return SLOT_PROFILE_NAME + index;
+  return -1;
+}
+
+// Explicit little-endian layout, independent of struct packing and of the
+// size of unsigned long on the platform
+static uint8_t encodeSlot(int slot, const StoreState& s, uint8_t* out) {
+  uint8_t* p = out;
+  switch (slot) {
+    case 0:
+      p = putFloat(p, s.settings.sidetoneFreq);
+      p = putFloat(p, s.settings.volume);
+      *p++ = s.settings.waveform;
+      *p++ = (s.settings.useHeadphones ? 0x01 : 0) | (s.settings.decoderEnabled ? 0x02 : 0) | (s.settings.useExternalAudio ? 0x04 : 0) | (s.settings.kochModeEnabled ? 0x08 : 0);
+      break;
+    case 1:
+      p = putU16(p, s.kochLesson);
+      break;
+    case 2:
+      p = putU32(p, s.stats.totalDits);
+      p = putU32(p, s.stats.totalDahs);
+      p = putU32(p, s.stats.charactersDecoded);
+      break;
+    case 3:
+      p = putU32(p, s.stats.sessionsCompleted);
+      p = putFloat(p, s.stats.bestWPM);
+      p = putFloat(p, s.stats.averageAccuracy);
+      p = putU16(p, s.stats.highestLesson);
+      p = putU16(p, s.stats.customLessonsCompleted);
+      break;
+    case 4:
+      p = putFloat(p, s.stats.totalTrainingMinutes);
+      p = putU32(p, s.stats.lastSessionTime);
+      break;
+    default:
+      if (slot < SLOT_LESSON_ACCURACY) {
+        const CharSummary& c = s.chars[slot - SLOT_CHAR_STATS];
+        p = putU16(p, c.correct);
+        p = putU16(p, c.otherErrors);
+        for (int i = 0; i < SUMMARY_CONFUSIONS; i++) {
+          *p++ = c.confusedWith[i];
+          p = putU16(p, c.confusedCount[i]);
+        }
+        memcpy(p, c.latency, LATENCY_BINS);
+        p += LATENCY_BINS;
+      } else if (slot < SLOT_PROFILE_ACTIVE) {
+        p = putFloat(p, s.stats.lessonAccuracy[slot - SLOT_LESSON_ACCURACY]);
+      } else if (slot == SLOT_PROFILE_ACTIVE) {
+        *p++ = s.profiles.active;
+      } else {
+        // Fixed width, zero padded, so the length check in decodeSlot still holds
+        memset(p, 0, PROFILE_NAME_MAX);
+        strncpy((char*)p, s.profiles.names[slot - SLOT_PROFILE_NAME], PROFILE_NAME_MAX);
+        p += PROFILE_NAME_MAX;
+      }
+      break;
+  }
+  return p - out;
+}
+
+// A length that does not match the current layout means the record came from a
+// different schema; it is skipped and the field keeps its default
+static bool decodeSlot(int slot, const uint8_t* p, uint8_t len, StoreState& s) {
+  uint8_t expected[MAX_PAYLOAD];
+  if (len != encodeSlot(slot, s, expected)) return false;
+
+  switch (slot) {
+    case 0:
+      s.settings.sidetoneFreq = getFloat(p);
+      s.settings.volume = getFloat(p + 4);
+      s.settings.waveform = p[8];
+      s.settings.useHeadphones = p[9] & 0x01;
+      s.settings.decoderEnabled = p[9] & 0x02;
+      s.settings.useExternalAudio = p[9] & 0x04;
+      s.settings.kochModeEnabled = p[9] & 0x08;
+      s.hasSettings = true;
+      break;
+    case 1:
+      s.kochLesson = getU16(p);
+      break;
+    case 2:
+      s.stats.totalDits = getU32(p);
+      s.stats.totalDahs = getU32(p + 4);
+      s.stats.charactersDecoded = getU32(p + 8);
+      break;
+    case 3:
+      s.stats.sessionsCompleted = getU32(p);
+      s.stats.bestWPM = getFloat(p + 4);
+      s.stats.averageAccuracy = getFloat(p + 8);
+      s.stats.highestLesson = getU16(p + 12);
+      s.stats.customLessonsCompleted = getU16(p + 14);
+      break;
+    case 4:
+      s.stats.totalTrainingMinutes = getFloat(p);
+      s.stats.lastSessionTime = getU32(p + 4);
+      break;
+    default:
+      if (slot < SLOT_LESSON_ACCURACY) {
+        CharSummary& c = s.chars[slot - SLOT_CHAR_STATS];
+        c.correct = getU16(p);
+        c.otherErrors = getU16(p + 2);
+        for (int i = 0; i < SUMMARY_CONFUSIONS; i++) {
+          c.confusedWith[i] = p[4 + 3 * i];
+          c.confusedCount[i] = getU16(p + 5 + 3 * i);
+        }
+        memcpy(c.latency, p + 4 + 3 * SUMMARY_CONFUSIONS, LATENCY_BINS);
+      } else if (slot < SLOT_PROFILE_ACTIVE) {
+        s.stats.lessonAccuracy[slot - SLOT_LESSON_ACCURACY] = getFloat(p);
+      } else if (slot == SLOT_PROFILE_ACTIVE) {
+        s.profiles.active = p[0] < PROFILE_COUNT ? p[0] : 0;
+      } else {
+        char* name = s.profiles.names[slot - SLOT_PROFILE_NAME];
+        memcpy(name, p, PROFILE_NAME_MAX);
+        name[PROFILE_NAME_MAX] = '\0';
+      }
+      break;
+  }
+  return true;
+}
+
+// ---- Storage access ---------------------------------------------------------------
+
+static int segmentBase(int segment) {
+  return segment * SEGMENT_SIZE;
+}
+
+static void storeWrite(int addr, const void* src, size_t len) {
+  uint32_t start = halMicros();
+  halStorageWrite(addr, src, len);
+  writeMicros += halMicros() - start;
+  bytesWritten += len;
+}
+
+static bool readHeader(int segment, uint32_t& gen) {
+  uint8_t h[HEADER_SIZE];
+  halStorageRead(segmentBase(segment), h, sizeof(h));
+  if (memcmp(h, STORE_MAGIC, 4) != 0 || h[4] != STORE_SCHEMA_VERSION) return false;
+  if (crc16(h, HEADER_SIZE - 2) != getU16(h + HEADER_SIZE - 2)) return false;
+  gen = getU32(h + 6);
+  return true;
+}
+
+static void writeHeader(int segment, uint32_t gen) {
+  uint8_t h[HEADER_SIZE];
+  memcpy(h, STORE_MAGIC, 4);
+  h[4] = STORE_SCHEMA_VERSION;
+  h[5] = 0;
+  putU32(h + 6, gen);
+  putU16(h + HEADER_SIZE - 2, crc16(h, HEADER_SIZE - 2));
+  storeWrite(segmentBase(segment), h, sizeof(h));
+}
+
+// Key, index, length, payload and CRC; returns the record length
+static int encodeRecord(int slot, const StoreState& s, uint8_t* rec) {
+  uint8_t len = encodeSlot(slot, s, rec + 3);
+  slotKey(slot, rec[0], rec[1]);
+  rec[2] = len;
+  putU16(rec + 3 + len, crc16(rec, 3 + len));
+  return RECORD_OVERHEAD + len;
+}
+
+// Writes one record at pos and returns the position after it, or -1 if it does
+// not fit. The end mark goes down first so a torn record is never followed by
+// stale bytes from an older generation.
+static int writeRecord(int segment, int pos, int slot, const StoreState& s) {
+  uint8_t rec[RECORD_OVERHEAD + MAX_PAYLOAD];
+  int end = pos + encodeRecord(slot, s, rec);
+  int segmentEnd = segmentBase(segment) + SEGMENT_SIZE;
+  if (end > segmentEnd) return -1;
+  if (end < segmentEnd) storeWrite(end, &END_MARK, 1);
+  storeWrite(pos, rec, end - pos);
+  recordsWritten++;
+  return end;
+}
+
+// An old per-letter error count becomes errors with an unknown copied symbol
+static void importCharErrors(uint8_t letter, uint32_t errors, StoreState& state) {
+  int symbol = morseSymbolIndex('A' + letter);
+  if (letter >= 26 || symbol < 0) return;
+  CharSummary& c = state.chars[symbol];
+  c.otherErrors = errors > 0xFFFF ? 0xFFFF : errors;
+}
+
+// Replays a segment's records into state and returns the append position
+static int scanSegment(int segment, StoreState& state) {
+  int pos = segmentBase(segment) + HEADER_SIZE;
+  int segmentEnd = segmentBase(segment) + SEGMENT_SIZE;
+  uint8_t rec[RECORD_OVERHEAD + MAX_PAYLOAD];
+
+  while (pos + RECORD_OVERHEAD <= segmentEnd) {
+    halStorageRead(pos, rec, 3);
+    if (rec[0] == END_MARK) break;
+    uint8_t len = rec[2];
+    if (len > MAX_PAYLOAD || pos + RECORD_OVERHEAD + len > segmentEnd) {
+      tornRecords++;
+      break;
+    }
+    halStorageRead(pos + 3, rec + 3, len + 2);
+    if (crc16(rec, 3 + len) != getU16(rec + 3 + len)) {
+      tornRecords++;  // power lost mid-append: the log ends here
+      break;
+    }
+    int slot = slotOf(rec[0], rec[1]);
+    if (slot >= 0) {
+      decodeSlot(slot, rec + 3, len, state);
+    } else if (rec[0] == KEY_CHAR_ERRORS && len == 4) {
+      importCharErrors(rec[1], getU32(rec + 3), state);
+    }
+    pos += RECORD_OVERHEAD + len;
+  }
+  return pos;
+}
+
+static bool slotIsZero(int slot, const StoreState& s) {
+  uint8_t buf[MAX_PAYLOAD];
+  uint8_t len = encodeSlot(slot, s, buf);
+  for (uint8_t i = 0; i < len; i++) {
+    if (buf[i]) return false;
+  }
+  return true;
+}
+
+// ---- Compaction -------------------------------------------------------------------
+
+static void startCompaction() {
+  int target = 1 - activeSegment;
+  uint8_t erased[HEADER_SIZE];
+  memset(erased, 0xFF, sizeof(erased));
+  storeWrite(segmentBase(target), erased, sizeof(erased));  // stays invalid until finished
+
+  compacting = true;
+  compactSlot = 0;
+  compactPos = segmentBase(target) + HEADER_SIZE;
+  storeWrite(compactPos, &END_MARK, 1);
+  memset(dirtyDuringCompact, 0, sizeof(dirtyDuringCompact));
+}
+
+// The copy did not fit. Its header was never written, so the active segment
+// stays the valid one. The trigger waits for further appends before trying again.
+static void abandonCompaction() {
+  compacting = false;
+  replacing = false;
+  liveEnd = appendPos;
+  compactFailures++;
+}
+
+// False if the copy has to start over
+static bool finishCompaction() {
+  int target = 1 - activeSegment;
+
+  // Groups saved to the old segment after they had already been copied. If
+  // they overflow the copy, a fresh one holds them once each.
+  for (int slot = 0; slot < STORE_SLOT_COUNT; slot++) {
+    if (dirtyDuringCompact[slot / 8] & (1 << (slot % 8))) {
+      int end = writeRecord(target, compactPos, slot, stored);
+      if (end < 0) {
+        compactRestarts++;
+        startCompaction();
+        return false;
+      }
+      compactPos = end;
+    }
+  }
+
+  writeHeader(target, generation + 1);
+  generation++;
+  activeSegment = target;
+  appendPos = compactPos;
+  liveEnd = compactPos;
+  compacting = false;
+  replacing = false;
+  compactions++;
+  return true;
+}
+
+// Header and non-default groups: where a compaction of s ends
+static int compactedSize(const StoreState& s) {
+  int size = HEADER_SIZE;
+  uint8_t buf[MAX_PAYLOAD];
+  for (int slot = 0; slot < STORE_SLOT_COUNT; slot++) {
+    if (slot >= SLOT_FIXED && slotIsZero(slot, s)) continue;
+    size += RECORD_OVERHEAD + encodeSlot(slot, s, buf);
+  }
+  return size;
+}
+
+// Copy the next non-default group; true once the copy is complete or abandoned
+static bool compactStep() {
+  while (compactSlot < STORE_SLOT_COUNT) {
+    int slot = compactSlot++;
+    if (slot >= SLOT_FIXED && slotIsZero(slot, stored)) continue;  // absent means zero
+    int end = writeRecord(1 - activeSegment, compactPos, slot, stored);
+    if (end < 0) {
+      abandonCompaction();
+      return true;
+    }
+    compactPos = end;
+    return false;
+  }
+  return finishCompaction();
+}
+
+static void compactNow() {
+  if (!compacting) startCompaction();
+  while (!compactStep()) {
+  }
+}
+
+// ---- Public interface ---------------------------------------------------------------
+
+bool storeLoad(StoreState& state) {
+  memset(&state, 0, sizeof(state));
+
+  uint32_t gen[2];
+  bool valid[2] = { readHeader(0, gen[0]), readHeader(1, gen[1]) };
+  if (!valid[0] && !valid[1]) return false;
+
+  // Generations only grow; a torn compaction left its target header invalid
+  if (valid[0] && valid[1]) {
+    activeSegment = (int32_t)(gen[1] - gen[0]) > 0 ? 1 : 0;
+  } else {
+    activeSegment = valid[1] ? 1 : 0;
+  }
+  generation = gen[activeSegment];
+  appendPos = scanSegment(activeSegment, state);
+  liveEnd = segmentBase(activeSegment) + compactedSize(state);
+  if (liveEnd > appendPos) liveEnd = appendPos;  // imported old records can lay out larger
+  stored = state;
+  compacting = false;
+  replacing = false;
+  return true;
+}
+
+void storeFormat(const StoreState& state) {
+  stored = state;
+  compacting = false;
+  replacing = false;
+  activeSegment = 1;  // compact into segment 0
+  generation = 0;
+  compactNow();
+}
+
+bool storeSave(const StoreState& state) {
+  uint32_t start = halMicros();
+  uint8_t records = 0;
+  bool saved = true;
+
+  for (int slot = 0; slot < STORE_SLOT_COUNT; slot++) {
+    uint8_t now[MAX_PAYLOAD], was[MAX_PAYLOAD];
+    uint8_t len = encodeSlot(slot, state, now);
+    if (len == encodeSlot(slot, stored, was) && memcmp(now, was, len) == 0) continue;
+
+    // The active segment still holds the state being replaced: the change
+    // goes into the copy instead, now or when finishCompaction() catches up
+    if (replacing) {
+      decodeSlot(slot, now, len, stored);
+      if (slot < compactSlot) dirtyDuringCompact[slot / 8] |= 1 << (slot % 8);
+      continue;
+    }
+
+    int end = writeRecord(activeSegment, appendPos, slot, state);
+    if (end < 0) {
+      compactNow();  // segment full: finish the copy now, then append there
+      end = writeRecord(activeSegment, appendPos, slot, state);
+    }
+    if (end < 0) {
+      droppedGroups++;  // stays different from stored, so the next save tries again
+      saved = false;
+      continue;
+    }
+    appendPos = end;
+    decodeSlot(slot, now, len, stored);
+    records++;
+
+    if (compacting && slot < compactSlot) {
+      dirtyDuringCompact[slot / 8] |= 1 << (slot % 8);
+    }
+  }
+
+  lastSaveRecords = records;
+  lastSaveMicros = halMicros() - start;
+  return saved;
+}
+
+void storeReplace(const StoreState& state) {
+  stored = state;
+  compacting = false;  // restart any copy in progress: it holds the old values
+  startCompaction();
+  replacing = true;
+}
+
+void storeService() {
+  if (!compacting) {
+    int room = segmentBase(activeSegment) + SEGMENT_SIZE - liveEnd;
+    if (appendPos - liveEnd > room / COMPACT_ROOM_DIVISOR) startCompaction();
+    return;
+  }
+  if (halMillis() - lastCompactStep >= COMPACT_STEP_INTERVAL) {
+    lastCompactStep = halMillis();
+    compactStep();
+  }
+}
+
+void printStoreStats() {
+  consolePrintf("\n=== STORE ===\n");
+  consolePrintf("Schema %u, segment %d, generation %lu%s\n", (unsigned)STORE_SCHEMA_VERSION, activeSegment,
+                (unsigned long)generation, replacing ? " (replacing)" : compacting ? " (compacting)" : "");
+  consolePrintf("Log: %d/%d bytes, %d live\n", appendPos - segmentBase(activeSegment), SEGMENT_SIZE,
+                liveEnd - segmentBase(activeSegment));
+  consolePrintf("Records written: %lu (%lu bytes)\n", (unsigned long)recordsWritten, (unsigned long)bytesWritten);
+  consolePrintf("Last save: %u records in %lu us\n", (unsigned)lastSaveRecords, (unsigned long)lastSaveMicros);
+  consolePrintf("Write time total: %lu us\n", (unsigned long)writeMicros);
+  consolePrintf("Compactions: %lu (%lu restarted, %lu failed), torn records skipped: %lu\n",
+                (unsigned long)compactions, (unsigned long)compactRestarts, (unsigned long)compactFailures,
+                (unsigned long)tornRecords);
+  consolePrintf("Groups not saved: %lu\n", (unsigned long)droppedGroups);
+  consolePrintf("=============\n\n");
+}
+
+// ---- Backups ----------------------------------------------------------------------
+
+static_assert(RECORD_OVERHEAD + MAX_PAYLOAD <= BACKUP_RECORD_MAX, "BACKUP_RECORD_MAX too small");
+static_assert(BACKUP_HEADER_SIZE + BACKUP_SLOT_COUNT * BACKUP_RECORD_MAX + 1 <= BACKUP_SIZE_MAX, "BACKUP_SIZE_MAX too small");
+
+size_t storeBackupRecord(int& slot, const StoreState& state, uint8_t* out) {
+  if (slot < 0) {
+    memcpy(out, BACKUP_MAGIC, 4);
+    out[4] = BACKUP_FORMAT_VERSION;
+    out[5] = STORE_SCHEMA_VERSION;
+    slot = 0;
+    return BACKUP_HEADER_SIZE;
+  }
+  while (slot < BACKUP_SLOT_COUNT) {
+    int s = slot++;
+    if (s >= SLOT_FIXED && slotIsZero(s, state)) continue;  // absent means zero, as in the log
+    return encodeRecord(s, state, out);
+  }
+  if (slot > BACKUP_SLOT_COUNT) return 0;
+  slot++;
+  out[0] = END_MARK;
+  return 1;
+}
+
+void storeBackupBegin(BackupReader& reader, StoreState& state) {
+  memset(&reader, 0, sizeof(reader));
+  reader.need = BACKUP_HEADER_SIZE;
+  memset(&state, 0, sizeof(state));
+}
+
+// Called each time reader.need bytes are in: the header, a key byte (or the
+// end mark), the key/index/length triple, or a whole record
+static void backupStep(BackupReader& reader, StoreState& state) {
+  uint8_t* rec = reader.record;
+  if (!reader.started) {
+    // Other schema versions are accepted; groups whose layout changed are skipped on decode
+    reader.failed = memcmp(rec, BACKUP_MAGIC, 4) != 0 || rec[4] != BACKUP_FORMAT_VERSION;
+    reader.started = true;
+  } else if (reader.need == 1) {
+    if (rec[0] == END_MARK) reader.finished = true;
+    else reader.need = 3;
+    return;
+  } else if (reader.need == 3) {
+    if (rec[2] > MAX_PAYLOAD) reader.failed = true;
+    reader.need = RECORD_OVERHEAD + rec[2];
+    return;
+  } else {
+    uint8_t len = rec[2];
+    if (crc16(rec, 3 + len) != getU16(rec + 3 + len)) {
+      reader.failed = true;
+      return;
+    }
+    int slot = slotOf(rec[0], rec[1]);
+    if (slot >= 0 && slot < BACKUP_SLOT_COUNT && decodeSlot(slot, rec + 3, len, state)) reader.records++;
+  }
+  reader.have = 0;
+  reader.need = 1;
+}
+
+bool storeBackupFeed(BackupReader& reader, const uint8_t* data, size_t len, StoreState& state) {
+  for (size_t i = 0; i < len && !reader.failed; i++) {
+    if (reader.finished) {
+      reader.failed = true;  // data after the end mark
+      break;
+    }
+    reader.record[reader.have++] = data[i];
+    if (reader.have == reader.need) backupStep(reader, state);
+  }
+  return !reader.failed;
+}
@@ -0,0 +1,75 @@
+#ifndef TRAINER_STORE_H
+#define TRAINER_STORE_H
+
+// Log-structured persistence over the emulated EEPROM.
+//
+// The area is split into two segments. The active one starts with a header
+// (magic, schema version, generation, CRC) followed by append-only records:
+//   key u8, index u8, length u8, payload, CRC-16 over the preceding bytes
+// Each record holds one field group (settings, lesson, counters, one letter's
+// copy summary, one lesson's accuracy). A save appends only the groups that
+// differ from what is already stored. Once the appends since the last
+// compaction fill half the room left after the live values, storeService()
+// copies the live values into the other segment a record at a time and
+// switches over by writing its header last. On load, the first record
+// with a bad CRC ends the log, so a torn write loses only the save in progress.
+
+#include "trainer_core.h"
+#include "trainer_charstats.h"
+#include "trainer_profiles.h"
+
+const uint8_t STORE_SCHEMA_VERSION = 1;
+
+struct StoreState {
+  TrainingStats stats;
+  DeviceSettings settings;
+  int kochLesson;
+  CharSummary chars[MORSE_SYMBOL_COUNT];  // by morseTable index
+  ProfileDirectory profiles;  // not part of backups
+  bool hasSettings;  // false when no settings record was found
+};
+
+bool storeLoad(StoreState& state);          // false if neither segment is valid
+void storeFormat(const StoreState& state);  // start a fresh store holding state
+bool storeSave(const StoreState& state);    // append the field groups that changed; false if one did not fit
+// Rewrites the store to hold state by compacting it into the other segment in
+// the background; until that finishes the old segment stays as it was, so a
+// reset in between comes back with the previous contents
+void storeReplace(const StoreState& state);
+void storeService();                        // background compaction, once per tick
+void printStoreStats();
+
+// ---- Backups ---------------------------------------------------------------------
+// A backup is "CWBK", the backup format version and STORE_SCHEMA_VERSION,
+// then one log record (as above) for every field group that is not all zero,
+// then an end mark byte. It is produced and consumed a record at a time.
+
+const uint8_t BACKUP_FORMAT_VERSION = 1;
+const size_t BACKUP_RECORD_MAX = 21;  // largest header or record
+const size_t BACKUP_SIZE_MAX = 2048;
+
+// Writes the header (slot < 0) or the record for the next group from slot on,
+// advancing slot past it; returns 0 once the end mark has been written
+size_t storeBackupRecord(int& slot, const StoreState& state, uint8_t* out);
+
+struct BackupReader {
+  uint8_t record[BACKUP_RECORD_MAX];
+  size_t have;
+  size_t need;  // bytes of the current header or record
+  bool started;
+  bool finished;  // end mark seen
+  bool failed;
+  uint16_t records;
+};
+
+void storeBackupBegin(BackupReader& reader, StoreState& state);
+// Decodes backup bytes into state; false once the data is not a valid backup
+bool storeBackupFeed(BackupReader& reader, const uint8_t* data, size_t len, StoreState& state);
+
+// Between the globals and a StoreState (trainer_stats.cpp). Restoring leaves
+// the profile directory global alone; loadSettings() sets it from the store.
+void captureStoreState(StoreState& state);
+void restoreStoreState(const StoreState& state);
+void defaultStoreState(StoreState& state);
+
+#endif  // TRAINER_STORE_H
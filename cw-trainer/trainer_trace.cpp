@@ -0,0 +1,540 @@
+#include "trainer_core.h"
+#include "trainer_trace.h"
+#include "trainer_input.h"
+#include "trainer_charstats.h"
+#include "trainer_drill.h"
+
+static const uint8_t TRACE_MAGIC[4] = { 'C', 'W', 'T', '2' };
+const size_t TRACE_END_RESERVE = 1 + 5 + 4;  // room kept for the TRACE_END record
+const size_t TRACE_LINE_MAX = 255;
+
+static uint8_t traceBuffer[TRACE_BUFFER_SIZE];
+static size_t traceLen = 0;
+static TraceState traceState = TRACE_IDLE;
+static uint32_t traceEvents = 0;
+static bool traceFull = false;
+static uint32_t lastEventTime = 0;
+static uint32_t fingerprint = 0;
+
+// Input state as last recorded, or as replayed
+static bool tracedKey = false;
+static bool tracedTone = false;
+
+// Replay cursor
+static const uint8_t* replayData = nullptr;
+static size_t replayLen = 0;
+static size_t replayPos = 0;
+static uint32_t replayClock = 0;
+static uint32_t replaySpeed = 1;
+static uint32_t replayEvents = 0;
+static bool replayMatched = false;
+
+// ---- Encoding helpers ---------------------------------------------------------
+
+static const uint32_t FNV_OFFSET = 2166136261u;
+
+static void fingerprintBytes(const char* s) {
+  while (*s) {
+    fingerprint ^= (uint8_t)*s++;
+    fingerprint *= 16777619u;
+  }
+}
+
+static void putByte(uint8_t b) {
+  traceBuffer[traceLen++] = b;
+}
+
+static void putU16(uint16_t v) {
+  putByte(v & 0xFF);
+  putByte(v >> 8);
+}
+
+static void putU32(uint32_t v) {
+  for (int i = 0; i < 4; i++) putByte((v >> (8 * i)) & 0xFF);
+}
+
+static void putFloat(float f) {
+  uint32_t v;
+  memcpy(&v, &f, sizeof(v));
+  putU32(v);
+}
+
+static void putVarint(uint32_t v) {
+  while (v >= 0x80) {
+    putByte((v & 0x7F) | 0x80);
+    v >>= 7;
+  }
+  putByte(v);
+}
+
+// Bounds-checked reader over a trace being replayed
+struct TraceReader {
+  const uint8_t* data;
+  size_t len;
+  size_t pos;
+  bool ok;
+
+  uint8_t byte() {
+    if (pos >= len) {
+      ok = false;
+      return 0;
+    }
+    return data[pos++];
+  }
+  uint16_t u16() {
+    uint16_t lo = byte();
+    return lo | (uint16_t)byte() << 8;
+  }
+  uint32_t u32() {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= (uint32_t)byte() << (8 * i);
+    return v;
+  }
+  float f32() {
+    uint32_t v = u32();
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+  }
+  uint32_t varint() {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t b = byte();
+      v |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) return v;
+    }
+    ok = false;
+    return 0;
+  }
+};
+
+// ---- Snapshot -------------------------------------------------------------------
+// Everything the traced inputs are interpreted against. Timers are not part of
+// it: recording and replay both start from an idle trainer.
+
+// Character stats go in sparsely: symbol count, then per copied symbol its
+// index, summary totals and latency bins, and the non-zero matrix cells
+static void writeCharacterStats() {
+  uint8_t symbols = 0;
+  for (int s = 0; s < MORSE_SYMBOL_COUNT; s++) {
+    if (symbolAttempts(s)) symbols++;
+  }
+  putByte(symbols);
+  for (int s = 0; s < MORSE_SYMBOL_COUNT; s++) {
+    if (!symbolAttempts(s)) continue;
+    CharSummary summary;
+    summarizeSymbol(s, summary);
+    putByte(s);
+    putU16(summary.otherErrors);
+    for (int i = 0; i < LATENCY_BINS; i++) putByte(summary.latency[i]);
+
+    uint8_t cells = 0;
+    for (int c = 0; c < MORSE_SYMBOL_COUNT; c++) {
+      if (confusionMatrix[s][c]) cells++;
+    }
+    putByte(cells);
+    for (int c = 0; c < MORSE_SYMBOL_COUNT; c++) {
+      if (!confusionMatrix[s][c]) continue;
+      putByte(c);
+      putU16(confusionMatrix[s][c]);
+    }
+  }
+}
+
+static void readCharacterStats(TraceReader& in) {
+  resetCharacterStats();
+  uint8_t symbols = in.byte();
+  for (int n = 0; n < symbols && in.ok; n++) {
+    uint8_t s = in.byte();
+    CharSummary summary;
+    memset(&summary, 0, sizeof(summary));
+    summary.otherErrors = in.u16();
+    for (int i = 0; i < LATENCY_BINS; i++) summary.latency[i] = in.byte();
+    if (s >= MORSE_SYMBOL_COUNT) {
+      in.ok = false;
+      return;
+    }
+    restoreSymbol(s, summary);  // folded errors and latency; the cells follow exactly
+
+    uint8_t cells = in.byte();
+    for (int i = 0; i < cells && in.ok; i++) {
+      uint8_t c = in.byte();
+      uint16_t count = in.u16();
+      if (c < MORSE_SYMBOL_COUNT) confusionMatrix[s][c] = count;
+    }
+  }
+}
+
+static void writeSnapshot() {
+  putByte(kochLesson);
+  putByte(kochSpeed);
+  putByte(kochEffectiveSpeed);
+  putByte(currentPracticeMode);
+  putByte(currentWaveform);
+  putByte(currentMenu);
+  putByte(menuSelection);
+  putByte((decoderEnabled ? 0x01 : 0) | (kochModeEnabled ? 0x02 : 0) | (useExternalAudio ? 0x04 : 0) | (useHeadphones ? 0x08 : 0) | (inMenu ? 0x10 : 0) | (editMode ? 0x20 : 0) | (tracedKey ? 0x40 : 0) | (tracedTone ? 0x80 : 0));
+  putU16((uint16_t)(sidetoneFreq + 0.5f));
+  putFloat(volume);
+  putFloat(ditLength);
+
+  putU32(stats.totalDits);
+  putU32(stats.totalDahs);
+  putU32(stats.charactersDecoded);
+  putU32(stats.sessionsCompleted);
+  putFloat(stats.bestWPM);
+  putFloat(stats.totalTrainingMinutes);
+  putU16(stats.highestLesson);
+  putFloat(stats.averageAccuracy);
+  for (int i = 0; i < KOCH_LESSON_COUNT; i++) putFloat(stats.lessonAccuracy[i]);
+  writeCharacterStats();
+  for (int s = 0; s < MORSE_SYMBOL_COUNT; s++) putByte(drillRecency(s));
+}
+
+static bool readSnapshot(TraceReader& in) {
+  kochLesson = in.byte();
+  kochSpeed = in.byte();
+  kochEffectiveSpeed = in.byte();
+  currentPracticeMode = (PracticeMode)in.byte();
+  currentWaveform = in.byte() & 3;
+  currentMenu = (MenuMode)in.byte();
+  menuSelection = in.byte();
+  uint8_t flags = in.byte();
+  sidetoneFreq = in.u16();
+  volume = in.f32();
+  float tracedDitLength = in.f32();
+
+  stats.totalDits = in.u32();
+  stats.totalDahs = in.u32();
+  stats.charactersDecoded = in.u32();
+  stats.sessionsCompleted = in.u32();
+  stats.bestWPM = in.f32();
+  stats.totalTrainingMinutes = in.f32();
+  stats.highestLesson = in.u16();
+  stats.averageAccuracy = in.f32();
+  for (int i = 0; i < KOCH_LESSON_COUNT; i++) stats.lessonAccuracy[i] = in.f32();
+  readCharacterStats(in);
+  for (int s = 0; s < MORSE_SYMBOL_COUNT; s++) drillSetRecency(s, in.byte());
+
+  if (!in.ok || kochLesson < 1 || kochLesson > KOCH_LESSON_COUNT) return false;
+
+  decoderEnabled = flags & 0x01;
+  kochModeEnabled = flags & 0x02;
+  useExternalAudio = flags & 0x04;
+  useHeadphones = flags & 0x08;
+  inMenu = flags & 0x10;
+  editMode = flags & 0x20;
+  tracedKey = flags & 0x40;
+  tracedTone = flags & 0x80;
+
+  initializeKoch();
+  ditLength = tracedDitLength;
+  return true;
+}
+
+// ---- Recording ------------------------------------------------------------------
+
+// Reserve room for one event; once full, recording keeps running but drops events
+static bool beginEvent(TraceEventType type, uint8_t arg, size_t payload) {
+  if (traceState != TRACE_RECORDING) return false;
+  if (traceLen + 1 + 5 + payload + TRACE_END_RESERVE > sizeof(traceBuffer)) {
+    traceFull = true;
+    return false;
+  }
+  uint32_t now = halMillis();
+  putByte((type << 4) | (arg & 0x0F));
+  putVarint(now - lastEventTime);
+  lastEventTime = now;
+  traceEvents++;
+  return true;
+}
+
+void traceRecordStart() {
+  if (traceState == TRACE_REPLAYING) return;
+
+  // Start from an idle trainer so the replay can rebuild the same state
+  if (kochSending || kochListening) stopKochLesson();
+  saveSettings();
+
+  traceLen = 0;
+  traceEvents = 0;
+  traceFull = false;
+  tracedKey = inputKeyDown();
+  tracedTone = halToneDetected();
+  keyPressed = tracedKey;
+
+  uint32_t seed = trainerRandom32();
+  for (int i = 0; i < 4; i++) putByte(TRACE_MAGIC[i]);
+  putU32(seed);
+  writeSnapshot();
+
+  trainerRandomSeed(seed);
+  resetDecoder();
+  lastEventTime = halMillis();
+  fingerprint = FNV_OFFSET;
+  traceState = TRACE_RECORDING;
+}
+
+void traceRecordStop() {
+  if (traceState != TRACE_RECORDING) return;
+  uint32_t now = halMillis();
+  putByte(TRACE_END << 4);
+  putVarint(now - lastEventTime);
+  putU32(fingerprint);
+  traceState = TRACE_IDLE;
+}
+
+bool traceRecording() {
+  return traceState == TRACE_RECORDING;
+}
+
+bool traceOverflowed() {
+  return traceFull;
+}
+
+const uint8_t* traceData() {
+  return traceBuffer;
+}
+
+size_t traceLength() {
+  return traceLen;
+}
+
+uint32_t traceEventCount() {
+  return traceEvents;
+}
+
+// ---- Input hooks ----------------------------------------------------------------
+
+bool traceKeyDown() {
+  if (traceState == TRACE_REPLAYING) return tracedKey;
+  bool down = inputKeyDown();
+  if (traceState == TRACE_RECORDING && down != tracedKey && beginEvent(TRACE_KEY, down, 0)) {
+    tracedKey = down;
+  }
+  return down;
+}
+
+bool traceToneDetected() {
+  if (traceState == TRACE_REPLAYING) return tracedTone;
+  bool tone = halToneDetected();
+  if (traceState == TRACE_RECORDING && tone != tracedTone && beginEvent(TRACE_TONE, tone, 0)) {
+    tracedTone = tone;
+  }
+  return tone;
+}
+
+void traceEncoder(int delta) {
+  uint32_t zigzag = delta < 0 ? ((uint32_t)(-delta) << 1) - 1 : (uint32_t)delta << 1;
+  if (beginEvent(TRACE_ENCODER, 0, 5)) putVarint(zigzag);
+}
+
+void traceButton(bool longPress) {
+  beginEvent(TRACE_BUTTON, longPress, 0);
+}
+
+static void traceLine(TraceEventType type, const char* line) {
+  size_t len = strlen(line);
+  if (len > TRACE_LINE_MAX) len = TRACE_LINE_MAX;
+  if (beginEvent(type, 0, 1 + len)) {
+    putByte(len);
+    memcpy(traceBuffer + traceLen, line, len);
+    traceLen += len;
+  }
+}
+
+void traceSerialLine(const char* line) {
+  traceLine(TRACE_SERIAL, line);
+}
+
+void traceLinkLine(const char* line) {
+  traceLine(TRACE_LINK, line);
+}
+
+void traceOutput(const char* text) {
+  if (traceState != TRACE_IDLE) fingerprintBytes(text);
+}
+
+// ---- Replay ---------------------------------------------------------------------
+
+bool traceReplayBegin(const uint8_t* data, size_t len, uint32_t speed) {
+  if (traceState != TRACE_IDLE) return false;
+
+  TraceReader in = { data, len, 0, true };
+  for (int i = 0; i < 4; i++) {
+    if (in.byte() != TRACE_MAGIC[i]) return false;
+  }
+  uint32_t seed = in.u32();
+  if (!readSnapshot(in)) return false;
+
+  kochSending = false;
+  kochListening = false;
+  halToneOff();
+  keyPressed = tracedKey;
+  applySettings();
+  updateWaveform();
+  updateVolume();
+  updateOutputRouting();
+  updateAudioInput();
+
+  replayData = data;
+  replayLen = len;
+  replayPos = in.pos;
+  replayClock = halMillis();
+  replaySpeed = speed < 1 ? 1 : speed;
+  replayEvents = 0;
+  replayMatched = false;
+
+  trainerRandomSeed(seed);
+  traceState = TRACE_REPLAYING;
+  resetDecoder();
+  sessionStartTime = halMillis();
+  fingerprint = FNV_OFFSET;
+  return true;
+}
+
+// Put the device back to its stored settings once a replay is over
+static void finishReplay(bool sawEnd, uint32_t expected) {
+  traceState = TRACE_IDLE;
+  replayMatched = sawEnd && fingerprint == expected;
+  kochSending = false;
+  kochListening = false;
+  halToneOff();
+
+  consolePrintf("Trace replay %s: %lu events, output %08lx (%s)\n", sawEnd ? "done" : "aborted",
+                (unsigned long)replayEvents, (unsigned long)fingerprint,
+                replayMatched ? "matches recording" : "DIFFERS");
+
+  loadSettings();
+  initializeKoch();
+  applySettings();
+}
+
+bool traceReplayPoll() {
+  if (traceState != TRACE_REPLAYING) return false;
+
+  uint32_t now = halMillis();
+  while (true) {
+    TraceReader in = { replayData, replayLen, replayPos, true };
+    uint8_t head = in.byte();
+    uint32_t dt = in.varint();
+    if (!in.ok) {
+      finishReplay(false, 0);
+      return false;
+    }
+    if ((int32_t)(now - (replayClock + dt)) < 0) return true;  // not due yet
+    replayClock += dt;
+
+    uint8_t arg = head & 0x0F;
+    char line[TRACE_LINE_MAX + 1];
+    switch (head >> 4) {
+      case TRACE_KEY:
+        tracedKey = arg;
+        break;
+      case TRACE_TONE:
+        tracedTone = arg;
+        break;
+      case TRACE_ENCODER:
+        {
+          uint32_t zigzag = in.varint();
+          int delta = (zigzag & 1) ? -(int)((zigzag + 1) >> 1) : (int)(zigzag >> 1);
+          if (in.ok) menuRotate(delta);
+        }
+        break;
+      case TRACE_BUTTON:
+        if (arg) menuLongPress();
+        else menuShortPress();
+        break;
+      case TRACE_SERIAL:
+      case TRACE_LINK:
+        {
+          uint8_t n = in.byte();
+          if (in.pos + n > replayLen) {
+            in.ok = false;
+            break;
+          }
+          memcpy(line, replayData + in.pos, n);
+          line[n] = '\0';
+          in.pos += n;
+          if ((head >> 4) == TRACE_SERIAL) processSerialCommand(line);
+          else processWiFiMessage(line);
+        }
+        break;
+      case TRACE_END:
+        {
+          uint32_t expected = in.u32();
+          finishReplay(in.ok, expected);
+        }
+        return false;
+      default:
+        in.ok = false;
+        break;
+    }
+    if (!in.ok) {
+      finishReplay(false, 0);
+      return false;
+    }
+    replayPos = in.pos;
+    replayEvents++;
+  }
+}
+
+void traceReplayStop() {
+  if (traceState == TRACE_REPLAYING) finishReplay(false, 0);
+}
+
+bool traceReplaying() {
+  return traceState == TRACE_REPLAYING;
+}
+
+uint32_t traceReplaySpeed() {
+  return replaySpeed;
+}
+
+bool traceReplayMatched() {
+  return replayMatched;
+}
+
+// ---- USB console ----------------------------------------------------------------
+
+static void dumpTrace() {
+  consolePrintf("TRACE BEGIN %u\n", (unsigned)traceLen);
+  for (size_t i = 0; i < traceLen; i += 32) {
+    char hex[65];
+    size_t n = traceLen - i < 32 ? traceLen - i : 32;
+    for (size_t j = 0; j < n; j++) {
+      snprintf(hex + 2 * j, 3, "%02X", traceBuffer[i + j]);
+    }
+    consolePrintf("%s\n", hex);
+  }
+  consolePrintf("TRACE END\n");
+}
+
+void processTraceCommand(const char* args) {
+  if (strcmp(args, "START") == 0) {
+    traceRecordStart();
+    consolePrintf("Trace recording (%u bytes)\n", (unsigned)sizeof(traceBuffer));
+  } else if (strcmp(args, "STOP") == 0) {
+    if (traceState == TRACE_REPLAYING) {
+      traceReplayStop();
+    } else {
+      traceRecordStop();
+      consolePrintf("Trace stopped: %lu events, %u bytes%s\n", (unsigned long)traceEvents,
+                    (unsigned)traceLen, traceFull ? " (buffer full, events dropped)" : "");
+    }
+  } else if (strcmp(args, "DUMP") == 0) {
+    if (traceState == TRACE_IDLE) dumpTrace();
+  } else if (startsWith(args, "REPLAY")) {
+    int speed = atoi(args + 6);
+    if (traceState != TRACE_IDLE || traceLen == 0) {
+      consolePrintf("No finished trace to replay\n");
+    } else if (traceReplayBegin(traceBuffer, traceLen, speed > 0 ? speed : 1)) {
+      consolePrintf("Replaying trace at %lux\n", (unsigned long)replaySpeed);
+    }
+  } else {
+    consolePrintf("Trace: %s, %lu events, %u/%u bytes%s\n",
+                  traceState == TRACE_RECORDING ? "recording" : traceState == TRACE_REPLAYING ? "replaying" : "idle",
+                  (unsigned long)traceEvents, (unsigned)traceLen, (unsigned)sizeof(traceBuffer),
+                  traceFull ? ", events dropped" : "");
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef TRAINER_TRACE_H
+#define TRAINER_TRACE_H
+
+// Input event trace: records every input the core consumes (key and tone
+// detector edges, encoder detents, button presses, console and companion
+// lines) into a RAM buffer, and replays such a buffer through the same code
+// paths at any speed. Dumped over USB with TRACE DUMP, a field trace becomes a
+// reproducible regression case for host_sim.
+//
+// Format (little-endian):
+//   header  "CWT2", seed u32, then the config/decoder/menu snapshot the
+//           recording started from (see writeSnapshot())
+//   events  type<<4 | arg, varint ms since the previous event, payload
+//   end     TRACE_END with a u32 FNV-1a fingerprint of the console output
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE 32768
+#endif
+
+enum TraceEventType : uint8_t {
+  TRACE_KEY = 1,      // arg = key down
+  TRACE_TONE = 2,     // arg = tone detected
+  TRACE_ENCODER = 3,  // payload: zigzag varint detents
+  TRACE_BUTTON = 4,   // arg = 0 short press, 1 long press
+  TRACE_SERIAL = 5,   // payload: u8 length + console line
+  TRACE_LINK = 6,     // payload: u8 length + companion line
+  TRACE_END = 15      // payload: u32 output fingerprint
+};
+
+enum TraceState : uint8_t { TRACE_IDLE,
+                            TRACE_RECORDING,
+                            TRACE_REPLAYING };
+
+// Recording
+void traceRecordStart();
+void traceRecordStop();
+bool traceRecording();
+bool traceOverflowed();  // buffer filled and events were dropped
+
+// Replay. A device replays its own buffer; host_sim loads a dumped one.
+bool traceReplayBegin(const uint8_t* data, size_t len, uint32_t speed);
+bool traceReplayPoll();  // feed events due by halMillis(); false once finished
+void traceReplayStop();
+bool traceReplaying();
+uint32_t traceReplaySpeed();
+bool traceReplayMatched();  // fingerprint of the finished replay equals the recording
+
+const uint8_t* traceData();
+size_t traceLength();
+uint32_t traceEventCount();
+
+// Input hooks used by the core. While replaying, key and tone read back the
+// traced state instead of the live inputs.
+bool traceKeyDown();
+bool traceToneDetected();
+void traceEncoder(int delta);
+void traceButton(bool longPress);
+void traceSerialLine(const char* line);
+void traceLinkLine(const char* line);
+void traceOutput(const char* text);  // console output, folded into the fingerprint
+
+// USB console: TRACE START|STOP|DUMP|INFO|REPLAY [speed]
+void processTraceCommand(const char* args);
+
+#endif  // TRAINER_TRACE_H
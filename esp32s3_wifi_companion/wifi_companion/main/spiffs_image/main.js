@@ -1,8 +1,12 @@
 const API_BASE = '';
 const statusTable = document.getElementById('status-table');
 const statsTable  = document.getElementById('stats-table');
+const charTable   = document.getElementById('char-table');
 const lastCmdEl   = document.getElementById('last-cmd');
 const ipEl        = document.getElementById('device-ip');
+const profileEl   = document.getElementById('profile-select');
+const historyTierEl = document.getElementById('history-tier');
+const historyChart  = document.getElementById('history-chart');
 
 // fetch device IP via window.location once loaded
 ipEl.textContent = location.hostname;
@@ -20,6 +24,39 @@ document.getElementById('reset-stats').addEventListener('click', () => {
   }).then(refreshAll);
 });
 
+document.getElementById('import-backup').addEventListener('click', async () => {
+  const file = document.getElementById('import-file').files[0];
+  const resultEl = document.getElementById('import-result');
+  if (!file) return;
+  resultEl.textContent = 'Restoring...';
+  const r = await fetch(`${API_BASE}/api/import`, {
+    method: 'POST',
+    headers: { 'Content-Type': 'application/octet-stream' },
+    body: file
+  });
+  const res = await r.json();
+  resultEl.textContent = res.ok ? `Restored ${res.records} records` : `Failed: ${res.error}`;
+  refreshAll();
+});
+
+historyTierEl.addEventListener('change', refreshHistory);
+profileEl.addEventListener('change', () => sendCmd(`TEENSY:PROFILE:${profileEl.value}`));
+
+document.getElementById('profile-rename').addEventListener('click', () => {
+  const name = document.getElementById('profile-name').value.trim();
+  if (name) sendCmd(`TEENSY:PROFILE_NAME:${name}`);
+});
+
+function renderProfiles(active, names) {
+  if (document.activeElement === profileEl) return;  // do not yank the list while it is open
+  profileEl.innerHTML = '';
+  names.forEach((name, i) => {
+    const option = new Option(`${i + 1} ${name}`, i + 1);
+    option.selected = i + 1 === active;
+    profileEl.add(option);
+  });
+}
+
 function renderTable(table, dataObj) {
   table.innerHTML = '';
   Object.entries(dataObj).forEach(([k, v]) => {
@@ -29,6 +66,50 @@ function renderTable(table, dataObj) {
   });
 }
 
+// One row per copied character: accuracy, what it was mistaken for, and the
+// response-time histogram (<300, <600, <1200, <2400, <4800, more ms)
+function renderCharTable(table, symbols) {
+  table.innerHTML = '';
+  const head = table.insertRow();
+  ['Char', 'Accuracy', 'Copied as', 'Response ms <300/600/1.2k/2.4k/4.8k/more'].forEach(h => {
+    head.insertCell().textContent = h;
+  });
+  symbols.forEach(c => {
+    const total = c.correct + c.errors;
+    const row = table.insertRow();
+    row.insertCell().textContent = c.symbol;
+    row.insertCell().textContent = total ? `${(100 * c.correct / total).toFixed(1)}% (${c.correct}/${total})` : '-';
+    row.insertCell().textContent = Object.entries(c.confusions).map(([k, v]) => `${k}:${v}`).join(' ');
+    row.insertCell().textContent = c.latency.join('/');
+  });
+}
+
+// Accuracy on a 0-100 scale, speed scaled to the fastest point
+function renderHistory(canvas, points) {
+  const ctx = canvas.getContext('2d');
+  const w = canvas.width, h = canvas.height, pad = 10;
+  ctx.clearRect(0, 0, w, h);
+  if (points.length === 0) return;
+  const color = getComputedStyle(document.documentElement).getPropertyValue('--accent') || '#0a0';
+  const maxWpm = Math.max(...points.map(p => p.wpm), 1);
+  const x = i => pad + (points.length > 1 ? i * (w - 2 * pad) / (points.length - 1) : (w - 2 * pad) / 2);
+  const line = (value, dash) => {
+    ctx.beginPath();
+    ctx.setLineDash(dash);
+    points.forEach((p, i) => {
+      const y = h - pad - value(p) * (h - 2 * pad);
+      i ? ctx.lineTo(x(i), y) : ctx.moveTo(x(i), y);
+    });
+    ctx.stroke();
+  };
+  ctx.strokeStyle = color.trim();
+  ctx.lineWidth = 2;
+  line(p => p.accuracy / 100, []);
+  ctx.strokeStyle = '#888';
+  line(p => p.wpm / maxWpm, [4, 4]);
+  ctx.setLineDash([]);
+}
+
 async function getJSON(path) {
   const r = await fetch(`${API_BASE}${path}`);
   if (!r.ok) throw new Error(path + ' ' + r.status);
@@ -37,27 +118,50 @@ async function getJSON(path) {
 
 async function refreshStatus() {
   try {
-    const s = await getJSON('/api/status');
+    const { profile, profiles, link, audio: au, spectrum: sp, ...s } = await getJSON('/api/status');
+    renderProfiles(profile, profiles);
+    if (link) {
+      s.link = `${link.framed ? 'framed' : 'text'} at ${link.baud} baud, ${link.frames + link.lines} received, ` +
+               `${link.badFrames} bad, ${link.lostFrames} lost, ${link.garbled} garbled, ${link.badFields} bad fields, ${link.overruns} overruns`;
+    }
+    if (au && au.listeners) {
+      s.audio = `${au.listeners} listening, ${au.frames} frames, ${au.lost} samples lost, ${au.dropped} dropped, ` +
+                `${au.upstreamMs} ms to the companion, ${au.latencyMs} ms to the speaker, ${au.underruns} underruns`;
+    }
+    if (sp && sp.listeners) {
+      s.spectrum = `${sp.listeners} watching, ${sp.frames} frames, ${sp.dropped} dropped, ${sp.upstreamMs} ms to the companion`;
+    }
     renderTable(statusTable, s);
   } catch (e) { console.error(e); }
 }
 
 async function refreshStats() {
   try {
-    const st = await getJSON('/api/stats');
+    const { symbols, ...st } = await getJSON('/api/stats');
     renderTable(statsTable, st);
+    renderCharTable(charTable, symbols || []);
+  } catch (e) { console.error(e); }
+}
+
+async function refreshHistory() {
+  try {
+    const { points } = await getJSON(`/api/history?tier=${historyTierEl.value}`);
+    renderHistory(historyChart, points);
   } catch (e) { console.error(e); }
 }
 
 async function refreshControl() {
   try {
     const c = await getJSON('/api/control');
-    lastCmdEl.textContent = c.lastCmd || '-';
+    let text = c.lastCmd || '-';
+    if (c.lastResult === 'TIMEOUT') text += ' (no answer)';
+    else if (c.lastResult) text += ` (${c.lastResult}, ${c.lastLatencyMs} ms)`;
+    lastCmdEl.textContent = text;
   } catch (e) { console.error(e); }
 }
 
 async function refreshAll() {
-  await Promise.all([refreshStatus(), refreshStats(), refreshControl()]);
+  await Promise.all([refreshStatus(), refreshStats(), refreshHistory(), refreshControl()]);
 }
 
 async function sendCmd(cmd) {
@@ -69,5 +173,174 @@ async function sendCmd(cmd) {
   refreshControl();
 }
 
+// ---- Live audio -------------------------------------------------------------
+// /ws/audio carries the Teensy's IMA-ADPCM frames (cw-trainer/trainer_monitor.h),
+// each after a uint16 of ms already spent upstream. Frames are scheduled
+// AUDIO_BUFFER_MS ahead; a gap in the sample numbers plays as silence, and a
+// frame that arrives too late restarts the buffer (an underrun).
+
+const AUDIO_RATE = 8000;
+const AUDIO_BUFFER_MS = 80;
+const ADPCM_STEPS = [
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+  107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+  876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428,
+  4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+  22385, 24623, 27086, 29794, 32767];
+const ADPCM_INDEX_STEPS = [-1, -1, -1, -1, 2, 4, 6, 8];
+
+const audioToggle = document.getElementById('audio-toggle');
+const audioInfoEl = document.getElementById('audio-info');
+let audio = null;  // the open stream: socket, AudioContext and playback state
+
+function adpcmDecode(codes, predictor, index) {
+  const out = new Float32Array(codes.length * 2);
+  for (let i = 0; i < out.length; i++) {
+    const code = (codes[i >> 1] >> (i & 1 ? 4 : 0)) & 0x0F;
+    const step = ADPCM_STEPS[index];
+    let diff = step >> 3;
+    if (code & 4) diff += step;
+    if (code & 2) diff += step >> 1;
+    if (code & 1) diff += step >> 2;
+    predictor = Math.max(-32768, Math.min(32767, predictor + (code & 8 ? -diff : diff)));
+    index = Math.max(0, Math.min(88, index + ADPCM_INDEX_STEPS[code & 7]));
+    out[i] = predictor / 32768;
+  }
+  return out;
+}
+
+// uint16 upstream ms, then FrameAudio: uint32 sample, uint32 time, uint16 age,
+// int16 predictor, uint8 index, then the codes
+function playAudioFrame(a, data) {
+  if (data.byteLength < 15) return;
+  const view = new DataView(data);
+  const upstream = view.getUint16(0, true);
+  const sample = view.getUint32(2, true);
+  const pcm = adpcmDecode(new Uint8Array(data, 15), view.getInt16(12, true), view.getUint8(14));
+  const now = a.ctx.currentTime;
+  if (a.nextSample !== null && sample !== a.nextSample) {
+    a.nextTime += Math.min(sample - a.nextSample, AUDIO_RATE) / AUDIO_RATE;  // lost on the way
+  }
+  if (a.nextTime < now) {
+    if (a.nextSample !== null) a.underruns++;
+    a.nextTime = now + AUDIO_BUFFER_MS / 1000;
+  }
+  const buffer = a.ctx.createBuffer(1, pcm.length, AUDIO_RATE);
+  buffer.copyToChannel(pcm, 0);
+  const source = a.ctx.createBufferSource();
+  source.buffer = buffer;
+  source.connect(a.ctx.destination);
+  source.start(a.nextTime);
+  a.bufferMs = (a.nextTime - now) * 1000;
+  a.latency = upstream + a.bufferMs + (a.ctx.outputLatency || a.ctx.baseLatency || 0) * 1000;
+  a.nextTime += buffer.duration;
+  a.nextSample = sample + pcm.length;
+}
+
+function reportAudio(a) {
+  if (a.ws.readyState !== WebSocket.OPEN) return;
+  const report = { latency: Math.round(a.latency), buffer: Math.round(a.bufferMs), underruns: a.underruns };
+  a.ws.send(JSON.stringify(report));
+  a.ws.send(`ping:${performance.now().toFixed(1)}`);
+  audioInfoEl.textContent = `${report.latency} ms behind the key (${report.buffer} ms buffered), ` +
+                            `${a.underruns} underruns, round trip ${a.rtt === null ? '-' : a.rtt.toFixed(0)} ms`;
+}
+
+function stopAudio() {
+  if (!audio) return;
+  clearInterval(audio.timer);
+  audio.ws.close();
+  audio.ctx.close();
+  audio = null;
+  audioToggle.textContent = 'Listen';
+  audioInfoEl.textContent = '';
+}
+
+function startAudio() {
+  const ctx = new AudioContext({ latencyHint: 'interactive' });
+  const ws = new WebSocket(`ws://${location.host}/ws/audio`);
+  ws.binaryType = 'arraybuffer';
+  const a = { ws, ctx, nextTime: 0, nextSample: null, underruns: 0, latency: 0, bufferMs: 0, rtt: null };
+  ws.onmessage = ev => {
+    if (typeof ev.data !== 'string') playAudioFrame(a, ev.data);
+    else if (ev.data.startsWith('pong:')) a.rtt = performance.now() - parseFloat(ev.data.slice(5));
+  };
+  ws.onclose = () => { if (audio === a) stopAudio(); };
+  a.timer = setInterval(() => reportAudio(a), 1000);
+  audio = a;
+  audioToggle.textContent = 'Stop';
+  audioInfoEl.textContent = 'Connecting...';
+}
+
+audioToggle.addEventListener('click', () => (audio ? stopAudio() : startAudio()));
+
+// ---- Waterfall ----------------------------------------------------------------
+// /ws/spectrum carries FRAME_SPECTRUM (cw-trainer/trainer_spectrum.h) after the
+// same uint16 upstream ms as the audio: uint32 time, uint16 first bin, uint16
+// bin width in mHz, uint8 bins per point, then one level per point in half-dB
+// steps above -127.5 dBFS. Each frame is one row, newest at the top.
+
+const WATERFALL_FLOOR_DB = -100;
+const WATERFALL_RANGE_DB = 70;
+
+const spectrumToggle = document.getElementById('spectrum-toggle');
+const spectrumInfoEl = document.getElementById('spectrum-info');
+const waterfall = document.getElementById('waterfall');
+let spectrum = null;  // the open socket
+
+function spectrumConfig() {
+  const value = id => parseInt(document.getElementById(id).value, 10);
+  return { low: value('spectrum-low'), high: value('spectrum-high'), points: 48, rate: value('spectrum-rate') };
+}
+
+// Dark blue through red to yellow as the level rises
+function waterfallColor(level) {
+  const t = Math.max(0, Math.min(1, (level / 2 - 127.5 - WATERFALL_FLOOR_DB) / WATERFALL_RANGE_DB));
+  return [Math.round(255 * Math.min(1, t * 2)), Math.round(255 * Math.max(0, t * 2 - 1)), Math.round(96 * (1 - t))];
+}
+
+function drawSpectrumFrame(data) {
+  if (data.byteLength < 11) return;
+  const view = new DataView(data);
+  const firstBin = view.getUint16(6, true);
+  const binHz = view.getUint16(8, true) / 1000;
+  const merge = view.getUint8(10);
+  const levels = new Uint8Array(data, 11);
+  const ctx = waterfall.getContext('2d');
+  const w = waterfall.width;
+  ctx.drawImage(waterfall, 0, 1);
+  const row = ctx.createImageData(w, 1);
+  for (let x = 0; x < w; x++) {
+    const [r, g, b] = waterfallColor(levels[Math.floor(x * levels.length / w)]);
+    row.data.set([r, g, b, 255], x * 4);
+  }
+  ctx.putImageData(row, 0, 0);
+  const low = firstBin * binHz;
+  spectrumInfoEl.textContent = `${low.toFixed(0)}-${(low + levels.length * merge * binHz).toFixed(0)} Hz, ` +
+                               `${levels.length} points of ${(merge * binHz).toFixed(0)} Hz, ${view.getUint16(0, true)} ms upstream`;
+}
+
+function stopSpectrum() {
+  if (!spectrum) return;
+  spectrum.close();
+  spectrum = null;
+  spectrumToggle.textContent = 'Show';
+}
+
+function startSpectrum() {
+  const ws = new WebSocket(`ws://${location.host}/ws/spectrum`);
+  ws.binaryType = 'arraybuffer';
+  ws.onopen = () => ws.send(JSON.stringify(spectrumConfig()));
+  ws.onmessage = ev => { if (typeof ev.data !== 'string') drawSpectrumFrame(ev.data); };
+  ws.onclose = () => { if (spectrum === ws) stopSpectrum(); };
+  spectrum = ws;
+  spectrumToggle.textContent = 'Hide';
+}
+
+spectrumToggle.addEventListener('click', () => (spectrum ? stopSpectrum() : startSpectrum()));
+document.getElementById('spectrum-apply').addEventListener('click', () => {
+  if (spectrum && spectrum.readyState === WebSocket.OPEN) spectrum.send(JSON.stringify(spectrumConfig()));
+});
+
 refreshAll();
 setInterval(refreshAll, 5000);
\ No newline at end of file
@@ -1,9 +1,12 @@
 #include "trainer_protocol.h"
+#include "trainer_frame.h"
+#include "web_server.h"
 #include "driver/uart.h"  // for uart_wait_tx_idle_polling
 #include "esp_log.h"
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <stdlib.h>
 #include "driver/uart.h"
 #include "esp_system.h"  // for esp_restart
 
@@ -11,109 +14,541 @@
 #define UART_1 UART_NUM_1
 #endif
 
+#define BUF_LEN_RX 512  /* longest line or frame from the Teensy */
 
-trainer_status_t g_status;  // zero-initialised by default
+#define BAUD_CONFIRM_MS 2000   /* a new rate must carry something valid by then */
+#define BAUD_SILENCE_MS 15000  /* three missed pings at a raised rate */
+#define BAUD_ERROR_QUIET_MS 1000  /* UART errors this long after the last good message */
 
-void trainer_status_reset(void)
-{
-    memset(&g_status, 0, sizeof(g_status));
-    g_status.frequency = 600;
-    g_status.speed = 20;
-    g_status.effective_speed = 13;
-    strcpy(g_status.waveform, "Sine");
-    strcpy(g_status.output, "Headphones");
-    g_status.wifi_connected = false;
-    g_status.teensy_ready = false;
-}
 
-static void parse_status_message(const char *status)
+static uint8_t s_rx_buffer[BUF_LEN_RX];
+static FrameReceiver s_rx;
+static bool s_framed = false;     // send frames; set by the Teensy's HELLO
+static uint8_t s_tx_seq = 0;
+static FrameStatus s_status;      // last STATUS frame with the deltas since applied
+
+/* UART rate (cw-trainer/trainer_frame.h); the Teensy proposes, we follow */
+static uint32_t s_max_baud = LINK_BAUD_DEFAULT;
+static bool s_flow = false;
+static uint32_t s_baud = LINK_BAUD_DEFAULT;
+static uint32_t s_baud_since = 0;     /* ms */
+static bool s_baud_confirmed = true;  /* something valid arrived at s_baud */
+static uint32_t s_last_good = 0;      /* ms of the last valid line or frame */
+
+/* Teensy times of the latest decoded characters, for copy speed */
+#define COPY_WINDOW 16
+#define COPY_IDLE_MS 10000  /* a longer pause starts a new measurement */
+static uint32_t s_copy_times[COPY_WINDOW];
+static int s_copy_count = 0;
+static int s_copy_head = 0;
+
+static const char *const waveform_names[] = { "Sine", "Square", "Sawtooth", "Triangle" };
+
+/* Next KEY=VALUE field of a STATUS: or STATS: line; false at the end. A field
+ * without '=', or with a key or value too long for the buffers, is skipped
+ * and counted rather than cut short into something else. */
+static bool next_field(const char **p, char *key, size_t key_size, char *val, size_t val_size)
 {
-    const char *p = status;
-    while (*p) {
-        const char *eq = strchr(p, '=');
-        if (!eq) break;
-        const char *comma = strchr(eq, ',');
-        if (!comma) comma = p + strlen(p);
-
-        char key[16] = {0};
-        char val[32] = {0};
-        size_t klen = eq - p;
-        size_t vlen = comma - eq - 1;
-        if (klen >= sizeof(key)) klen = sizeof(key) - 1;
-        if (vlen >= sizeof(val)) vlen = sizeof(val) - 1;
-        memcpy(key, p, klen);
-        memcpy(val, eq + 1, vlen);
+    while (**p) {
+        const char *field = *p;
+        const char *comma = strchr(field, ',');
+        if (!comma) comma = field + strlen(field);
+        *p = *comma ? comma + 1 : comma;
+
+        const char *eq = memchr(field, '=', comma - field);
+        size_t klen = eq ? (size_t)(eq - field) : 0;
+        size_t vlen = eq ? (size_t)(comma - eq - 1) : 0;
+        if (klen == 0 || klen >= key_size || vlen >= val_size) {
+            g_status.link.bad_fields++;
+            continue;
+        }
+        memcpy(key, field, klen);
         key[klen] = '\0';
+        memcpy(val, eq + 1, vlen);
         val[vlen] = '\0';
+        return true;
+    }
+    return false;
+}
 
-        if (strcmp(key, "LESSON") == 0) g_status.lesson = atoi(val);
-        else if (strcmp(key, "FREQ") == 0) g_status.frequency = atoi(val);
-        else if (strcmp(key, "SPEED") == 0) g_status.speed = atoi(val);
-        else if (strcmp(key, "EFFSPEED") == 0) g_status.effective_speed = atoi(val);
-        else if (strcmp(key, "ACC") == 0) g_status.accuracy = (float)atof(val);
-        else if (strcmp(key, "DEC") == 0) g_status.decoder_enabled = (strcmp(val, "1") == 0);
-        else if (strcmp(key, "KOCH") == 0) g_status.koch_mode = (strcmp(val, "1") == 0);
-        else if (strcmp(key, "WAVE") == 0) strncpy(g_status.waveform, val, sizeof(g_status.waveform) - 1);
-        else if (strcmp(key, "OUT") == 0) strncpy(g_status.output, val, sizeof(g_status.output) - 1);
-        else if (strcmp(key, "SEND") == 0) g_status.sending = (strcmp(val, "1") == 0);
-        else if (strcmp(key, "LISTEN") == 0) g_status.listening = (strcmp(val, "1") == 0);
+/* The whole value as a number within [min, max]; anything else is counted
+ * and leaves the field as it was */
+static bool parse_number(const char *val, double min, double max, double *out)
+{
+    char *end;
+    double v = strtod(val, &end);
+    if (end == val || *end || !(v >= min && v <= max)) {  /* also NaN */
+        g_status.link.bad_fields++;
+        return false;
+    }
+    *out = v;
+    return true;
+}
 
-        if (*comma == '\0') break;
-        p = comma + 1;
+static bool parse_flag(const char *val, bool *out)
+{
+    if ((val[0] != '0' && val[0] != '1') || val[1]) {
+        g_status.link.bad_fields++;
+        return false;
+    }
+    *out = val[0] == '1';
+    return true;
+}
+
+static void parse_status_message(const char *status)
+{
+    const char *p = status;
+    char key[16];
+    char val[32];
+    double v;
+    while (next_field(&p, key, sizeof(key), val, sizeof(val))) {
+        /* Bounds are the widths of the FrameStatus members */
+        if (strcmp(key, "LESSON") == 0) {
+            if (parse_number(val, 0, 255, &v)) g_status.lesson = (int)v;
+        } else if (strcmp(key, "FREQ") == 0) {
+            if (parse_number(val, 0, 65535, &v)) g_status.frequency = (int)v;
+        } else if (strcmp(key, "SPEED") == 0) {
+            if (parse_number(val, 0, 255, &v)) g_status.speed = (int)v;
+        } else if (strcmp(key, "EFFSPEED") == 0) {
+            if (parse_number(val, 0, 255, &v)) g_status.effective_speed = (int)v;
+        } else if (strcmp(key, "ACC") == 0) {
+            if (parse_number(val, 0, 100, &v)) g_status.accuracy = (float)v;
+        } else if (strcmp(key, "DEC") == 0) {
+            parse_flag(val, &g_status.decoder_enabled);
+        } else if (strcmp(key, "KOCH") == 0) {
+            parse_flag(val, &g_status.koch_mode);
+        } else if (strcmp(key, "SEND") == 0) {
+            parse_flag(val, &g_status.sending);
+        } else if (strcmp(key, "LISTEN") == 0) {
+            parse_flag(val, &g_status.listening);
+        } else if (strcmp(key, "WAVE") == 0) {
+            size_t i = 0;
+            while (i < sizeof(waveform_names) / sizeof(waveform_names[0]) && strcmp(val, waveform_names[i]) != 0) i++;
+            if (i < sizeof(waveform_names) / sizeof(waveform_names[0])) strcpy(g_status.waveform, waveform_names[i]);
+            else g_status.link.bad_fields++;
+        } else if (strcmp(key, "OUT") == 0) {
+            if (strcmp(val, "Headphones") == 0 || strcmp(val, "Speaker") == 0) strcpy(g_status.output, val);
+            else g_status.link.bad_fields++;
+        }
+        /* other keys are a newer Teensy's */
     }
 }
 
 static void parse_stats_message(const char *stats)
 {
     const char *p = stats;
-    while (*p) {
-        const char *eq = strchr(p, '=');
-        if (!eq) break;
-        const char *comma = strchr(eq, ',');
-        if (!comma) comma = p + strlen(p);
-
-        char key[16] = {0};
-        char val[32] = {0};
-        size_t klen = eq - p;
-        size_t vlen = comma - eq - 1;
-        if (klen >= sizeof(key)) klen = sizeof(key) - 1;
-        if (vlen >= sizeof(val)) vlen = sizeof(val) - 1;
-        memcpy(key, p, klen);
-        memcpy(val, eq + 1, vlen);
-        key[klen] = '\0';
-        val[vlen] = '\0';
+    char key[16];
+    char val[32];
+    double v;
+    while (next_field(&p, key, sizeof(key), val, sizeof(val))) {
+        if (strcmp(key, "SESSIONS") == 0) {
+            if (parse_number(val, 0, UINT32_MAX, &v)) g_status.sessions = (uint32_t)v;
+        } else if (strcmp(key, "CHARS") == 0) {
+            if (parse_number(val, 0, UINT32_MAX, &v)) g_status.characters = (uint32_t)v;
+        } else if (strcmp(key, "BESTWPM") == 0) {
+            if (parse_number(val, 0, 100, &v)) g_status.best_wpm = (float)v;
+        }
+    }
+}
+
+/* CHARSTAT:<symbol>|<correct>|<errors>|<copied><count> ...|<latency bins>
+ * Fields are split on '|' because ',' and '=' are Morse symbols. */
+static void parse_charstat_message(const char *msg)
+{
+    if (!msg[0] || msg[1] != '|') return;
+    char symbol = msg[0];
+
+    char_stat_t *entry = NULL;
+    for (int i = 0; i < g_status.char_stat_count; i++) {
+        if (g_status.char_stats[i].symbol == symbol) {
+            entry = &g_status.char_stats[i];
+            break;
+        }
+    }
+    if (!entry) {
+        if (g_status.char_stat_count >= CHAR_STATS_MAX) return;
+        entry = &g_status.char_stats[g_status.char_stat_count++];
+    }
+    memset(entry, 0, sizeof(*entry));
+    entry->symbol = symbol;
+
+    char *p = (char *)msg + 2;
+    entry->correct = (uint16_t)strtoul(p, &p, 10);
+    if (*p != '|') return;
+    entry->errors = (uint32_t)strtoul(p + 1, &p, 10);
+    if (*p != '|') return;
+    p++;
+    while (*p && *p != '|' && entry->confusion_count < CHAR_CONFUSIONS_MAX) {
+        if (*p == ' ') {
+            p++;
+            continue;
+        }
+        entry->confused_with[entry->confusion_count] = *p;
+        entry->confused_times[entry->confusion_count] = (uint16_t)strtoul(p + 1, &p, 10);
+        entry->confusion_count++;
+    }
+    p = strchr(p, '|');
+    if (!p) return;
+    p++;
+    for (int i = 0; i < LATENCY_BINS && *p; i++) {
+        entry->latency[i] = (uint8_t)strtoul(p, &p, 10);
+    }
+}
+
+/* PROFILES:<active>|<name>|<name>... with the active profile 1-based */
+static void parse_profiles_message(const char *msg)
+{
+    char *p;
+    int profile = (int)strtol(msg, &p, 10);
+    if (profile != g_status.profile) {
+        /* the Teensy resends the new profile's CHARSTAT and HISTORY lines */
+        g_status.char_stat_count = 0;
+        memset(g_status.history, 0, sizeof(g_status.history));
+    }
+    g_status.profile = profile;
+    g_status.profile_count = 0;
+    while (*p == '|' && g_status.profile_count < PROFILES_MAX) {
+        p++;
+        size_t len = strcspn(p, "|");
+        char *name = g_status.profiles[g_status.profile_count++];
+        if (len >= PROFILE_NAME_LEN) len = PROFILE_NAME_LEN - 1;
+        memcpy(name, p, len);
+        name[len] = '\0';
+        p += strcspn(p, "|");
+    }
+}
 
-        if (strcmp(key, "SESSIONS") == 0) g_status.sessions = (uint32_t)atoi(val);
-        else if (strcmp(key, "CHARS") == 0) g_status.characters = (uint32_t)atoi(val);
-        else if (strcmp(key, "BESTWPM") == 0) g_status.best_wpm = (float)atof(val);
+/* HISTORY:<S|D|W> <slot> <start> <sessions> <lesson> <characters> <accuracy> <speed> <effective>
+ * or HISTORY:CLEAR before a full resend */
+static void parse_history_message(const char *msg)
+{
+    if (strcmp(msg, "CLEAR") == 0) {
+        memset(g_status.history, 0, sizeof(g_status.history));
+        return;
+    }
+    const char *tiers = "SDW";
+    const char *t = strchr(tiers, msg[0]);
+    if (!msg[0] || !t) return;
 
-        if (*comma == '\0') break;
-        p = comma + 1;
+    int slot;
+    unsigned long start, characters;
+    unsigned sessions, lesson;
+    float accuracy, speed, effective;
+    if (sscanf(msg + 1, "%d %lu %u %u %lu %f %f %f", &slot, &start, &sessions, &lesson, &characters,
+               &accuracy, &speed, &effective) != 8 || slot < 0 || slot >= HISTORY_SLOTS_MAX) {
+        return;
     }
+    history_ring_t *ring = &g_status.history[t - tiers];
+    history_point_t *p = &ring->slots[slot];
+    p->start = start;
+    p->sessions = (uint16_t)sessions;
+    p->lesson = (uint8_t)lesson;
+    p->characters = characters;
+    p->accuracy = accuracy;
+    p->speed = speed;
+    p->effective_speed = effective;
+    p->valid = true;
+    ring->newest = slot;
 }
 
-static void append_decoded_text(const char *fragment)
+/* Keeps at least the last 200 characters; the buffer is only shifted when it
+   fills, not on every fragment */
+static void append_decoded_text(const char *fragment, size_t len)
 {
-    strncat(g_status.decoded_text, fragment, sizeof(g_status.decoded_text) - strlen(g_status.decoded_text) - 1);
-    // keep last 200 chars like original
-    size_t len = strlen(g_status.decoded_text);
-    if (len > 200) {
-        memmove(g_status.decoded_text, g_status.decoded_text + (len - 200), 200);
-        g_status.decoded_text[200] = '\0';
+    const size_t keep = 200;
+    size_t room = sizeof(g_status.decoded_text) - 1;
+    if (len > keep) {
+        fragment += len - keep;
+        len = keep;
+    }
+    if (g_status.decoded_len + len > room) {
+        size_t drop = g_status.decoded_len + len - keep;
+        if (drop > g_status.decoded_len) drop = g_status.decoded_len;
+        memmove(g_status.decoded_text, g_status.decoded_text + drop, g_status.decoded_len - drop);
+        g_status.decoded_len -= drop;
     }
+    memcpy(g_status.decoded_text + g_status.decoded_len, fragment, len);
+    g_status.decoded_len += len;
+    g_status.decoded_text[g_status.decoded_len] = '\0';
+}
+
+static void note_copy_time(uint32_t t)
+{
+    uint32_t newest = s_copy_times[(s_copy_head + COPY_WINDOW - 1) % COPY_WINDOW];
+    if (s_copy_count > 0 && t - newest > COPY_IDLE_MS) {  /* also a restarted Teensy */
+        s_copy_count = 0;
+        g_status.copy_wpm = 0;
+    }
+    s_copy_times[s_copy_head] = t;
+    s_copy_head = (s_copy_head + 1) % COPY_WINDOW;
+    if (s_copy_count < COPY_WINDOW) s_copy_count++;
+
+    uint32_t oldest = s_copy_times[(s_copy_head + COPY_WINDOW - s_copy_count) % COPY_WINDOW];
+    if (s_copy_count >= 2 && t > oldest) {
+        /* five characters to the word, as the Teensy counts */
+        g_status.copy_wpm = (s_copy_count - 1) * 60000.0f / (t - oldest) / 5.0f;
+    }
+}
+
+/* FRAME_DECODED: the characters as text (mis-copies in brackets, like the
+   DECODED line) and their times for the copy speed */
+static void handle_decoded_frame(const uint8_t *body, size_t len)
+{
+    FrameDecoded head;
+    if (len < sizeof(head) || (len - sizeof(head)) % sizeof(FrameDecodedChar) != 0) return;
+    memcpy(&head, body, sizeof(head));
+    char text[FRAME_BODY_MAX / sizeof(FrameDecodedChar) * 3 + 1];
+    size_t n = 0;
+    uint32_t t = head.start;
+    for (size_t i = sizeof(head); i < len; i += sizeof(FrameDecodedChar)) {
+        FrameDecodedChar entry;
+        memcpy(&entry, body + i, sizeof(entry));
+        t += entry.gap;
+        char c = entry.c & ~DECODED_MISCOPY;
+        if (c < 0x20 || c == 0x7F) {  /* would cut the text short or garble the page */
+            g_status.link.bad_fields++;
+            continue;
+        }
+        if (entry.c & DECODED_MISCOPY) {
+            text[n++] = '[';
+            text[n++] = c;
+            text[n++] = ']';
+        } else {
+            text[n++] = c;
+        }
+        if (c != ' ') note_copy_time(t);
+    }
+    append_decoded_text(text, n);
+}
+
+static void link_send_frame(uint8_t type, const void *body, size_t len)
+{
+    uint8_t frame[FRAME_ENCODED_MAX];  /* on the stack: any task may send */
+    size_t n = frameEncode(type, s_tx_seq++, body, len, frame);
+    uart_write_bytes(UART_1, (const char *)frame, n);
+}
+
+void link_send_line(const char *line)
+{
+    size_t len = strlen(line);
+    if (s_framed && len <= FRAME_BODY_MAX) {
+        link_send_frame(FRAME_TEXT, line, len);
+        return;
+    }
+    uart_write_bytes(UART_1, line, len);
+    uart_write_bytes(UART_1, "\n", 1);
+}
+
+static void send_pong(void)
+{
+    if (s_framed) {
+        link_send_frame(FRAME_PONG, NULL, 0);
+    } else {
+        uart_write_bytes(UART_1, "PONG\n", 5);    // async, do not block
+    }
+}
+
+void link_set_limits(uint32_t max_baud, bool flow_control)
+{
+    s_max_baud = max_baud;
+    s_flow = flow_control;
+    g_status.link.baud = s_baud;
+}
+
+/* Switches once everything queued has left at the old rate */
+static void set_baud(uint32_t baud)
+{
+    uart_wait_tx_done(UART_1, pdMS_TO_TICKS(100));
+    uart_set_baudrate(UART_1, baud);
+    s_baud = baud;
+    s_baud_since = esp_log_timestamp();
+    s_baud_confirmed = baud == LINK_BAUD_DEFAULT;
+    g_status.link.baud = baud;
+    ESP_LOGI("proto", "Teensy link at %u baud", (unsigned)baud);
+}
+
+/* BAUD:<rate>; answered at the current rate with the rate we will use */
+static void handle_baud(const char *msg)
+{
+    uint32_t rate = strtoul(msg, NULL, 10);
+    bool ok = rate >= LINK_BAUD_DEFAULT && rate <= s_max_baud &&
+              (rate <= LINK_BAUD_UNPACED || s_flow);
+    char reply[24];
+    snprintf(reply, sizeof(reply), PREFIX_BAUD_OK "%u", (unsigned)(ok ? rate : s_baud));
+    link_send_line(reply);
+    if (ok) set_baud(rate);
+}
+
+void link_poll(void)
+{
+    if (s_baud == LINK_BAUD_DEFAULT) return;
+    uint32_t now = esp_log_timestamp();
+    if ((!s_baud_confirmed && now - s_baud_since > BAUD_CONFIRM_MS) ||
+        now - s_last_good > BAUD_SILENCE_MS) {
+        ESP_LOGW("proto", "Nothing valid at %u baud", (unsigned)s_baud);
+        set_baud(LINK_BAUD_DEFAULT);
+    }
+}
+
+void link_uart_error(void)
+{
+    g_status.link.uart_errors++;
+    /* A restarted Teensy talks at the default rate; errors just after a
+       switch are its last bytes at the old one */
+    if (s_baud != LINK_BAUD_DEFAULT && esp_log_timestamp() - s_last_good > BAUD_ERROR_QUIET_MS) {
+        ESP_LOGW("proto", "UART errors at %u baud", (unsigned)s_baud);
+        set_baud(LINK_BAUD_DEFAULT);
+    }
+}
+
+/* HELLO:<version>,<capabilities>[,<max baud>] from the Teensy; answered in
+ * text, since it may not take frames, then frames are used if it offered them */
+static void handle_hello(const char *msg)
+{
+    const char *caps = strchr(msg, ',');
+    int version = atoi(msg);
+    char reply[40];
+    snprintf(reply, sizeof(reply), PREFIX_HELLO "%d,%d,%u\n", LINK_VERSION,
+             LINK_CAP_FRAMES | (s_flow ? LINK_CAP_FLOW : 0), (unsigned)s_max_baud);
+    uart_write_bytes(UART_1, reply, strlen(reply));
+    int cap_bits = caps ? atoi(caps + 1) : 0;
+    s_framed = version >= 1 && (cap_bits & LINK_CAP_FRAMES);
+    s_rx.seqKnown = false;
+    g_status.link.framed = s_framed;
+    g_status.link.acks = version >= 1 && (cap_bits & LINK_CAP_ACKS);
+    ESP_LOGI("proto", "Teensy link v%d, %s", version, s_framed ? "framed" : "text");
+    if (s_framed) web_link_hello();  /* the Teensy may have restarted under a watching browser */
+}
+
+static void handle_status_frame(const FrameStatus *s)
+{
+    g_status.lesson = s->lesson;
+    g_status.frequency = s->frequency;
+    g_status.speed = s->speed;
+    g_status.effective_speed = s->effectiveSpeed;
+    if (s->accuracy <= 1000) {
+        g_status.accuracy = s->accuracy / 10.0f;
+    } else {
+        g_status.link.bad_fields++;
+    }
+    g_status.decoder_enabled = s->flags & STATUS_DECODER;
+    g_status.koch_mode = s->flags & STATUS_KOCH;
+    g_status.sending = s->flags & STATUS_SENDING;
+    g_status.listening = s->flags & STATUS_LISTENING;
+    if (s->waveform < sizeof(waveform_names) / sizeof(waveform_names[0])) {
+        strcpy(g_status.waveform, waveform_names[s->waveform]);
+    }
+    strcpy(g_status.output, (s->flags & STATUS_HEADPHONES) ? "Headphones" : "Speaker");
+}
+
+static void handle_frame(void)
+{
+    char text[FRAME_BODY_MAX + 1];
+    if (s_rx.type == FRAME_TEXT) {
+        memcpy(text, s_rx.body, s_rx.bodyLen);
+        text[s_rx.bodyLen] = '\0';
+    }
+    switch (s_rx.type) {
+    case FRAME_TEXT:
+        process_teensy_message(text);
+        break;
+    case FRAME_PING:
+        send_pong();
+        break;
+    case FRAME_STATUS:
+        if (s_rx.bodyLen == sizeof(FrameStatus)) {
+            memcpy(&s_status, s_rx.body, sizeof(s_status));
+            handle_status_frame(&s_status);
+        }
+        break;
+    case FRAME_STATUS_DELTA:
+        if (frameStatusApply(&s_status, s_rx.body, s_rx.bodyLen)) {
+            handle_status_frame(&s_status);
+        }
+        break;
+    case FRAME_STATS:
+        if (s_rx.bodyLen == sizeof(FrameStats)) {
+            FrameStats s;
+            memcpy(&s, s_rx.body, sizeof(s));
+            g_status.sessions = s.sessions;
+            g_status.characters = s.characters;
+            if (s.bestWpm <= 1000) {
+                g_status.best_wpm = s.bestWpm / 10.0f;
+            } else {
+                g_status.link.bad_fields++;
+            }
+        }
+        break;
+    case FRAME_DECODED:
+        handle_decoded_frame(s_rx.body, s_rx.bodyLen);
+        break;
+    case FRAME_BENCH:
+        link_send_frame(FRAME_BENCH, s_rx.body, s_rx.bodyLen);
+        break;
+    case FRAME_AUDIO:
+        web_audio_frame(s_rx.body, s_rx.bodyLen);
+        break;
+    case FRAME_SPECTRUM:
+        web_spectrum_frame(s_rx.body, s_rx.bodyLen);
+        break;
+    default:
+        break;  /* a newer Teensy's message type */
+    }
+}
+
+void link_receive(const uint8_t *data, size_t len)
+{
+    if (!s_rx.buf) frameReceiverInit(&s_rx, s_rx_buffer, sizeof(s_rx_buffer));
+    for (size_t i = 0; i < len; i++) {
+        int got = frameReceiveByte(&s_rx, data[i]);
+        if (got != FRAME_RX_NONE) {
+            s_last_good = esp_log_timestamp();  /* before a BAUD: switch resets the confirmation */
+            s_baud_confirmed = true;
+        }
+        switch (got) {
+        case FRAME_RX_TEXT:
+            process_teensy_message(s_rx.text);
+            break;
+        case FRAME_RX_FRAME:
+            handle_frame();
+            break;
+        default:
+            break;
+        }
+    }
+    g_status.link.frames = s_rx.frames;
+    g_status.link.lines = s_rx.lines;
+    g_status.link.bad_frames = s_rx.crcErrors;
+    g_status.link.lost_frames = s_rx.seqGaps;
+    g_status.link.overflows = s_rx.overflows;
+    g_status.link.garbled = s_rx.garbled;
 }
 
 void process_teensy_message(const char *msg)
 {
-    ESP_LOGI("proto", "RX: %s", msg);
+    if (strncmp(msg, PREFIX_EXPORT, 7) == 0 || strncmp(msg, PREFIX_IMPORT, 7) == 0) {
+        ESP_LOGD("proto", "RX: %s", msg);
+    } else {
+        ESP_LOGI("proto", "RX: %s", msg);
+    }
     if (strncmp(msg, "STATUS:", 7) == 0) {
         parse_status_message(msg + 7);
     } else if (strncmp(msg, "DECODED:", 8) == 0) {
-        append_decoded_text(msg + 8);
+        append_decoded_text(msg + 8, strlen(msg + 8));
     } else if (strncmp(msg, "CURRENT:", 8) == 0) {
         strncpy(g_status.current_text, msg + 8, sizeof(g_status.current_text) - 1);
     } else if (strncmp(msg, "STATS:", 6) == 0) {
         parse_stats_message(msg + 6);
+    } else if (strncmp(msg, PREFIX_CHARSTAT, 9) == 0) {
+        parse_charstat_message(msg + 9);
+    } else if (strncmp(msg, PREFIX_HISTORY, 8) == 0) {
+        parse_history_message(msg + 8);
+    } else if (strncmp(msg, PREFIX_PROFILES, 9) == 0) {
+        parse_profiles_message(msg + 9);
+    } else if (strncmp(msg, PREFIX_EXPORT, 7) == 0 || strncmp(msg, PREFIX_IMPORT, 7) == 0) {
+        web_backup_line(msg);
+    } else if (strncmp(msg, PREFIX_ACK, 4) == 0) {
+        web_command_ack(msg + 4);
     } else if (strncmp(msg, "PING", 4) == 0) {
         ESP_LOGI("proto", "PING received");
         /* Measure how long it takes from receiving PING to queueing the PONG
@@ -122,9 +557,13 @@ void process_teensy_message(const char *msg)
          * uart_wait_tx_idle_polling() call to keep the protocol handler
          * responsive. */
         uint32_t start_ts = esp_log_timestamp();
-        uart_write_bytes(UART_1, "PONG\n", 5);    // async, do not block
+        send_pong();
         uint32_t latency = esp_log_timestamp() - start_ts;
         ESP_LOGI("proto", "TX: PONG (latency %u ms)", (unsigned)latency);
+    } else if (strncmp(msg, PREFIX_HELLO, 6) == 0) {
+        handle_hello(msg + 6);
+    } else if (strncmp(msg, PREFIX_BAUD, 5) == 0) {
+        handle_baud(msg + 5);
     } else if (strncmp(msg, "RESET_ESP", 9) == 0) {
         // Acknowledge then reboot
         uart_write_bytes(UART_1, "RESETTING\n", 10);
@@ -135,7 +574,10 @@ void process_teensy_message(const char *msg)
         ESP_LOGI("proto", "TX: PONG");
     } else if (strncmp(msg, "TEENSY:READY", 12) == 0) {
         //printf("Teensy ready\n");
-        g_status.teensy_ready = true;
+        g_teensy_ready = true;
+        s_framed = false;  /* a restarted Teensy talks text until its HELLO */
+        g_status.link.framed = false;
+        g_status.link.acks = false;
         uart_write_bytes(UART_1, "PONG\n", 5);
         // uart_wait_tx_idle_polling(UART_1);  // removed to avoid blocking
         ESP_LOGI("proto", "TX: PONG");
@@ -6,12 +6,29 @@
 #define MSG_READY_ESP01 "ESP01:READY"
 #define MSG_READY_ESP32 "ESP32:READY"
 #define MSG_HEARTBEAT   "ESP01:HEARTBEAT"
+#define PREFIX_HELLO    "HELLO:"
+#define PREFIX_BAUD     "BAUD:"
+#define PREFIX_BAUD_OK  "BAUD_OK:"
+#define PREFIX_CMD      "CMD:"
+#define PREFIX_ACK      "ACK:"
+#define ACK_OK          "OK"
+#define ACK_RANGE       "RANGE"
+#define ACK_REFUSED     "REFUSED"
+#define ACK_UNKNOWN     "UNKNOWN"
+#define PREFIX_AUDIO    "AUDIO:"
+#define PREFIX_SPECTRUM "SPECTRUM:"
 
 #define PREFIX_STATUS   "STATUS:"
 #define PREFIX_STATS    "STATS:"
 #define PREFIX_DECODED  "DECODED:"
 #define PREFIX_CURRENT  "CURRENT:"
+#define PREFIX_CHARSTAT "CHARSTAT:"
+#define PREFIX_PROFILES "PROFILES:"
+#define PREFIX_HISTORY  "HISTORY:"
+#define PREFIX_EXPORT   "EXPORT:"
+#define PREFIX_IMPORT   "IMPORT:"
 
+#include <stddef.h>
 #include "trainer_status.h"
 
 #ifdef __cplusplus
@@ -24,7 +41,26 @@ extern "C" {
  */
 void process_teensy_message(const char *msg);
 
-/* Reset g_status to default values. */
+/* Feed bytes read from the Teensy UART: text lines and binary frames
+ * (cw-trainer/trainer_frame.h) are told apart and dispatched. Call from the
+ * UART task only. */
+void link_receive(const uint8_t *data, size_t len);
+
+/* Send a protocol line to the Teensy, as a frame once the HELLO exchange
+ * agreed on frames. Safe from any task. */
+void link_send_line(const char *line);
+
+/* The UART's limits, offered in our HELLO: the highest rate and whether
+ * RTS/CTS are wired. Call before the UART task starts. */
+void link_set_limits(uint32_t max_baud, bool flow_control);
+
+/* From the UART task between events and on UART framing or parity errors:
+ * a raised rate that carries nothing valid falls back to LINK_BAUD_DEFAULT,
+ * where a restarted Teensy talks. */
+void link_poll(void);
+void link_uart_error(void);
+
+/* Reset g_status to default values, link state aside (trainer_status.h). */
 void trainer_status_reset(void);
 
 #ifdef __cplusplus
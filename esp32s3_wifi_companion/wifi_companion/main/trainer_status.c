@@ -0,0 +1,99 @@
+#include "trainer_status.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+trainer_status_t g_status;  // zero-initialised by default
+volatile bool g_wifi_connected = false;
+volatile bool g_teensy_ready = false;
+
+/* Seqlock over the published copy: the sequence is odd while a publish is
+ * under way. The copy is kept as relaxed atomic words, so a reader racing the
+ * writer gets a mix of old and new words, never an undefined read, and the
+ * sequence tells it to try again. */
+_Static_assert(sizeof(trainer_status_t) % sizeof(uint32_t) == 0, "trainer_status_t is copied in words");
+#define STATUS_WORDS (sizeof(trainer_status_t) / sizeof(uint32_t))
+#define SNAPSHOT_SPINS 64  /* then yield: the writer may be preempted mid-publish */
+
+static _Atomic uint32_t s_published[STATUS_WORDS];
+static atomic_uint s_seq;
+static atomic_uint s_reset_requests;  /* asked for since the last reset */
+
+void trainer_status_reset(void)
+{
+    link_status_t link = g_status.link;
+    memset(&g_status, 0, sizeof(g_status));
+    g_status.link = link;
+    g_status.frequency = 600;
+    g_status.speed = 20;
+    g_status.effective_speed = 13;
+    strcpy(g_status.waveform, "Sine");
+    strcpy(g_status.output, "Headphones");
+}
+
+void trainer_status_publish(void)
+{
+    unsigned requests = atomic_load_explicit(&s_reset_requests, memory_order_acquire);
+    if (requests) trainer_status_reset();
+
+    unsigned seq = atomic_load_explicit(&s_seq, memory_order_relaxed);
+    atomic_store_explicit(&s_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);  /* the odd sequence before any word */
+    const uint8_t *src = (const uint8_t *)&g_status;
+    for (size_t i = 0; i < STATUS_WORDS; i++) {
+        uint32_t w;
+        memcpy(&w, src + i * sizeof(w), sizeof(w));
+        atomic_store_explicit(&s_published[i], w, memory_order_relaxed);
+    }
+    atomic_store_explicit(&s_seq, seq + 2, memory_order_release);
+
+    /* Only the requests this publish saw: one that came in since stays
+     * pending and the next publish resets again */
+    if (requests) {
+        atomic_compare_exchange_strong_explicit(&s_reset_requests, &requests, 0, memory_order_release,
+                                                memory_order_relaxed);
+    }
+}
+
+/* Words [first, first + count) of one publish into dst */
+static unsigned snapshot_words(void *dst, size_t first, size_t count)
+{
+    uint8_t *out = (uint8_t *)dst;
+    for (unsigned retries = 0;; retries++) {
+        unsigned seq = atomic_load_explicit(&s_seq, memory_order_acquire);
+        if (!(seq & 1)) {
+            for (size_t i = 0; i < count; i++) {
+                uint32_t w = atomic_load_explicit(&s_published[first + i], memory_order_relaxed);
+                memcpy(out + i * sizeof(w), &w, sizeof(w));
+            }
+            atomic_thread_fence(memory_order_acquire);  /* every word before the second look */
+            if (atomic_load_explicit(&s_seq, memory_order_relaxed) == seq) return retries;
+        }
+        if (retries >= SNAPSHOT_SPINS) vTaskDelay(1);
+    }
+}
+
+unsigned trainer_status_snapshot(trainer_status_t *out)
+{
+    return snapshot_words(out, 0, STATUS_WORDS);
+}
+
+_Static_assert(offsetof(trainer_status_t, link) % sizeof(uint32_t) == 0 &&
+               sizeof(link_status_t) % sizeof(uint32_t) == 0, "g_status.link is copied in words");
+
+void trainer_status_link(link_status_t *out)
+{
+    snapshot_words(out, offsetof(trainer_status_t, link) / sizeof(uint32_t), sizeof(link_status_t) / sizeof(uint32_t));
+}
+
+void trainer_status_request_reset(void)
+{
+    atomic_fetch_add_explicit(&s_reset_requests, 1, memory_order_release);
+}
+
+bool trainer_status_reset_pending(void)
+{
+    return atomic_load_explicit(&s_reset_requests, memory_order_acquire) != 0;
+}
@@ -2,15 +2,77 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Per-character copy statistics, one entry per symbol the Teensy reported in a
+ * CHARSTAT line. Latency bins are response times <300, <600, <1200, <2400,
+ * <4800 and >=4800 ms. */
+#define CHAR_STATS_MAX      64
+#define CHAR_CONFUSIONS_MAX 3
+#define LATENCY_BINS        6
+
+/* Operator profiles as listed in the last PROFILES line */
+#define PROFILES_MAX        8
+#define PROFILE_NAME_LEN    13
+
+/* Session history mirrored slot for slot from HISTORY lines: per-session,
+ * daily and weekly rings (cw-trainer/trainer_history.h). Points are means
+ * over the sessions in the bucket. */
+#define HISTORY_TIER_COUNT  3   /* sessions, days, weeks */
+#define HISTORY_SLOTS_MAX   52
+
+typedef struct {
+    uint32_t start;        /* Unix time of the first session */
+    uint16_t sessions;
+    uint8_t lesson;
+    bool valid;
+    uint32_t characters;
+    float accuracy;
+    float speed;
+    float effective_speed;
+} history_point_t;
+
+typedef struct {
+    history_point_t slots[HISTORY_SLOTS_MAX];
+    int newest;            /* slot of the last line received */
+} history_ring_t;
+
+typedef struct {
+    char symbol;
+    uint16_t correct;
+    uint32_t errors;
+    uint8_t confusion_count;
+    char confused_with[CHAR_CONFUSIONS_MAX];
+    uint16_t confused_times[CHAR_CONFUSIONS_MAX];
+    uint8_t latency[LATENCY_BINS];
+} char_stat_t;
+
 /*
  * Structure mirroring the fields used in the original ESP8266 sketch.
  * Sizes for text buffers are chosen to be generous yet reasonable for RAM.
  */
+/* Teensy link state as the protocol has it. It belongs to the link, not to
+ * the training figures, so trainer_status_reset() keeps it. */
+typedef struct {
+    bool framed;             /* the Teensy's HELLO offered frames */
+    uint32_t frames;
+    uint32_t lines;
+    uint32_t bad_frames;     /* failed CRC or COBS */
+    uint32_t lost_frames;    /* sequence gaps */
+    uint32_t overflows;      /* overlong lines and frames */
+    uint32_t garbled;        /* lines with control bytes */
+    uint32_t bad_fields;     /* status and stats fields malformed or out of range, and
+                                unprintable decoded characters; ignored */
+    uint32_t baud;
+    uint32_t uart_errors;    /* framing and parity */
+    uint32_t overruns;       /* UART FIFO or driver buffer full */
+    bool acks;               /* the Teensy's HELLO offered command acks */
+} link_status_t;
+
 typedef struct {
     int lesson;
     int frequency;
@@ -22,27 +84,59 @@ typedef struct {
 
     char current_text[128];   // currently playing training text
     char decoded_text[256];   // rolling decoded buffer
+    size_t decoded_len;
+    float copy_wpm;           /* from the Teensy's character times; 0 when unknown */
 
     uint32_t sessions;
     uint32_t characters;
     float best_wpm;
 
+    char_stat_t char_stats[CHAR_STATS_MAX];
+    int char_stat_count;
+
+    int profile;  /* active, 1-based; 0 until the Teensy reports it */
+    char profiles[PROFILES_MAX][PROFILE_NAME_LEN];
+    int profile_count;
+
+    history_ring_t history[HISTORY_TIER_COUNT];
+
     char waveform[16];
     char output[16];
 
     bool sending;
     bool listening;
 
-    /* New connection-status flags */
-    bool wifi_connected;   /* true once the ESP32 got an IP from AP */
-    bool teensy_ready;     /* true once the Teensy sends TEENSY:READY */
+    /* Teensy link (cw-trainer/trainer_frame.h) */
+    link_status_t link;
+
+    /* Live audio (FRAME_AUDIO) relayed to /ws/audio; frame counts are kept
+     * by the feed (web_server.c) */
+    uint32_t audio_lost;        /* samples missing between frames from the Teensy */
 } trainer_status_t;
 
-/* Global instance that the rest of the program can reference */
+/*
+ * The UART task's working copy: only that task reads or writes it, a message
+ * at a time. After each batch of complete messages it publishes a copy, and
+ * every other task reads that through trainer_status_snapshot(), so a page
+ * never shows a new lesson with the old accuracy or half a decoded_text
+ * shift. Publishing never waits for readers; a reader that overlaps a
+ * publish copies again.
+ */
 extern trainer_status_t g_status;
 
-/* Helper to restore defaults */
+void trainer_status_publish(void);  /* UART task only */
+unsigned trainer_status_snapshot(trainer_status_t *out);  /* any task; returns the retries */
+void trainer_status_link(link_status_t *out);  /* any task; just g_status.link, off the same publish */
+
+/* Restore defaults, keeping g_status.link; UART task only. Other tasks ask
+ * for it, and the next publish carries it out. */
 void trainer_status_reset(void);
+void trainer_status_request_reset(void);
+bool trainer_status_reset_pending(void);
+
+/* Connection flags, single bytes each task may read directly */
+extern volatile bool g_wifi_connected;  /* the ESP32 has an IP from the AP */
+extern volatile bool g_teensy_ready;    /* the Teensy sent TEENSY:READY since */
 
 #ifdef __cplusplus
 }
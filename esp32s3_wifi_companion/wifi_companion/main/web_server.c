@@ -3,14 +3,505 @@
 #include "esp_http_server.h"
 #include "cJSON.h"
 #include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "trainer_protocol.h"
+#include "trainer_crc.h"
+#include "trainer_frame.h"
+#include "esp_log.h"
 #include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
 
 static httpd_handle_t server = NULL;
 static char g_last_cmd[64] = ""; // stores most recent control command
+static char g_last_result[12] = "";  // its ACK result, "TIMEOUT" or "" if not acknowledged
+static uint32_t g_last_latency = 0;  // ms
+
+// --- Backup transfers -----------------------------------------------------------
+// /api/export and /api/import relay the Teensy's EXPORT:/IMPORT: lines (see
+// cw-trainer/trainer_export.h). The UART task queues them here while a transfer
+// is running; the handler checks each line's sequence number and CRC and
+// streams the payload on, so neither side holds more than a line or a chunk.
+
+#define BACKUP_LINE_MAX    112
+#define BACKUP_QUEUE_DEPTH 16
+#define BACKUP_CHUNK_BYTES 20     // EXPORT_CHUNK_BYTES on the Teensy
+#define BACKUP_TIMEOUT_MS  3000   // per line; the Teensy sends one every 5 ms
+
+typedef struct {
+    char text[BACKUP_LINE_MAX];
+} backup_line_t;
+
+static QueueHandle_t backup_queue = NULL;
+static volatile bool backup_running = false;
+
+void web_backup_line(const char *line)
+{
+    if (!backup_running || !backup_queue) return;
+    backup_line_t item;
+    strncpy(item.text, line, sizeof(item.text) - 1);
+    item.text[sizeof(item.text) - 1] = '\0';
+    xQueueSend(backup_queue, &item, 0);  // a full queue drops the line; the sequence check catches it
+}
+
+// Next line with the given prefix, prefix stripped; false on timeout
+static bool backup_wait(const char *prefix, backup_line_t *item)
+{
+    size_t n = strlen(prefix);
+    while (xQueueReceive(backup_queue, item, pdMS_TO_TICKS(BACKUP_TIMEOUT_MS)) == pdTRUE) {
+        if (strncmp(item->text, prefix, n) == 0) {
+            memmove(item->text, item->text + n, strlen(item->text + n) + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void backup_start(void)
+{
+    xQueueReset(backup_queue);
+    backup_running = true;
+}
+
+static int hex_digit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// "<seq> <payload> <crc>" split in place; false if malformed
+static bool split_data_line(char *line, unsigned long *seq, char **payload, uint16_t *crc)
+{
+    char *end;
+    *seq = strtoul(line, &end, 10);
+    if (end == line || *end != ' ') return false;
+    char *last = strrchr(end, ' ');
+    if (last == end) return false;
+    *last = '\0';
+    *payload = end + 1;
+    *crc = (uint16_t)strtoul(last + 1, NULL, 16);
+    return true;
+}
+
+// --- /api/export GET handler (?format=csv for CSV, binary backup otherwise) ------
+static esp_err_t api_export_get(httpd_req_t *req)
+{
+    char query[32];
+    char format[8] = "bin";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "format", format, sizeof(format));
+    }
+    bool csv = strcmp(format, "csv") == 0;
+
+    backup_start();
+    link_send_line(csv ? "TEENSY:EXPORT CSV" : "TEENSY:EXPORT BIN");
+
+    backup_line_t item;
+    if (!backup_wait(PREFIX_EXPORT, &item) || strncmp(item.text, "BEGIN", 5) != 0) {
+        backup_running = false;
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Trainer did not start the export");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, csv ? "text/csv" : "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition",
+                       csv ? "attachment; filename=\"cw-trainer-stats.csv\""
+                           : "attachment; filename=\"cw-trainer-backup.cwbk\"");
+
+    // Once data has gone out the status is fixed, so a bad stream just stops:
+    // returning ESP_FAIL closes the connection and the download is incomplete
+    unsigned long lines = 0;
+    uint16_t total_crc = 0xFFFF;
+    for (;;) {
+        if (!backup_wait(PREFIX_EXPORT, &item)) break;
+        if (strncmp(item.text, "END", 3) == 0) {
+            char *p;
+            unsigned long count = strtoul(item.text + 3, &p, 10);
+            unsigned long crc = strtoul(p, NULL, 16);
+            backup_running = false;
+            if (count != lines || crc != total_crc) return ESP_FAIL;
+            httpd_resp_send_chunk(req, NULL, 0);
+            return ESP_OK;
+        }
+
+        unsigned long seq;
+        char *payload;
+        uint16_t crc;
+        if (!split_data_line(item.text, &seq, &payload, &crc) || seq != lines + 1) break;
+        size_t len = strlen(payload);
+        if (csv) {
+            if (crc16((const uint8_t *)payload, len) != crc) break;
+            payload[len] = '\n';
+            total_crc = crc16Update(total_crc, (const uint8_t *)payload, len + 1);
+            httpd_resp_send_chunk(req, payload, len + 1);
+        } else {
+            uint8_t chunk[BACKUP_CHUNK_BYTES];
+            size_t n = 0;
+            for (; n < sizeof(chunk) && hex_digit(payload[2 * n]) >= 0 && hex_digit(payload[2 * n + 1]) >= 0; n++) {
+                chunk[n] = (uint8_t)(hex_digit(payload[2 * n]) << 4 | hex_digit(payload[2 * n + 1]));
+            }
+            if (2 * n != len || crc16(chunk, n) != crc) break;
+            total_crc = crc16Update(total_crc, chunk, n);
+            httpd_resp_send_chunk(req, (const char *)chunk, n);
+        }
+        lines = seq;
+    }
+    backup_running = false;
+    return ESP_FAIL;
+}
+
+// Sends one IMPORT: line and waits for the Teensy's answer to it
+static bool import_exchange(const char *line, backup_line_t *reply)
+{
+    link_send_line(line);
+    return backup_wait(PREFIX_IMPORT, reply);
+}
+
+static esp_err_t import_fail(httpd_req_t *req, const char *reason)
+{
+    backup_running = false;
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "ok", false);
+    cJSON_AddStringToObject(root, "error", reason);
+    char *out = cJSON_PrintUnformatted(root);
+    httpd_resp_set_status(req, "400 Bad Request");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, out);
+    cJSON_Delete(root);
+    free(out);
+    return ESP_OK;
+}
+
+// --- /api/import POST handler: body is a binary backup from /api/export ----------
+static esp_err_t api_import_post(httpd_req_t *req)
+{
+    int remaining = req->content_len;
+    if (remaining <= 0) return import_fail(req, "empty body");
+
+    backup_start();
+    backup_line_t reply;
+    if (!import_exchange(PREFIX_IMPORT "BEGIN BIN 1", &reply)) return import_fail(req, "trainer not responding");
+    if (strcmp(reply.text, "ACK 0") != 0) return import_fail(req, reply.text);
+
+    char line[BACKUP_LINE_MAX];
+    uint8_t chunk[BACKUP_CHUNK_BYTES];
+    unsigned long lines = 0;
+    uint16_t total_crc = 0xFFFF;
+    while (remaining > 0) {
+        int n = 0;
+        while (n < (int)sizeof(chunk) && remaining > 0) {
+            int r = httpd_req_recv(req, (char *)chunk + n, sizeof(chunk) - n < (size_t)remaining ? sizeof(chunk) - n : remaining);
+            if (r == HTTPD_SOCK_ERR_TIMEOUT) continue;
+            if (r <= 0) return import_fail(req, "upload interrupted");
+            n += r;
+            remaining -= r;
+        }
+        lines++;
+        int pos = snprintf(line, sizeof(line), PREFIX_IMPORT "%lu ", lines);
+        for (int i = 0; i < n; i++) pos += snprintf(line + pos, sizeof(line) - pos, "%02X", chunk[i]);
+        snprintf(line + pos, sizeof(line) - pos, " %04X", crc16(chunk, n));
+        total_crc = crc16Update(total_crc, chunk, n);
+
+        char ack[16];
+        snprintf(ack, sizeof(ack), "ACK %lu", lines);
+        if (!import_exchange(line, &reply)) return import_fail(req, "trainer not responding");
+        if (strcmp(reply.text, ack) != 0) return import_fail(req, reply.text);
+    }
+
+    snprintf(line, sizeof(line), PREFIX_IMPORT "END %lu %04X", lines, total_crc);
+    if (!import_exchange(line, &reply)) return import_fail(req, "trainer not responding");
+    if (strncmp(reply.text, "OK", 2) != 0) return import_fail(req, reply.text);
+    backup_running = false;
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "ok", true);
+    cJSON_AddNumberToObject(root, "records", atoi(reply.text + 2));
+    char *out = cJSON_PrintUnformatted(root);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, out);
+    cJSON_Delete(root);
+    free(out);
+    return ESP_OK;
+}
+
+// --- Browser feeds ---------------------------------------------------------------
+// Live audio (/ws/audio) and the spectrum (/ws/spectrum) stream Teensy frames
+// to WebSocket listeners. The first listener of a feed sends its start line to
+// the Teensy, the last one to leave its stop line, so the Teensy only does the
+// work while someone watches. The UART task queues each frame body; the server
+// task sends it on, prefixed with a little-endian uint16: ms from capture on
+// the Teensy to leaving here (its age when sent, the time on the wire and the
+// time queued). Text messages from a browser: "ping:<t>" is echoed as
+// "pong:<t>" for round trips, anything else is JSON for the feed.
+
+#define FEED_LISTENERS_MAX  4
+#define FEED_MESSAGE_MAX    96   // browser text messages
+
+typedef struct {
+    uint32_t arrived;   /* esp_log_timestamp() */
+    uint16_t age_ms;    /* on the Teensy, as the frame says */
+    uint16_t wire_ms;
+    uint16_t len;
+    uint8_t body[FRAME_BODY_MAX];
+} feed_packet_t;
+
+typedef struct ws_feed ws_feed_t;
+struct ws_feed {
+    const char *name;
+    int queue_depth;
+    char start_line[40];
+    const char *stop_line;
+    void (*on_json)(ws_feed_t *feed, const char *json);
+    int fds[FEED_LISTENERS_MAX];  // touched by the server task only
+    volatile int count;
+    QueueHandle_t queue;
+    volatile bool work_pending;
+    uint32_t frames;
+    uint32_t bytes;        // frame bodies sent, per listener
+    uint32_t dropped;      // frames the queue had no room for
+    uint32_t upstream_ms;  // last frame
+};
+
+static bool feed_add(ws_feed_t *feed, int fd)
+{
+    for (int i = 0; i < feed->count; i++) {
+        if (feed->fds[i] == fd) return true;
+    }
+    if (feed->count == FEED_LISTENERS_MAX) return false;
+    feed->fds[feed->count++] = fd;
+    if (feed->count == 1) link_send_line(feed->start_line);
+    ESP_LOGI("web", "%s listener %d connected, %d listening", feed->name, fd, feed->count);
+    return true;
+}
+
+static void feed_remove(ws_feed_t *feed, int fd)
+{
+    for (int i = 0; i < feed->count; i++) {
+        if (feed->fds[i] != fd) continue;
+        feed->fds[i] = feed->fds[--feed->count];
+        if (feed->count == 0) link_send_line(feed->stop_line);
+        ESP_LOGI("web", "%s listener %d left, %d listening", feed->name, fd, feed->count);
+        return;
+    }
+}
+
+static void feed_send_work(void *arg)
+{
+    ws_feed_t *feed = arg;
+    feed->work_pending = false;  // frames queued from here on schedule another pass
+    feed_packet_t p;
+    uint8_t msg[2 + FRAME_BODY_MAX];
+    while (xQueueReceive(feed->queue, &p, 0) == pdTRUE) {
+        uint32_t upstream = p.age_ms + p.wire_ms + (esp_log_timestamp() - p.arrived);
+        if (upstream > 0xFFFF) upstream = 0xFFFF;
+        feed->upstream_ms = upstream;
+        msg[0] = upstream & 0xFF;
+        msg[1] = upstream >> 8;
+        memcpy(msg + 2, p.body, p.len);
+        httpd_ws_frame_t frame = {
+            .final = true,
+            .type = HTTPD_WS_TYPE_BINARY,
+            .payload = msg,
+            .len = 2 + p.len
+        };
+        for (int i = feed->count - 1; i >= 0; i--) {
+            int fd = feed->fds[i];
+            if (httpd_ws_get_fd_info(server, fd) != HTTPD_WS_CLIENT_WEBSOCKET ||
+                httpd_ws_send_frame_async(server, fd, &frame) != ESP_OK) {
+                feed_remove(feed, fd);  // gone without a close frame
+                continue;
+            }
+            feed->bytes += p.len;
+        }
+    }
+}
+
+// From the UART task, so the working g_status is safe to read
+static void feed_frame(ws_feed_t *feed, const uint8_t *body, size_t len, uint16_t age_ms)
+{
+    feed_packet_t p;
+    uint32_t baud = g_status.link.baud ? g_status.link.baud : LINK_BAUD_DEFAULT;
+    p.arrived = esp_log_timestamp();
+    p.age_ms = age_ms;
+    p.wire_ms = (len + 7) * 10000 / baud;  // framing adds 7 bytes, 10 bits each
+    p.len = len;
+    memcpy(p.body, body, len);
+    feed->frames++;
+    if (xQueueSend(feed->queue, &p, 0) != pdTRUE) {
+        feed->dropped++;  // the server task is behind; the browser sees a gap
+        return;
+    }
+    if (!feed->work_pending) {
+        feed->work_pending = true;
+        if (httpd_queue_work(server, feed_send_work, feed) != ESP_OK) feed->work_pending = false;
+    }
+}
+
+static esp_err_t ws_feed_handler(httpd_req_t *req)
+{
+    ws_feed_t *feed = req->user_ctx;
+    int fd = httpd_req_to_sockfd(req);
+    if (req->method == HTTP_GET) {  // the handshake
+        return feed_add(feed, fd) ? ESP_OK : ESP_FAIL;
+    }
+    uint8_t buf[FEED_MESSAGE_MAX];
+    httpd_ws_frame_t frame = { 0 };
+    esp_err_t r = httpd_ws_recv_frame(req, &frame, 0);
+    if (r != ESP_OK) return r;
+    if (frame.len >= sizeof(buf)) return ESP_FAIL;
+    frame.payload = buf;
+    if (frame.len > 0 && (r = httpd_ws_recv_frame(req, &frame, frame.len)) != ESP_OK) return r;
+    buf[frame.len] = '\0';
+
+    switch (frame.type) {
+    case HTTPD_WS_TYPE_CLOSE:
+        feed_remove(feed, fd);
+        frame.len = 0;
+        return httpd_ws_send_frame(req, &frame);
+    case HTTPD_WS_TYPE_PING:
+        frame.type = HTTPD_WS_TYPE_PONG;
+        return httpd_ws_send_frame(req, &frame);
+    case HTTPD_WS_TYPE_TEXT:
+        if (strncmp((char *)buf, "ping:", 5) == 0) {
+            buf[1] = 'o';
+            return httpd_ws_send_frame(req, &frame);
+        }
+        feed->on_json(feed, (char *)buf);
+        return ESP_OK;
+    default:
+        return ESP_OK;
+    }
+}
+
+static void register_feed(ws_feed_t *feed, const char *uri)
+{
+    feed->queue = xQueueCreate(feed->queue_depth, sizeof(feed_packet_t));
+    httpd_uri_t ws = {
+        .uri = uri,
+        .method = HTTP_GET,
+        .handler = ws_feed_handler,
+        .user_ctx = feed,
+        .is_websocket = true,
+        .handle_ws_control_frames = true
+    };
+    httpd_register_uri_handler(server, &ws);
+}
+
+static cJSON *feed_to_json(cJSON *parent, const char *name, const ws_feed_t *feed)
+{
+    cJSON *o = cJSON_AddObjectToObject(parent, name);
+    cJSON_AddNumberToObject(o, "listeners", feed->count);
+    cJSON_AddNumberToObject(o, "frames", feed->frames);
+    cJSON_AddNumberToObject(o, "bytes", feed->bytes);
+    cJSON_AddNumberToObject(o, "dropped", feed->dropped);
+    cJSON_AddNumberToObject(o, "upstreamMs", feed->upstream_ms);
+    return o;
+}
+
+// Live audio: FRAME_AUDIO (cw-trainer/trainer_monitor.h). The browser reports
+// its buffering and the total delay back.
+
+static void audio_report(ws_feed_t *feed, const char *json);
+
+static ws_feed_t audio_feed = {
+    .name = "audio",
+    .queue_depth = 8,  // 160 ms of frames
+    .start_line = PREFIX_AUDIO "1",
+    .stop_line = PREFIX_AUDIO "0",
+    .on_json = audio_report
+};
+static uint32_t audio_next = 0;  // sample number the next frame should start at
+
+// As the browser last reported them; written and read in the server task
+static uint32_t audio_latency_ms;  // capture to the browser's speaker
+static uint32_t audio_buffer_ms;   // the browser's jitter buffer
+static uint32_t audio_underruns;
+
+void web_audio_frame(const uint8_t *body, size_t len)
+{
+    if (!audio_feed.queue || audio_feed.count == 0 || len < sizeof(FrameAudio) || len > FRAME_BODY_MAX) return;
+    FrameAudio head;
+    memcpy(&head, body, sizeof(head));
+    if (head.sample != 0 && head.sample != audio_next) {  // 0 starts a stream
+        g_status.audio_lost += head.sample - audio_next;
+    }
+    audio_next = head.sample + (len - sizeof(head)) * 2;
+    feed_frame(&audio_feed, body, len, head.age);
+}
+
+static void audio_report(ws_feed_t *feed, const char *json)
+{
+    (void)feed;
+    cJSON *root = cJSON_Parse(json);
+    if (!root) return;
+    cJSON *latency = cJSON_GetObjectItem(root, "latency");
+    cJSON *buffer = cJSON_GetObjectItem(root, "buffer");
+    cJSON *underruns = cJSON_GetObjectItem(root, "underruns");
+    if (cJSON_IsNumber(latency)) audio_latency_ms = latency->valuedouble;
+    if (cJSON_IsNumber(buffer)) audio_buffer_ms = buffer->valuedouble;
+    if (cJSON_IsNumber(underruns)) audio_underruns = underruns->valuedouble;
+    cJSON_Delete(root);
+}
+
+// Spectrum: FRAME_SPECTRUM (cw-trainer/trainer_spectrum.h). A browser may send
+// {"low":Hz,"high":Hz,"points":n,"rate":n}; the latest asked for is what every
+// listener gets, and the Teensy refuses what would exceed its frame bound.
+
+static void spectrum_config(ws_feed_t *feed, const char *json);
+
+static ws_feed_t spectrum_feed = {
+    .name = "spectrum",
+    .queue_depth = 4,
+    .start_line = PREFIX_SPECTRUM "1",  // the Teensy's last settings
+    .stop_line = PREFIX_SPECTRUM "0",
+    .on_json = spectrum_config
+};
+
+void web_spectrum_frame(const uint8_t *body, size_t len)
+{
+    if (!spectrum_feed.queue || spectrum_feed.count == 0 || len < sizeof(FrameSpectrum) || len > FRAME_BODY_MAX) return;
+    feed_frame(&spectrum_feed, body, len, 0);
+}
+
+static void spectrum_config(ws_feed_t *feed, const char *json)
+{
+    cJSON *root = cJSON_Parse(json);
+    if (!root) return;
+    const char *keys[4] = { "low", "high", "points", "rate" };
+    int v[4];
+    bool ok = true;
+    for (int i = 0; i < 4; i++) {
+        cJSON *item = cJSON_GetObjectItem(root, keys[i]);
+        ok = ok && cJSON_IsNumber(item) && item->valuedouble >= 0 && item->valuedouble <= 30000;
+        v[i] = ok ? (int)item->valuedouble : 0;
+    }
+    cJSON_Delete(root);
+    if (!ok) return;
+    snprintf(feed->start_line, sizeof(feed->start_line), PREFIX_SPECTRUM "%d,%d,%d,%d", v[0], v[1], v[2], v[3]);
+    link_send_line(feed->start_line);
+}
+
+void web_link_hello(void)
+{
+    if (audio_feed.count > 0) link_send_line(audio_feed.start_line);
+    if (spectrum_feed.count > 0) link_send_line(spectrum_feed.start_line);
+}
+
+// Handlers run one at a time in the server task, so one snapshot buffer does
+static trainer_status_t status_view;
+
+static const trainer_status_t *status_snapshot(void)
+{
+    trainer_status_snapshot(&status_view);
+    return &status_view;
+}
 
 static cJSON *status_to_json(void)
 {
-    const trainer_status_t *s = &g_status;
+    const trainer_status_t *s = status_snapshot();
     cJSON *root = cJSON_CreateObject();
     cJSON_AddNumberToObject(root, "lesson", s->lesson);
     cJSON_AddNumberToObject(root, "frequency", s->frequency);
@@ -24,14 +515,110 @@ static cJSON *status_to_json(void)
     cJSON_AddNumberToObject(root, "sessions", s->sessions);
     cJSON_AddNumberToObject(root, "characters", s->characters);
     cJSON_AddNumberToObject(root, "bestWPM", s->best_wpm);
+    cJSON_AddNumberToObject(root, "copyWPM", s->copy_wpm);
     cJSON_AddStringToObject(root, "waveform", s->waveform);
     cJSON_AddStringToObject(root, "output", s->output);
     cJSON_AddBoolToObject(root, "sending", s->sending);
     cJSON_AddBoolToObject(root, "listening", s->listening);
+    cJSON_AddNumberToObject(root, "profile", s->profile);
+    cJSON *profiles = cJSON_AddArrayToObject(root, "profiles");
+    for (int i = 0; i < s->profile_count; i++) {
+        cJSON_AddItemToArray(profiles, cJSON_CreateString(s->profiles[i]));
+    }
+    cJSON *link = cJSON_AddObjectToObject(root, "link");
+    cJSON_AddBoolToObject(link, "framed", s->link.framed);
+    cJSON_AddNumberToObject(link, "frames", s->link.frames);
+    cJSON_AddNumberToObject(link, "lines", s->link.lines);
+    cJSON_AddNumberToObject(link, "badFrames", s->link.bad_frames);
+    cJSON_AddNumberToObject(link, "lostFrames", s->link.lost_frames);
+    cJSON_AddNumberToObject(link, "overflows", s->link.overflows);
+    cJSON_AddNumberToObject(link, "garbled", s->link.garbled);
+    cJSON_AddNumberToObject(link, "badFields", s->link.bad_fields);
+    cJSON_AddNumberToObject(link, "baud", s->link.baud);
+    cJSON_AddNumberToObject(link, "uartErrors", s->link.uart_errors);
+    cJSON_AddNumberToObject(link, "overruns", s->link.overruns);
+    cJSON *audio = feed_to_json(root, "audio", &audio_feed);
+    cJSON_AddNumberToObject(audio, "lost", s->audio_lost);
+    cJSON_AddNumberToObject(audio, "latencyMs", audio_latency_ms);
+    cJSON_AddNumberToObject(audio, "bufferMs", audio_buffer_ms);
+    cJSON_AddNumberToObject(audio, "underruns", audio_underruns);
+    feed_to_json(root, "spectrum", &spectrum_feed);
     return root;
 }
 
+// --- Acknowledged commands -------------------------------------------------------
+// A Teensy that offered LINK_CAP_ACKS gets each control command as
+// CMD:<id>:<command> and answers ACK:<id>,<result> (cw-trainer/
+// trainer_protocol.h). The POST waits for the answer up to
+// CONTROL_ACK_TIMEOUT_MS; a late answer to an earlier command is skipped by
+// its id. The slow-request worker runs one POST at a time, so there is one
+// waiter.
+
+#define CONTROL_ACK_TIMEOUT_MS 1000
+#define ACK_QUEUE_DEPTH        4
+
+typedef struct {
+    uint32_t id;
+    uint32_t at;  /* esp_log_timestamp() on arrival */
+    char result[12];
+} command_ack_t;
+
+static QueueHandle_t ack_queue = NULL;
+static uint32_t command_id = 0;
+
+// Round trips binned at <10, <20, <50, <100, <200, <500 and >=500 ms;
+// timeouts are counted apart. Kept here: only the server task sends commands.
+#define CMD_LATENCY_BINS 7
+static const uint16_t cmd_latency_limits[CMD_LATENCY_BINS - 1] = { 10, 20, 50, 100, 200, 500 };
+static uint32_t cmd_sent, cmd_rejected, cmd_timeouts;
+static uint32_t cmd_latency[CMD_LATENCY_BINS];
+
+void web_command_ack(const char *ack)
+{
+    if (!ack_queue) return;
+    command_ack_t item;
+    char *end;
+    item.id = strtoul(ack, &end, 10);
+    if (end == ack || *end != ',') return;
+    strncpy(item.result, end + 1, sizeof(item.result) - 1);
+    item.result[sizeof(item.result) - 1] = '\0';
+    item.at = esp_log_timestamp();
+    xQueueSend(ack_queue, &item, 0);
+}
+
+static void note_command_latency(uint32_t ms)
+{
+    int bin = 0;
+    while (bin < CMD_LATENCY_BINS - 1 && ms >= cmd_latency_limits[bin]) bin++;
+    cmd_latency[bin]++;
+}
+
+// Sends the command and waits for its ACK; false on timeout
+static bool command_exchange(const char *cmd, command_ack_t *ack, uint32_t *latency)
+{
+    char line[FRAME_BODY_MAX + 1];
+    uint32_t id = ++command_id;
+    snprintf(line, sizeof(line), PREFIX_CMD "%u:%s", (unsigned)id, cmd);
+    uint32_t sent = esp_log_timestamp();
+    link_send_line(line);
+    cmd_sent++;
+
+    uint32_t waited;
+    while ((waited = esp_log_timestamp() - sent) < CONTROL_ACK_TIMEOUT_MS &&
+           xQueueReceive(ack_queue, ack, pdMS_TO_TICKS(CONTROL_ACK_TIMEOUT_MS - waited)) == pdTRUE) {
+        if (ack->id != id) continue;
+        *latency = ack->at - sent;
+        note_command_latency(*latency);
+        if (strcmp(ack->result, ACK_OK) != 0) cmd_rejected++;
+        return true;
+    }
+    cmd_timeouts++;
+    return false;
+}
+
 // --- /api/control POST handler -------------------------------------------------
+// {"ok":true} once sent to a Teensy without acks; otherwise ok, its result
+// (OK, RANGE, REFUSED, UNKNOWN) and the round trip, or 504 without an answer
 static esp_err_t api_control_post(httpd_req_t *req)
 {
     int total = req->content_len;
@@ -62,13 +649,34 @@ static esp_err_t api_control_post(httpd_req_t *req)
     }
 
     const char *cmd_str = cmd->valuestring;
-    uart_write_bytes(UART_NUM_1, cmd_str, strlen(cmd_str));
     strncpy(g_last_cmd, cmd_str, sizeof(g_last_cmd) - 1);
-    uart_write_bytes(UART_NUM_1, "\n", 1);
+    httpd_resp_set_type(req, "application/json");
+    link_status_t link;
+    trainer_status_link(&link);  // not status_view: that belongs to the server task
+    if (!link.acks) {
+        link_send_line(cmd_str);
+        g_last_result[0] = '\0';
+        cJSON_Delete(root);
+        httpd_resp_sendstr(req, "{\"ok\":true}");
+        return ESP_OK;
+    }
 
+    command_ack_t ack;
+    uint32_t latency = 0;
+    bool answered = command_exchange(cmd_str, &ack, &latency);
     cJSON_Delete(root);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, "{\"ok\":true}");
+    strncpy(g_last_result, answered ? ack.result : "TIMEOUT", sizeof(g_last_result) - 1);
+    g_last_latency = latency;
+
+    cJSON *reply = cJSON_CreateObject();
+    cJSON_AddBoolToObject(reply, "ok", answered && strcmp(ack.result, ACK_OK) == 0);
+    cJSON_AddStringToObject(reply, "result", g_last_result);
+    if (answered) cJSON_AddNumberToObject(reply, "latencyMs", latency);
+    char *out = cJSON_PrintUnformatted(reply);
+    if (!answered) httpd_resp_set_status(req, "504 Gateway Timeout");
+    httpd_resp_sendstr(req, out);
+    cJSON_Delete(reply);
+    free(out);
     return ESP_OK;
 }
 
@@ -77,6 +685,19 @@ static esp_err_t api_control_get(httpd_req_t *req)
 {
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "lastCmd", g_last_cmd);
+    cJSON_AddStringToObject(root, "lastResult", g_last_result);
+    cJSON_AddNumberToObject(root, "lastLatencyMs", g_last_latency);
+
+    cJSON *commands = cJSON_AddObjectToObject(root, "commands");
+    cJSON_AddNumberToObject(commands, "sent", cmd_sent);
+    cJSON_AddNumberToObject(commands, "rejected", cmd_rejected);
+    cJSON_AddNumberToObject(commands, "timeouts", cmd_timeouts);
+    cJSON *limits = cJSON_AddArrayToObject(commands, "latencyLimitsMs");
+    cJSON *bins = cJSON_AddArrayToObject(commands, "latency");
+    for (int i = 0; i < CMD_LATENCY_BINS; i++) {
+        if (i < CMD_LATENCY_BINS - 1) cJSON_AddItemToArray(limits, cJSON_CreateNumber(cmd_latency_limits[i]));
+        cJSON_AddItemToArray(bins, cJSON_CreateNumber(cmd_latency[i]));
+    }
     char *out = cJSON_PrintUnformatted(root);
     httpd_resp_set_type(req, "application/json");
     httpd_resp_sendstr(req, out);
@@ -86,13 +707,34 @@ static esp_err_t api_control_get(httpd_req_t *req)
 }
 
 // --- /api/stats GET/POST handlers ---------------------------------------------
+#define STATS_RESET_WAIT_MS 1000
+
 static cJSON *stats_to_json(void)
 {
-    const trainer_status_t *s = &g_status;
+    const trainer_status_t *s = status_snapshot();
     cJSON *root = cJSON_CreateObject();
     cJSON_AddNumberToObject(root, "sessions", s->sessions);
     cJSON_AddNumberToObject(root, "characters", s->characters);
     cJSON_AddNumberToObject(root, "bestWPM", s->best_wpm);
+
+    cJSON *symbols = cJSON_AddArrayToObject(root, "symbols");
+    for (int i = 0; i < s->char_stat_count; i++) {
+        const char_stat_t *c = &s->char_stats[i];
+        char symbol[2] = { c->symbol, '\0' };
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "symbol", symbol);
+        cJSON_AddNumberToObject(item, "correct", c->correct);
+        cJSON_AddNumberToObject(item, "errors", c->errors);
+        cJSON *confusions = cJSON_AddObjectToObject(item, "confusions");
+        for (int j = 0; j < c->confusion_count; j++) {
+            char with[2] = { c->confused_with[j], '\0' };
+            cJSON_AddNumberToObject(confusions, with, c->confused_times[j]);
+        }
+        int latency[LATENCY_BINS];
+        for (int j = 0; j < LATENCY_BINS; j++) latency[j] = c->latency[j];
+        cJSON_AddItemToObject(item, "latency", cJSON_CreateIntArray(latency, LATENCY_BINS));
+        cJSON_AddItemToArray(symbols, item);
+    }
     return root;
 }
 
@@ -128,7 +770,12 @@ static esp_err_t api_stats_post(httpd_req_t *req)
     }
     cJSON *reset = cJSON_GetObjectItem(root, "reset");
     if (cJSON_IsBool(reset) && cJSON_IsTrue(reset)) {
-        trainer_status_reset();
+        // The UART task owns g_status: it resets at its next publish, within
+        // one pass of its loop (500 ms without traffic)
+        trainer_status_request_reset();
+        for (int i = 0; i < STATS_RESET_WAIT_MS / 10 && trainer_status_reset_pending(); i++) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
     }
     cJSON_Delete(root);
     httpd_resp_set_type(req, "application/json");
@@ -136,6 +783,46 @@ static esp_err_t api_stats_post(httpd_req_t *req)
     return ESP_OK;
 }
 
+// --- /api/history GET handler (?tier=sessions|days|weeks, days by default) ----
+static esp_err_t api_history_get(httpd_req_t *req)
+{
+    static const char *names[HISTORY_TIER_COUNT] = { "sessions", "days", "weeks" };
+    char query[32];
+    char tier_name[12] = "days";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        httpd_query_key_value(query, "tier", tier_name, sizeof(tier_name));
+    }
+    int tier = 1;
+    for (int i = 0; i < HISTORY_TIER_COUNT; i++) {
+        if (strcmp(tier_name, names[i]) == 0) tier = i;
+    }
+
+    // Oldest first: the slots after the newest one wrap round to it
+    const history_ring_t *ring = &status_snapshot()->history[tier];
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "tier", names[tier]);
+    cJSON *points = cJSON_AddArrayToObject(root, "points");
+    for (int i = 1; i <= HISTORY_SLOTS_MAX; i++) {
+        const history_point_t *p = &ring->slots[(ring->newest + i) % HISTORY_SLOTS_MAX];
+        if (!p->valid) continue;
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "start", p->start);
+        cJSON_AddNumberToObject(item, "sessions", p->sessions);
+        cJSON_AddNumberToObject(item, "lesson", p->lesson);
+        cJSON_AddNumberToObject(item, "characters", p->characters);
+        cJSON_AddNumberToObject(item, "accuracy", p->accuracy);
+        cJSON_AddNumberToObject(item, "wpm", p->speed);
+        cJSON_AddNumberToObject(item, "effectiveWpm", p->effective_speed);
+        cJSON_AddItemToArray(points, item);
+    }
+    char *out = cJSON_PrintUnformatted(root);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, out);
+    cJSON_Delete(root);
+    free(out);
+    return ESP_OK;
+}
+
 // Existing status GET handler
 static esp_err_t api_status_get(httpd_req_t *req)
 {
@@ -193,14 +880,71 @@ static esp_err_t static_get(httpd_req_t *req)
     return ESP_OK;
 }
 
+// --- Slow requests ---------------------------------------------------------------
+// Command round trips, the stats reset and the backup relays wait on the
+// Teensy, for up to a second or for a whole transfer. On the server task that
+// would hold up everything else it runs, the /ws/audio and /ws/spectrum sends
+// included, so those requests are handed over to one worker task that runs
+// them in turn (httpd_req_async_handler_begin, ESP-IDF 5.1 and later).
+
+#define SLOW_QUEUE_DEPTH 4
+#define SLOW_TASK_STACK  6144
+
+typedef esp_err_t (*slow_handler_t)(httpd_req_t *req);
+
+typedef struct {
+    httpd_req_t *req;  /* the server's copy, valid until completed */
+    slow_handler_t handler;
+} slow_request_t;
+
+static QueueHandle_t slow_queue = NULL;
+
+static void slow_task(void *arg)
+{
+    slow_request_t item;
+    for (;;) {
+        if (xQueueReceive(slow_queue, &item, portMAX_DELAY) != pdTRUE) continue;
+        // ESP_FAIL closes the connection, as it does from the server task
+        if (item.handler(item.req) != ESP_OK) {
+            httpd_sess_trigger_close(item.req->handle, httpd_req_to_sockfd(item.req));
+        }
+        httpd_req_async_handler_complete(item.req);
+    }
+}
+
+static esp_err_t defer_request(httpd_req_t *req, slow_handler_t handler)
+{
+    slow_request_t item = { .handler = handler };
+    if (httpd_req_async_handler_begin(req, &item.req) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    if (xQueueSend(slow_queue, &item, 0) != pdTRUE) {
+        httpd_req_async_handler_complete(item.req);
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_sendstr(req, "Busy");
+        return ESP_OK;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t api_control_post_deferred(httpd_req_t *req) { return defer_request(req, api_control_post); }
+static esp_err_t api_stats_post_deferred(httpd_req_t *req) { return defer_request(req, api_stats_post); }
+static esp_err_t api_export_get_deferred(httpd_req_t *req) { return defer_request(req, api_export_get); }
+static esp_err_t api_import_post_deferred(httpd_req_t *req) { return defer_request(req, api_import_post); }
+
 void start_webserver(void)
 {
     if (server) return; // already running
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.uri_match_fn = httpd_uri_match_wildcard; // allow wildcard if needed later
+    config.max_uri_handlers = 12;  // the default 8 is fewer than are registered below
 
     if (httpd_start(&server, &config) == ESP_OK) {
+        slow_queue = xQueueCreate(SLOW_QUEUE_DEPTH, sizeof(slow_request_t));
+        xTaskCreate(slow_task, "web_slow", SLOW_TASK_STACK, NULL, 5, NULL);
+
         httpd_uri_t status_uri = {
             .uri       = "/api/status",
             .method    = HTTP_GET,
@@ -218,10 +962,11 @@ void start_webserver(void)
     httpd_register_uri_handler(server, &control_get);
 
     // Register /api/control POST
+        ack_queue = xQueueCreate(ACK_QUEUE_DEPTH, sizeof(command_ack_t));
         httpd_uri_t control_post = {
             .uri = "/api/control",
             .method = HTTP_POST,
-            .handler = api_control_post,
+            .handler = api_control_post_deferred,
             .user_ctx = NULL
         };
         httpd_register_uri_handler(server, &control_post);
@@ -239,10 +984,41 @@ void start_webserver(void)
     httpd_uri_t stats_post = {
         .uri = "/api/stats",
         .method = HTTP_POST,
-        .handler = api_stats_post,
+        .handler = api_stats_post_deferred,
         .user_ctx = NULL
     };
     httpd_register_uri_handler(server, &stats_post);
+
+    // Register /api/history GET
+    httpd_uri_t history_get = {
+        .uri = "/api/history",
+        .method = HTTP_GET,
+        .handler = api_history_get,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &history_get);
+
+    // Register /api/export GET and /api/import POST
+    backup_queue = xQueueCreate(BACKUP_QUEUE_DEPTH, sizeof(backup_line_t));
+    httpd_uri_t export_get = {
+        .uri = "/api/export",
+        .method = HTTP_GET,
+        .handler = api_export_get_deferred,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &export_get);
+
+    httpd_uri_t import_post = {
+        .uri = "/api/import",
+        .method = HTTP_POST,
+        .handler = api_import_post_deferred,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(server, &import_post);
+
+    // Register /ws/audio and /ws/spectrum (need CONFIG_HTTPD_WS_SUPPORT)
+    register_feed(&audio_feed, "/ws/audio");
+    register_feed(&spectrum_feed, "/ws/spectrum");
     }
 
     // Register static file handler
@@ -1,11 +1,28 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void start_webserver(void);
 
+/* EXPORT:/IMPORT: lines from the Teensy, handed to a running backup transfer */
+void web_backup_line(const char *line);
+
+/* The rest of an ACK:<id>,<result> line, for the /api/control request waiting on it */
+void web_command_ack(const char *ack);
+
+/* FRAME_AUDIO and FRAME_SPECTRUM bodies from the Teensy, relayed to the
+ * /ws/audio and /ws/spectrum listeners */
+void web_audio_frame(const uint8_t *body, size_t len);
+void web_spectrum_frame(const uint8_t *body, size_t len);
+
+/* The Teensy said HELLO: ask again for the feeds browsers are waiting on */
+void web_link_hello(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,6 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "esp_system.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
@@ -11,6 +12,7 @@
 #include "driver/gpio.h"
 #include "trainer_status.h"
 #include "trainer_protocol.h"
+#include "trainer_frame.h"
 #include "web_server.h"
 #include "esp_log.h"
 #include "esp_spiffs.h"
@@ -26,6 +28,23 @@ static const char *TAG = "wifi_companion";
 #define UART_1_RX_PIN  GPIO_NUM_13         // IO13 = UART1 RX (connect to Teensy TX)
 #define UART_1_TX_PIN  GPIO_NUM_12         // IO12 = UART1 TX (connect to Teensy RX)
 #define BUF_LEN        512
+#define UART_1_RX_BUF  4096   /* driver ring buffers: a busy web server must not cost bytes */
+#define UART_1_TX_BUF  4096
+#define UART_1_EVENTS  32
+
+/* RTS/CTS to the Teensy (-1 if not wired) and the highest rate to offer */
+#ifndef CONFIG_TEENSY_LINK_RTS_GPIO
+#define CONFIG_TEENSY_LINK_RTS_GPIO -1
+#endif
+#ifndef CONFIG_TEENSY_LINK_CTS_GPIO
+#define CONFIG_TEENSY_LINK_CTS_GPIO -1
+#endif
+#ifndef CONFIG_TEENSY_LINK_MAX_BAUD
+#define CONFIG_TEENSY_LINK_MAX_BAUD 2000000
+#endif
+#define UART_1_FLOW    (CONFIG_TEENSY_LINK_RTS_GPIO >= 0 && CONFIG_TEENSY_LINK_CTS_GPIO >= 0)
+
+static QueueHandle_t s_uart_1_queue;
 #define READY_GPIO     GPIO_NUM_8   // Pin to signal readiness to Teensy
 #define STATUS_LED_GPIO GPIO_NUM_2  // Built-in LED for connection status
 
@@ -36,8 +55,8 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base, int32_t e
         esp_wifi_connect();
     } else if (event_id == WIFI_EVENT_STA_DISCONNECTED) {
         ESP_LOGW(TAG, "WiFi disconnected, retrying...");
-        g_status.wifi_connected = false;
-        g_status.teensy_ready = false;
+        g_wifi_connected = false;
+        g_teensy_ready = false;
         gpio_set_level(STATUS_LED_GPIO, 0);
         esp_wifi_connect();
     }
@@ -47,7 +66,7 @@ static void on_got_ip(void* arg, esp_event_base_t event_base, int32_t event_id,
 {
     ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
     ESP_LOGI(TAG, "Connected with IP: " IPSTR, IP2STR(&event->ip_info.ip));
-    g_status.wifi_connected = true;
+    g_wifi_connected = true;
     gpio_set_level(READY_GPIO, 0);  // signal ready to Teensy
 }
 
@@ -85,16 +104,21 @@ static void uart_init(void)
     // uart_param_config(UART_NUM, &config);
     // uart_set_pin(UART_NUM, UART_TX_PIN, UART_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
 
+    /* Starts at the default rate; the Teensy raises it after the HELLOs */
     uart_config_t config_1 = {
-        .baud_rate  = 115200,
+        .baud_rate  = LINK_BAUD_DEFAULT,
         .data_bits  = UART_DATA_8_BITS,
         .parity     = UART_PARITY_DISABLE,
         .stop_bits  = UART_STOP_BITS_1,
-        .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE
+        .flow_ctrl  = UART_1_FLOW ? UART_HW_FLOWCTRL_CTS_RTS : UART_HW_FLOWCTRL_DISABLE,
+        .rx_flow_ctrl_thresh = 100  /* of the 128-byte FIFO */
     };
-    uart_driver_install(UART_1, BUF_LEN * 2, 0, 0, NULL, 0);
+    uart_driver_install(UART_1, UART_1_RX_BUF, UART_1_TX_BUF, UART_1_EVENTS, &s_uart_1_queue, 0);
     uart_param_config(UART_1, &config_1);
-    uart_set_pin(UART_1, UART_1_TX_PIN, UART_1_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_set_pin(UART_1, UART_1_TX_PIN, UART_1_RX_PIN,
+                 UART_1_FLOW ? CONFIG_TEENSY_LINK_RTS_GPIO : UART_PIN_NO_CHANGE,
+                 UART_1_FLOW ? CONFIG_TEENSY_LINK_CTS_GPIO : UART_PIN_NO_CHANGE);
+    link_set_limits(CONFIG_TEENSY_LINK_MAX_BAUD, UART_1_FLOW);
 }
 
 static void uart_num_task(void *arg)
@@ -120,33 +144,44 @@ static void uart_num_task(void *arg)
     }
 }
 
+/* Woken by the driver's events rather than polling with a timeout; lines and
+ * frames are split out in link_receive() */
 static void uart_1_task(void *arg)
 {
-    /* Stream-oriented newline splitter. */
-    static char line[BUF_LEN + 1];
-    static size_t line_len = 0;
     static uint8_t buf[BUF_LEN];
+    uart_event_t event;
 
+    trainer_status_publish();
     for (;;) {
-        int len = uart_read_bytes(UART_1, buf, BUF_LEN, pdMS_TO_TICKS(100));
-        if (len <= 0) continue;
-        ESP_LOGD("uart1", "read %d bytes", len);
-        for (int i = 0; i < len; ++i) {
-            char c = (char)buf[i];
-            if (c == '\r') continue;              // ignore CR
-            if (c == '\n') {
-                if (line_len > 0) {
-                    line[line_len] = '\0';       // NUL-terminate
-                    process_teensy_message(line);
-                    line_len = 0;                 // reset for next line
+        if (xQueueReceive(s_uart_1_queue, &event, pdMS_TO_TICKS(500)) == pdTRUE) {
+            switch (event.type) {
+            case UART_DATA: {
+                size_t left = event.size;
+                while (left > 0) {
+                    int len = uart_read_bytes(UART_1, buf, left < BUF_LEN ? left : BUF_LEN, 0);
+                    if (len <= 0) break;
+                    link_receive(buf, len);
+                    left -= len;
                 }
-            } else if (line_len < BUF_LEN) {
-                line[line_len++] = c;
-            } else {
-                // overflow, reset
-                line_len = 0;
+                break;
+            }
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                /* what is buffered is no longer contiguous; the receiver resyncs on the next delimiter */
+                g_status.link.overruns++;
+                uart_flush_input(UART_1);
+                xQueueReset(s_uart_1_queue);
+                break;
+            case UART_FRAME_ERR:
+            case UART_PARITY_ERR:
+                link_uart_error();
+                break;
+            default:
+                break;
             }
         }
+        link_poll();
+        trainer_status_publish();  /* whole messages only; a partial one waits in the receiver */
     }
 }
 
@@ -157,11 +192,11 @@ static void status_led_task(void *arg)
 {
     bool led_state = false;
     for (;;) {
-        if (!g_status.wifi_connected) {
+        if (!g_wifi_connected) {
             /* Wi-Fi not connected – LED off */
             gpio_set_level(STATUS_LED_GPIO, 0);
             vTaskDelay(pdMS_TO_TICKS(500));
-        } else if (g_status.wifi_connected && !g_status.teensy_ready) {
+        } else if (g_wifi_connected && !g_teensy_ready) {
             /* Blink while waiting for Teensy READY */
             led_state = !led_state;
             gpio_set_level(STATUS_LED_GPIO, led_state);